@@ -0,0 +1,61 @@
+#include "benchmark.h"
+#include "batch_render.h"
+
+static const uint32 jobCount = 64;
+
+// Thumbnail-sized jobs, each simulated for a few frames before the one that is kept
+static void makeJobs(BatchJob* jobs)
+{
+    for (uint32 i = 0; i < jobCount; i++)
+    {
+        BatchJob& job = jobs[i];
+        snprintf(job.name, sizeof(job.name), "thumb%02u", i);
+        snprintf(job.output, sizeof(job.output), "bench_batch_%02u.ppm", i);
+        job.width = 512;
+        job.height = 512;
+        job.frames = 8;
+        job.objects = 4096;
+        job.seed = i + 1;
+    }
+}
+
+void benchBatch()
+{
+    BatchJob* jobs = new BatchJob[jobCount];
+    makeJobs(jobs);
+
+    uint32 inFlight[] = { 1, 2, 3 };
+    for (uint32 framesInFlight : inFlight)
+    {
+        NullDeviceConfig deviceConfig;
+        BatchDevice device = batchNullDevice(deviceConfig);
+        BatchConfig config;
+        config.framesInFlight = framesInFlight;
+        config.saveOutputs = false;
+
+        BatchStats stats;
+        batchRun(jobs, jobCount, device, config, &stats);
+        device.destroy(device.userData);
+
+        char label[96];
+        snprintf(label, sizeof(label), "%u frame(s) in flight, per frame", framesInFlight);
+        benchReport(label, stats.frames, stats.seconds);
+        printf("  %-48s %10.1f jobs/s, %.3f s waiting on fences\n", "",
+            (float64)stats.jobsCompleted / stats.seconds, stats.waitSeconds);
+    }
+
+    // Saving adds the readback splat and the file write to the last frame of every job
+    NullDeviceConfig deviceConfig;
+    BatchDevice device = batchNullDevice(deviceConfig);
+    BatchConfig config;
+    BatchStats stats;
+    batchRun(jobs, jobCount, device, config, &stats);
+    device.destroy(device.userData);
+    benchReport("2 frames in flight, saving images, per job", stats.jobsCompleted, stats.seconds);
+    for (uint32 i = 0; i < jobCount; i++)
+    {
+        remove(jobs[i].output);
+    }
+
+    delete[] jobs;
+}
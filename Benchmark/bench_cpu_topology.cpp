@@ -0,0 +1,191 @@
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu_topology.h"
+
+static const uint32 roundTrips = 20000;
+static const uint32 renderChunks = 2000;
+
+// Two threads hand a token back and forth; every hop is a cache line moving between cores
+static float64 pingPong(int32 firstCpu, int32 secondCpu)
+{
+    alignas(SGS_CACHE_LINE_SIZE) std::atomic<uint32> token(0);
+
+    auto player = [&token](int32 cpu, uint32 parity) {
+        if (cpu >= 0)
+        {
+            CpuSet set;
+            cpuSetClear(&set);
+            cpuSetAdd(&set, (uint32)cpu);
+            cpuSetCurrentThreadAffinity(&set);
+        }
+        for (uint32 i = parity; i < roundTrips * 2; i += 2)
+        {
+            // Yield after a short spin, or two threads sharing a core would spin out their slices
+            uint32 spins = 0;
+            while (token.load(std::memory_order_acquire) != i)
+            {
+                if (++spins > 64)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            token.store(i + 1, std::memory_order_release);
+        }
+    };
+
+    float64 start = benchNow();
+    std::thread second(player, secondCpu, 1);
+    player(firstCpu, 0);
+    second.join();
+    return benchNow() - start;
+}
+
+static void reportPingPong(const char* label, int32 firstCpu, int32 secondCpu)
+{
+    char name[96];
+    if (firstCpu >= 0)
+    {
+        snprintf(name, sizeof(name), "round trip, %s (%d, %d)", label, firstCpu, secondCpu);
+    }
+    else
+    {
+        snprintf(name, sizeof(name), "round trip, %s", label);
+    }
+    benchReport(name, roundTrips, pingPong(firstCpu, secondCpu));
+}
+
+// The first pair of logical cores related the way the test wants, -1 if there is none
+static bool findPair(const CpuTopology* topology, bool sameCore, bool sameL3, int32* first, int32* second)
+{
+    for (uint32 i = 0; i < topology->logicalCount; i++)
+    {
+        for (uint32 j = i + 1; j < topology->logicalCount; j++)
+        {
+            const CpuLogicalCore& a = topology->logical[i];
+            const CpuLogicalCore& b = topology->logical[j];
+            if ((a.core == b.core) == sameCore && (a.l3Group == b.l3Group) == sameL3)
+            {
+                *first = (int32)a.id;
+                *second = (int32)b.id;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// A latency critical thread doing fixed chunks of work while background threads keep every
+// core busy. Returns the chunk times in microseconds, sorted.
+static std::vector<float64> renderUnderLoad(const CpuTopology* topology, bool placed)
+{
+    if (placed)
+    {
+        e_threadPlacement policies[ENGINE_THREAD_COUNT];
+        cpuPlacementDefaultPolicies(policies);
+        CpuPlacementPlan plan;
+        cpuPlacementBuildPlan(topology, policies, &plan);
+        cpuPlacementInitialize(&plan);
+    }
+
+    std::atomic<bool> stop(false);
+    uint32 backgroundCount = topology->logicalCount < 2 ? 2 : topology->logicalCount;
+    std::vector<std::thread> background;
+    for (uint32 i = 0; i < backgroundCount; i++)
+    {
+        background.emplace_back([&stop, i]() {
+            cpuPlacementAttachThread(ENGINE_THREAD_WORKER, i);
+            float64 x = 1.0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                for (uint32 k = 0; k < 10000; k++)
+                {
+                    x = sqrt(x + (float64)k);
+                }
+                benchDoNotOptimize(x);
+            }
+            cpuPlacementDetachThread();
+        });
+    }
+
+    std::vector<float64> chunks;
+    std::thread render([&chunks]() {
+        cpuPlacementAttachThread(ENGINE_THREAD_RENDER, 0);
+        float64 x = 1.0;
+        for (uint32 i = 0; i < renderChunks; i++)
+        {
+            float64 start = benchNow();
+            for (uint32 k = 0; k < 20000; k++)
+            {
+                x = sqrt(x + (float64)k);
+            }
+            benchDoNotOptimize(x);
+            chunks.push_back((benchNow() - start) * 1e6);
+        }
+        cpuPlacementDetachThread();
+    });
+    render.join();
+
+    stop.store(true);
+    for (std::thread& thread : background)
+    {
+        thread.join();
+    }
+    cpuPlacementShutdown();
+
+    std::sort(chunks.begin(), chunks.end());
+    return chunks;
+}
+
+static void reportRender(const char* label, const std::vector<float64>& chunks)
+{
+    printf("  %-48s %10.1f us median %10.1f us p99 %10.1f us max\n", label,
+        chunks[chunks.size() / 2], chunks[chunks.size() * 99 / 100], chunks.back());
+}
+
+void benchCpuTopology()
+{
+    CpuTopology* topology = new CpuTopology();
+    const uint32 detections = 50;
+    float64 start = benchNow();
+    for (uint32 i = 0; i < detections; i++)
+    {
+        cpuTopologyDetect(topology);
+    }
+    benchReport("detect topology", detections, benchNow() - start);
+    printf("  %u logical, %u physical cores, %u L3 group(s), %u NUMA node(s)%s%s\n",
+        topology->logicalCount, topology->coreCount, topology->l3GroupCount, topology->numaNodeCount,
+        topology->smt ? ", SMT" : "", topology->hybrid ? ", hybrid" : "");
+
+    int32 first, second;
+    reportPingPong("unpinned", -1, -1);
+    reportPingPong("same logical core", (int32)topology->logical[0].id, (int32)topology->logical[0].id);
+    if (findPair(topology, true, true, &first, &second))
+    {
+        reportPingPong("SMT siblings", first, second);
+    }
+    else
+    {
+        printf("  %-48s no SMT siblings on this machine\n", "round trip, SMT siblings");
+    }
+    if (findPair(topology, false, true, &first, &second))
+    {
+        reportPingPong("separate cores, shared L3", first, second);
+    }
+    else
+    {
+        printf("  %-48s needs two physical cores\n", "round trip, separate cores");
+    }
+    if (findPair(topology, false, false, &first, &second))
+    {
+        reportPingPong("separate L3", first, second);
+    }
+
+    reportRender("render chunk under load, unplaced", renderUnderLoad(topology, false));
+    reportRender("render chunk under load, default placement", renderUnderLoad(topology, true));
+    delete topology;
+}
@@ -0,0 +1,74 @@
+#include "benchmark.h"
+#include "console_variables.h"
+
+static const uint32 readCount = 20000000;
+static const uint32 variableCount = 64;
+
+// What a hardcoded setting costs: the value has to be loaded, it just can't change
+static volatile int32 hardcodedSetting = 3;
+
+void benchCvars()
+{
+    char names[variableCount][CVAR_NAME_SIZE];
+    ConsoleVariable* variables[variableCount];
+    for (uint32 i = 0; i < variableCount; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "bench.setting%02u", i);
+        variables[i] = cvarRegisterInt(names[i], 3, 0, 1000, "benchmark setting");
+    }
+    ConsoleVariable* hot = variables[variableCount - 1];
+
+    int64 sum = 0;
+    float64 start = benchNow();
+    for (uint32 i = 0; i < readCount; i++)
+    {
+        sum += hardcodedSetting;
+    }
+    benchReport("read hardcoded value", readCount, benchNow() - start);
+
+    start = benchNow();
+    for (uint32 i = 0; i < readCount; i++)
+    {
+        sum += cvarInt(hot);
+    }
+    benchReport("read through cached pointer", readCount, benchNow() - start);
+
+    // The map-lookup-per-read design this avoids, with the variable at the end of the list
+    const uint32 lookupCount = readCount / 100;
+    start = benchNow();
+    for (uint32 i = 0; i < lookupCount; i++)
+    {
+        sum += cvarInt(cvarFind(names[variableCount - 1]));
+    }
+    benchReport("read by name lookup", lookupCount, benchNow() - start);
+    benchDoNotOptimize(sum);
+
+    const uint32 frames = 100000;
+    start = benchNow();
+    for (uint32 i = 0; i < frames; i++)
+    {
+        cvarApplyPending();
+    }
+    benchReport("apply per frame, nothing queued", frames, benchNow() - start);
+
+    start = benchNow();
+    for (uint32 i = 0; i < frames; i++)
+    {
+        for (uint32 v = 0; v < 8; v++)
+        {
+            cvarSetInt(variables[v], (int32)(i & 255));
+        }
+        cvarApplyPending();
+    }
+    benchReport("apply per frame, 8 sets queued", frames, benchNow() - start);
+
+    start = benchNow();
+    uint32 parsed = 0;
+    for (uint32 i = 0; i < frames; i++)
+    {
+        parsed += cvarParseCommandLine("--fps=60 +bench.setting01=12 +bench.setting02=7");
+    }
+    benchReport("parse command line, 2 variables", frames, benchNow() - start);
+    cvarApplyPending();
+    benchDoNotOptimize(parsed);
+}
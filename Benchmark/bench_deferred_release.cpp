@@ -0,0 +1,118 @@
+#include "benchmark.h"
+#include "frame_contexts.h"
+
+static const uint32 frameCount = 200;
+static const uint32 releasesPerFrame = 8;
+static const uint64 bufferSize = 256 * 1024;
+
+static void noRelease(void* object, void* userData)
+{
+}
+
+// Every frame replaces a few streaming buffers. Without the queue each replacement needs the
+// GPU idle before the old buffer can go.
+static void runFrames(bool deferred)
+{
+    RhiDeviceConfig deviceConfig;
+    deviceConfig.null.submitLatencyNanoseconds = 50000;
+    deviceConfig.null.nanosecondsPerDraw = 1000;
+    RhiDevice* device = rhiCreateDevice(deviceConfig);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    FrameContexts frames;
+    FrameContextsConfig config;
+    config.count = 2;
+    config.uploadBytes = 0;
+    frameContextsInitialize(&frames, device, config);
+
+    RhiResource* buffers[releasesPerFrame];
+    for (uint32 i = 0; i < releasesPerFrame; i++)
+    {
+        buffers[i] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, rhiBufferDesc(bufferSize), RHI_STATE_COMMON, "bench buffer");
+    }
+
+    float64 start = benchNow();
+    for (uint32 frame = 0; frame < frameCount; frame++)
+    {
+        FrameContext* context = frameContextsBegin(&frames);
+        rhiBeginCommandList(list, context->allocator);
+        for (uint32 draw = 0; draw < 1000; draw++)
+        {
+            rhiCmdDraw(list, 36, 1, 0, 0);
+        }
+        rhiEndCommandList(list);
+        rhiQueueSubmit(queue, &list, 1);
+
+        for (uint32 i = 0; i < releasesPerFrame; i++)
+        {
+            if (deferred)
+            {
+                frameContextsReleaseResource(&frames, buffers[i]);
+            }
+            else
+            {
+                frameContextsEnd(&frames);
+                frameContextsWaitIdle(&frames);
+                rhiDestroyResource(buffers[i]);
+                frameContextsBegin(&frames);
+            }
+            buffers[i] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, rhiBufferDesc(bufferSize), RHI_STATE_COMMON, "bench buffer");
+        }
+        frameContextsEnd(&frames);
+    }
+    frameContextsWaitIdle(&frames);
+    float64 seconds = benchNow() - start;
+
+    DeferredReleaseStats stats;
+    deferredReleaseGetStats(&frames.releases, &stats);
+    benchReport(deferred ? "deferred release, per frame" : "flush before each release, per frame", frameCount, seconds);
+    if (deferred)
+    {
+        printf("  %-48s %10llu peak pending, %.1f MB\n", "",
+            (unsigned long long)stats.peakPending, (float64)stats.peakPendingBytes / (1024.0 * 1024.0));
+    }
+
+    for (uint32 i = 0; i < releasesPerFrame; i++)
+    {
+        rhiDestroyResource(buffers[i]);
+    }
+    frameContextsShutdown(&frames);
+    rhiDestroyCommandList(list);
+    rhiDestroyDevice(device);
+}
+
+// Queue overhead alone: fence values that already completed, released by the next collect
+static void benchQueueOverhead()
+{
+    RhiDeviceConfig deviceConfig;
+    RhiDevice* device = rhiCreateDevice(deviceConfig);
+    RhiFence* fence = rhiCreateFence(device, 1, "bench fence");
+    DeferredReleaseQueue* queue = new DeferredReleaseQueue();
+    deferredReleaseInitialize(queue, fence);
+
+    const uint32 rounds = 10000;
+    const uint32 perRound = 64;
+    int dummy;
+    float64 start = benchNow();
+    for (uint32 round = 0; round < rounds; round++)
+    {
+        for (uint32 i = 0; i < perRound; i++)
+        {
+            deferredReleaseCallback(queue, &dummy, noRelease, nullptr, 0, 1);
+        }
+        deferredReleaseCollect(queue);
+    }
+    benchReport("retire + collect, per object", (uint64)rounds * perRound, benchNow() - start);
+
+    deferredReleaseShutdown(queue);
+    delete queue;
+    rhiDestroyFence(fence);
+    rhiDestroyDevice(device);
+}
+
+void benchDeferredRelease()
+{
+    runFrames(false);
+    runFrames(true);
+    benchQueueOverhead();
+}
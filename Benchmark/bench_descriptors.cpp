@@ -0,0 +1,237 @@
+#include "benchmark.h"
+#include "descriptor_heaps.h"
+
+// What a heap without a free list does: scan for the first unused descriptor
+struct ScanAllocator
+{
+    bool* used;
+    uint32 capacity;
+};
+
+static uint32 scanAllocate(ScanAllocator* allocator)
+{
+    for (uint32 i = 0; i < allocator->capacity; i++)
+    {
+        if (!allocator->used[i])
+        {
+            allocator->used[i] = true;
+            return i;
+        }
+    }
+    return DESCRIPTOR_INVALID;
+}
+
+static uint32 nextRandom(uint32* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+void benchDescriptors()
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 0;
+    RhiDevice* device = rhiCreateDevice(config);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+
+    // Churn at 90% occupancy: free a random descriptor, allocate one
+    const uint32 capacity = 16384;
+    const uint32 live = capacity * 9 / 10;
+    const uint32 churn = 2000000;
+    uint32* indices = new uint32[live];
+
+    DescriptorAllocator* allocator = new DescriptorAllocator();
+    descriptorAllocatorInitialize(allocator, device, RHI_DESCRIPTOR_HEAP_RESOURCE, capacity, "bench staging descriptors");
+    for (uint32 i = 0; i < live; i++)
+    {
+        indices[i] = descriptorAllocate(allocator);
+    }
+    uint32 random = 1;
+    float64 start = benchNow();
+    for (uint32 i = 0; i < churn; i++)
+    {
+        uint32 slot = nextRandom(&random) % live;
+        descriptorFree(allocator, indices[slot]);
+        indices[slot] = descriptorAllocate(allocator);
+    }
+    float64 freeListSeconds = benchNow() - start;
+    for (uint32 i = 0; i < live; i++)
+    {
+        descriptorFree(allocator, indices[i]);
+    }
+    descriptorAllocatorShutdown(allocator);
+    delete allocator;
+
+    ScanAllocator scan;
+    scan.capacity = capacity;
+    scan.used = new bool[capacity]();
+    for (uint32 i = 0; i < live; i++)
+    {
+        indices[i] = scanAllocate(&scan);
+    }
+    const uint32 scanChurn = churn / 20;
+    random = 1;
+    start = benchNow();
+    for (uint32 i = 0; i < scanChurn; i++)
+    {
+        uint32 slot = nextRandom(&random) % live;
+        scan.used[indices[slot]] = false;
+        indices[slot] = scanAllocate(&scan);
+    }
+    float64 scanSeconds = benchNow() - start;
+    delete[] scan.used;
+
+    // Bindless churn, freed descriptors retiring two frames later
+    const uint32 heapCapacity = 65536;
+    const uint32 bindlessCapacity = 16384;
+    ShaderDescriptorHeap* heap = new ShaderDescriptorHeap();
+    shaderDescriptorHeapInitialize(heap, device, fence, heapCapacity, bindlessCapacity, "bench shader descriptors");
+    for (uint32 i = 0; i < live / 2; i++)
+    {
+        indices[i] = shaderDescriptorAllocate(heap);
+    }
+    const uint32 bindlessFrames = 2000;
+    const uint32 bindlessPerFrame = 512;
+    uint64 frame = 0;
+    uint32 failed = 0;
+    random = 1;
+    float64 bindlessSeconds = 0.0;
+    for (uint32 f = 0; f < bindlessFrames; f++, frame++)
+    {
+        start = benchNow();
+        shaderDescriptorBeginFrame(heap);
+        for (uint32 i = 0; i < bindlessPerFrame; i++)
+        {
+            uint32 slot = nextRandom(&random) % (live / 2);
+            shaderDescriptorFree(heap, indices[slot], frame + 1);
+            indices[slot] = shaderDescriptorAllocate(heap);
+            failed += indices[slot] == DESCRIPTOR_INVALID;
+        }
+        bindlessSeconds += benchNow() - start;
+        rhiQueueSignal(queue, fence, frame + 1);
+        if (frame >= 2)
+        {
+            rhiFenceWait(fence, frame - 1);
+        }
+    }
+    rhiFenceWait(fence, frame);
+    shaderDescriptorBeginFrame(heap);
+    for (uint32 i = 0; i < live / 2; i++)
+    {
+        shaderDescriptorFree(heap, indices[i], frame);
+    }
+
+    // Per-frame tables filled from staging descriptors: batched, then one call per copy
+    const uint32 views = 4096;
+    DescriptorAllocator* staging = new DescriptorAllocator();
+    descriptorAllocatorInitialize(staging, device, RHI_DESCRIPTOR_HEAP_RESOURCE, views, "bench staging views");
+    RhiResource* buffer = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT,
+        rhiBufferDesc(65536, RHI_RESOURCE_FLAG_UNORDERED_ACCESS), RHI_STATE_COMMON, "bench buffer");
+    for (uint32 i = 0; i < views; i++)
+    {
+        rhiWriteView(staging->heap, descriptorAllocate(staging), i & 1 ? RHI_VIEW_UNORDERED_ACCESS : RHI_VIEW_SHADER_RESOURCE, buffer);
+    }
+
+    RhiCommandAllocator* commandAllocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "bench allocator");
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    DescriptorCopyBatch* batch = new DescriptorCopyBatch();
+    descriptorCopyBatchInitialize(batch, device);
+
+    // Draws with 8 descriptor tables: 4 material textures next to each other in the staging
+    // heap, 4 scattered ones
+    const uint32 frames = 500;
+    const uint32 drawsPerFrame = 1000;
+    const uint32 tableSize = 8;
+    RhiNullStats before;
+    rhiNullGetStats(device, &before);
+    float64 tableSeconds[2] = {};
+    uint64 tableCopies = 0;
+    for (uint32 batched = 2; batched-- > 0;)
+    {
+        for (uint32 f = 0; f < frames; f++, frame++)
+        {
+            rhiResetCommandAllocator(commandAllocator);
+            rhiBeginCommandList(list, commandAllocator);
+            start = benchNow();
+            shaderDescriptorBeginFrame(heap);
+            for (uint32 d = 0; d < drawsPerFrame; d++)
+            {
+                uint32 table = shaderDescriptorAllocateTable(heap, tableSize);
+                if (table == DESCRIPTOR_INVALID)
+                {
+                    failed++;
+                    continue;
+                }
+                uint32 material = (d * 4) % views;
+                for (uint32 i = 0; i < tableSize; i++)
+                {
+                    uint32 source = i < 4 ? material + i : nextRandom(&random) % views;
+                    if (batched)
+                    {
+                        descriptorCopy(batch, heap->heap, table + i, staging->heap, source);
+                    }
+                    else
+                    {
+                        RhiDescriptorCopy copy = { heap->heap, table + i, staging->heap, source, 1 };
+                        rhiCopyDescriptors(device, &copy, 1);
+                    }
+                    tableCopies++;
+                }
+            }
+            if (batched)
+            {
+                descriptorCopyFlush(batch, list);
+            }
+            shaderDescriptorEndFrame(heap, frame + 1);
+            tableSeconds[batched] += benchNow() - start;
+            rhiEndCommandList(list);
+            rhiQueueSubmit(queue, &list, 1);
+            rhiQueueSignal(queue, fence, frame + 1);
+            if (frame >= 2)
+            {
+                rhiFenceWait(fence, frame - 1);
+            }
+        }
+    }
+    rhiFenceWait(fence, frame);
+
+    RhiNullStats after;
+    rhiNullGetStats(device, &after);
+    DescriptorCopyBatchStats batchStats;
+    descriptorCopyBatchGetStats(batch, &batchStats);
+    ShaderDescriptorHeapStats heapStats;
+    shaderDescriptorHeapGetStats(heap, &heapStats);
+    uint64 copied = after.descriptorsCopied - before.descriptorsCopied;
+    uint64 calls = after.descriptorCopyCalls - before.descriptorCopyCalls;
+
+    benchReport("descriptor allocate + free, free list", churn, freeListSeconds);
+    benchReport("descriptor allocate + free, linear scan", scanChurn, scanSeconds);
+    benchReport("bindless allocate + free, retired by fence", bindlessFrames * bindlessPerFrame, bindlessSeconds);
+    benchReport("8 descriptor table per draw, batched copies", frames * drawsPerFrame, tableSeconds[1]);
+    benchReport("8 descriptor table per draw, a call per copy", frames * drawsPerFrame, tableSeconds[0]);
+    printf("  %-48s %10.1f copy calls per frame batched, %u unbatched, %llu of %llu copies merged\n", "",
+        (float64)batchStats.calls / frames, drawsPerFrame * tableSize,
+        (unsigned long long)batchStats.merged, (unsigned long long)batchStats.copies);
+    printf("  %-48s %10u of %u ring descriptors in use, %u of %u bindless allocated\n", "",
+        heapStats.ringInUse, heapStats.ringCapacity, heapStats.bindlessAllocated, heapStats.bindlessCapacity);
+    printf("  %-48s %10llu descriptors copied by the null device in %llu calls, %llu expected%s\n", "",
+        (unsigned long long)copied, (unsigned long long)calls, (unsigned long long)tableCopies,
+        copied != tableCopies || failed ? " (DESCRIPTOR BUG)" : "");
+
+    delete batch;
+    rhiDestroyCommandList(list);
+    rhiDestroyCommandAllocator(commandAllocator);
+    for (uint32 i = 0; i < views; i++)
+    {
+        descriptorFree(staging, i);
+    }
+    descriptorAllocatorShutdown(staging);
+    delete staging;
+    rhiDestroyResource(buffer);
+    shaderDescriptorHeapShutdown(heap);
+    delete heap;
+    delete[] indices;
+    rhiDestroyFence(fence);
+    rhiDestroyDevice(device);
+}
@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include <string>
+
+#include "benchmark.h"
+#include "dx_check.h"
+
+// The DX_CHECK the sandbox used before dx_check.h. It converted __FILE__ to a std::wstring on
+// every call, successful or not. mbstowcs stands in for MultiByteToWideChar.
+struct LegacyDxException
+{
+    LegacyDxException(HRESULT hr, const std::wstring& functionName, const std::wstring& filename, int lineNumber)
+        : m_errorCode(hr), m_functionName(functionName), m_filename(filename), m_lineNumber(lineNumber) {}
+    HRESULT m_errorCode = 0;
+    std::wstring m_functionName;
+    std::wstring m_filename;
+    int32 m_lineNumber = -1;
+};
+
+inline std::wstring legacyAnsiToWString(const std::string& str)
+{
+    wchar_t buffer[512];
+    mbstowcs(buffer, str.c_str(), 512);
+    return std::wstring(buffer);
+}
+
+#define LEGACY_WIDE(s) L##s
+#define LEGACY_WIDE_STRING(x) LEGACY_WIDE(#x)
+
+#define LEGACY_DX_CHECK(x)                                                       \
+{                                                                                \
+    HRESULT hr__ = (x);                                                          \
+    std::wstring wfn = legacyAnsiToWString(__FILE__);                            \
+    if(hr__ < 0) { throw LegacyDxException(hr__, LEGACY_WIDE_STRING(x), wfn, __LINE__); } \
+}
+
+static volatile int32 failAt = -1;
+
+SGS_NOINLINE static HRESULT fakeDeviceCall(int32 index)
+{
+    return index == failAt ? (HRESULT)0x887A0005 : 0;
+}
+
+void benchDxCheck()
+{
+    const int32 iterations = 20000000;
+
+    float64 start = benchNow();
+    for (int32 i = 0; i < iterations; i++)
+    {
+        LEGACY_DX_CHECK(fakeDeviceCall(i));
+    }
+    benchReport("legacy DX_CHECK, success", iterations, benchNow() - start);
+
+    start = benchNow();
+    for (int32 i = 0; i < iterations; i++)
+    {
+        DX_CHECK(fakeDeviceCall(i));
+    }
+    benchReport("DX_CHECK, success", iterations, benchNow() - start);
+
+    start = benchNow();
+    for (int32 i = 0; i < iterations; i++)
+    {
+        fakeDeviceCall(i);
+    }
+    benchReport("unchecked call", iterations, benchNow() - start);
+
+    // The failure path is allowed to be slow, but it should still work without allocating
+    failAt = 7;
+    try
+    {
+        for (int32 i = 0; i < 10; i++)
+        {
+            DX_CHECK(fakeDeviceCall(i));
+        }
+    }
+    catch (const DxException& exception)
+    {
+        DxFailure failure;
+        dxGetRecentFailures(&failure, 1);
+        printf("  caught 0x%08X from %s (line %d), %llu failure(s) recorded\n", (uint32)exception.errorCode,
+            failure.site->expression, failure.site->line, (unsigned long long)dxGetFailureCount());
+    }
+}
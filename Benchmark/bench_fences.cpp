@@ -0,0 +1,152 @@
+#include <thread>
+
+#include "benchmark.h"
+#include "rhi.h"
+#include "timeline_fence.h"
+
+static void countCallback(uint64 value, void* userData)
+{
+    (*(uint64*)userData)++;
+}
+
+// Two threads hand a value back and forth: every step is one signal and one blocking wait
+static void benchPingPong()
+{
+    const uint64 rounds = 20000;
+    TimelineFence* ping = new TimelineFence();
+    TimelineFence* pong = new TimelineFence();
+    timelineFenceInitialize(ping, 0);
+    timelineFenceInitialize(pong, 0);
+
+    float64 start = benchNow();
+    std::thread other([ping, pong, rounds]() {
+        for (uint64 i = 1; i <= rounds; i++)
+        {
+            timelineFenceWait(ping, i);
+            timelineFenceSignal(pong, i);
+        }
+    });
+    for (uint64 i = 1; i <= rounds; i++)
+    {
+        timelineFenceSignal(ping, i);
+        timelineFenceWait(pong, i);
+    }
+    float64 seconds = benchNow() - start;
+    other.join();
+    benchReport("timeline ping-pong, per signal + wait", rounds * 2, seconds);
+
+    timelineFenceShutdown(ping);
+    timelineFenceShutdown(pong);
+    delete ping;
+    delete pong;
+}
+
+static void benchTimelineFence()
+{
+    TimelineFence* fence = new TimelineFence();
+    timelineFenceInitialize(fence, 0);
+
+    const uint64 queries = 10000000;
+    uint64 complete = 0;
+    float64 start = benchNow();
+    for (uint64 i = 0; i < queries; i++)
+    {
+        complete += timelineFenceIsComplete(fence, i & 1) ? 1 : 0;
+    }
+    benchReport("timeline is-complete query", queries, benchNow() - start);
+    benchDoNotOptimize(complete);
+
+    const uint64 signals = 1000000;
+    start = benchNow();
+    for (uint64 i = 1; i <= signals; i++)
+    {
+        timelineFenceSignal(fence, i);
+    }
+    benchReport("timeline signal, nobody waiting", signals, benchNow() - start);
+
+    // Attached ahead of time, fired by one signal each
+    const uint64 callbacks = 100000;
+    uint64 fired = 0;
+    uint64 base = timelineFenceCompletedValue(fence);
+    start = benchNow();
+    for (uint64 i = 1; i <= callbacks; i++)
+    {
+        timelineFenceOnComplete(fence, base + i, countCallback, &fired);
+        timelineFenceSignal(fence, base + i);
+    }
+    benchReport("timeline callback attach + fire", fired, benchNow() - start);
+    timelineFenceShutdown(fence);
+    delete fence;
+
+    TimelineFence* fences = new TimelineFence[4];
+    TimelineFence* pointers[4];
+    uint64 values[4] = { 1, 1, 1, 1 };
+    for (uint32 i = 0; i < 4; i++)
+    {
+        timelineFenceInitialize(&fences[i], 0);
+        pointers[i] = &fences[i];
+    }
+    const uint64 rounds = 5000;
+    start = benchNow();
+    std::thread signaller([&fences, rounds]() {
+        for (uint64 round = 1; round <= rounds; round++)
+        {
+            for (uint32 i = 0; i < 4; i++)
+            {
+                timelineFenceSignal(&fences[i], round);
+            }
+            std::this_thread::yield();
+        }
+    });
+    for (uint64 round = 1; round <= rounds; round++)
+    {
+        for (uint32 i = 0; i < 4; i++)
+        {
+            values[i] = round;
+        }
+        timelineFenceWaitMany(pointers, values, 4, true);
+    }
+    signaller.join();
+    benchReport("timeline wait on 4 fences, all", rounds, benchNow() - start);
+    for (uint32 i = 0; i < 4; i++)
+    {
+        timelineFenceShutdown(&fences[i]);
+    }
+    delete[] fences;
+}
+
+// Through the RHI on the null device: an idle queue signals and the wait returns at once
+static void benchNullFences()
+{
+    RhiDeviceConfig config;
+    RhiDevice* device = rhiCreateDevice(config);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+
+    const uint64 flushes = 200000;
+    float64 start = benchNow();
+    for (uint64 i = 1; i <= flushes; i++)
+    {
+        rhiQueueSignal(queue, fence, i);
+        rhiFenceWait(fence, i);
+    }
+    benchReport("null signal + wait on an idle queue", flushes, benchNow() - start);
+
+    uint64 fired = 0;
+    start = benchNow();
+    for (uint64 i = 1; i <= flushes; i++)
+    {
+        rhiFenceOnComplete(fence, i, countCallback, &fired);
+    }
+    benchReport("null callback on a completed value", fired, benchNow() - start);
+
+    rhiDestroyFence(fence);
+    rhiDestroyDevice(device);
+}
+
+void benchFences()
+{
+    benchPingPong();
+    benchTimelineFence();
+    benchNullFences();
+}
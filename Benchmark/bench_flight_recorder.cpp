@@ -0,0 +1,35 @@
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "flight_recorder.h"
+
+static const uint32 eventsPerThread = 20000000;
+
+static void recordEvents()
+{
+    for (uint32 i = 0; i < eventsPerThread; i++)
+    {
+        SGSRECORD(FLIGHT_EVENT_MARKER, "bench", i);
+    }
+}
+
+void benchFlightRecorder()
+{
+    float64 start = benchNow();
+    recordEvents();
+    benchReport("record event, 1 thread", eventsPerThread, benchNow() - start);
+
+    const uint32 threadCount = 4;
+    std::vector<std::thread> threads;
+    start = benchNow();
+    for (uint32 t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back(recordEvents);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    benchReport("record event, 4 threads (per event)", (uint64)eventsPerThread * threadCount, benchNow() - start);
+}
@@ -0,0 +1,97 @@
+#include "benchmark.h"
+#include "frame_contexts.h"
+
+static const uint32 frameCount = 300;
+static const uint32 drawsPerFrame = 2000;
+
+// Stands in for simulation and culling work on the render thread
+static void spinFor(float64 seconds)
+{
+    float64 end = benchNow() + seconds;
+    while (benchNow() < end)
+    {
+    }
+}
+
+// The modeled GPU takes about 2 ms per frame, the CPU about 1.5 ms. With one context the two
+// add up; with more they overlap and the GPU sets the frame rate.
+static void runFrames(uint32 contextCount)
+{
+    RhiDeviceConfig deviceConfig;
+    deviceConfig.null.submitLatencyNanoseconds = 50000;
+    deviceConfig.null.nanosecondsPerDraw = 1000;
+    deviceConfig.null.maxFrameLatency = FRAME_CONTEXT_MAX;
+    RhiDevice* device = rhiCreateDevice(deviceConfig);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    RhiSwapChainDesc swapChainDesc;
+    swapChainDesc.width = 256;
+    swapChainDesc.height = 256;
+    swapChainDesc.bufferCount = 3;
+    RhiSwapChain* swapChain = rhiCreateSwapChain(device, queue, swapChainDesc);
+
+    FrameContexts frames;
+    FrameContextsConfig config;
+    config.count = contextCount;
+    frameContextsInitialize(&frames, device, config);
+
+    const float32 clearColor[4] = { 0.1f, 0.2f, 0.3f, 1.0f };
+    float64 start = benchNow();
+    for (uint32 frame = 0; frame < frameCount; frame++)
+    {
+        FrameContext* context = frameContextsBegin(&frames);
+        spinFor(0.0015);
+
+        // Per-frame constants live in the context's upload buffer
+        uint64 constantsOffset = 0;
+        float32* constants = (float32*)frameContextAllocate(context, 256, 256, &constantsOffset);
+        constants[0] = (float32)frame;
+
+        rhiBeginCommandList(list, context->allocator);
+        RhiResource* backBuffer = rhiSwapChainBuffer(swapChain, rhiSwapChainCurrentIndex(swapChain));
+        RhiBarrier barrier = rhiTransition(backBuffer, RHI_STATE_PRESENT, RHI_STATE_RENDER_TARGET);
+        rhiCmdBarriers(list, &barrier, 1);
+        rhiCmdClearRenderTarget(list, backBuffer, clearColor);
+        rhiCmdSetRenderTargets(list, &backBuffer, 1, nullptr);
+        rhiCmdSetVertexBuffer(list, 0, context->upload, constantsOffset, 256, 16);
+        for (uint32 draw = 0; draw < drawsPerFrame; draw++)
+        {
+            rhiCmdDraw(list, 36, 1, 0, 0);
+        }
+        barrier = rhiTransition(backBuffer, RHI_STATE_RENDER_TARGET, RHI_STATE_PRESENT);
+        rhiCmdBarriers(list, &barrier, 1);
+        rhiEndCommandList(list);
+
+        rhiQueueSubmit(queue, &list, 1);
+        rhiPresent(swapChain, 0);
+        frameContextsEnd(&frames);
+    }
+    frameContextsWaitIdle(&frames);
+    float64 seconds = benchNow() - start;
+
+    FrameContextsStats stats;
+    frameContextsGetStats(&frames, &stats);
+    RhiNullStats gpuStats;
+    rhiNullGetStats(device, &gpuStats);
+
+    char label[96];
+    snprintf(label, sizeof(label), "%u frame context(s), per frame", contextCount);
+    benchReport(label, frameCount, seconds);
+    printf("  %-48s %10.1f frames/s, gpu busy %.0f%%, cpu waiting %.0f%%\n", "",
+        (float64)frameCount / seconds, 100.0 * gpuStats.gpuBusySeconds / seconds, 100.0 * stats.waitSeconds / seconds);
+    printf("  %-48s %10.0f%% overlapped, %.2f frames queued on average\n", "",
+        stats.overlapFraction * 100.0, stats.averageFramesInFlight);
+
+    frameContextsShutdown(&frames);
+    rhiDestroySwapChain(swapChain);
+    rhiDestroyCommandList(list);
+    rhiDestroyDevice(device);
+}
+
+void benchFrameContexts()
+{
+    for (uint32 contextCount = 1; contextCount <= 3; contextCount++)
+    {
+        runFrames(contextCount);
+    }
+}
@@ -0,0 +1,202 @@
+#include "benchmark.h"
+#include "frame_graph.h"
+
+struct Pipelines
+{
+    RhiPipeline* graphics;
+    RhiPipeline* compute;
+};
+
+static void drawPass(RhiCommandList* list, const FrameGraph* graph, void* userData)
+{
+    rhiCmdSetPipeline(list, ((Pipelines*)userData)->graphics);
+    rhiCmdDraw(list, 3, 1, 0, 0);
+}
+
+static void dispatchPass(RhiCommandList* list, const FrameGraph* graph, void* userData)
+{
+    rhiCmdSetPipeline(list, ((Pipelines*)userData)->compute);
+    rhiCmdDispatch(list, 120, 68, 1);
+}
+
+// A deferred frame with a debug view nobody reads, culled along with its target
+static void declareFrame(FrameGraph* graph, RhiResource* backBuffer, uint32 width, uint32 height, Pipelines* pipelines)
+{
+    uint32 targetFlags = RHI_RESOURCE_FLAG_RENDER_TARGET;
+    frameGraphBegin(graph);
+    FrameGraphHandle shadowMap = frameGraphCreateTexture(graph, "shadow map",
+        rhiTexture2DDesc(RHI_FORMAT_D32_FLOAT, 2048, 2048, RHI_RESOURCE_FLAG_DEPTH_STENCIL));
+    FrameGraphHandle albedo = frameGraphCreateTexture(graph, "albedo", rhiTexture2DDesc(RHI_FORMAT_RGBA8_UNORM, width, height, targetFlags));
+    FrameGraphHandle normals = frameGraphCreateTexture(graph, "normals", rhiTexture2DDesc(RHI_FORMAT_RGBA16_FLOAT, width, height, targetFlags));
+    FrameGraphHandle depth = frameGraphCreateTexture(graph, "depth",
+        rhiTexture2DDesc(RHI_FORMAT_D24_UNORM_S8_UINT, width, height, RHI_RESOURCE_FLAG_DEPTH_STENCIL));
+    FrameGraphHandle occlusion = frameGraphCreateTexture(graph, "ambient occlusion",
+        rhiTexture2DDesc(RHI_FORMAT_R32_FLOAT, width, height, RHI_RESOURCE_FLAG_UNORDERED_ACCESS));
+    FrameGraphHandle hdr = frameGraphCreateTexture(graph, "hdr", rhiTexture2DDesc(RHI_FORMAT_RGBA16_FLOAT, width, height, targetFlags));
+    FrameGraphHandle debugView = frameGraphCreateTexture(graph, "debug view", rhiTexture2DDesc(RHI_FORMAT_RGBA8_UNORM, width, height, targetFlags));
+    FrameGraphHandle bloomDown = frameGraphCreateTexture(graph, "bloom down",
+        rhiTexture2DDesc(RHI_FORMAT_RGBA16_FLOAT, width / 2, height / 2, targetFlags));
+    FrameGraphHandle bloomBlur = frameGraphCreateTexture(graph, "bloom blur",
+        rhiTexture2DDesc(RHI_FORMAT_RGBA16_FLOAT, width / 2, height / 2, targetFlags));
+    FrameGraphHandle output = frameGraphImport(graph, "back buffer", backBuffer, RHI_STATE_PRESENT);
+
+    frameGraphAddPass(graph, "shadows", drawPass, pipelines);
+    frameGraphWrite(graph, shadowMap, RHI_STATE_DEPTH_WRITE);
+
+    frameGraphAddPass(graph, "gbuffer", drawPass, pipelines);
+    frameGraphWrite(graph, albedo, RHI_STATE_RENDER_TARGET);
+    frameGraphWrite(graph, normals, RHI_STATE_RENDER_TARGET);
+    frameGraphWrite(graph, depth, RHI_STATE_DEPTH_WRITE);
+
+    frameGraphAddPass(graph, "ambient occlusion", dispatchPass, pipelines);
+    frameGraphRead(graph, depth, RHI_STATE_NON_PIXEL_SHADER_RESOURCE);
+    frameGraphRead(graph, normals, RHI_STATE_NON_PIXEL_SHADER_RESOURCE);
+    frameGraphWrite(graph, occlusion, RHI_STATE_UNORDERED_ACCESS);
+
+    frameGraphAddPass(graph, "occlusion blur", dispatchPass, pipelines);
+    frameGraphRead(graph, occlusion, RHI_STATE_UNORDERED_ACCESS);
+    frameGraphWrite(graph, occlusion, RHI_STATE_UNORDERED_ACCESS);
+
+    frameGraphAddPass(graph, "lighting", drawPass, pipelines);
+    frameGraphRead(graph, albedo, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphRead(graph, normals, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphRead(graph, depth, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphRead(graph, shadowMap, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphRead(graph, occlusion, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphWrite(graph, hdr, RHI_STATE_RENDER_TARGET);
+
+    frameGraphAddPass(graph, "debug normals", drawPass, pipelines);
+    frameGraphRead(graph, normals, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphWrite(graph, debugView, RHI_STATE_RENDER_TARGET);
+
+    frameGraphAddPass(graph, "bloom down", drawPass, pipelines);
+    frameGraphRead(graph, hdr, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphWrite(graph, bloomDown, RHI_STATE_RENDER_TARGET);
+
+    frameGraphAddPass(graph, "bloom blur", drawPass, pipelines);
+    frameGraphRead(graph, bloomDown, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphWrite(graph, bloomBlur, RHI_STATE_RENDER_TARGET);
+
+    frameGraphAddPass(graph, "tonemap", drawPass, pipelines);
+    frameGraphRead(graph, hdr, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphRead(graph, bloomBlur, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraphWrite(graph, output, RHI_STATE_RENDER_TARGET);
+}
+
+void benchFrameGraph()
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 0;
+    RhiDevice* device = rhiCreateDevice(config);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+
+    Pipelines pipelines;
+    RhiPipelineDesc pipelineDesc;
+    pipelines.graphics = rhiCreatePipeline(device, pipelineDesc, "bench pipeline");
+    static const uint8 computeShader[4] = {};
+    pipelineDesc.computeShader = computeShader;
+    pipelineDesc.computeShaderSize = sizeof(computeShader);
+    pipelines.compute = rhiCreatePipeline(device, pipelineDesc, "bench compute");
+
+    // Two buffers standing in for a swapchain, in the registry like the sandbox's
+    ResourceStateRegistry* registry = new ResourceStateRegistry();
+    resourceStateRegistryInitialize(registry);
+    RhiResource* backBuffers[2];
+    for (uint32 i = 0; i < 2; i++)
+    {
+        backBuffers[i] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT,
+            rhiTexture2DDesc(RHI_FORMAT_RGBA8_UNORM, 1920, 1080, RHI_RESOURCE_FLAG_RENDER_TARGET), RHI_STATE_PRESENT, "bench back buffer");
+        resourceStateRegister(registry, backBuffers[i], RHI_STATE_PRESENT);
+    }
+
+    RhiCommandAllocator* allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "bench allocator");
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    RhiCommandList* fixup = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench fixup list");
+    ResourceStateTracker tracker;
+    resourceStateTrackerInitialize(&tracker, registry);
+
+    // Every frame waits for the GPU, so replaced resources can go right away
+    FrameGraph* graph = new FrameGraph();
+    frameGraphInitialize(graph, device, nullptr);
+
+    // The same topology every frame, then a resize every frame
+    const uint32 frames = 2000;
+    float64 compileSeconds[2] = {};
+    float64 executeSeconds = 0.0;
+    uint64 frame = 0;
+    for (uint32 resizing = 0; resizing < 2; resizing++)
+    {
+        for (uint32 i = 0; i < frames; i++, frame++)
+        {
+            bool small = resizing && (i & 1);
+            float64 start = benchNow();
+            declareFrame(graph, backBuffers[frame & 1], small ? 1600 : 1920, small ? 900 : 1080, &pipelines);
+            bool compiled = frameGraphCompile(graph, frame);
+            float64 declared = benchNow();
+            compileSeconds[resizing] += declared - start;
+            if (!compiled)
+            {
+                printf("  frame graph compile failed\n");
+                break;
+            }
+
+            rhiResetCommandAllocator(allocator);
+            start = benchNow();
+            rhiBeginCommandList(list, allocator);
+            resourceStateTrackerBegin(&tracker, list);
+            frameGraphExecute(graph, &tracker);
+            rhiEndCommandList(list);
+            executeSeconds += benchNow() - start;
+
+            RhiCommandList* submission[2];
+            uint32 submissionCount = 0;
+            rhiBeginCommandList(fixup, allocator);
+            if (resourceStateResolve(&tracker, fixup))
+            {
+                submission[submissionCount++] = fixup;
+            }
+            rhiEndCommandList(fixup);
+            submission[submissionCount++] = list;
+            rhiQueueSubmit(queue, submission, submissionCount);
+            rhiQueueSignal(queue, fence, frame + 1);
+            rhiFenceWait(fence, frame + 1);
+        }
+    }
+
+    FrameGraphStats stats;
+    frameGraphGetStats(graph, &stats);
+    RhiNullStats nullStats;
+    rhiNullGetStats(device, &nullStats);
+
+    benchReport("declare + compile, same topology", frames, compileSeconds[0]);
+    benchReport("declare + compile, resized every frame", frames, compileSeconds[1]);
+    benchReport("execute", 2 * frames, executeSeconds);
+    printf("  %-48s %10llu compiles, %llu cache hits\n", "",
+        (unsigned long long)stats.compiles, (unsigned long long)stats.cacheHits);
+    printf("  %-48s %10u passes, %u culled, %u transient resources, %u culled, %u barriers per frame\n", "",
+        stats.passes, stats.culledPasses, stats.transientResources, stats.culledResources, stats.barriers);
+    printf("  %-48s %10.2f MB transient without aliasing, %.2f MB aliased, %.2f MB peak live\n", "",
+        stats.transientBytes / (1024.0 * 1024.0), stats.aliasedBytes / (1024.0 * 1024.0), stats.peakLiveBytes / (1024.0 * 1024.0));
+    printf("  %-48s %10llu barriers replayed by the null GPU, %llu with the wrong before state%s\n", "",
+        (unsigned long long)nullStats.barriers, (unsigned long long)nullStats.barrierMismatches,
+        nullStats.barrierMismatches ? " (FRAME GRAPH BUG)" : "");
+
+    frameGraphShutdown(graph);
+    delete graph;
+    resourceStateTrackerShutdown(&tracker);
+    rhiDestroyCommandList(fixup);
+    rhiDestroyCommandList(list);
+    rhiDestroyCommandAllocator(allocator);
+    for (uint32 i = 0; i < 2; i++)
+    {
+        resourceStateUnregister(registry, backBuffers[i]);
+        rhiDestroyResource(backBuffers[i]);
+    }
+    resourceStateRegistryShutdown(registry);
+    delete registry;
+    rhiDestroyPipeline(pipelines.compute);
+    rhiDestroyPipeline(pipelines.graphics);
+    rhiDestroyFence(fence);
+    rhiDestroyDevice(device);
+}
@@ -0,0 +1,58 @@
+#include "benchmark.h"
+#include "frame_pacer.h"
+
+// Stands in for recording and presenting a frame: busy work for about workMs
+static void simulateFrameWork(float64 workMs)
+{
+    float64 end = benchNow() + workMs * 1e-3;
+    uint64 iterations = 0;
+    while (benchNow() < end)
+    {
+        iterations++;
+    }
+    benchDoNotOptimize(iterations);
+}
+
+static void runCase(const char* name, FramePacerConfig config, bool active, float64 seconds)
+{
+    FramePacer pacer;
+    framePacerInitialize(&pacer, config);
+    framePacerSetActive(&pacer, active);
+
+    float64 end = benchNow() + seconds;
+    while (benchNow() < end)
+    {
+        simulateFrameWork(2.0);
+        framePacerEndFrame(&pacer);
+    }
+
+    FramePacerStats stats;
+    framePacerGetStats(&pacer, &stats);
+    printf("  %-40s %7.1f fps %6.1f%% cpu  frame %7.3f ms  jitter %6.3f ms  max %7.3f ms  margin %5.2f ms\n",
+        name, (float64)stats.frames / stats.wallSeconds, stats.cpuUtilization * 100.0,
+        stats.averageFrameMs, stats.jitterMs, stats.maxFrameMs, stats.spinMarginMs);
+    framePacerShutdown(&pacer);
+}
+
+void benchFramePacer()
+{
+    const float64 seconds = 1.5;
+
+    FramePacerConfig uncapped;
+    runCase("uncapped", uncapped, true, seconds);
+
+    FramePacerConfig sleepOnly;
+    sleepOnly.targetFps = 120.0;
+    sleepOnly.spinMarginMs = 0.0;
+    sleepOnly.adaptiveSpin = false;
+    runCase("120 fps, sleep only", sleepOnly, true, seconds);
+
+    FramePacerConfig paced;
+    paced.targetFps = 120.0;
+    runCase("120 fps, sleep then spin", paced, true, seconds);
+
+    runCase("120 fps, inactive (30 fps)", paced, false, seconds);
+
+    uncapped.inactiveFps = 30.0;
+    runCase("uncapped, inactive (30 fps)", uncapped, false, seconds);
+}
@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "benchmark.h"
+#include "frame_timing.h"
+
+static const uint32 frameCount = 200000;
+static const char* benchCsvPath = "bench_frame_timing.csv";
+
+// Deterministic frame times: 8 ms frames with noise and a long frame every 500
+static uint32 syntheticMicroseconds(uint32 frame)
+{
+    uint32 noise = (frame * 2654435761u) >> 22;
+    return 8000 + noise + ((frame % 500) == 499 ? 25000 : 0);
+}
+
+// The straightforward alternative: copy the window and sort it for every query
+static float64 sortedPercentile(const std::vector<uint32>& window, float64 percentile)
+{
+    std::vector<uint32> sorted(window);
+    std::sort(sorted.begin(), sorted.end());
+    uint64 rank = (uint64)(percentile * 0.01 * (float64)sorted.size() + 0.5);
+    rank = rank < 1 ? 1 : rank;
+    return (float64)sorted[rank - 1] * 1e-3;
+}
+
+void benchFrameTiming()
+{
+    FrameTiming* timing = new FrameTiming();
+    FrameTimingConfig config;
+    frameTimingInitialize(timing, config);
+
+    // Instrumentation cost: a frame with three phases marked
+    float64 start = benchNow();
+    for (uint32 i = 0; i < frameCount; i++)
+    {
+        frameTimingBeginFrame(timing);
+        frameTimingBeginPhase(timing, FRAME_TIMING_RECORD);
+        frameTimingEndPhase(timing, FRAME_TIMING_RECORD);
+        frameTimingBeginPhase(timing, FRAME_TIMING_SUBMIT);
+        frameTimingEndPhase(timing, FRAME_TIMING_SUBMIT);
+        frameTimingBeginPhase(timing, FRAME_TIMING_WAIT);
+        frameTimingEndPhase(timing, FRAME_TIMING_WAIT);
+        frameTimingEndFrame(timing);
+    }
+    benchReport("instrumented frame (3 phases)", frameCount, benchNow() - start);
+
+    // Fill the window with known frame times by driving the samples directly
+    frameTimingReset(timing);
+    std::vector<uint32> window;
+    for (uint32 i = 0; i < FRAME_TIMING_WINDOW * 4; i++)
+    {
+        frameTimingBeginFrame(timing);
+        timing->frameStart = frameTimingNow() - (int64)syntheticMicroseconds(i) * 1000;
+        frameTimingEndFrame(timing);
+    }
+    for (uint32 i = FRAME_TIMING_WINDOW * 3; i < FRAME_TIMING_WINDOW * 4; i++)
+    {
+        window.push_back(syntheticMicroseconds(i));
+    }
+
+    const uint32 queries = 20000;
+    float64 histogramP99 = 0.0;
+    start = benchNow();
+    for (uint32 i = 0; i < queries; i++)
+    {
+        histogramP99 = frameTimingPercentile(timing, FRAME_TIMING_WALL, 99.0);
+        benchDoNotOptimize(histogramP99);
+    }
+    benchReport("p99 query, histogram", queries, benchNow() - start);
+
+    float64 sortedP99 = 0.0;
+    start = benchNow();
+    for (uint32 i = 0; i < queries; i++)
+    {
+        sortedP99 = sortedPercentile(window, 99.0);
+        benchDoNotOptimize(sortedP99);
+    }
+    benchReport("p99 query, copy and sort", queries, benchNow() - start);
+
+    FrameTimingStats stats;
+    frameTimingGetStats(timing, &stats);
+    const FrameTimingPhaseStats& wall = stats.phases[FRAME_TIMING_WALL];
+    printf("  wall p50 %.3f (exact %.3f) p95 %.3f (exact %.3f) p99 %.3f (exact %.3f) max %.3f ms, %llu hitches\n",
+        wall.p50Ms, sortedPercentile(window, 50.0), wall.p95Ms, sortedPercentile(window, 95.0),
+        histogramP99, sortedP99, wall.maxMs, (unsigned long long)stats.hitches);
+
+    start = benchNow();
+    bool written = frameTimingWriteCsv(timing, benchCsvPath);
+    benchReport("csv dump of the window", written ? FRAME_TIMING_WINDOW : 0, benchNow() - start);
+    remove(benchCsvPath);
+
+    delete timing;
+}
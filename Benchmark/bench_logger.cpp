@@ -0,0 +1,192 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "logger.h"
+
+static const uint32 messagesPerThread = 200000;
+static const char* benchLogPath = "bench_logger.txt";
+
+// The synchronous logOutput as it was before the async backend: two 32000 byte stack buffers,
+// two formatting passes and the write on the calling thread. Console calls are replaced by a file
+// write so the numbers compare formatting and queuing rather than terminal speed.
+static FILE* legacyFile = nullptr;
+
+static void legacyLogOutput(e_logLevel level, const char* message, ...)
+{
+    const char* levelString[6] = { "[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: " };
+
+    const int32 msgLength = 32000;
+    char outMessage[msgLength];
+    char outputMessage[msgLength];
+    memset(outMessage, 0, sizeof(outMessage));
+
+    va_list argPtr;
+    va_start(argPtr, message);
+    vsnprintf(outMessage, msgLength, message, argPtr);
+    va_end(argPtr);
+
+    snprintf(outputMessage, msgLength, "%s%s\n", levelString[level], outMessage);
+    fwrite(outputMessage, 1, strlen(outputMessage), legacyFile);
+}
+
+typedef void (*PFN_logCall)(uint32 thread, uint32 index);
+
+static void legacyCall(uint32 thread, uint32 index)
+{
+    legacyLogOutput(LOG_LEVEL_INFO, "frame %u thread %u: drew %d objects in %.3f ms", index, thread, (int32)(index & 1023), index * 0.001);
+}
+
+static void engineCall(uint32 thread, uint32 index)
+{
+    logOutput(LOG_LEVEL_INFO, "frame %u thread %u: drew %d objects in %.3f ms", index, thread, (int32)(index & 1023), index * 0.001);
+}
+
+static void binaryCall(uint32 thread, uint32 index)
+{
+    SGSLOG_BINARY(LOG_LEVEL_INFO, "frame %u thread %u: drew %d objects in %.3f ms", index, thread, (int32)(index & 1023), index * 0.001);
+}
+
+static uint64 fileSize(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    uint64 size = (uint64)ftell(file);
+    fclose(file);
+    return size;
+}
+
+// Returns the slowest producer's time spent inside log calls.
+static float64 runProducers(uint32 threadCount, PFN_logCall call)
+{
+    std::vector<std::thread> threads;
+    std::vector<float64> elapsed(threadCount, 0.0);
+
+    for (uint32 t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([t, call, &elapsed]() {
+            float64 start = benchNow();
+            for (uint32 i = 0; i < messagesPerThread; i++)
+            {
+                call(t, i);
+            }
+            elapsed[t] = benchNow() - start;
+        });
+    }
+
+    float64 slowest = 0.0;
+    for (uint32 t = 0; t < threadCount; t++)
+    {
+        threads[t].join();
+        slowest = elapsed[t] > slowest ? elapsed[t] : slowest;
+    }
+    return slowest;
+}
+
+typedef enum e_benchLogMode {
+    BENCH_LOG_LEGACY,
+    BENCH_LOG_SYNC,
+    BENCH_LOG_ASYNC,
+    BENCH_LOG_ASYNC_BINARY
+}e_benchLogMode;
+
+static void runCase(const char* name, uint32 threadCount, e_benchLogMode mode)
+{
+    char label[128];
+    uint64 total = (uint64)messagesPerThread * threadCount;
+
+    float64 start = benchNow();
+    float64 callerTime;
+    if (mode == BENCH_LOG_LEGACY)
+    {
+        legacyFile = fopen(benchLogPath, "wb");
+        callerTime = runProducers(threadCount, legacyCall);
+        fflush(legacyFile);
+        fclose(legacyFile);
+    }
+    else
+    {
+        bool binary = mode == BENCH_LOG_ASYNC_BINARY;
+        logAddSink(binary ? logBinaryFileSink(benchLogPath) : logFileSink(benchLogPath));
+        LogConfig config;
+        config.async = mode != BENCH_LOG_SYNC;
+        config.ringCapacity = 4096;
+        logInitialize(config);
+        callerTime = runProducers(threadCount, binary ? binaryCall : engineCall);
+        logShutdown();
+    }
+    float64 totalTime = benchNow() - start;
+    uint64 bytes = fileSize(benchLogPath);
+
+    snprintf(label, sizeof(label), "%s, %u thread(s), caller", name, threadCount);
+    benchReport(label, total, callerTime);
+    snprintf(label, sizeof(label), "%s, %u thread(s), end to end", name, threadCount);
+    benchReport(label, total, totalTime);
+    printf("  %-48s %10.1f bytes/msg\n", "", (float64)bytes / (float64)total);
+}
+
+static float64 expensiveArgument(uint32 index)
+{
+    float64 value = 0.0;
+    for (uint32 i = 0; i < 64; i++)
+    {
+        value += (float64)(index ^ i) * 0.5;
+    }
+    return value;
+}
+
+// A filtered-out call must not evaluate its arguments, and a rate limited one must not reach the rings.
+static void runFilterCases()
+{
+    const uint32 iterations = 10000000;
+    logSetCategoryLevel(LOG_CATEGORY_RENDER, LOG_LEVEL_WARN);
+
+    float64 start = benchNow();
+    for (uint32 i = 0; i < iterations; i++)
+    {
+        SGSTRACE_CAT(LOG_CATEGORY_RENDER, "value %f", expensiveArgument(i));
+    }
+    benchReport("category disabled at runtime", iterations, benchNow() - start);
+
+    logSetCategoryLevel(LOG_CATEGORY_RENDER, LOG_LEVEL_TRACE);
+    logSetCategoryRateLimit(LOG_CATEGORY_RENDER, 10);
+    LogMemoryBuffer memory;
+    char storage[4096];
+    memory.data = storage;
+    memory.capacity = sizeof(storage);
+    logAddSink(logMemorySink(&memory));
+    LogConfig config;
+    logInitialize(config);
+
+    start = benchNow();
+    for (uint32 i = 0; i < iterations; i++)
+    {
+        SGSTRACE_CAT(LOG_CATEGORY_RENDER, "frame %u", i);
+    }
+    benchReport("rate limited to 10/s per call site", iterations, benchNow() - start);
+
+    logShutdown();
+    logSetCategoryRateLimit(LOG_CATEGORY_RENDER, 0);
+}
+
+void benchLogger()
+{
+    uint32 threadCounts[] = { 1, 4 };
+    for (uint32 threadCount : threadCounts)
+    {
+        runCase("legacy sync", threadCount, BENCH_LOG_LEGACY);
+        runCase("sync", threadCount, BENCH_LOG_SYNC);
+        runCase("async", threadCount, BENCH_LOG_ASYNC);
+        runCase("async binary", threadCount, BENCH_LOG_ASYNC_BINARY);
+    }
+    remove(benchLogPath);
+
+    runFilterCases();
+}
\ No newline at end of file
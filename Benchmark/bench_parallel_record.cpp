@@ -0,0 +1,86 @@
+#include <thread>
+
+#include "benchmark.h"
+#include "parallel_record.h"
+
+static const uint32 jobCount = 64;
+
+struct DrawRange
+{
+    uint32 drawCount;
+};
+
+// Job i records its share of the frame's draws, each with its own constants
+static void recordRange(RhiCommandList* list, uint32 job, void* userData)
+{
+    const DrawRange* range = (const DrawRange*)userData;
+    uint32 first = range->drawCount * job / jobCount;
+    uint32 last = range->drawCount * (job + 1) / jobCount;
+    for (uint32 draw = first; draw < last; draw++)
+    {
+        uint32 constants[4] = { draw, job, draw ^ job, 0 };
+        rhiCmdSetConstants(list, constants, 4, 0);
+        rhiCmdDraw(list, 36, 1, 0, 0);
+    }
+}
+
+static void runRecording(uint32 drawCount, uint32 threads)
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 0;
+    RhiDevice* device = rhiCreateDevice(config);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+    ParallelRecorder* recorder = new ParallelRecorder();
+    parallelRecorderInitialize(recorder, device, queue, fence, threads);
+
+    DrawRange range = { drawCount };
+    const uint32 frames = 20;
+    uint64 fenceValue = 0;
+    float64 recordSeconds = 0.0;
+    float64 submitSeconds = 0.0;
+    for (uint32 frame = 0; frame < frames; frame++)
+    {
+        float64 start = benchNow();
+        parallelRecord(recorder, jobCount, recordRange, &range);
+        float64 recorded = benchNow();
+        parallelRecordSubmit(recorder, ++fenceValue);
+        rhiQueueSignal(queue, fence, fenceValue);
+        submitSeconds += benchNow() - recorded;
+        recordSeconds += recorded - start;
+        // Two frames in flight: allocators from two frames back are free again
+        if (fenceValue > 2)
+        {
+            rhiFenceWait(fence, fenceValue - 2);
+        }
+    }
+    rhiFenceWait(fence, fenceValue);
+
+    ParallelRecordStats stats;
+    parallelRecorderGetStats(recorder, &stats);
+    char label[96];
+    snprintf(label, sizeof(label), "%uk draws, %u thread(s), record per draw", drawCount / 1000, threads);
+    benchReport(label, (uint64)frames * drawCount, recordSeconds);
+    printf("  %-48s %10.2f ms/frame recording, %.2f ms submitting, %u allocators\n", "",
+        recordSeconds * 1000.0 / frames, submitSeconds * 1000.0 / frames, stats.allocatorsCreated);
+
+    parallelRecorderShutdown(recorder);
+    delete recorder;
+    rhiDestroyFence(fence);
+    rhiDestroyDevice(device);
+}
+
+void benchParallelRecord()
+{
+    uint32 hardwareThreads = std::thread::hardware_concurrency();
+    printf("  %u hardware thread(s)\n", hardwareThreads);
+    uint32 drawCounts[] = { 10000, 50000, 100000 };
+    uint32 threadCounts[] = { 1, 2, 4, 8 };
+    for (uint32 drawCount : drawCounts)
+    {
+        for (uint32 threads : threadCounts)
+        {
+            runRecording(drawCount, threads);
+        }
+    }
+}
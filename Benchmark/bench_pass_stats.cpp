@@ -0,0 +1,164 @@
+#include "benchmark.h"
+#include "pass_stats.h"
+#include "validation.h"
+
+struct SyntheticFrame
+{
+    RhiResource* targets[2];
+    RhiResource* upload;
+    RhiResource* constants;
+    RhiPipeline* pipeline;
+    RhiPipeline* compute;
+    uint32 drawCount;
+};
+
+// A small deferred frame: upload, shadow and geometry draws, a lighting dispatch and a post pass
+static void recordFrame(RhiCommandList* list, const SyntheticFrame& frame)
+{
+    rhiCmdBeginPass(list, "upload");
+    rhiCmdCopyBuffer(list, frame.constants, 0, frame.upload, 0, 64 * 1024);
+    RhiBarrier toConstants = rhiTransition(frame.constants, RHI_STATE_COPY_DEST, RHI_STATE_COMMON);
+    rhiCmdBarriers(list, &toConstants, 1);
+
+    const char* geometryPasses[] = { "shadows", "gbuffer" };
+    for (const char* name : geometryPasses)
+    {
+        rhiCmdBeginPass(list, name);
+        float32 clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        rhiCmdClearRenderTarget(list, frame.targets[0], clearColor);
+        rhiCmdSetRenderTargets(list, frame.targets, 1, nullptr);
+        rhiCmdSetPipeline(list, frame.pipeline);
+        for (uint32 draw = 0; draw < frame.drawCount; draw++)
+        {
+            rhiCmdSetConstants(list, &draw, 1, 0);
+            rhiCmdDraw(list, 36, 1, 0, 0);
+        }
+    }
+
+    rhiCmdBeginPass(list, "lighting");
+    RhiBarrier toRead = rhiTransition(frame.targets[0], RHI_STATE_RENDER_TARGET, RHI_STATE_PIXEL_SHADER_RESOURCE);
+    rhiCmdBarriers(list, &toRead, 1);
+    rhiCmdSetPipeline(list, frame.compute);
+    rhiCmdDispatch(list, 120, 68, 1);
+    rhiCmdAddCounter(list, RHI_COUNTER_DESCRIPTOR_COPIES, 8);
+
+    rhiCmdBeginPass(list, "post");
+    RhiBarrier restore[2] = {
+        rhiTransition(frame.targets[0], RHI_STATE_PIXEL_SHADER_RESOURCE, RHI_STATE_RENDER_TARGET),
+        rhiTransition(frame.constants, RHI_STATE_COMMON, RHI_STATE_COPY_DEST)
+    };
+    rhiCmdBarriers(list, restore, 2);
+    rhiCmdSetRenderTargets(list, &frame.targets[1], 1, nullptr);
+    rhiCmdSetPipeline(list, frame.pipeline);
+    rhiCmdDraw(list, 3, 1, 0, 0);
+    rhiCmdEndPass(list);
+}
+
+static float64 runFrames(RhiDevice* device, const SyntheticFrame& frame, PassStats* stats, uint32 frames, float64* aggregateSeconds)
+{
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiCommandAllocator* allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "bench allocator");
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+
+    float64 recordSeconds = 0.0;
+    *aggregateSeconds = 0.0;
+    for (uint32 i = 0; i < frames; i++)
+    {
+        rhiResetCommandAllocator(allocator);
+        float64 start = benchNow();
+        rhiBeginCommandList(list, allocator);
+        recordFrame(list, frame);
+        rhiEndCommandList(list);
+        float64 recorded = benchNow();
+        passStatsAddList(stats, list);
+        passStatsEndFrame(stats, i);
+        *aggregateSeconds += benchNow() - recorded;
+        recordSeconds += recorded - start;
+
+        rhiQueueSubmit(queue, &list, 1);
+        rhiQueueSignal(queue, fence, i + 1);
+        rhiFenceWait(fence, i + 1);
+    }
+
+    rhiDestroyFence(fence);
+    rhiDestroyCommandList(list);
+    rhiDestroyCommandAllocator(allocator);
+    return recordSeconds;
+}
+
+void benchPassStats()
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 0;
+    RhiDevice* device = rhiCreateDevice(config);
+
+    SyntheticFrame frame;
+    RhiResourceDesc targetDesc = rhiTexture2DDesc(RHI_FORMAT_RGBA8_UNORM, 1920, 1080, RHI_RESOURCE_FLAG_RENDER_TARGET);
+    frame.targets[0] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, targetDesc, RHI_STATE_RENDER_TARGET, "bench gbuffer");
+    frame.targets[1] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, targetDesc, RHI_STATE_RENDER_TARGET, "bench output");
+    frame.upload = rhiCreateCommittedResource(device, RHI_HEAP_UPLOAD, rhiBufferDesc(64 * 1024), RHI_STATE_GENERIC_READ, "bench upload");
+    frame.constants = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, rhiBufferDesc(64 * 1024), RHI_STATE_COPY_DEST, "bench constants");
+    RhiPipelineDesc pipelineDesc;
+    pipelineDesc.rootConstantCount = 1;
+    frame.pipeline = rhiCreatePipeline(device, pipelineDesc, "bench pipeline");
+    static const uint8 computeShader[4] = {};
+    pipelineDesc.computeShader = computeShader;
+    pipelineDesc.computeShaderSize = sizeof(computeShader);
+    frame.compute = rhiCreatePipeline(device, pipelineDesc, "bench compute");
+    frame.drawCount = 5000;
+
+    // Counting is the only difference between the runs; validation stays off so it isn't measured
+    PassStats* stats = new PassStats();
+    const uint32 frames = 200;
+    uint64 commandsPerFrame = 2 * (3 + 2 * (uint64)frame.drawCount) + 9;
+    e_validationTier previousTier = validationTier;
+    validationTier = VALIDATION_TIER_OFF;
+    bool counting[] = { false, true };
+    for (bool enabled : counting)
+    {
+        rhiPassCountersEnabled = enabled;
+        passStatsInitialize(stats);
+        float64 aggregateSeconds = 0.0;
+        float64 recordSeconds = runFrames(device, frame, stats, frames, &aggregateSeconds);
+        char label[96];
+        snprintf(label, sizeof(label), "record per command, pass counters %s", enabled ? "on" : "off");
+        benchReport(label, frames * commandsPerFrame, recordSeconds);
+        printf("  %-48s %10.2f us/frame merging passes\n", "", aggregateSeconds * 1e6 / frames);
+    }
+    validationTier = previousTier;
+
+    const PassStatsFrame* last = passStatsGetFrame(stats, 0);
+    printf("  %-10s", "pass");
+    for (uint32 counter = 0; counter < RHI_COUNTER_COUNT; counter++)
+    {
+        printf(" %10.10s", rhiCounterName((e_rhiCounter)counter));
+    }
+    printf("\n");
+    for (uint32 i = 0; i <= last->passCount; i++)
+    {
+        const RhiPassCounters& pass = i < last->passCount ? last->passes[i] : last->total;
+        printf("  %-10s", passStatsPassName(pass));
+        for (uint32 counter = 0; counter < RHI_COUNTER_COUNT; counter++)
+        {
+            printf(" %10llu", (unsigned long long)pass.values[counter]);
+        }
+        printf("\n");
+    }
+
+    float64 start = benchNow();
+    bool written = passStatsWriteCsv(stats, "bench_pass_stats.csv") && passStatsWriteJson(stats, "bench_pass_stats.json");
+    printf("  %-48s %10.2f ms writing %u frames as CSV and JSON%s\n", "", (benchNow() - start) * 1e3,
+        PASS_STATS_HISTORY, written ? "" : " (failed)");
+    remove("bench_pass_stats.csv");
+    remove("bench_pass_stats.json");
+
+    delete stats;
+    rhiDestroyPipeline(frame.compute);
+    rhiDestroyPipeline(frame.pipeline);
+    rhiDestroyResource(frame.constants);
+    rhiDestroyResource(frame.upload);
+    rhiDestroyResource(frame.targets[1]);
+    rhiDestroyResource(frame.targets[0]);
+    rhiDestroyDevice(device);
+}
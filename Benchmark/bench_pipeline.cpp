@@ -0,0 +1,111 @@
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "render_snapshot.h"
+#include "scene.h"
+
+static const uint32 objectCount = 50000;
+static const uint32 frameCount = 200;
+// Stands in for the fence wait on a GPU that needs this long per frame
+static const float64 gpuMilliseconds = 4.0;
+
+// The headless half of a renderer: one model-view-projection per draw, written to a command
+// buffer, then a wait for the "GPU"
+static void recordAndSubmit(const RenderSnapshot* snapshot, std::vector<float32>& commands)
+{
+    for (uint32 i = 0; i < snapshot->drawCount; i++)
+    {
+        const RenderDraw& draw = snapshot->draws[i];
+        matrixMultiply(&commands[i * 16], snapshot->camera.viewProjection, snapshot->transforms[draw.transform].world);
+    }
+    benchDoNotOptimize(commands[0]);
+    std::this_thread::sleep_for(std::chrono::microseconds((int64)(gpuMilliseconds * 1000.0)));
+}
+
+static float64 runSerial(float64* simulationMs, float64* renderMs)
+{
+    Scene scene;
+    sceneInitialize(&scene, objectCount, 7);
+    SnapshotExchange exchange;
+    snapshotExchangeInitialize(&exchange, objectCount);
+    std::vector<float32> commands(objectCount * 16);
+
+    float64 simulation = 0.0;
+    float64 render = 0.0;
+    float64 start = benchNow();
+    for (uint32 frame = 0; frame < frameCount; frame++)
+    {
+        float64 stepStart = benchNow();
+        RenderSnapshot* snapshot = snapshotBeginWrite(&exchange);
+        sceneUpdate(&scene, 1.0f / 60.0f);
+        sceneWriteSnapshot(&scene, snapshot);
+        snapshotPublish(&exchange);
+        float64 stepEnd = benchNow();
+        simulation += stepEnd - stepStart;
+
+        const RenderSnapshot* rendered = snapshotAcquire(&exchange);
+        recordAndSubmit(rendered, commands);
+        snapshotRelease(&exchange);
+        render += benchNow() - stepEnd;
+    }
+    float64 total = benchNow() - start;
+
+    *simulationMs = simulation * 1e3 / frameCount;
+    *renderMs = render * 1e3 / frameCount;
+    snapshotExchangeShutdown(&exchange);
+    sceneShutdown(&scene);
+    return total;
+}
+
+static float64 runPipelined(float64* simulationWait, float64* renderWait)
+{
+    Scene scene;
+    sceneInitialize(&scene, objectCount, 7);
+    SnapshotExchange exchange;
+    snapshotExchangeInitialize(&exchange, objectCount);
+    std::vector<float32> commands(objectCount * 16);
+
+    float64 start = benchNow();
+    std::thread renderThread([&]() {
+        for (uint32 frame = 0; frame < frameCount; frame++)
+        {
+            const RenderSnapshot* snapshot = snapshotAcquire(&exchange);
+            recordAndSubmit(snapshot, commands);
+            snapshotRelease(&exchange);
+        }
+    });
+
+    for (uint32 frame = 0; frame < frameCount; frame++)
+    {
+        RenderSnapshot* snapshot = snapshotBeginWrite(&exchange);
+        sceneUpdate(&scene, 1.0f / 60.0f);
+        sceneWriteSnapshot(&scene, snapshot);
+        snapshotPublish(&exchange);
+    }
+    renderThread.join();
+    float64 total = benchNow() - start;
+
+    *simulationWait = exchange.simulationWaitSeconds;
+    *renderWait = exchange.renderWaitSeconds;
+    snapshotExchangeShutdown(&exchange);
+    sceneShutdown(&scene);
+    return total;
+}
+
+void benchPipeline()
+{
+    printf("  %u objects, %u frames, %.1f ms simulated GPU time, %u hardware threads\n",
+        objectCount, frameCount, gpuMilliseconds, std::thread::hardware_concurrency());
+
+    float64 simulationMs, renderMs;
+    float64 serial = runSerial(&simulationMs, &renderMs);
+    benchReport("serial frame", frameCount, serial);
+    printf("  %-48s %10.3f ms simulate, %.3f ms record + GPU\n", "", simulationMs, renderMs);
+
+    float64 simulationWait, renderWait;
+    float64 pipelined = runPipelined(&simulationWait, &renderWait);
+    benchReport("pipelined frame", frameCount, pipelined);
+    printf("  %-48s %10.2fx throughput, waits: simulation %.3f s, render %.3f s\n", "",
+        serial / pipelined, simulationWait, renderWait);
+}
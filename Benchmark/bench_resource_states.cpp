@@ -0,0 +1,195 @@
+#include "benchmark.h"
+#include "resource_states.h"
+
+static const uint32 textureCount = 32;
+static const uint32 bufferCount = 32;
+static const uint32 listCount = 4;
+static const uint32 transitionsPerList = 2000;
+// Transitions between two flushes, the draws or dispatches that need them
+static const uint32 transitionsPerFlush = 4;
+
+static const uint32 textureStates[] = { RHI_STATE_RENDER_TARGET, RHI_STATE_PIXEL_SHADER_RESOURCE, RHI_STATE_SHADER_RESOURCE,
+    RHI_STATE_UNORDERED_ACCESS, RHI_STATE_COPY_SOURCE, RHI_STATE_COPY_DEST };
+static const uint32 bufferStates[] = { RHI_STATE_NON_PIXEL_SHADER_RESOURCE, RHI_STATE_UNORDERED_ACCESS,
+    RHI_STATE_COPY_SOURCE, RHI_STATE_COPY_DEST, RHI_STATE_VERTEX_AND_CONSTANT_BUFFER };
+static const uint32 textureStateCount = sizeof(textureStates) / sizeof(textureStates[0]);
+static const uint32 bufferStateCount = sizeof(bufferStates) / sizeof(bufferStates[0]);
+
+struct Random
+{
+    uint64 state;
+};
+
+static uint32 nextRandom(Random* random, uint32 range)
+{
+    random->state = random->state * 6364136223846793005ull + 1442695040888963407ull;
+    return (uint32)(random->state >> 33) % range;
+}
+
+// A list's worth of transitions on random resources, mips and slices, with a flush standing in
+// for every draw and now and then a split transition across a few of them
+static void recordList(ResourceStateTracker* tracker, RhiResource* const* resources, Random* random)
+{
+    RhiResource* split = nullptr;
+    for (uint32 i = 0; i < transitionsPerList; i++)
+    {
+        uint32 index = nextRandom(random, textureCount + bufferCount);
+        RhiResource* resource = resources[index];
+        bool texture = index < textureCount;
+        uint32 after = texture ? textureStates[nextRandom(random, textureStateCount)] :
+            bufferStates[nextRandom(random, bufferStateCount)];
+        uint32 subresource = RHI_ALL_SUBRESOURCES;
+        if (texture && nextRandom(random, 2))
+        {
+            subresource = nextRandom(random, rhiSubresourceCount(rhiGetResourceDesc(resource)));
+        }
+
+        if (!split && nextRandom(random, 16) == 0)
+        {
+            resourceStateBeginTransition(tracker, resource, after, subresource);
+            split = resource;
+        }
+        else if (resource != split)
+        {
+            resourceStateTransition(tracker, resource, after, subresource);
+        }
+
+        if (i % transitionsPerFlush == transitionsPerFlush - 1)
+        {
+            if (split && nextRandom(random, 4) == 0)
+            {
+                resourceStateEndTransition(tracker, split);
+                split = nullptr;
+            }
+            resourceStateFlush(tracker);
+        }
+    }
+    if (split)
+    {
+        resourceStateEndTransition(tracker, split);
+    }
+    resourceStateFlush(tracker);
+}
+
+void benchResourceStates()
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 0;
+    RhiDevice* device = rhiCreateDevice(config);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+
+    ResourceStateRegistry* registry = new ResourceStateRegistry();
+    resourceStateRegistryInitialize(registry);
+    RhiResource* resources[textureCount + bufferCount];
+    for (uint32 i = 0; i < textureCount; i++)
+    {
+        RhiResourceDesc desc = rhiTexture2DDesc(RHI_FORMAT_RGBA8_UNORM, 256, 256,
+            RHI_RESOURCE_FLAG_RENDER_TARGET | RHI_RESOURCE_FLAG_UNORDERED_ACCESS);
+        desc.mipLevels = 4;
+        desc.arraySize = 2;
+        resources[i] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, desc, RHI_STATE_COMMON, "bench texture");
+        resourceStateRegister(registry, resources[i], RHI_STATE_COMMON);
+    }
+    for (uint32 i = 0; i < bufferCount; i++)
+    {
+        RhiResource* buffer = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, rhiBufferDesc(4096, RHI_RESOURCE_FLAG_UNORDERED_ACCESS),
+            RHI_STATE_COMMON, "bench buffer");
+        resources[textureCount + i] = buffer;
+        resourceStateRegister(registry, buffer, RHI_STATE_COMMON);
+    }
+
+    RhiCommandAllocator* allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "bench allocator");
+    RhiCommandList* lists[listCount];
+    RhiCommandList* fixups[listCount];
+    ResourceStateTracker trackers[listCount];
+    for (uint32 i = 0; i < listCount; i++)
+    {
+        lists[i] = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+        fixups[i] = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench fixup list");
+        resourceStateTrackerInitialize(&trackers[i], registry);
+    }
+
+    // Lists are recorded independently, as on worker threads, then resolved in submission order
+    Random random = { 1 };
+    const uint32 frames = 50;
+    float64 recordSeconds = 0.0;
+    float64 resolveSeconds = 0.0;
+    for (uint32 frame = 0; frame < frames; frame++)
+    {
+        rhiResetCommandAllocator(allocator);
+        float64 start = benchNow();
+        for (uint32 i = 0; i < listCount; i++)
+        {
+            rhiBeginCommandList(lists[i], allocator);
+            resourceStateTrackerBegin(&trackers[i], lists[i]);
+            recordList(&trackers[i], resources, &random);
+            rhiEndCommandList(lists[i]);
+        }
+        float64 recorded = benchNow();
+
+        RhiCommandList* submission[2 * listCount];
+        uint32 submissionCount = 0;
+        for (uint32 i = 0; i < listCount; i++)
+        {
+            rhiBeginCommandList(fixups[i], allocator);
+            bool needed = resourceStateResolve(&trackers[i], fixups[i]);
+            rhiEndCommandList(fixups[i]);
+            if (needed)
+            {
+                submission[submissionCount++] = fixups[i];
+            }
+            submission[submissionCount++] = lists[i];
+        }
+        resolveSeconds += benchNow() - recorded;
+        recordSeconds += recorded - start;
+
+        rhiQueueSubmit(queue, submission, submissionCount);
+        rhiQueueSignal(queue, fence, frame + 1);
+        rhiFenceWait(fence, frame + 1);
+    }
+
+    ResourceStateTrackerStats total = {};
+    for (uint32 i = 0; i < listCount; i++)
+    {
+        ResourceStateTrackerStats stats;
+        resourceStateTrackerGetStats(&trackers[i], &stats);
+        total.transitions += stats.transitions;
+        total.merged += stats.merged;
+        total.barriers += stats.barriers;
+        total.flushes += stats.flushes;
+        total.resolvedBarriers += stats.resolvedBarriers;
+        total.fixups += stats.fixups;
+    }
+    RhiNullStats nullStats;
+    rhiNullGetStats(device, &nullStats);
+
+    benchReport("record per transition", total.transitions, recordSeconds);
+    benchReport("resolve per list", (uint64)frames * listCount, resolveSeconds);
+    printf("  %-48s %10.2f barriers per rhiCmdBarriers call, %llu of %llu transitions merged away\n", "",
+        total.flushes ? (float64)total.barriers / total.flushes : 0.0,
+        (unsigned long long)total.merged, (unsigned long long)total.transitions);
+    printf("  %-48s %10llu barrier calls instead of %llu, %llu fixup barriers in %llu fixup lists\n", "",
+        (unsigned long long)total.flushes, (unsigned long long)total.transitions,
+        (unsigned long long)total.resolvedBarriers, (unsigned long long)total.fixups);
+    printf("  %-48s %10llu barriers replayed by the null GPU, %llu with the wrong before state%s\n", "",
+        (unsigned long long)nullStats.barriers, (unsigned long long)nullStats.barrierMismatches,
+        nullStats.barrierMismatches ? " (TRACKER BUG)" : "");
+
+    for (uint32 i = 0; i < listCount; i++)
+    {
+        resourceStateTrackerShutdown(&trackers[i]);
+        rhiDestroyCommandList(fixups[i]);
+        rhiDestroyCommandList(lists[i]);
+    }
+    rhiDestroyCommandAllocator(allocator);
+    for (uint32 i = 0; i < textureCount + bufferCount; i++)
+    {
+        resourceStateUnregister(registry, resources[i]);
+        rhiDestroyResource(resources[i]);
+    }
+    resourceStateRegistryShutdown(registry);
+    delete registry;
+    rhiDestroyFence(fence);
+    rhiDestroyDevice(device);
+}
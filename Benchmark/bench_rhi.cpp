@@ -0,0 +1,118 @@
+#include "benchmark.h"
+#include "rhi.h"
+
+static const uint32 drawsPerList = 10000;
+
+// Recording is what the render thread pays per draw; replay is the null backend's submit
+static void benchRecordAndSubmit()
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 0;
+    RhiDevice* device = rhiCreateDevice(config);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiCommandAllocator* allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "bench allocator");
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+    uint64 fenceValue = 0;
+
+    const uint32 iterations = 50;
+    float64 recordSeconds = 0.0;
+    float64 submitSeconds = 0.0;
+    for (uint32 i = 0; i < iterations; i++)
+    {
+        float64 start = benchNow();
+        rhiResetCommandAllocator(allocator);
+        rhiBeginCommandList(list, allocator);
+        for (uint32 draw = 0; draw < drawsPerList; draw++)
+        {
+            uint32 constants[4] = { draw, draw + 1, draw + 2, draw + 3 };
+            rhiCmdSetConstants(list, constants, 4, 0);
+            rhiCmdDraw(list, 36, 1, 0, 0);
+        }
+        rhiEndCommandList(list);
+        float64 recorded = benchNow();
+        rhiQueueSubmit(queue, &list, 1);
+        submitSeconds += benchNow() - recorded;
+        recordSeconds += recorded - start;
+
+        rhiQueueSignal(queue, fence, ++fenceValue);
+        rhiFenceWait(fence, fenceValue);
+    }
+
+    RhiNullStats stats;
+    rhiNullGetStats(device, &stats);
+    benchReport("record constants + draw", (uint64)iterations * drawsPerList, recordSeconds);
+    benchReport("null submit replay, per draw", (uint64)iterations * drawsPerList, submitSeconds);
+    printf("  %-48s %10.1f bytes/draw\n", "", (float64)stats.streamBytes / (float64)stats.draws);
+
+    rhiDestroyFence(fence);
+    rhiDestroyCommandList(list);
+    rhiDestroyCommandAllocator(allocator);
+    rhiDestroyDevice(device);
+}
+
+// Record, submit, present, then wait for the GPU before the next frame. The modeled GPU takes
+// about 2 ms per frame; bench_frame_contexts runs the same frame without the flush.
+static void benchFlushedFrames()
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 50000;
+    config.null.nanosecondsPerDraw = 1000;
+    RhiDevice* device = rhiCreateDevice(config);
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiCommandAllocator* allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "bench allocator");
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+    uint64 fenceValue = 0;
+    RhiSwapChainDesc swapChainDesc;
+    swapChainDesc.width = 256;
+    swapChainDesc.height = 256;
+    RhiSwapChain* swapChain = rhiCreateSwapChain(device, queue, swapChainDesc);
+
+    const uint32 frames = 200;
+    const float32 clearColor[4] = { 0.1f, 0.2f, 0.3f, 1.0f };
+    float64 waitSeconds = 0.0;
+    float64 start = benchNow();
+    for (uint32 frame = 0; frame < frames; frame++)
+    {
+        rhiResetCommandAllocator(allocator);
+        rhiBeginCommandList(list, allocator);
+        RhiResource* backBuffer = rhiSwapChainBuffer(swapChain, rhiSwapChainCurrentIndex(swapChain));
+        RhiBarrier barrier = rhiTransition(backBuffer, RHI_STATE_PRESENT, RHI_STATE_RENDER_TARGET);
+        rhiCmdBarriers(list, &barrier, 1);
+        rhiCmdClearRenderTarget(list, backBuffer, clearColor);
+        rhiCmdSetRenderTargets(list, &backBuffer, 1, nullptr);
+        for (uint32 draw = 0; draw < 2000; draw++)
+        {
+            rhiCmdDraw(list, 36, 1, 0, 0);
+        }
+        barrier = rhiTransition(backBuffer, RHI_STATE_RENDER_TARGET, RHI_STATE_PRESENT);
+        rhiCmdBarriers(list, &barrier, 1);
+        rhiEndCommandList(list);
+
+        rhiQueueSubmit(queue, &list, 1);
+        rhiPresent(swapChain, 0);
+        rhiQueueSignal(queue, fence, ++fenceValue);
+
+        float64 waitStart = benchNow();
+        rhiFenceWait(fence, fenceValue);
+        waitSeconds += benchNow() - waitStart;
+    }
+    float64 seconds = benchNow() - start;
+
+    benchReport("full flush every frame, per frame", frames, seconds);
+    printf("  %-48s %10.1f frames/s, %.0f%% of the CPU time waiting\n", "",
+        (float64)frames / seconds, 100.0 * waitSeconds / seconds);
+
+    rhiDestroySwapChain(swapChain);
+    rhiDestroyFence(fence);
+    rhiDestroyCommandList(list);
+    rhiDestroyCommandAllocator(allocator);
+    rhiDestroyDevice(device);
+}
+
+void benchRhi()
+{
+    benchRecordAndSubmit();
+    benchFlushedFrames();
+}
@@ -0,0 +1,125 @@
+#include <thread>
+
+#include "benchmark.h"
+#include "startup_graph.h"
+
+// Stand-ins for the Sandbox init tasks: most of their time is spent waiting on the driver, the
+// window system or the disk, which is what a sleep models
+struct SleepTask
+{
+    float64 milliseconds;
+};
+
+static bool sleepTask(void* userData)
+{
+    SleepTask* task = (SleepTask*)userData;
+    std::this_thread::sleep_for(std::chrono::microseconds((int64)(task->milliseconds * 1000.0)));
+    return true;
+}
+
+static bool emptyTask(void* userData)
+{
+    benchDoNotOptimize(userData);
+    return true;
+}
+
+static SleepTask debugLayer = { 2.0 };
+static SleepTask factory = { 3.0 };
+static SleepTask device = { 20.0 };
+static SleepTask fence = { 0.5 };
+static SleepTask commandObjects = { 2.0 };
+static SleepTask window = { 15.0 };
+static SleepTask swapChain = { 8.0 };
+static SleepTask scene = { 5.0 };
+static SleepTask shaderCache = { 25.0 };
+static SleepTask msaaCheck = { 1.0 };
+
+static void buildEngineGraph(StartupGraph* graph)
+{
+    startupGraphInitialize(graph);
+    uint32 debug = startupGraphAddTask(graph, "debug layer", sleepTask, &debugLayer);
+    uint32 dxgi = startupGraphAddTask(graph, "factory", sleepTask, &factory);
+    uint32 logical = startupGraphAddTask(graph, "device", sleepTask, &device);
+    startupGraphAddDependency(graph, logical, debug);
+    startupGraphAddDependency(graph, logical, dxgi);
+    uint32 fenceTask = startupGraphAddTask(graph, "fence", sleepTask, &fence);
+    startupGraphAddDependency(graph, fenceTask, logical);
+    uint32 commands = startupGraphAddTask(graph, "command objects", sleepTask, &commandObjects);
+    startupGraphAddDependency(graph, commands, logical);
+    uint32 msaa = startupGraphAddTask(graph, "msaa check", sleepTask, &msaaCheck, STARTUP_TASK_LAZY);
+    startupGraphAddDependency(graph, msaa, logical);
+    uint32 windowTask = startupGraphAddTask(graph, "window", sleepTask, &window);
+    uint32 swap = startupGraphAddTask(graph, "swapchain", sleepTask, &swapChain);
+    startupGraphAddDependency(graph, swap, windowTask);
+    startupGraphAddDependency(graph, swap, commands);
+    startupGraphAddDependency(graph, swap, fenceTask);
+    startupGraphAddTask(graph, "scene", sleepTask, &scene);
+    uint32 shaders = startupGraphAddTask(graph, "shader cache", sleepTask, &shaderCache);
+    startupGraphAddDependency(graph, shaders, logical);
+}
+
+static void runEngineGraph(const char* label, uint32 threadCount)
+{
+    const uint32 runs = 10;
+    StartupGraphStats total = {};
+    for (uint32 i = 0; i < runs; i++)
+    {
+        StartupGraph* graph = new StartupGraph();
+        buildEngineGraph(graph);
+        startupGraphRun(graph, threadCount);
+
+        StartupGraphStats stats;
+        startupGraphGetStats(graph, &stats);
+        total.wallSeconds += stats.wallSeconds;
+        total.taskSeconds += stats.taskSeconds;
+        total.criticalPathSeconds += stats.criticalPathSeconds;
+        total.tasksDeferred = stats.tasksDeferred;
+        delete graph;
+    }
+
+    printf("  %-48s %10.2f ms wall, %.2f ms task time, %.2f ms critical path, %u deferred\n", label,
+        total.wallSeconds * 1e3 / runs, total.taskSeconds * 1e3 / runs, total.criticalPathSeconds * 1e3 / runs,
+        total.tasksDeferred);
+}
+
+// Scheduling cost alone: a fan out of empty tasks behind one root
+static void runOverhead(uint32 threadCount)
+{
+    const uint32 graphs = 2000;
+    float64 seconds = 0.0;
+    StartupGraph* graph = new StartupGraph();
+    for (uint32 i = 0; i < graphs; i++)
+    {
+        startupGraphInitialize(graph);
+        uint32 root = startupGraphAddTask(graph, "root", emptyTask, nullptr);
+        for (uint32 t = 1; t < STARTUP_GRAPH_MAX_TASKS; t++)
+        {
+            uint32 task = startupGraphAddTask(graph, "leaf", emptyTask, nullptr);
+            startupGraphAddDependency(graph, task, root);
+        }
+
+        float64 start = benchNow();
+        startupGraphRun(graph, threadCount);
+        seconds += benchNow() - start;
+    }
+    delete graph;
+
+    char label[96];
+    snprintf(label, sizeof(label), "empty task, %u thread%s", threadCount, threadCount == 1 ? "" : "s");
+    benchReport(label, (uint64)graphs * STARTUP_GRAPH_MAX_TASKS, seconds);
+}
+
+void benchStartup()
+{
+    printf("  engine-shaped graph, %.1f ms of serial init work, %u hardware threads\n",
+        debugLayer.milliseconds + factory.milliseconds + device.milliseconds + fence.milliseconds +
+        commandObjects.milliseconds + window.milliseconds + swapChain.milliseconds + scene.milliseconds +
+        shaderCache.milliseconds, std::thread::hardware_concurrency());
+
+    runEngineGraph("serial (1 thread)", 1);
+    runEngineGraph("graph, 2 threads", 2);
+    runEngineGraph("graph, 4 threads", 4);
+
+    runOverhead(1);
+    runOverhead(4);
+}
@@ -0,0 +1,163 @@
+#include "benchmark.h"
+#include "state_filter.h"
+
+static const uint32 pipelineCount = 8;
+static const uint32 meshCount = 64;
+static const uint32 drawsPerMesh = 16;
+static const uint32 constantCount = 16;
+static const uint32 tableSize = 4;
+
+struct SyntheticScene
+{
+    RhiResource* target;
+    RhiResource* depth;
+    RhiPipeline* pipelines[pipelineCount];
+    RhiDescriptorHeap* descriptors;
+    RhiResource* vertexBuffers[meshCount];
+    RhiResource* indexBuffers[meshCount];
+};
+
+// A draw stream sorted by pipeline, then mesh, as a naive renderer records it: every draw binds
+// all of its state. Material constants and descriptor tables repeat per mesh, only the object's
+// index changes per draw. Each pipeline change drops the table, so it is set again after one.
+static void recordStream(StateFilter* filter, const SyntheticScene& scene, uint32 drawCount)
+{
+    RhiViewport viewport = { 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f };
+    RhiRect scissor = { 0, 0, 1920, 1080 };
+    RhiCommandList* list = filter->list;
+    for (uint32 draw = 0; draw < drawCount; draw++)
+    {
+        uint32 pipeline = draw * pipelineCount / drawCount;
+        uint32 mesh = (draw / drawsPerMesh) % meshCount;
+        uint32 constants[constantCount];
+        for (uint32 i = 0; i < constantCount - 1; i++)
+        {
+            constants[i] = mesh * 31 + i;
+        }
+        constants[constantCount - 1] = draw;
+
+        stateFilterSetViewport(filter, viewport);
+        stateFilterSetScissor(filter, scissor);
+        stateFilterSetRenderTargets(filter, &scene.target, 1, scene.depth);
+        stateFilterSetDescriptorHeap(filter, scene.descriptors);
+        stateFilterSetPipeline(filter, scene.pipelines[pipeline]);
+        stateFilterSetConstants(filter, constants, constantCount, 0);
+        stateFilterSetDescriptorTable(filter, mesh * tableSize);
+        stateFilterSetVertexBuffer(filter, 0, scene.vertexBuffers[mesh], 0, 64 * 1024, 32);
+        stateFilterSetIndexBuffer(filter, scene.indexBuffers[mesh], 0, 16 * 1024, RHI_FORMAT_R32_UINT);
+        rhiCmdDrawIndexed(list, 36, 1, 0, 0, 0);
+    }
+}
+
+static void runStream(const SyntheticScene& scene, RhiDevice* device, uint32 drawCount, bool enabled)
+{
+    RhiQueue* queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    RhiCommandAllocator* allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "bench allocator");
+    RhiCommandList* list = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "bench list");
+    RhiFence* fence = rhiCreateFence(device, 0, "bench fence");
+    StateFilter filter;
+    stateFilterInitialize(&filter, enabled);
+
+    RhiNullStats before;
+    rhiNullGetStats(device, &before);
+    const uint32 frames = 20;
+    float64 recordSeconds = 0.0;
+    for (uint32 frame = 0; frame < frames; frame++)
+    {
+        rhiResetCommandAllocator(allocator);
+        float64 start = benchNow();
+        rhiBeginCommandList(list, allocator);
+        stateFilterBegin(&filter, list);
+        recordStream(&filter, scene, drawCount);
+        rhiEndCommandList(list);
+        recordSeconds += benchNow() - start;
+        rhiQueueSubmit(queue, &list, 1);
+        rhiQueueSignal(queue, fence, frame + 1);
+        rhiFenceWait(fence, frame + 1);
+    }
+    RhiNullStats after;
+    rhiNullGetStats(device, &after);
+
+    StateFilterStats stats;
+    stateFilterGetStats(&filter, &stats);
+    uint64 calls = 0;
+    uint64 filtered = 0;
+    for (uint32 i = 0; i < STATE_FILTER_CALL_COUNT; i++)
+    {
+        calls += stats.calls[i];
+        filtered += stats.filtered[i];
+    }
+    uint64 draws = (uint64)frames * drawCount;
+    uint64 commands = after.commands - before.commands;
+    char label[96];
+    snprintf(label, sizeof(label), "%uk draws, filter %s, record per draw", drawCount / 1000, enabled ? "on" : "off");
+    benchReport(label, draws, recordSeconds);
+    printf("  %-48s %10.2f commands/draw, %llu of %llu binds dropped, %.1f KB stream/frame\n", "",
+        (float64)commands / draws, (unsigned long long)filtered, (unsigned long long)calls,
+        (float64)(after.streamBytes - before.streamBytes) / frames / 1024.0);
+    if (enabled)
+    {
+        for (uint32 i = 0; i < STATE_FILTER_CALL_COUNT; i++)
+        {
+            printf("  %-48s %-16s %5.1f%% of %llu dropped\n", "", stateFilterCallName((e_stateFilterCall)i),
+                stats.calls[i] ? 100.0 * stats.filtered[i] / stats.calls[i] : 0.0, (unsigned long long)stats.calls[i]);
+        }
+        printf("  %-48s %-16s %5.1f%% of values cut\n", "", "constant values",
+            stats.constantValues ? 100.0 * stats.constantValuesFiltered / stats.constantValues : 0.0);
+    }
+
+    rhiDestroyFence(fence);
+    rhiDestroyCommandList(list);
+    rhiDestroyCommandAllocator(allocator);
+}
+
+void benchStateFilter()
+{
+    RhiDeviceConfig config;
+    config.null.submitLatencyNanoseconds = 0;
+    RhiDevice* device = rhiCreateDevice(config);
+
+    SyntheticScene scene;
+    scene.target = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT,
+        rhiTexture2DDesc(RHI_FORMAT_RGBA8_UNORM, 1920, 1080, RHI_RESOURCE_FLAG_RENDER_TARGET), RHI_STATE_RENDER_TARGET, "bench target");
+    scene.depth = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT,
+        rhiTexture2DDesc(RHI_FORMAT_D24_UNORM_S8_UINT, 1920, 1080, RHI_RESOURCE_FLAG_DEPTH_STENCIL), RHI_STATE_DEPTH_WRITE, "bench depth");
+    RhiPipelineDesc pipelineDesc;
+    pipelineDesc.rootConstantCount = constantCount;
+    pipelineDesc.descriptorTable = true;
+    for (uint32 i = 0; i < pipelineCount; i++)
+    {
+        scene.pipelines[i] = rhiCreatePipeline(device, pipelineDesc, "bench pipeline");
+    }
+    RhiDescriptorHeapDesc heapDesc;
+    heapDesc.type = RHI_DESCRIPTOR_HEAP_RESOURCE;
+    heapDesc.capacity = meshCount * tableSize;
+    heapDesc.shaderVisible = true;
+    scene.descriptors = rhiCreateDescriptorHeap(device, heapDesc, "bench descriptors");
+    for (uint32 i = 0; i < meshCount; i++)
+    {
+        scene.vertexBuffers[i] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, rhiBufferDesc(64 * 1024), RHI_STATE_COMMON, "bench vertices");
+        scene.indexBuffers[i] = rhiCreateCommittedResource(device, RHI_HEAP_DEFAULT, rhiBufferDesc(16 * 1024), RHI_STATE_COMMON, "bench indices");
+    }
+
+    uint32 drawCounts[] = { 10000, 100000 };
+    for (uint32 drawCount : drawCounts)
+    {
+        runStream(scene, device, drawCount, false);
+        runStream(scene, device, drawCount, true);
+    }
+
+    for (uint32 i = 0; i < meshCount; i++)
+    {
+        rhiDestroyResource(scene.vertexBuffers[i]);
+        rhiDestroyResource(scene.indexBuffers[i]);
+    }
+    for (uint32 i = 0; i < pipelineCount; i++)
+    {
+        rhiDestroyPipeline(scene.pipelines[i]);
+    }
+    rhiDestroyDescriptorHeap(scene.descriptors);
+    rhiDestroyResource(scene.depth);
+    rhiDestroyResource(scene.target);
+    rhiDestroyDevice(device);
+}
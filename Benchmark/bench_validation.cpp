@@ -0,0 +1,43 @@
+#include <vector>
+
+#include "benchmark.h"
+#include "assertions.h"
+#include "bench_validation.h"
+
+volatile uint64 benchValidationSink = 0;
+
+float64 benchValidationLoop(BenchDraw* draws, uint32 drawCount, uint32 frames)
+{
+    BENCH_VALIDATION_LOOP(draws, drawCount, frames);
+}
+
+void benchValidation()
+{
+    const uint32 drawCount = 4096;
+    const uint32 frames = 2000;
+    const uint64 operations = (uint64)drawCount * frames;
+
+    std::vector<BenchNamedObject> objects(drawCount);
+    std::vector<BenchDraw> draws(drawCount);
+    for (uint32 i = 0; i < drawCount; i++)
+    {
+        draws[i].object = &objects[i];
+        draws[i].vertexCount = 3 + (i & 255) * 3;
+        draws[i].state = BENCH_DRAW_STATE_RENDER_TARGET;
+    }
+
+    e_validationTier previousTier = validationTier;
+
+    benchReport("compiled out (max tier off)", operations, benchValidationLoopCompiledOut(draws.data(), drawCount, frames));
+
+    e_validationTier tiers[] = { VALIDATION_TIER_OFF, VALIDATION_TIER_LIGHT, VALIDATION_TIER_FULL };
+    for (e_validationTier tier : tiers)
+    {
+        char label[64];
+        validationTier = tier;
+        snprintf(label, sizeof(label), "runtime tier %s", validationTierName(tier));
+        benchReport(label, operations, benchValidationLoop(draws.data(), drawCount, frames));
+    }
+
+    validationTier = previousTier;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "defines.h"
+
+// Stand-in for a D3D12 object and a recorded draw, shared by both validation benchmark files
+struct BenchNamedObject
+{
+    const wchar_t* name;
+    void SetName(const wchar_t* newName) { name = newName; }
+};
+
+struct BenchDraw
+{
+    BenchNamedObject* object;
+    uint32 vertexCount;
+    uint32 state;
+};
+
+#define BENCH_DRAW_STATE_RENDER_TARGET 4
+
+// One frame records every draw: a bounds assertion, a state validation and a debug name
+// The draws pointer goes through a volatile each frame so the optimizer can't hoist the sum out.
+#define BENCH_VALIDATION_LOOP(draws, drawCount, frames)                                         \
+    uint64 vertices = 0;                                                                        \
+    BenchDraw* volatile drawsPerFrame = (draws);                                                \
+    float64 start = benchNow();                                                                 \
+    for (uint32 frame = 0; frame < (frames); frame++)                                           \
+    {                                                                                           \
+        BenchDraw* frameDraws = drawsPerFrame;                                                  \
+        for (uint32 i = 0; i < (drawCount); i++)                                                \
+        {                                                                                       \
+            BenchDraw& draw = frameDraws[i];                                                    \
+            SGSASSERT(draw.vertexCount <= 65536);                                               \
+            SGSVALIDATE(draw.state == BENCH_DRAW_STATE_RENDER_TARGET, "draw target in wrong state"); \
+            SGSNAME(draw.object, L"draw");                                                      \
+            vertices += draw.vertexCount;                                                       \
+        }                                                                                       \
+    }                                                                                           \
+    float64 elapsed = benchNow() - start;                                                       \
+    benchValidationSink = vertices;                                                             \
+    return elapsed
+
+extern volatile uint64 benchValidationSink;
+
+float64 benchValidationLoop(BenchDraw* draws, uint32 drawCount, uint32 frames);
+float64 benchValidationLoopCompiledOut(BenchDraw* draws, uint32 drawCount, uint32 frames);
@@ -0,0 +1,11 @@
+// Same loop as bench_validation.cpp, built with validation capped at the off tier
+#define SGS_VALIDATION_MAX_TIER 0
+
+#include "benchmark.h"
+#include "assertions.h"
+#include "bench_validation.h"
+
+float64 benchValidationLoopCompiledOut(BenchDraw* draws, uint32 drawCount, uint32 frames)
+{
+    BENCH_VALIDATION_LOOP(draws, drawCount, frames);
+}
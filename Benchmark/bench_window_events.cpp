@@ -0,0 +1,165 @@
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "benchmark.h"
+#include "window_events.h"
+
+static const uint32 eventCount = 4000000;
+
+// What the window thread sees during a drag-resize with the mouse moving: mostly motion and
+// resizes, with an occasional key or click in between.
+static WindowEvent syntheticEvent(uint32 index)
+{
+    WindowEvent event;
+    uint32 kind = index & 15;
+    event.type = kind < 10 ? WINDOW_EVENT_MOUSE_MOVE : kind < 15 ? WINDOW_EVENT_RESIZE : WINDOW_EVENT_KEY_DOWN;
+    if ((index & 63) == 63)
+    {
+        event.type = WINDOW_EVENT_MOUSE_BUTTON;
+    }
+    event.a = (int32)(index & 1023);
+    event.b = (int32)(index >> 10);
+    event.time = index;
+    return event;
+}
+
+// The baseline a window thread would otherwise use: a locked deque, drained one event at a time
+struct LockedEventQueue
+{
+    std::mutex mutex;
+    std::deque<WindowEvent> events;
+};
+
+static void singleThreadCase(const char* name, bool singleProducer)
+{
+    WindowEventQueue queue;
+    windowEventQueueInitialize(&queue, WINDOW_EVENT_QUEUE_DEFAULT_CAPACITY, singleProducer);
+
+    uint64 processed = 0;
+    float64 start = benchNow();
+    for (uint32 i = 0; i < eventCount; i++)
+    {
+        windowEventPush(&queue, syntheticEvent(i));
+        if ((i & 1023) == 1023)
+        {
+            WindowEventBatch batch;
+            do
+            {
+                windowEventDrain(&queue, &batch);
+                processed += batch.count;
+            } while (batch.moreAvailable);
+        }
+    }
+    benchReport(name, eventCount, benchNow() - start);
+    printf("  %-48s %10.2f events/handled event\n", "", (float64)eventCount / (float64)processed);
+    windowEventQueueShutdown(&queue);
+}
+
+static void lockedCase()
+{
+    LockedEventQueue locked;
+    float64 start = benchNow();
+    for (uint32 i = 0; i < eventCount; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lock(locked.mutex);
+            locked.events.push_back(syntheticEvent(i));
+        }
+        if ((i & 1023) == 1023)
+        {
+            for (;;)
+            {
+                std::lock_guard<std::mutex> lock(locked.mutex);
+                if (locked.events.empty())
+                {
+                    break;
+                }
+                benchDoNotOptimize(locked.events.front());
+                locked.events.pop_front();
+            }
+        }
+    }
+    benchReport("mutex + deque push and pop, 1 thread", eventCount, benchNow() - start);
+}
+
+// A window thread pushing as fast as it can while a frame thread drains once per frame. The
+// producer's time per push is what the window procedure would spend before returning.
+static void threadedCase(uint32 producerCount)
+{
+    WindowEventQueue queue;
+    windowEventQueueInitialize(&queue, WINDOW_EVENT_QUEUE_DEFAULT_CAPACITY, producerCount == 1);
+
+    std::atomic<uint32> producersDone(0);
+    std::thread producers[4];
+    float64 producerTime[4] = {};
+    uint32 perProducer = eventCount / producerCount;
+
+    float64 start = benchNow();
+    for (uint32 p = 0; p < producerCount; p++)
+    {
+        producers[p] = std::thread([&, p]() {
+            float64 producerStart = benchNow();
+            for (uint32 i = 0; i < perProducer; i++)
+            {
+                while (!windowEventPush(&queue, syntheticEvent(i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            producerTime[p] = benchNow() - producerStart;
+            producersDone.fetch_add(1);
+        });
+    }
+
+    uint64 popped = 0;
+    uint64 handled = 0;
+    uint64 frames = 0;
+    for (;;)
+    {
+        bool done = producersDone.load() == producerCount;
+        WindowEventBatch batch;
+        do
+        {
+            windowEventDrain(&queue, &batch);
+            popped += batch.popped;
+            handled += batch.count;
+        } while (batch.moreAvailable);
+        frames++;
+
+        if (done && popped == (uint64)perProducer * producerCount)
+        {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    float64 total = benchNow() - start;
+
+    float64 slowest = 0.0;
+    for (uint32 p = 0; p < producerCount; p++)
+    {
+        producers[p].join();
+        slowest = producerTime[p] > slowest ? producerTime[p] : slowest;
+    }
+
+    char label[96];
+    snprintf(label, sizeof(label), "lock-free, %u producer(s), push", producerCount);
+    benchReport(label, perProducer, slowest);
+    snprintf(label, sizeof(label), "lock-free, %u producer(s), end to end", producerCount);
+    benchReport(label, popped, total);
+    printf("  %-48s %10.2f events/handled event, %llu drains, %llu full retries\n", "",
+        (float64)popped / (float64)(handled ? handled : 1), (unsigned long long)frames,
+        (unsigned long long)windowEventDroppedCount(&queue));
+
+    windowEventQueueShutdown(&queue);
+}
+
+void benchWindowEvents()
+{
+    singleThreadCase("single producer push + batched drain", true);
+    singleThreadCase("multi producer push + batched drain", false);
+    lockedCase();
+    threadedCase(1);
+    threadedCase(2);
+}
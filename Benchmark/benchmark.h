@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+
+#include "defines.h"
+
+typedef void (*PFN_benchmark)();
+
+inline float64 benchNow()
+{
+    using namespace std::chrono;
+    return duration<float64>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline void benchReport(const char* name, uint64 operations, float64 seconds)
+{
+    float64 nsPerOp = operations ? seconds * 1e9 / (float64)operations : 0.0;
+    float64 opsPerSecond = seconds > 0.0 ? (float64)operations / seconds : 0.0;
+    printf("  %-48s %10.1f ns/op %14.0f op/s\n", name, nsPerOp, opsPerSecond);
+}
+
+// Keeps the optimizer from discarding benchmarked work
+template<typename T>
+inline void benchDoNotOptimize(const T& value)
+{
+    volatile const T* sink = &value;
+    (void)sink;
+}
+
+void benchLogger();
+void benchFlightRecorder();
+void benchDxCheck();
+void benchValidation();
+void benchWindowEvents();
+void benchFramePacer();
+void benchFrameTiming();
+void benchPipeline();
+void benchBatch();
+void benchStartup();
+void benchCvars();
+void benchCpuTopology();
+void benchRhi();
+void benchFrameContexts();
+void benchFences();
+void benchDeferredRelease();
+void benchParallelRecord();
+void benchStateFilter();
+void benchPassStats();
+void benchResourceStates();
+void benchFrameGraph();
+void benchDescriptors();
@@ -0,0 +1,10 @@
+@echo off
+
+echo "building benchmark"
+
+set include_paths= /I..\Engine\src
+set file_paths= ..\Benchmark\*.cpp
+
+pushd ..\bin
+cl /EHsc /WX /Zi /O2 %include_paths% /DDEBUG %file_paths% /Fe:benchmark.exe /link engine.lib D3D12.lib dxgi.lib
+popd
\ No newline at end of file
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+echo "building benchmark"
+
+include_paths="-I../Engine/src"
+file_paths="../Benchmark/*.cpp"
+
+pushd ../bin > /dev/null
+g++ -std=c++14 -Werror -g -O2 $include_paths -DDEBUG $file_paths -o benchmark -L. -lengine -lpthread
+popd > /dev/null
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+struct BenchmarkEntry
+{
+    const char* name;
+    PFN_benchmark run;
+};
+
+static BenchmarkEntry benchmarks[] = {
+    { "logger", benchLogger },
+    { "flight_recorder", benchFlightRecorder },
+    { "dx_check", benchDxCheck },
+    { "validation", benchValidation },
+    { "window_events", benchWindowEvents },
+    { "frame_pacer", benchFramePacer },
+    { "frame_timing", benchFrameTiming },
+    { "pipeline", benchPipeline },
+    { "batch", benchBatch },
+    { "startup", benchStartup },
+    { "cvars", benchCvars },
+    { "cpu_topology", benchCpuTopology },
+    { "rhi", benchRhi },
+    { "frame_contexts", benchFrameContexts },
+    { "fences", benchFences },
+    { "deferred_release", benchDeferredRelease },
+    { "parallel_record", benchParallelRecord },
+    { "state_filter", benchStateFilter },
+    { "pass_stats", benchPassStats },
+    { "resource_states", benchResourceStates },
+    { "frame_graph", benchFrameGraph },
+    { "descriptors", benchDescriptors },
+};
+
+int main(int argc, char** argv)
+{
+    const uint32 count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    bool ranAny = false;
+
+    for (uint32 i = 0; i < count; i++)
+    {
+        if (argc > 1 && strcmp(argv[1], benchmarks[i].name) != 0)
+        {
+            continue;
+        }
+
+        printf("[%s]\n", benchmarks[i].name);
+        benchmarks[i].run();
+        ranAny = true;
+    }
+
+    if (!ranAny)
+    {
+        printf("unknown benchmark '%s', available:", argv[1]);
+        for (uint32 i = 0; i < count; i++)
+        {
+            printf(" %s", benchmarks[i].name);
+        }
+        printf("\n");
+        return 1;
+    }
+
+    return 0;
+}
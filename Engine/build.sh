@@ -0,0 +1,12 @@
+#!/bin/bash
+
+echo "building engine"
+
+include_paths="-I../Engine/src"
+
+mkdir -p ../bin
+
+pushd ../bin > /dev/null
+g++ -std=c++14 -Werror -g -O2 $include_paths -DDEBUG -c ../Engine/src/*.cpp
+ar rcs libengine.a *.o
+popd > /dev/null
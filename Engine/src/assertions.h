@@ -1,20 +1,27 @@
 #pragma once
 
 #include "defines.h"
+#include "validation.h"
 
-// Disable assertions by commenting the below line
+// Assertions are compiled in unless the build caps validation at VALIDATION_TIER_OFF. At runtime
+// SGSASSERT and SGSASSERT_MSG run from the light tier up, SGSASSERT_DEBUG and SGSVALIDATE only
+// in the full tier.
+#if SGS_VALIDATION_MAX_TIER > VALIDATION_TIER_OFF
 #define SGSASSERTIONS_ENABLED
+#endif
 
 #ifdef SGSASSERTIONS_ENABLED
 #if _MSC_VER
 #define debugBreak() __debugbreak()
+#else
+#define debugBreak() __builtin_trap()
 #endif // _MSC_VER
 
 void report_assertion_failure(const char* expression, const char* message, const char* file, int32 line);
 
 #define SGSASSERT(expr)                                                \
     {                                                                \
-        if (expr) {                                                  \
+        if (!SGS_VALIDATION_ENABLED(VALIDATION_TIER_LIGHT) || (expr)) { \
         } else {                                                     \
             report_assertion_failure(#expr, "", __FILE__, __LINE__); \
             debugBreak();                                            \
@@ -23,7 +30,7 @@ void report_assertion_failure(const char* expression, const char* message, const
 
 #define SGSASSERT_MSG(expr, message)                                            \
     {                                                                           \
-        if (expr) {                                                             \
+        if (!SGS_VALIDATION_ENABLED(VALIDATION_TIER_LIGHT) || (expr)) {         \
         }                                                                       \
         else {                                                                  \
             report_assertion_failure(#expr, message, __FILE__, __LINE__);       \
@@ -31,22 +38,31 @@ void report_assertion_failure(const char* expression, const char* message, const
         }                                                                       \
     }
 
-#ifdef _DEBUG
+// Resource state and other consistency checks that are too expensive for the light tier
+#define SGSVALIDATE(expr, message)                                              \
+    {                                                                           \
+        if (!SGS_VALIDATION_ENABLED(VALIDATION_TIER_FULL) || (expr)) {          \
+        }                                                                       \
+        else {                                                                  \
+            report_assertion_failure(#expr, message, __FILE__, __LINE__);       \
+            debugBreak();                                                       \
+        }                                                                       \
+    }
+
+// Per command checks on hot paths, gated on the tier only like SGSVALIDATE
 #define SGSASSERT_DEBUG(expr)                                                   \
 {                                                                               \
-    if (expr) {}                                                                \
+    if (!SGS_VALIDATION_ENABLED(VALIDATION_TIER_FULL) || (expr)) {}             \
     else {                                                                      \
         report_assertion_failure(#expr, "", __FILE__, __LINE__);                \
         debugBreak();                                                           \
     }                                                                           \
 }
-#else
-#define SGSASSERT_DEBUG(expr) // Does nothing at all
-#endif
 
 #else
 #define SGSASSERT(expr)
-#define SGSASSERT_MSG(expr)
+#define SGSASSERT_MSG(expr, message)
+#define SGSVALIDATE(expr, message)
 #define SGSASSERT_DEBUG(expr)
 
 #endif // SGSASSERTIONS_ENABLED
@@ -56,4 +72,4 @@ static void IsaacNoJuguisAClasse()
     float jaja;
     bool jiji = true;
     return;
-}
\ No newline at end of file
+}
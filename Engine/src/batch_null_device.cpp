@@ -0,0 +1,173 @@
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "batch_render.h"
+
+// Completion times of recent fence values; the scheduler never has more in flight than this
+#define NULL_DEVICE_FENCE_HISTORY 64
+
+struct NullTarget
+{
+    uint8* pixels;
+    uint32 width;
+    uint32 height;
+};
+
+struct NullDevice
+{
+    NullDeviceConfig config;
+    NullTarget targets[BATCH_MAX_FRAMES_IN_FLIGHT];
+    uint64 nextFence;
+    int64 busyUntil;
+    int64 completionTimes[NULL_DEVICE_FENCE_HISTORY];
+};
+
+static const uint8 materialColors[8][3] = {
+    { 230, 57, 70 }, { 241, 250, 238 }, { 168, 218, 220 }, { 69, 123, 157 },
+    { 29, 53, 87 }, { 255, 183, 3 }, { 42, 157, 143 }, { 38, 70, 83 }
+};
+
+static int64 nowNanoseconds()
+{
+    using namespace std::chrono;
+    return (int64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool nullCreateTarget(void* userData, uint32 slot, uint32 width, uint32 height)
+{
+    NullDevice* device = (NullDevice*)userData;
+    NullTarget& target = device->targets[slot];
+    delete[] target.pixels;
+    target.pixels = new uint8[(uint64)width * height * 4];
+    target.width = width;
+    target.height = height;
+    return true;
+}
+
+// What the readback would contain: the clear color and a small square at each draw's origin
+static void splat(NullTarget& target, const RenderSnapshot* snapshot)
+{
+    uint8 clear[4];
+    for (uint32 i = 0; i < 4; i++)
+    {
+        float32 value = snapshot->clearColor[i] < 0.0f ? 0.0f : snapshot->clearColor[i] > 1.0f ? 1.0f : snapshot->clearColor[i];
+        clear[i] = (uint8)(value * 255.0f + 0.5f);
+    }
+    uint32 pixelCount = target.width * target.height;
+    for (uint32 i = 0; i < pixelCount; i++)
+    {
+        memcpy(target.pixels + i * 4, clear, 4);
+    }
+
+    const float32* viewProjection = snapshot->camera.viewProjection;
+    for (uint32 i = 0; i < snapshot->drawCount; i++)
+    {
+        const RenderDraw& draw = snapshot->draws[i];
+        const float32* world = snapshot->transforms[draw.transform].world;
+
+        // viewProjection * world * (0, 0, 0, 1) only needs the translation column
+        float32 clip[4];
+        for (uint32 row = 0; row < 4; row++)
+        {
+            clip[row] = viewProjection[0 * 4 + row] * world[12] + viewProjection[1 * 4 + row] * world[13] +
+                viewProjection[2 * 4 + row] * world[14] + viewProjection[3 * 4 + row];
+        }
+        if (clip[3] <= 0.0f)
+        {
+            continue;
+        }
+
+        int32 x = (int32)((clip[0] / clip[3] * 0.5f + 0.5f) * (float32)target.width);
+        int32 y = (int32)((0.5f - clip[1] / clip[3] * 0.5f) * (float32)target.height);
+        const uint8* color = materialColors[draw.material % 8];
+        for (int32 dy = 0; dy < 2; dy++)
+        {
+            for (int32 dx = 0; dx < 2; dx++)
+            {
+                int32 px = x + dx;
+                int32 py = y + dy;
+                if (px >= 0 && py >= 0 && px < (int32)target.width && py < (int32)target.height)
+                {
+                    uint8* pixel = target.pixels + ((uint64)py * target.width + px) * 4;
+                    pixel[0] = color[0];
+                    pixel[1] = color[1];
+                    pixel[2] = color[2];
+                    pixel[3] = 255;
+                }
+            }
+        }
+    }
+}
+
+static uint64 nullRender(void* userData, uint32 slot, const RenderSnapshot* snapshot, bool readback)
+{
+    NullDevice* device = (NullDevice*)userData;
+    NullTarget& target = device->targets[slot];
+
+    // The modeled GPU works through submissions in order, one at a time
+    float64 cost = (float64)target.width * target.height * device->config.nanosecondsPerPixel +
+        (float64)snapshot->drawCount * device->config.nanosecondsPerDraw;
+    int64 now = nowNanoseconds();
+    int64 start = device->busyUntil > now ? device->busyUntil : now;
+    device->busyUntil = start + (int64)cost;
+
+    uint64 fenceValue = ++device->nextFence;
+    device->completionTimes[fenceValue % NULL_DEVICE_FENCE_HISTORY] = device->busyUntil;
+
+    if (readback)
+    {
+        splat(target, snapshot);
+    }
+    return fenceValue;
+}
+
+static bool nullIsComplete(void* userData, uint64 fenceValue)
+{
+    NullDevice* device = (NullDevice*)userData;
+    return nowNanoseconds() >= device->completionTimes[fenceValue % NULL_DEVICE_FENCE_HISTORY];
+}
+
+static void nullWait(void* userData, uint64 fenceValue)
+{
+    NullDevice* device = (NullDevice*)userData;
+    int64 remaining = device->completionTimes[fenceValue % NULL_DEVICE_FENCE_HISTORY] - nowNanoseconds();
+    if (remaining > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
+    }
+}
+
+static bool nullSave(void* userData, uint32 slot, const char* path)
+{
+    NullDevice* device = (NullDevice*)userData;
+    NullTarget& target = device->targets[slot];
+    return batchWritePpm(path, target.pixels, target.width, target.height, target.width * 4);
+}
+
+static void nullDestroy(void* userData)
+{
+    NullDevice* device = (NullDevice*)userData;
+    for (uint32 i = 0; i < BATCH_MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        delete[] device->targets[i].pixels;
+    }
+    delete device;
+}
+
+BatchDevice batchNullDevice(const NullDeviceConfig& config)
+{
+    NullDevice* nullDevice = new NullDevice();
+    nullDevice->config = config;
+
+    BatchDevice device;
+    device.createTarget = nullCreateTarget;
+    device.render = nullRender;
+    device.isComplete = nullIsComplete;
+    device.wait = nullWait;
+    device.save = nullSave;
+    device.destroy = nullDestroy;
+    device.userData = nullDevice;
+    return device;
+}
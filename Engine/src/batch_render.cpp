@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "batch_render.h"
+#include "logger.h"
+#include "scene.h"
+
+struct BatchSlot
+{
+    bool busy;
+    bool final;             // holds the last frame of its job, which still has to be saved
+    uint32 job;
+    uint64 fenceValue;
+    uint32 width;
+    uint32 height;
+};
+
+static float64 secondsNow()
+{
+    using namespace std::chrono;
+    return duration<float64>(steady_clock::now().time_since_epoch()).count();
+}
+
+void batchJobListFree(BatchJobList* list)
+{
+    delete[] list->jobs;
+    list->jobs = nullptr;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+static void appendJob(BatchJobList* list, const BatchJob& job)
+{
+    if (list->count == list->capacity)
+    {
+        uint32 capacity = list->capacity ? list->capacity * 2 : 16;
+        BatchJob* jobs = new BatchJob[capacity];
+        for (uint32 i = 0; i < list->count; i++)
+        {
+            jobs[i] = list->jobs[i];
+        }
+        delete[] list->jobs;
+        list->jobs = jobs;
+        list->capacity = capacity;
+    }
+    list->jobs[list->count++] = job;
+}
+
+static bool isSeparator(char c)
+{
+    return c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Copies the next field into out and advances text past it
+static bool nextField(const char*& text, char* out, uint32 outSize)
+{
+    while (*text && isSeparator(*text))
+    {
+        text++;
+    }
+    if (!*text)
+    {
+        return false;
+    }
+
+    uint32 length = 0;
+    while (*text && !isSeparator(*text))
+    {
+        if (length < outSize - 1)
+        {
+            out[length++] = *text;
+        }
+        text++;
+    }
+    out[length] = 0;
+    return true;
+}
+
+bool batchParseJob(const char* text, BatchJob* job)
+{
+    BatchJob parsed;
+    char field[260];
+
+    if (!nextField(text, parsed.name, sizeof(parsed.name)) || !nextField(text, parsed.output, sizeof(parsed.output)))
+    {
+        return false;
+    }
+
+    uint32* numbers[] = { &parsed.width, &parsed.height, &parsed.frames, &parsed.objects, &parsed.seed };
+    uint32 required = 2;
+    for (uint32 i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++)
+    {
+        if (!nextField(text, field, sizeof(field)))
+        {
+            if (i < required)
+            {
+                return false;
+            }
+            break;
+        }
+        char* end;
+        unsigned long value = strtoul(field, &end, 10);
+        if (*end)
+        {
+            return false;
+        }
+        *numbers[i] = (uint32)value;
+    }
+
+    if (parsed.width == 0 || parsed.height == 0 || parsed.frames == 0)
+    {
+        return false;
+    }
+
+    *job = parsed;
+    return true;
+}
+
+bool batchLoadManifest(const char* path, BatchJobList* list)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        SGSERROR("Could not open batch manifest %s", path);
+        return false;
+    }
+
+    char line[1024];
+    uint32 lineNumber = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        const char* text = line;
+        while (*text == ' ' || *text == '\t')
+        {
+            text++;
+        }
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == 0)
+        {
+            continue;
+        }
+
+        BatchJob job;
+        if (batchParseJob(text, &job))
+        {
+            appendJob(list, job);
+        }
+        else
+        {
+            SGSWARN("%s:%u: bad batch job, expected 'name output width height [frames] [objects] [seed]'", path, lineNumber);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+uint32 batchJobsFromCommandLine(const char* commandLine, BatchJobList* list)
+{
+    uint32 before = list->count;
+    const char* cursor = commandLine;
+    while (cursor && (cursor = strstr(cursor, "--")) != nullptr)
+    {
+        char value[1024];
+        uint32 length = 0;
+        bool manifest = strncmp(cursor, "--batch=", 8) == 0;
+        bool job = strncmp(cursor, "--job=", 6) == 0;
+        cursor += 2;
+        if (!manifest && !job)
+        {
+            continue;
+        }
+
+        cursor = strchr(cursor, '=') + 1;
+        while (*cursor && *cursor != ' ' && *cursor != '\t' && length < sizeof(value) - 1)
+        {
+            value[length++] = *cursor++;
+        }
+        value[length] = 0;
+
+        BatchJob parsed;
+        if (manifest)
+        {
+            batchLoadManifest(value, list);
+        }
+        else if (batchParseJob(value, &parsed))
+        {
+            appendJob(list, parsed);
+        }
+        else
+        {
+            SGSWARN("Bad --job=%s, expected name,output,width,height[,frames[,objects[,seed]]]", value);
+        }
+    }
+    return list->count - before;
+}
+
+static void retireSlot(const BatchJob* jobs, const BatchDevice& device, const BatchConfig& config, BatchSlot& slot, uint32 slotIndex, BatchStats* stats)
+{
+    if (!slot.busy)
+    {
+        return;
+    }
+
+    if (!device.isComplete(device.userData, slot.fenceValue))
+    {
+        float64 start = secondsNow();
+        device.wait(device.userData, slot.fenceValue);
+        stats->waitSeconds += secondsNow() - start;
+    }
+    slot.busy = false;
+
+    if (slot.final)
+    {
+        slot.final = false;
+        const BatchJob& job = jobs[slot.job];
+        if (!config.saveOutputs || device.save(device.userData, slotIndex, job.output))
+        {
+            stats->jobsCompleted++;
+        }
+        else
+        {
+            SGSERROR("Batch job %s: could not write %s", job.name, job.output);
+            stats->jobsFailed++;
+        }
+    }
+}
+
+void batchRun(const BatchJob* jobs, uint32 jobCount, const BatchDevice& device, const BatchConfig& config, BatchStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    float64 start = secondsNow();
+
+    uint32 framesInFlight = config.framesInFlight < 1 ? 1 : config.framesInFlight;
+    framesInFlight = framesInFlight > BATCH_MAX_FRAMES_IN_FLIGHT ? BATCH_MAX_FRAMES_IN_FLIGHT : framesInFlight;
+    BatchSlot slots[BATCH_MAX_FRAMES_IN_FLIGHT] = {};
+
+    // One snapshot is enough: devices consume it while recording
+    uint32 capacity = 0;
+    for (uint32 i = 0; i < jobCount; i++)
+    {
+        capacity = jobs[i].objects > capacity ? jobs[i].objects : capacity;
+    }
+    RenderSnapshot snapshot = {};
+    snapshot.transforms = new RenderTransform[capacity ? capacity : 1];
+    snapshot.draws = new RenderDraw[capacity ? capacity : 1];
+    snapshot.capacity = capacity;
+
+    uint32 nextSlot = 0;
+    for (uint32 jobIndex = 0; jobIndex < jobCount; jobIndex++)
+    {
+        const BatchJob& job = jobs[jobIndex];
+        Scene scene;
+        sceneInitialize(&scene, job.objects, job.seed);
+        scene.aspectRatio = (float32)job.width / (float32)job.height;
+
+        bool failed = false;
+        for (uint32 frame = 0; frame < job.frames && !failed; frame++)
+        {
+            uint32 slotIndex = nextSlot;
+            nextSlot = (nextSlot + 1) % framesInFlight;
+            BatchSlot& slot = slots[slotIndex];
+            retireSlot(jobs, device, config, slot, slotIndex, stats);
+
+            if (slot.width != job.width || slot.height != job.height)
+            {
+                if (!device.createTarget(device.userData, slotIndex, job.width, job.height))
+                {
+                    SGSERROR("Batch job %s: could not create a %ux%u target", job.name, job.width, job.height);
+                    slot.width = 0;
+                    slot.height = 0;
+                    failed = true;
+                    break;
+                }
+                slot.width = job.width;
+                slot.height = job.height;
+            }
+
+            sceneUpdate(&scene, config.stepSeconds);
+            snapshot.frame = frame;
+            sceneWriteSnapshot(&scene, &snapshot);
+
+            bool final = frame == job.frames - 1;
+            slot.fenceValue = device.render(device.userData, slotIndex, &snapshot, final && config.saveOutputs);
+            slot.busy = true;
+            slot.final = final;
+            slot.job = jobIndex;
+            stats->frames++;
+        }
+
+        if (failed)
+        {
+            stats->jobsFailed++;
+        }
+        sceneShutdown(&scene);
+    }
+
+    for (uint32 i = 0; i < framesInFlight; i++)
+    {
+        retireSlot(jobs, device, config, slots[i], i, stats);
+    }
+
+    delete[] snapshot.transforms;
+    delete[] snapshot.draws;
+    stats->seconds = secondsNow() - start;
+}
+
+bool batchWritePpm(const char* path, const uint8* rgba, uint32 width, uint32 height, uint32 rowPitch)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    uint8* row = new uint8[width * 3];
+    for (uint32 y = 0; y < height; y++)
+    {
+        const uint8* source = rgba + (uint64)y * rowPitch;
+        for (uint32 x = 0; x < width; x++)
+        {
+            row[x * 3 + 0] = source[x * 4 + 0];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        fwrite(row, 1, width * 3, file);
+    }
+    delete[] row;
+
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
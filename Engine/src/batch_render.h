@@ -0,0 +1,92 @@
+#pragma once
+
+#include "defines.h"
+#include "render_snapshot.h"
+
+// Windowless batch rendering for thumbnails and regression images. Each job simulates the test
+// scene for a number of fixed steps, renders every step into an offscreen target and saves the
+// last one. Frames of consecutive jobs share BATCH_MAX_FRAMES_IN_FLIGHT targets: the scheduler
+// only waits for a target when it comes around again, never between jobs.
+
+#define BATCH_MAX_FRAMES_IN_FLIGHT 4
+
+// Fields of a job line, separated by commas or whitespace:
+//   name output width height [frames] [objects] [seed]
+// Manifests hold one job per line; empty lines and lines starting with # are skipped.
+struct BatchJob
+{
+    char name[64];
+    char output[260];
+    uint32 width;
+    uint32 height;
+    uint32 frames = 1;
+    uint32 objects = 256;
+    uint32 seed = 1;
+};
+
+struct BatchJobList
+{
+    BatchJob* jobs;
+    uint32 count;
+    uint32 capacity;
+};
+
+// What a batch needs from a GPU. All calls come from the thread running batchRun.
+struct BatchDevice
+{
+    // (Re)creates the offscreen target of a slot. Only called when the slot is idle.
+    bool (*createTarget)(void* userData, uint32 slot, uint32 width, uint32 height);
+    // Records and submits a frame into the slot's target. With readback the image is also copied
+    // somewhere save can reach. Returns the fence value that completes with the frame.
+    uint64 (*render)(void* userData, uint32 slot, const RenderSnapshot* snapshot, bool readback);
+    bool (*isComplete)(void* userData, uint64 fenceValue);
+    void (*wait)(void* userData, uint64 fenceValue);
+    // Writes the slot's last readback to a file; the frame has completed
+    bool (*save)(void* userData, uint32 slot, const char* path);
+    void (*destroy)(void* userData);
+    void* userData = nullptr;
+};
+
+struct BatchConfig
+{
+    uint32 framesInFlight = 2;          // clamped to [1, BATCH_MAX_FRAMES_IN_FLIGHT]
+    float32 stepSeconds = 1.0f / 60.0f;
+    bool saveOutputs = true;
+};
+
+struct BatchStats
+{
+    uint32 jobsCompleted;
+    uint32 jobsFailed;
+    uint64 frames;
+    float64 seconds;
+    float64 waitSeconds;                // blocked on slot fences
+};
+
+void batchJobListFree(BatchJobList* list);
+bool batchParseJob(const char* text, BatchJob* job);
+// Appends the manifest's jobs. Returns false if the file can't be read; bad lines are skipped.
+bool batchLoadManifest(const char* path, BatchJobList* list);
+// Collects every --batch=manifest and --job=fields option. Returns the number of jobs added.
+uint32 batchJobsFromCommandLine(const char* commandLine, BatchJobList* list);
+
+void batchRun(const BatchJob* jobs, uint32 jobCount, const BatchDevice& device, const BatchConfig& config, BatchStats* stats);
+
+// Binary PPM, alpha dropped. rowPitch is in bytes.
+bool batchWritePpm(const char* path, const uint8* rgba, uint32 width, uint32 height, uint32 rowPitch);
+
+// A device without a GPU: frames complete after a modeled GPU time and readbacks are a CPU splat
+// of every draw's origin over the clear color, so images are deterministic.
+struct NullDeviceConfig
+{
+    float64 nanosecondsPerPixel = 0.25;
+    float64 nanosecondsPerDraw = 20.0;
+};
+
+BatchDevice batchNullDevice(const NullDeviceConfig& config);
+
+struct RhiDevice;
+
+// Renders through an RHI device, so the same scheduler drives D3D12 or the RHI null backend.
+// Every slot owns a command allocator, an offscreen target and a readback buffer.
+BatchDevice batchRhiDevice(RhiDevice* device);
@@ -0,0 +1,148 @@
+#include "batch_render.h"
+#include "rhi.h"
+
+struct RhiBatchSlot
+{
+    RhiCommandAllocator* allocator;
+    RhiResource* target;
+    RhiResource* readback;
+    uint32 rowPitch;
+    uint32 width;
+    uint32 height;
+};
+
+struct RhiBatchDevice
+{
+    RhiDevice* device;
+    RhiQueue* queue;
+    RhiCommandList* commandList;
+    RhiFence* fence;
+    uint64 fenceValue;
+    RhiBatchSlot slots[BATCH_MAX_FRAMES_IN_FLIGHT];
+};
+
+static bool rhiBatchCreateTarget(void* userData, uint32 slotIndex, uint32 width, uint32 height)
+{
+    RhiBatchDevice* batch = (RhiBatchDevice*)userData;
+    RhiBatchSlot& slot = batch->slots[slotIndex];
+    rhiDestroyResource(slot.target);
+    rhiDestroyResource(slot.readback);
+    slot.target = nullptr;
+    slot.readback = nullptr;
+
+    RhiResourceDesc targetDesc = rhiTexture2DDesc(RHI_FORMAT_RGBA8_UNORM, width, height, RHI_RESOURCE_FLAG_RENDER_TARGET);
+    slot.target = rhiCreateCommittedResource(batch->device, RHI_HEAP_DEFAULT, targetDesc, RHI_STATE_RENDER_TARGET, "batch target");
+    if (!slot.target)
+    {
+        return false;
+    }
+
+    uint64 readbackSize = 0;
+    rhiGetCopyableFootprint(batch->device, targetDesc, &slot.rowPitch, &readbackSize);
+    slot.readback = rhiCreateCommittedResource(batch->device, RHI_HEAP_READBACK, rhiBufferDesc(readbackSize), RHI_STATE_COPY_DEST, "batch readback");
+    if (!slot.readback)
+    {
+        return false;
+    }
+
+    slot.width = width;
+    slot.height = height;
+    return true;
+}
+
+static uint64 rhiBatchRender(void* userData, uint32 slotIndex, const RenderSnapshot* snapshot, bool readback)
+{
+    RhiBatchDevice* batch = (RhiBatchDevice*)userData;
+    RhiBatchSlot& slot = batch->slots[slotIndex];
+    RhiCommandList* list = batch->commandList;
+
+    // The scheduler only hands out a slot once its previous frame completed
+    rhiResetCommandAllocator(slot.allocator);
+    rhiBeginCommandList(list, slot.allocator);
+
+    RhiViewport viewport = { 0.0f, 0.0f, (float32)slot.width, (float32)slot.height, 0.0f, 1.0f };
+    RhiRect scissorRect = { 0, 0, (int32)slot.width, (int32)slot.height };
+    rhiCmdSetViewport(list, viewport);
+    rhiCmdSetScissor(list, scissorRect);
+    rhiCmdClearRenderTarget(list, slot.target, snapshot->clearColor);
+    rhiCmdSetRenderTargets(list, &slot.target, 1, nullptr);
+
+    if (readback)
+    {
+        RhiBarrier toCopy = rhiTransition(slot.target, RHI_STATE_RENDER_TARGET, RHI_STATE_COPY_SOURCE);
+        rhiCmdBarriers(list, &toCopy, 1);
+        rhiCmdCopyTextureToBuffer(list, slot.readback, slot.target);
+        RhiBarrier toTarget = rhiTransition(slot.target, RHI_STATE_COPY_SOURCE, RHI_STATE_RENDER_TARGET);
+        rhiCmdBarriers(list, &toTarget, 1);
+    }
+
+    rhiEndCommandList(list);
+    rhiQueueSubmit(batch->queue, &list, 1);
+    rhiQueueSignal(batch->queue, batch->fence, ++batch->fenceValue);
+    return batch->fenceValue;
+}
+
+static bool rhiBatchIsComplete(void* userData, uint64 fenceValue)
+{
+    RhiBatchDevice* batch = (RhiBatchDevice*)userData;
+    return rhiFenceIsComplete(batch->fence, fenceValue);
+}
+
+static void rhiBatchWait(void* userData, uint64 fenceValue)
+{
+    RhiBatchDevice* batch = (RhiBatchDevice*)userData;
+    rhiFenceWait(batch->fence, fenceValue);
+}
+
+static bool rhiBatchSave(void* userData, uint32 slotIndex, const char* path)
+{
+    RhiBatchDevice* batch = (RhiBatchDevice*)userData;
+    RhiBatchSlot& slot = batch->slots[slotIndex];
+
+    const uint8* data = (const uint8*)rhiMapResource(slot.readback);
+    if (!data)
+    {
+        return false;
+    }
+    bool written = batchWritePpm(path, data, slot.width, slot.height, slot.rowPitch);
+    rhiUnmapResource(slot.readback);
+    return written;
+}
+
+static void rhiBatchDestroy(void* userData)
+{
+    RhiBatchDevice* batch = (RhiBatchDevice*)userData;
+    for (uint32 i = 0; i < BATCH_MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        rhiDestroyResource(batch->slots[i].target);
+        rhiDestroyResource(batch->slots[i].readback);
+        rhiDestroyCommandAllocator(batch->slots[i].allocator);
+    }
+    rhiDestroyCommandList(batch->commandList);
+    rhiDestroyFence(batch->fence);
+    delete batch;
+}
+
+BatchDevice batchRhiDevice(RhiDevice* device)
+{
+    RhiBatchDevice* batch = new RhiBatchDevice();
+    batch->device = device;
+    batch->queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    batch->commandList = rhiCreateCommandList(device, RHI_QUEUE_DIRECT, "batch command list");
+    batch->fence = rhiCreateFence(device, 0, "batch fence");
+    batch->fenceValue = 0;
+    for (uint32 i = 0; i < BATCH_MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        batch->slots[i].allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "batch command allocator");
+    }
+
+    BatchDevice batchDevice;
+    batchDevice.createTarget = rhiBatchCreateTarget;
+    batchDevice.render = rhiBatchRender;
+    batchDevice.isComplete = rhiBatchIsComplete;
+    batchDevice.wait = rhiBatchWait;
+    batchDevice.save = rhiBatchSave;
+    batchDevice.destroy = rhiBatchDestroy;
+    batchDevice.userData = batch;
+    return batchDevice;
+}
@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <mutex>
+
+#include "console_variables.h"
+#include "logger.h"
+
+struct CvarRegistry
+{
+    ConsoleVariable variables[CVAR_MAX_VARIABLES];
+    uint32 count;
+    bool startupFinished;
+    std::mutex mutex;
+};
+
+static CvarRegistry registry;
+
+static uint32 floatBits(float32 value)
+{
+    uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float32 bitsFloat(uint32 bits)
+{
+    float32 value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Called with the mutex held
+static ConsoleVariable* findLocked(const char* name)
+{
+    for (uint32 i = 0; i < registry.count; i++)
+    {
+        if (strcmp(registry.variables[i].name, name) == 0)
+        {
+            return &registry.variables[i];
+        }
+    }
+    return nullptr;
+}
+
+static ConsoleVariable* registerVariable(const char* name, e_cvarType type, uint32 defaultValue, float64 minValue, float64 maxValue, const char* description, uint32 flags)
+{
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    ConsoleVariable* existing = findLocked(name);
+    if (existing)
+    {
+        if (existing->type != type)
+        {
+            SGSERROR("Console variable %s registered twice with different types", name);
+            return nullptr;
+        }
+        return existing;
+    }
+
+    if (registry.count == CVAR_MAX_VARIABLES || strlen(name) >= CVAR_NAME_SIZE)
+    {
+        SGSERROR("Could not register console variable %s", name);
+        return nullptr;
+    }
+
+    ConsoleVariable* cvar = &registry.variables[registry.count++];
+    strcpy(cvar->name, name);
+    cvar->description = description;
+    cvar->type = type;
+    cvar->flags = flags;
+    cvar->value.store(defaultValue, std::memory_order_relaxed);
+    cvar->defaultValue = defaultValue;
+    cvar->minValue = minValue;
+    cvar->maxValue = maxValue;
+    cvar->pending = defaultValue;
+    cvar->dirty = false;
+    cvar->onChange = nullptr;
+    cvar->userData = nullptr;
+    return cvar;
+}
+
+ConsoleVariable* cvarRegisterInt(const char* name, int32 defaultValue, int32 minValue, int32 maxValue, const char* description, uint32 flags)
+{
+    return registerVariable(name, CVAR_TYPE_INT, (uint32)defaultValue, minValue, maxValue, description, flags);
+}
+
+ConsoleVariable* cvarRegisterFloat(const char* name, float32 defaultValue, float32 minValue, float32 maxValue, const char* description, uint32 flags)
+{
+    return registerVariable(name, CVAR_TYPE_FLOAT, floatBits(defaultValue), minValue, maxValue, description, flags);
+}
+
+ConsoleVariable* cvarRegisterBool(const char* name, bool defaultValue, const char* description, uint32 flags)
+{
+    return registerVariable(name, CVAR_TYPE_BOOL, defaultValue ? 1 : 0, 0.0, 1.0, description, flags);
+}
+
+ConsoleVariable* cvarFind(const char* name)
+{
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return findLocked(name);
+}
+
+void cvarSetCallback(ConsoleVariable* cvar, PFN_cvarChanged onChange, void* userData)
+{
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    cvar->onChange = onChange;
+    cvar->userData = userData;
+}
+
+static bool queueValue(ConsoleVariable* cvar, uint32 value)
+{
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if ((cvar->flags & CVAR_FLAG_INIT_ONLY) && registry.startupFinished)
+    {
+        SGSWARN("Console variable %s can only be set at startup", cvar->name);
+        return false;
+    }
+    cvar->pending = value;
+    cvar->dirty = true;
+    return true;
+}
+
+bool cvarSetInt(ConsoleVariable* cvar, int32 value)
+{
+    value = value < (int32)cvar->minValue ? (int32)cvar->minValue : value;
+    value = value > (int32)cvar->maxValue ? (int32)cvar->maxValue : value;
+    return queueValue(cvar, (uint32)value);
+}
+
+bool cvarSetFloat(ConsoleVariable* cvar, float32 value)
+{
+    value = value < (float32)cvar->minValue ? (float32)cvar->minValue : value;
+    value = value > (float32)cvar->maxValue ? (float32)cvar->maxValue : value;
+    return queueValue(cvar, floatBits(value));
+}
+
+bool cvarSetBool(ConsoleVariable* cvar, bool value)
+{
+    return queueValue(cvar, value ? 1 : 0);
+}
+
+bool cvarSetFromString(const char* name, const char* text)
+{
+    ConsoleVariable* cvar = cvarFind(name);
+    if (!cvar)
+    {
+        SGSWARN("Unknown console variable %s", name);
+        return false;
+    }
+
+    char* end = nullptr;
+    switch (cvar->type)
+    {
+        case CVAR_TYPE_INT:
+        {
+            long value = strtol(text, &end, 10);
+            if (end != text && *end == 0)
+            {
+                return cvarSetInt(cvar, (int32)value);
+            }
+        } break;
+
+        case CVAR_TYPE_FLOAT:
+        {
+            float64 value = strtod(text, &end);
+            if (end != text && *end == 0)
+            {
+                return cvarSetFloat(cvar, (float32)value);
+            }
+        } break;
+
+        case CVAR_TYPE_BOOL:
+        {
+            if (strcmp(text, "1") == 0 || strcmp(text, "true") == 0 || strcmp(text, "on") == 0)
+            {
+                return cvarSetBool(cvar, true);
+            }
+            if (strcmp(text, "0") == 0 || strcmp(text, "false") == 0 || strcmp(text, "off") == 0)
+            {
+                return cvarSetBool(cvar, false);
+            }
+        } break;
+    }
+
+    SGSWARN("Bad value '%s' for console variable %s", text, name);
+    return false;
+}
+
+// Splits "name value", "name=value" or "name = value" in place
+static bool splitAssignment(char* text, char** name, char** value)
+{
+    while (*text == ' ' || *text == '\t')
+    {
+        text++;
+    }
+    *name = text;
+    while (*text && *text != ' ' && *text != '\t' && *text != '=')
+    {
+        text++;
+    }
+    if (!*text || text == *name)
+    {
+        return false;
+    }
+    *text++ = 0;
+
+    while (*text == ' ' || *text == '\t' || *text == '=')
+    {
+        text++;
+    }
+    *value = text;
+    while (*text && *text != ' ' && *text != '\t' && *text != '\r' && *text != '\n' && *text != '#')
+    {
+        text++;
+    }
+    *text = 0;
+    return **value != 0;
+}
+
+bool cvarLoadFile(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    char line[256];
+    uint32 lineNumber = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        char* text = line;
+        while (*text == ' ' || *text == '\t')
+        {
+            text++;
+        }
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == 0)
+        {
+            continue;
+        }
+
+        char* name;
+        char* value;
+        if (!splitAssignment(text, &name, &value))
+        {
+            SGSWARN("%s:%u: expected 'name value'", path, lineNumber);
+            continue;
+        }
+        cvarSetFromString(name, value);
+    }
+
+    fclose(file);
+    return true;
+}
+
+uint32 cvarParseCommandLine(const char* commandLine)
+{
+    uint32 queued = 0;
+    const char* cursor = commandLine;
+    while (cursor && *cursor)
+    {
+        while (*cursor == ' ' || *cursor == '\t')
+        {
+            cursor++;
+        }
+
+        const char* tokenStart = cursor;
+        while (*cursor && *cursor != ' ' && *cursor != '\t')
+        {
+            cursor++;
+        }
+        if (*tokenStart != '+' || cursor - tokenStart < 2)
+        {
+            continue;
+        }
+
+        char token[CVAR_NAME_SIZE + 64];
+        uint32 length = (uint32)(cursor - tokenStart - 1);
+        length = length < sizeof(token) - 1 ? length : sizeof(token) - 1;
+        memcpy(token, tokenStart + 1, length);
+        token[length] = 0;
+
+        char* name;
+        char* value;
+        if (strchr(token, '=') && splitAssignment(token, &name, &value) && cvarSetFromString(name, value))
+        {
+            queued++;
+        }
+        else if (!strchr(token, '='))
+        {
+            SGSWARN("Expected +name=value, got +%s", token);
+        }
+    }
+    return queued;
+}
+
+uint32 cvarApplyPending()
+{
+    ConsoleVariable* changed[CVAR_MAX_VARIABLES];
+    uint32 changedCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (uint32 i = 0; i < registry.count; i++)
+        {
+            ConsoleVariable& cvar = registry.variables[i];
+            if (!cvar.dirty)
+            {
+                continue;
+            }
+            cvar.dirty = false;
+            if (cvar.value.load(std::memory_order_relaxed) != cvar.pending)
+            {
+                cvar.value.store(cvar.pending, std::memory_order_relaxed);
+                changed[changedCount++] = &cvar;
+            }
+        }
+    }
+
+    for (uint32 i = 0; i < changedCount; i++)
+    {
+        if (changed[i]->onChange)
+        {
+            changed[i]->onChange(changed[i], changed[i]->userData);
+        }
+    }
+    return changedCount;
+}
+
+void cvarFinishStartup()
+{
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.startupFinished = true;
+}
+
+void cvarLogAll()
+{
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (uint32 i = 0; i < registry.count; i++)
+    {
+        const ConsoleVariable& cvar = registry.variables[i];
+        uint32 bits = cvar.value.load(std::memory_order_relaxed);
+        char value[32];
+        switch (cvar.type)
+        {
+            case CVAR_TYPE_INT: snprintf(value, sizeof(value), "%d", (int32)bits); break;
+            case CVAR_TYPE_FLOAT: snprintf(value, sizeof(value), "%g", bitsFloat(bits)); break;
+            case CVAR_TYPE_BOOL: snprintf(value, sizeof(value), "%s", bits ? "true" : "false"); break;
+        }
+        SGSINFO("  %-28s %-10s%s %s", cvar.name, value, bits != cvar.defaultValue ? "*" : " ", cvar.description ? cvar.description : "");
+    }
+}
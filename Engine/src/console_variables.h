@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string.h>
+#include <atomic>
+
+#include "defines.h"
+
+// Console variables: typed, named runtime settings that can come from a config file, the command
+// line or code. Register once and keep the returned pointer; reading through it is a single
+// relaxed load, cheap enough for hot paths. Sets only queue a value. cvarApplyPending publishes
+// every queued value at once, so calling it at the start of a frame keeps all variables stable
+// for the rest of that frame.
+
+#define CVAR_MAX_VARIABLES 256
+#define CVAR_NAME_SIZE 48
+
+typedef enum e_cvarType {
+    CVAR_TYPE_INT = 0,
+    CVAR_TYPE_FLOAT = 1,
+    CVAR_TYPE_BOOL = 2
+}e_cvarType;
+
+typedef enum e_cvarFlags {
+    CVAR_FLAG_INIT_ONLY = 1 << 0    // read during startup, sets after cvarFinishStartup are rejected
+}e_cvarFlags;
+
+struct ConsoleVariable;
+// Called from cvarApplyPending after the new value became visible
+typedef void (*PFN_cvarChanged)(ConsoleVariable* cvar, void* userData);
+
+struct ConsoleVariable
+{
+    char name[CVAR_NAME_SIZE];
+    const char* description;
+    e_cvarType type;
+    uint32 flags;
+    std::atomic<uint32> value;      // int32, float32 bits, or 0/1
+    uint32 defaultValue;
+    float64 minValue;               // int and float only
+    float64 maxValue;
+
+    // Guarded by the registry mutex
+    uint32 pending;
+    bool dirty;
+    PFN_cvarChanged onChange;
+    void* userData;
+};
+
+// Registering an existing name returns the existing variable if the type matches, nullptr otherwise
+ConsoleVariable* cvarRegisterInt(const char* name, int32 defaultValue, int32 minValue, int32 maxValue, const char* description, uint32 flags = 0);
+ConsoleVariable* cvarRegisterFloat(const char* name, float32 defaultValue, float32 minValue, float32 maxValue, const char* description, uint32 flags = 0);
+ConsoleVariable* cvarRegisterBool(const char* name, bool defaultValue, const char* description, uint32 flags = 0);
+
+// Linear search, for setup code. Hot paths keep the pointer from registration.
+ConsoleVariable* cvarFind(const char* name);
+void cvarSetCallback(ConsoleVariable* cvar, PFN_cvarChanged onChange, void* userData);
+
+inline int32 cvarInt(const ConsoleVariable* cvar)
+{
+    return (int32)cvar->value.load(std::memory_order_relaxed);
+}
+
+inline float32 cvarFloat(const ConsoleVariable* cvar)
+{
+    uint32 bits = cvar->value.load(std::memory_order_relaxed);
+    float32 value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline bool cvarBool(const ConsoleVariable* cvar)
+{
+    return cvar->value.load(std::memory_order_relaxed) != 0;
+}
+
+// Queue a value, clamped to the variable's range. Safe from any thread. Return false if the
+// variable is init only and startup finished.
+bool cvarSetInt(ConsoleVariable* cvar, int32 value);
+bool cvarSetFloat(ConsoleVariable* cvar, float32 value);
+bool cvarSetBool(ConsoleVariable* cvar, bool value);
+// Parses text by the variable's type. Bools take 0/1, true/false, on/off.
+bool cvarSetFromString(const char* name, const char* text);
+
+// One "name value" per line, '=' between them is optional. Empty lines and # comments skipped.
+bool cvarLoadFile(const char* path);
+// Every +name=value token. Returns the number of values queued.
+uint32 cvarParseCommandLine(const char* commandLine);
+
+// Publishes all queued values and runs the change callbacks. Call from one thread, once per
+// frame. Returns the number of variables whose value changed.
+uint32 cvarApplyPending();
+void cvarFinishStartup();
+
+// Logs every variable, its value and whether it differs from the default
+void cvarLogAll();
@@ -0,0 +1,831 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <thread>
+
+#include "cpu_topology.h"
+#include "logger.h"
+
+#if SGS_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define CPU_NO_ID 0xFFFFFFFFu
+
+uint32 cpuSetCount(const CpuSet* set)
+{
+    uint32 count = 0;
+    for (uint32 i = 0; i < CPU_MAX_LOGICAL_CORES / 64; i++)
+    {
+        uint64 bits = set->bits[i];
+        while (bits)
+        {
+            bits &= bits - 1;
+            count++;
+        }
+    }
+    return count;
+}
+
+static uint32 cpuSetFirst(const CpuSet* set)
+{
+    for (uint32 cpu = 0; cpu < CPU_MAX_LOGICAL_CORES; cpu++)
+    {
+        if (cpuSetHas(set, cpu))
+        {
+            return cpu;
+        }
+    }
+    return CPU_NO_ID;
+}
+
+bool cpuSetParseList(const char* text, CpuSet* set)
+{
+    cpuSetClear(set);
+    while (*text && *text != '\n')
+    {
+        char* end;
+        unsigned long first = strtoul(text, &end, 10);
+        if (end == text)
+        {
+            return false;
+        }
+        unsigned long last = first;
+        text = end;
+        if (*text == '-')
+        {
+            last = strtoul(text + 1, &end, 10);
+            if (end == text + 1 || last < first)
+            {
+                return false;
+            }
+            text = end;
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_MAX_LOGICAL_CORES; cpu++)
+        {
+            cpuSetAdd(set, (uint32)cpu);
+        }
+        if (*text == ',')
+        {
+            text++;
+        }
+    }
+    return true;
+}
+
+void cpuSetFormatList(const CpuSet* set, char* out, uint32 outSize)
+{
+    uint32 length = 0;
+    out[0] = 0;
+    for (uint32 cpu = 0; cpu < CPU_MAX_LOGICAL_CORES && length < outSize; cpu++)
+    {
+        if (!cpuSetHas(set, cpu))
+        {
+            continue;
+        }
+        uint32 last = cpu;
+        while (last + 1 < CPU_MAX_LOGICAL_CORES && cpuSetHas(set, last + 1))
+        {
+            last++;
+        }
+        int32 written = last == cpu
+            ? snprintf(out + length, outSize - length, "%s%u", length ? "," : "", cpu)
+            : snprintf(out + length, outSize - length, "%s%u-%u", length ? "," : "", cpu, last);
+        length += written > 0 ? (uint32)written : 0;
+        cpu = last;
+    }
+}
+
+// Maps raw ids (core ids, cache leaders, package numbers) to 0..n-1 in order of appearance
+static uint32 denseIds(uint32* values, uint32 count)
+{
+    uint32 seen[CPU_MAX_LOGICAL_CORES];
+    uint32 seenCount = 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        uint32 dense = seenCount;
+        for (uint32 j = 0; j < seenCount; j++)
+        {
+            if (seen[j] == values[i])
+            {
+                dense = j;
+                break;
+            }
+        }
+        if (dense == seenCount)
+        {
+            seen[seenCount++] = values[i];
+        }
+        values[i] = dense;
+    }
+    return seenCount;
+}
+
+// Raw values in, dense ids and counts out. Performance classes keep their order, 0 slowest.
+static void finishTopology(CpuTopology* topology)
+{
+    uint32 count = topology->logicalCount;
+    uint32 values[CPU_MAX_LOGICAL_CORES];
+
+#define CPU_DENSE_FIELD(field, counter)                     \
+    for (uint32 i = 0; i < count; i++)                      \
+    {                                                       \
+        values[i] = topology->logical[i].field;             \
+    }                                                       \
+    counter = denseIds(values, count);                      \
+    for (uint32 i = 0; i < count; i++)                      \
+    {                                                       \
+        topology->logical[i].field = values[i];             \
+    }
+
+    uint32 l2Groups;
+    CPU_DENSE_FIELD(core, topology->coreCount)
+    CPU_DENSE_FIELD(package, topology->packageCount)
+    CPU_DENSE_FIELD(numaNode, topology->numaNodeCount)
+    CPU_DENSE_FIELD(l2Group, l2Groups)
+    CPU_DENSE_FIELD(l3Group, topology->l3GroupCount)
+#undef CPU_DENSE_FIELD
+    (void)l2Groups;
+
+    // A class becomes the number of distinct classes below it
+    uint32 distinct[CPU_MAX_LOGICAL_CORES];
+    uint32 distinctCount = 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        bool seen = false;
+        for (uint32 j = 0; j < distinctCount; j++)
+        {
+            seen = seen || distinct[j] == topology->logical[i].performanceClass;
+        }
+        if (!seen)
+        {
+            distinct[distinctCount++] = topology->logical[i].performanceClass;
+        }
+    }
+    for (uint32 i = 0; i < count; i++)
+    {
+        uint32 rank = 0;
+        for (uint32 j = 0; j < distinctCount; j++)
+        {
+            rank += distinct[j] < topology->logical[i].performanceClass ? 1 : 0;
+        }
+        topology->logical[i].performanceClass = rank;
+    }
+    topology->maxPerformanceClass = distinctCount - 1;
+
+    topology->smt = topology->coreCount < count;
+    topology->hybrid = topology->maxPerformanceClass > 0;
+}
+
+static void fallbackTopology(CpuTopology* topology)
+{
+    uint32 count = std::thread::hardware_concurrency();
+    count = count == 0 ? 1 : count > CPU_MAX_LOGICAL_CORES ? CPU_MAX_LOGICAL_CORES : count;
+    topology->logicalCount = count;
+    for (uint32 i = 0; i < count; i++)
+    {
+        CpuLogicalCore& logical = topology->logical[i];
+        logical.id = i;
+        logical.core = i;
+        logical.package = 0;
+        logical.numaNode = 0;
+        logical.l2Group = i;
+        logical.l3Group = 0;
+        logical.performanceClass = 0;
+    }
+    finishTopology(topology);
+}
+
+static bool readText(const char* path, char* out, uint32 outSize)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+    size_t length = fread(out, 1, outSize - 1, file);
+    fclose(file);
+    out[length] = 0;
+    return length > 0;
+}
+
+static bool readUint(const char* path, uint32* value)
+{
+    char text[32];
+    if (!readText(path, text, sizeof(text)))
+    {
+        return false;
+    }
+    *value = (uint32)strtoul(text, nullptr, 10);
+    return true;
+}
+
+static bool readCpuList(const char* path, CpuSet* set)
+{
+    char text[1024];
+    return readText(path, text, sizeof(text)) && cpuSetParseList(text, set);
+}
+
+bool cpuTopologyFromSysfs(const char* sysRoot, CpuTopology* topology)
+{
+    memset(topology, 0, sizeof(*topology));
+
+    char path[512];
+    CpuSet online;
+    snprintf(path, sizeof(path), "%s/devices/system/cpu/online", sysRoot);
+    if (!readCpuList(path, &online) || cpuSetCount(&online) == 0)
+    {
+        return false;
+    }
+
+    // Intel hybrid parts list their core types; elsewhere the maximum clock or the scheduler's
+    // capacity tells them apart
+    CpuSet performanceCores;
+    CpuSet efficiencyCores;
+    snprintf(path, sizeof(path), "%s/devices/cpu_core/cpus", sysRoot);
+    bool intelHybrid = readCpuList(path, &performanceCores);
+    snprintf(path, sizeof(path), "%s/devices/cpu_atom/cpus", sysRoot);
+    intelHybrid = readCpuList(path, &efficiencyCores) && intelHybrid;
+
+    uint32 capacity[CPU_MAX_LOGICAL_CORES];
+    uint32 maxCapacity = 0;
+
+    for (uint32 cpu = 0; cpu < CPU_MAX_LOGICAL_CORES; cpu++)
+    {
+        if (!cpuSetHas(&online, cpu))
+        {
+            continue;
+        }
+        uint32 index = topology->logicalCount++;
+        CpuLogicalCore& logical = topology->logical[index];
+        logical.id = cpu;
+
+        // Siblings share a core; the lowest sibling identifies it
+        CpuSet siblings;
+        snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%u/topology/core_cpus_list", sysRoot, cpu);
+        if (!readCpuList(path, &siblings))
+        {
+            snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%u/topology/thread_siblings_list", sysRoot, cpu);
+            if (!readCpuList(path, &siblings))
+            {
+                cpuSetClear(&siblings);
+                cpuSetAdd(&siblings, cpu);
+            }
+        }
+        logical.core = cpuSetFirst(&siblings);
+
+        snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%u/topology/physical_package_id", sysRoot, cpu);
+        if (!readUint(path, &logical.package))
+        {
+            logical.package = 0;
+        }
+
+        // Caches are identified by the lowest cpu sharing them
+        logical.l2Group = logical.core;
+        logical.l3Group = CPU_NO_ID;
+        for (uint32 cacheIndex = 0; cacheIndex < 8; cacheIndex++)
+        {
+            uint32 level;
+            snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%u/cache/index%u/level", sysRoot, cpu, cacheIndex);
+            if (!readUint(path, &level))
+            {
+                break;
+            }
+            CpuSet shared;
+            snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", sysRoot, cpu, cacheIndex);
+            if ((level == 2 || level == 3) && readCpuList(path, &shared))
+            {
+                (level == 2 ? logical.l2Group : logical.l3Group) = cpuSetFirst(&shared);
+            }
+        }
+        // No L3 at all: everything on the package shares the memory side
+        logical.l3Group = logical.l3Group == CPU_NO_ID ? CPU_MAX_LOGICAL_CORES + logical.package : logical.l3Group;
+
+        capacity[index] = 0;
+        if (!intelHybrid)
+        {
+            snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%u/cpu_capacity", sysRoot, cpu);
+            if (!readUint(path, &capacity[index]))
+            {
+                snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%u/cpufreq/cpuinfo_max_freq", sysRoot, cpu);
+                readUint(path, &capacity[index]);
+            }
+            maxCapacity = capacity[index] > maxCapacity ? capacity[index] : maxCapacity;
+        }
+    }
+
+    for (uint32 i = 0; i < topology->logicalCount; i++)
+    {
+        CpuLogicalCore& logical = topology->logical[i];
+        if (intelHybrid)
+        {
+            logical.performanceClass = cpuSetHas(&performanceCores, logical.id) ? 1 : 0;
+        }
+        else
+        {
+            // Favored cores boost a few percent higher, that doesn't make them a different class
+            logical.performanceClass = capacity[i] * 100 >= maxCapacity * 85 ? 1 : 0;
+        }
+    }
+
+    // Nodes list their cpus; machines without NUMA have no node directory at all
+    for (uint32 node = 0; node < 64; node++)
+    {
+        CpuSet cpus;
+        snprintf(path, sizeof(path), "%s/devices/system/node/node%u/cpulist", sysRoot, node);
+        if (!readCpuList(path, &cpus))
+        {
+            continue;
+        }
+        for (uint32 i = 0; i < topology->logicalCount; i++)
+        {
+            if (cpuSetHas(&cpus, topology->logical[i].id))
+            {
+                topology->logical[i].numaNode = node;
+            }
+        }
+    }
+
+    finishTopology(topology);
+    return true;
+}
+
+#if SGS_PLATFORM_WINDOWS
+// Only processor group 0, which holds every logical core on machines with up to 64 of them
+static bool cpuTopologyFromWindows(CpuTopology* topology)
+{
+    memset(topology, 0, sizeof(*topology));
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+    {
+        return false;
+    }
+    uint8* buffer = new uint8[length];
+    if (!GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer, &length))
+    {
+        delete[] buffer;
+        return false;
+    }
+
+    // Per processor number; filled by the relations as they come
+    uint32 core[64], package[64], node[64], l2[64], l3[64], efficiency[64];
+    uint64 present = 0;
+    uint32 coreIndex = 0, packageIndex = 0, l2Index = 0, l3Index = 0;
+    for (uint32 i = 0; i < 64; i++)
+    {
+        package[i] = 0;
+        node[i] = 0;
+        l3[i] = CPU_MAX_LOGICAL_CORES;
+    }
+
+    for (DWORD offset = 0; offset < length;)
+    {
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer + offset);
+        offset += info->Size;
+
+        KAFFINITY mask = 0;
+        switch (info->Relationship)
+        {
+            case RelationProcessorCore:
+            case RelationProcessorPackage:
+                mask = info->Processor.GroupMask[0].Group == 0 ? info->Processor.GroupMask[0].Mask : 0;
+                break;
+            case RelationNumaNode:
+                mask = info->NumaNode.GroupMask.Group == 0 ? info->NumaNode.GroupMask.Mask : 0;
+                break;
+            case RelationCache:
+                mask = info->Cache.GroupMask.Group == 0 ? info->Cache.GroupMask.Mask : 0;
+                break;
+            default:
+                continue;
+        }
+
+        for (uint32 cpu = 0; cpu < 64; cpu++)
+        {
+            if (!((mask >> cpu) & 1))
+            {
+                continue;
+            }
+            switch (info->Relationship)
+            {
+                case RelationProcessorCore:
+                    present |= 1ull << cpu;
+                    core[cpu] = coreIndex;
+                    efficiency[cpu] = info->Processor.EfficiencyClass;
+                    break;
+                case RelationProcessorPackage: package[cpu] = packageIndex; break;
+                case RelationNumaNode: node[cpu] = info->NumaNode.NodeNumber; break;
+                case RelationCache:
+                    if (info->Cache.Level == 2) l2[cpu] = l2Index;
+                    if (info->Cache.Level == 3) l3[cpu] = l3Index;
+                    break;
+                default: break;
+            }
+        }
+
+        coreIndex += info->Relationship == RelationProcessorCore ? 1 : 0;
+        packageIndex += info->Relationship == RelationProcessorPackage ? 1 : 0;
+        l2Index += (info->Relationship == RelationCache && info->Cache.Level == 2) ? 1 : 0;
+        l3Index += (info->Relationship == RelationCache && info->Cache.Level == 3) ? 1 : 0;
+    }
+    delete[] buffer;
+
+    for (uint32 cpu = 0; cpu < 64; cpu++)
+    {
+        if (!((present >> cpu) & 1))
+        {
+            continue;
+        }
+        CpuLogicalCore& logical = topology->logical[topology->logicalCount++];
+        logical.id = cpu;
+        logical.core = core[cpu];
+        logical.package = package[cpu];
+        logical.numaNode = node[cpu];
+        logical.l2Group = l2Index ? l2[cpu] : core[cpu];
+        logical.l3Group = l3[cpu];
+        logical.performanceClass = efficiency[cpu];
+    }
+
+    if (topology->logicalCount == 0)
+    {
+        return false;
+    }
+    finishTopology(topology);
+    return true;
+}
+#endif
+
+bool cpuTopologyDetect(CpuTopology* topology)
+{
+#if SGS_PLATFORM_WINDOWS
+    bool detected = cpuTopologyFromWindows(topology);
+#else
+    bool detected = cpuTopologyFromSysfs("/sys", topology);
+#endif
+    if (!detected)
+    {
+        SGSWARN("Could not read the CPU topology, assuming %u independent cores", std::thread::hardware_concurrency());
+        fallbackTopology(topology);
+    }
+    return detected;
+}
+
+void cpuTopologyLog(const CpuTopology* topology)
+{
+    SGSINFO("CPU: %u logical cores, %u physical, %u package(s), %u NUMA node(s), %u L3 group(s)%s%s",
+        topology->logicalCount, topology->coreCount, topology->packageCount, topology->numaNodeCount,
+        topology->l3GroupCount, topology->smt ? ", SMT" : "", topology->hybrid ? ", hybrid" : "");
+
+    for (uint32 performanceClass = topology->maxPerformanceClass + 1; performanceClass-- > 0;)
+    {
+        CpuSet cpus;
+        cpuSetClear(&cpus);
+        for (uint32 i = 0; i < topology->logicalCount; i++)
+        {
+            if (topology->logical[i].performanceClass == performanceClass)
+            {
+                cpuSetAdd(&cpus, topology->logical[i].id);
+            }
+        }
+        char list[256];
+        cpuSetFormatList(&cpus, list, sizeof(list));
+        SGSINFO("  class %u cores: %s", performanceClass, list);
+    }
+}
+
+void cpuPlacementDefaultPolicies(e_threadPlacement* policies)
+{
+    policies[ENGINE_THREAD_MAIN] = THREAD_PLACEMENT_EXCLUSIVE_CORE;
+    policies[ENGINE_THREAD_RENDER] = THREAD_PLACEMENT_EXCLUSIVE_CORE;
+    policies[ENGINE_THREAD_WINDOW] = THREAD_PLACEMENT_ANY;
+    policies[ENGINE_THREAD_LOGGER] = THREAD_PLACEMENT_EFFICIENCY;
+    policies[ENGINE_THREAD_LOADER] = THREAD_PLACEMENT_EFFICIENCY;
+    policies[ENGINE_THREAD_WORKER] = THREAD_PLACEMENT_PERFORMANCE;
+}
+
+// Picks a logical core to pin to. A physical core with nothing claimed comes first, so pinned
+// threads spread across cores before they share one; an exclusive thread that finds no whole
+// core left still gets a logical core of its own.
+static uint32 pickLogical(const CpuTopology* topology, const CpuSet* claimed)
+{
+    for (uint32 pass = 0; pass < 3; pass++)
+    {
+        // Pass 0: free physical core of the top class, 1: free logical core of the top class,
+        // 2: any free logical core
+        for (uint32 performanceClass = topology->maxPerformanceClass + 1; performanceClass-- > 0;)
+        {
+            if (pass < 2 && performanceClass != topology->maxPerformanceClass)
+            {
+                continue;
+            }
+            for (uint32 i = 0; i < topology->logicalCount; i++)
+            {
+                const CpuLogicalCore& logical = topology->logical[i];
+                if (logical.performanceClass != performanceClass || cpuSetHas(claimed, logical.id))
+                {
+                    continue;
+                }
+                bool coreFree = true;
+                for (uint32 j = 0; j < topology->logicalCount; j++)
+                {
+                    coreFree = coreFree && (topology->logical[j].core != logical.core || !cpuSetHas(claimed, topology->logical[j].id));
+                }
+                if (pass == 0 && !coreFree)
+                {
+                    continue;
+                }
+                return i;
+            }
+        }
+    }
+    return CPU_NO_ID;
+}
+
+void cpuPlacementBuildPlan(const CpuTopology* topology, const e_threadPlacement* policies, CpuPlacementPlan* plan)
+{
+    memset(plan, 0, sizeof(*plan));
+    CpuSet claimed;
+    cpuSetClear(&claimed);
+
+    // Exclusive roles first, in role order, then plain pins
+    for (uint32 pass = 0; pass < 2; pass++)
+    {
+        e_threadPlacement wanted = pass == 0 ? THREAD_PLACEMENT_EXCLUSIVE_CORE : THREAD_PLACEMENT_PIN;
+        for (uint32 role = 0; role < ENGINE_THREAD_COUNT; role++)
+        {
+            plan->policies[role] = policies[role];
+            if (policies[role] != wanted)
+            {
+                continue;
+            }
+
+            // Workers get a core each as far as they go, every other role is one thread
+            uint32 wantedCount = role == ENGINE_THREAD_WORKER ? CPU_PLACEMENT_MAX_PINNED : 1;
+            while (plan->pinnedCount[role] < wantedCount)
+            {
+                uint32 index = pickLogical(topology, &claimed);
+                if (index == CPU_NO_ID)
+                {
+                    break;
+                }
+                const CpuLogicalCore& logical = topology->logical[index];
+                plan->pinned[role][plan->pinnedCount[role]++] = logical.id;
+                cpuSetAdd(&claimed, logical.id);
+                if (wanted == THREAD_PLACEMENT_EXCLUSIVE_CORE)
+                {
+                    for (uint32 j = 0; j < topology->logicalCount; j++)
+                    {
+                        if (topology->logical[j].core == logical.core)
+                        {
+                            cpuSetAdd(&claimed, topology->logical[j].id);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Shared sets avoid claimed cores when anything else is left
+    for (uint32 role = 0; role < ENGINE_THREAD_COUNT; role++)
+    {
+        CpuSet preferred, fallback;
+        cpuSetClear(&preferred);
+        cpuSetClear(&fallback);
+        for (uint32 i = 0; i < topology->logicalCount; i++)
+        {
+            const CpuLogicalCore& logical = topology->logical[i];
+            bool matches = true;
+            if (policies[role] == THREAD_PLACEMENT_EFFICIENCY && topology->hybrid)
+            {
+                matches = logical.performanceClass < topology->maxPerformanceClass;
+            }
+            else if (policies[role] != THREAD_PLACEMENT_EFFICIENCY)
+            {
+                matches = logical.performanceClass == topology->maxPerformanceClass;
+            }
+            if (matches)
+            {
+                cpuSetAdd(&fallback, logical.id);
+                if (!cpuSetHas(&claimed, logical.id))
+                {
+                    cpuSetAdd(&preferred, logical.id);
+                }
+            }
+        }
+        plan->shared[role] = cpuSetCount(&preferred) ? preferred : fallback;
+    }
+}
+
+struct PlacedThread
+{
+    bool used;
+    e_engineThread role;
+    uint32 index;
+#if SGS_PLATFORM_WINDOWS
+    HANDLE handle;
+    DWORD id;
+#else
+    pthread_t handle;
+#endif
+};
+
+static struct
+{
+    std::mutex mutex;
+    bool active;
+    CpuPlacementPlan plan;
+    PlacedThread threads[CPU_PLACEMENT_MAX_THREADS];
+} placement;
+
+static bool setAffinity(const PlacedThread& thread, const CpuSet* set)
+{
+#if SGS_PLATFORM_WINDOWS
+    return SetThreadAffinityMask(thread.handle, (DWORD_PTR)set->bits[0]) != 0;
+#else
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (uint32 cpu = 0; cpu < CPU_MAX_LOGICAL_CORES && cpu < CPU_SETSIZE; cpu++)
+    {
+        if (cpuSetHas(set, cpu))
+        {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    return pthread_setaffinity_np(thread.handle, sizeof(cpus), &cpus) == 0;
+#endif
+}
+
+// Called with the mutex held
+static void placeThread(const PlacedThread& thread)
+{
+    const CpuPlacementPlan& plan = placement.plan;
+    e_threadPlacement policy = plan.policies[thread.role];
+    if (!placement.active || policy == THREAD_PLACEMENT_ANY)
+    {
+        return;
+    }
+
+    CpuSet set;
+    uint32 pinnedCount = plan.pinnedCount[thread.role];
+    if ((policy == THREAD_PLACEMENT_PIN || policy == THREAD_PLACEMENT_EXCLUSIVE_CORE) && pinnedCount)
+    {
+        cpuSetClear(&set);
+        cpuSetAdd(&set, plan.pinned[thread.role][thread.index % pinnedCount]);
+    }
+    else
+    {
+        set = plan.shared[thread.role];
+    }
+
+    if (!setAffinity(thread, &set))
+    {
+        SGSWARN("Could not place the %s thread (%s)", cpuEngineThreadName(thread.role), cpuPlacementName(policy));
+    }
+}
+
+void cpuPlacementInitialize(const CpuPlacementPlan* plan)
+{
+    std::lock_guard<std::mutex> lock(placement.mutex);
+    placement.plan = *plan;
+    placement.active = true;
+    for (uint32 i = 0; i < CPU_PLACEMENT_MAX_THREADS; i++)
+    {
+        if (placement.threads[i].used)
+        {
+            placeThread(placement.threads[i]);
+        }
+    }
+}
+
+void cpuPlacementShutdown()
+{
+    std::lock_guard<std::mutex> lock(placement.mutex);
+    placement.active = false;
+}
+
+void cpuPlacementAttachThread(e_engineThread role, uint32 index)
+{
+    std::lock_guard<std::mutex> lock(placement.mutex);
+    for (uint32 i = 0; i < CPU_PLACEMENT_MAX_THREADS; i++)
+    {
+        PlacedThread& thread = placement.threads[i];
+        if (thread.used)
+        {
+            continue;
+        }
+        thread.used = true;
+        thread.role = role;
+        thread.index = index;
+#if SGS_PLATFORM_WINDOWS
+        thread.id = GetCurrentThreadId();
+        thread.handle = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, false, thread.id);
+#else
+        thread.handle = pthread_self();
+#endif
+        placeThread(thread);
+        return;
+    }
+}
+
+void cpuPlacementDetachThread()
+{
+    std::lock_guard<std::mutex> lock(placement.mutex);
+    for (uint32 i = 0; i < CPU_PLACEMENT_MAX_THREADS; i++)
+    {
+        PlacedThread& thread = placement.threads[i];
+#if SGS_PLATFORM_WINDOWS
+        if (thread.used && thread.id == GetCurrentThreadId())
+        {
+            CloseHandle(thread.handle);
+            thread.used = false;
+            return;
+        }
+#else
+        if (thread.used && pthread_equal(thread.handle, pthread_self()))
+        {
+            thread.used = false;
+            return;
+        }
+#endif
+    }
+}
+
+bool cpuSetCurrentThreadAffinity(const CpuSet* set)
+{
+    PlacedThread self = {};
+#if SGS_PLATFORM_WINDOWS
+    self.handle = GetCurrentThread();
+#else
+    self.handle = pthread_self();
+#endif
+    return setAffinity(self, set);
+}
+
+bool cpuGetCurrentThreadAffinity(CpuSet* set)
+{
+    cpuSetClear(set);
+#if SGS_PLATFORM_WINDOWS
+    // SetThreadAffinityMask returns the previous mask, so set it back right away
+    DWORD_PTR process, system;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system))
+    {
+        return false;
+    }
+    DWORD_PTR previous = SetThreadAffinityMask(GetCurrentThread(), process);
+    if (!previous)
+    {
+        return false;
+    }
+    SetThreadAffinityMask(GetCurrentThread(), previous);
+    set->bits[0] = (uint64)previous;
+    return true;
+#else
+    cpu_set_t cpus;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+    {
+        return false;
+    }
+    for (uint32 cpu = 0; cpu < CPU_MAX_LOGICAL_CORES && cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &cpus))
+        {
+            cpuSetAdd(set, cpu);
+        }
+    }
+    return true;
+#endif
+}
+
+const char* cpuPlacementName(e_threadPlacement placement)
+{
+    switch (placement)
+    {
+        case THREAD_PLACEMENT_ANY: return "any";
+        case THREAD_PLACEMENT_PERFORMANCE: return "performance";
+        case THREAD_PLACEMENT_EFFICIENCY: return "efficiency";
+        case THREAD_PLACEMENT_PIN: return "pin";
+        case THREAD_PLACEMENT_EXCLUSIVE_CORE: return "exclusive core";
+    }
+    return "unknown";
+}
+
+const char* cpuEngineThreadName(e_engineThread role)
+{
+    switch (role)
+    {
+        case ENGINE_THREAD_MAIN: return "main";
+        case ENGINE_THREAD_RENDER: return "render";
+        case ENGINE_THREAD_WINDOW: return "window";
+        case ENGINE_THREAD_LOGGER: return "logger";
+        case ENGINE_THREAD_LOADER: return "loader";
+        case ENGINE_THREAD_WORKER: return "worker";
+        case ENGINE_THREAD_COUNT: break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "defines.h"
+
+// Where engine threads can run. cpuTopologyDetect reads /sys on Linux and
+// GetLogicalProcessorInformationEx on Windows. Each logical core gets:
+// - the physical core it belongs to, which identifies its SMT siblings
+// - its package and NUMA node
+// - the cores it shares its L2 and L3 with
+// - a performance class
+//
+// Engine threads then ask for a placement policy instead of a core number. The plan built from
+// the topology turns each policy into a CPU set.
+
+#define CPU_MAX_LOGICAL_CORES 256
+
+struct CpuSet
+{
+    uint64 bits[CPU_MAX_LOGICAL_CORES / 64];
+};
+
+inline void cpuSetClear(CpuSet* set)
+{
+    for (uint32 i = 0; i < CPU_MAX_LOGICAL_CORES / 64; i++)
+    {
+        set->bits[i] = 0;
+    }
+}
+
+inline void cpuSetAdd(CpuSet* set, uint32 cpu)
+{
+    set->bits[cpu / 64] |= 1ull << (cpu % 64);
+}
+
+inline bool cpuSetHas(const CpuSet* set, uint32 cpu)
+{
+    return (set->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+uint32 cpuSetCount(const CpuSet* set);
+// "0-3,8,10-11", the format of the /sys cpu lists. Returns false on malformed input.
+bool cpuSetParseList(const char* text, CpuSet* set);
+void cpuSetFormatList(const CpuSet* set, char* out, uint32 outSize);
+
+struct CpuLogicalCore
+{
+    uint32 id;                      // OS processor number
+    uint32 core;                    // physical core index, shared by SMT siblings
+    uint32 package;
+    uint32 numaNode;
+    uint32 l2Group;                 // logical cores with the same group share that cache
+    uint32 l3Group;
+    uint32 performanceClass;        // higher is faster; all equal on non-hybrid parts
+};
+
+struct CpuTopology
+{
+    CpuLogicalCore logical[CPU_MAX_LOGICAL_CORES];
+    uint32 logicalCount;
+    uint32 coreCount;
+    uint32 packageCount;
+    uint32 numaNodeCount;
+    uint32 l3GroupCount;
+    uint32 maxPerformanceClass;
+    bool smt;                       // some core has more than one logical core
+    bool hybrid;                    // cores of more than one performance class
+};
+
+// Falls back to one package of hardware_concurrency independent cores if nothing can be read
+bool cpuTopologyDetect(CpuTopology* topology);
+// Linux backend with a configurable root, "/sys" normally
+bool cpuTopologyFromSysfs(const char* sysRoot, CpuTopology* topology);
+void cpuTopologyLog(const CpuTopology* topology);
+
+typedef enum e_threadPlacement {
+    THREAD_PLACEMENT_ANY = 0,               // left to the OS
+    THREAD_PLACEMENT_PERFORMANCE = 1,       // any performance core
+    THREAD_PLACEMENT_EFFICIENCY = 2,        // efficiency cores on hybrid parts, anything else otherwise
+    THREAD_PLACEMENT_PIN = 3,               // one logical core of its own, on a performance core
+    THREAD_PLACEMENT_EXCLUSIVE_CORE = 4     // PIN with the SMT siblings kept free of other placed threads
+}e_threadPlacement;
+
+typedef enum e_engineThread {
+    ENGINE_THREAD_MAIN = 0,                 // simulation
+    ENGINE_THREAD_RENDER = 1,
+    ENGINE_THREAD_WINDOW = 2,
+    ENGINE_THREAD_LOGGER = 3,
+    ENGINE_THREAD_LOADER = 4,
+    ENGINE_THREAD_WORKER = 5,
+    ENGINE_THREAD_COUNT
+}e_engineThread;
+
+// How many threads of a role get their own core with PIN and EXCLUSIVE_CORE
+#define CPU_PLACEMENT_MAX_PINNED 16
+
+struct CpuPlacementPlan
+{
+    e_threadPlacement policies[ENGINE_THREAD_COUNT];
+    CpuSet shared[ENGINE_THREAD_COUNT];     // ANY, PERFORMANCE, EFFICIENCY
+    uint32 pinned[ENGINE_THREAD_COUNT][CPU_PLACEMENT_MAX_PINNED];
+    uint32 pinnedCount[ENGINE_THREAD_COUNT];
+};
+
+// Latency critical roles (render, main) claim whole cores first, background roles stay off them
+void cpuPlacementDefaultPolicies(e_threadPlacement* policies);
+void cpuPlacementBuildPlan(const CpuTopology* topology, const e_threadPlacement* policies, CpuPlacementPlan* plan);
+
+// Engine threads attach themselves when they start and detach before they exit. Attaching
+// applies the active plan; threads attached before cpuPlacementInitialize (the logger starts
+// first) are placed when it runs. index tells threads of one role apart; pinned roles with
+// more threads than cores reuse the cores round robin.
+#define CPU_PLACEMENT_MAX_THREADS 64
+
+void cpuPlacementInitialize(const CpuPlacementPlan* plan);
+// Leaves affinities as they are and stops placing newly attached threads
+void cpuPlacementShutdown();
+void cpuPlacementAttachThread(e_engineThread role, uint32 index);
+void cpuPlacementDetachThread();
+
+// Raw affinity of the calling thread, returns false if the OS refused
+bool cpuSetCurrentThreadAffinity(const CpuSet* set);
+bool cpuGetCurrentThreadAffinity(CpuSet* set);
+const char* cpuPlacementName(e_threadPlacement placement);
+const char* cpuEngineThreadName(e_engineThread role);
@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "deferred_release.h"
+#include "assertions.h"
+
+// Released per pass outside the queue mutex
+#define DEFERRED_RELEASE_BATCH 64
+
+void deferredReleaseInitialize(DeferredReleaseQueue* queue, RhiFence* fence)
+{
+    queue->fence = fence;
+    queue->entries = nullptr;
+    queue->head = 0;
+    queue->count = 0;
+    queue->capacity = 0;
+    queue->lastValue = 0;
+    memset(&queue->stats, 0, sizeof(queue->stats));
+}
+
+void deferredReleaseShutdown(DeferredReleaseQueue* queue)
+{
+    if (queue->count)
+    {
+        rhiFenceWait(queue->fence, queue->lastValue);
+        deferredReleaseCollect(queue);
+    }
+    SGSASSERT(queue->count == 0);
+    free(queue->entries);
+    queue->entries = nullptr;
+    queue->capacity = 0;
+}
+
+static void grow(DeferredReleaseQueue* queue)
+{
+    uint32 capacity = queue->capacity ? queue->capacity * 2 : 64;
+    DeferredRelease* entries = (DeferredRelease*)malloc(capacity * sizeof(DeferredRelease));
+    SGSASSERT(entries);
+    for (uint32 i = 0; i < queue->count; i++)
+    {
+        entries[i] = queue->entries[(queue->head + i) % queue->capacity];
+    }
+    free(queue->entries);
+    queue->entries = entries;
+    queue->head = 0;
+    queue->capacity = capacity;
+}
+
+static void retire(DeferredReleaseQueue* queue, e_deferredReleaseType type, void* object, PFN_deferredRelease release, void* userData, uint64 bytes, uint64 fenceValue)
+{
+    if (!object)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->count == queue->capacity)
+    {
+        grow(queue);
+    }
+    if (fenceValue < queue->lastValue)
+    {
+        fenceValue = queue->lastValue;
+    }
+    queue->lastValue = fenceValue;
+
+    DeferredRelease& entry = queue->entries[(queue->head + queue->count) % queue->capacity];
+    entry.fenceValue = fenceValue;
+    entry.bytes = bytes;
+    entry.object = object;
+    entry.release = release;
+    entry.userData = userData;
+    entry.type = type;
+    queue->count++;
+
+    DeferredReleaseStats& stats = queue->stats;
+    stats.pending++;
+    stats.pendingBytes += bytes;
+    stats.pendingByType[type]++;
+    stats.peakPending = stats.pending > stats.peakPending ? stats.pending : stats.peakPending;
+    stats.peakPendingBytes = stats.pendingBytes > stats.peakPendingBytes ? stats.pendingBytes : stats.peakPendingBytes;
+}
+
+void deferredReleaseResource(DeferredReleaseQueue* queue, RhiResource* resource, uint64 fenceValue)
+{
+    uint64 bytes = resource ? rhiResourceMemorySize(resource) : 0;
+    retire(queue, DEFERRED_RELEASE_RESOURCE, resource, nullptr, nullptr, bytes, fenceValue);
+}
+
+void deferredReleaseHeap(DeferredReleaseQueue* queue, RhiHeap* heap, uint64 fenceValue)
+{
+    uint64 bytes = heap ? rhiGetHeapDesc(heap).size : 0;
+    retire(queue, DEFERRED_RELEASE_HEAP, heap, nullptr, nullptr, bytes, fenceValue);
+}
+
+void deferredReleasePipeline(DeferredReleaseQueue* queue, RhiPipeline* pipeline, uint64 fenceValue)
+{
+    retire(queue, DEFERRED_RELEASE_PIPELINE, pipeline, nullptr, nullptr, 0, fenceValue);
+}
+
+void deferredReleaseCommandAllocator(DeferredReleaseQueue* queue, RhiCommandAllocator* allocator, uint64 fenceValue)
+{
+    retire(queue, DEFERRED_RELEASE_COMMAND_ALLOCATOR, allocator, nullptr, nullptr, 0, fenceValue);
+}
+
+void deferredReleaseCallback(DeferredReleaseQueue* queue, void* object, PFN_deferredRelease release, void* userData, uint64 bytes, uint64 fenceValue)
+{
+    retire(queue, DEFERRED_RELEASE_CALLBACK, object, release, userData, bytes, fenceValue);
+}
+
+static void releaseEntry(const DeferredRelease& entry)
+{
+    switch (entry.type)
+    {
+        case DEFERRED_RELEASE_RESOURCE: rhiDestroyResource((RhiResource*)entry.object); break;
+        case DEFERRED_RELEASE_HEAP: rhiDestroyHeap((RhiHeap*)entry.object); break;
+        case DEFERRED_RELEASE_PIPELINE: rhiDestroyPipeline((RhiPipeline*)entry.object); break;
+        case DEFERRED_RELEASE_COMMAND_ALLOCATOR: rhiDestroyCommandAllocator((RhiCommandAllocator*)entry.object); break;
+        case DEFERRED_RELEASE_CALLBACK: entry.release(entry.object, entry.userData); break;
+        default: SGSASSERT(false); break;
+    }
+}
+
+uint32 deferredReleaseCollect(DeferredReleaseQueue* queue)
+{
+    uint32 released = 0;
+    uint64 completed = 0;
+    bool queried = false;
+    for (;;)
+    {
+        DeferredRelease batch[DEFERRED_RELEASE_BATCH];
+        uint32 batchCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (queue->count == 0)
+            {
+                return released;
+            }
+            // One fence query per collect; the front entry is the oldest
+            if (!queried)
+            {
+                completed = rhiFenceCompletedValue(queue->fence);
+                queried = true;
+            }
+            while (queue->count && batchCount < DEFERRED_RELEASE_BATCH && queue->entries[queue->head].fenceValue <= completed)
+            {
+                const DeferredRelease& entry = queue->entries[queue->head];
+                batch[batchCount++] = entry;
+                queue->stats.pending--;
+                queue->stats.pendingBytes -= entry.bytes;
+                queue->stats.pendingByType[entry.type]--;
+                queue->stats.released++;
+                queue->stats.releasedBytes += entry.bytes;
+                queue->head = (queue->head + 1) % queue->capacity;
+                queue->count--;
+            }
+        }
+        if (batchCount == 0)
+        {
+            return released;
+        }
+        for (uint32 i = 0; i < batchCount; i++)
+        {
+            releaseEntry(batch[i]);
+        }
+        released += batchCount;
+    }
+}
+
+void deferredReleaseGetStats(DeferredReleaseQueue* queue, DeferredReleaseStats* stats)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    *stats = queue->stats;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <mutex>
+
+#include "rhi.h"
+
+// Deferred destruction. Objects the GPU may still be using are retired with the fence value of
+// their last use and released in bulk once the fence reached it, so a release never waits for
+// the GPU. Retiring works from any thread; collecting belongs to the thread that owns the fence's
+// frames. Entries are kept in retirement order: a value lower than one retired before it is
+// raised to that one, which only makes the release later.
+
+typedef enum e_deferredReleaseType {
+    DEFERRED_RELEASE_RESOURCE = 0,
+    DEFERRED_RELEASE_HEAP = 1,
+    DEFERRED_RELEASE_PIPELINE = 2,
+    DEFERRED_RELEASE_COMMAND_ALLOCATOR = 3,
+    DEFERRED_RELEASE_CALLBACK = 4,      // descriptors and whatever else the caller frees itself
+    DEFERRED_RELEASE_TYPE_COUNT
+}e_deferredReleaseType;
+
+typedef void (*PFN_deferredRelease)(void* object, void* userData);
+
+struct DeferredRelease
+{
+    uint64 fenceValue;
+    uint64 bytes;
+    void* object;
+    PFN_deferredRelease release;        // callbacks only
+    void* userData;
+    e_deferredReleaseType type;
+};
+
+struct DeferredReleaseStats
+{
+    uint64 pending;
+    uint64 pendingBytes;
+    uint64 pendingByType[DEFERRED_RELEASE_TYPE_COUNT];
+    uint64 peakPending;
+    uint64 peakPendingBytes;
+    uint64 released;                    // since initialization
+    uint64 releasedBytes;
+};
+
+struct DeferredReleaseQueue
+{
+    RhiFence* fence;
+    std::mutex mutex;
+    DeferredRelease* entries;           // ring
+    uint32 head;
+    uint32 count;
+    uint32 capacity;
+    uint64 lastValue;
+    DeferredReleaseStats stats;
+};
+
+void deferredReleaseInitialize(DeferredReleaseQueue* queue, RhiFence* fence);
+// Waits for the last retired value, then releases everything
+void deferredReleaseShutdown(DeferredReleaseQueue* queue);
+
+// All of these accept nullptr and do nothing
+void deferredReleaseResource(DeferredReleaseQueue* queue, RhiResource* resource, uint64 fenceValue);
+void deferredReleaseHeap(DeferredReleaseQueue* queue, RhiHeap* heap, uint64 fenceValue);
+void deferredReleasePipeline(DeferredReleaseQueue* queue, RhiPipeline* pipeline, uint64 fenceValue);
+void deferredReleaseCommandAllocator(DeferredReleaseQueue* queue, RhiCommandAllocator* allocator, uint64 fenceValue);
+// release(object, userData) runs on the collecting thread once fenceValue completed. bytes is
+// only reported.
+void deferredReleaseCallback(DeferredReleaseQueue* queue, void* object, PFN_deferredRelease release, void* userData, uint64 bytes, uint64 fenceValue);
+
+// Releases everything whose fence value completed and returns how many. Never blocks on the GPU.
+uint32 deferredReleaseCollect(DeferredReleaseQueue* queue);
+void deferredReleaseGetStats(DeferredReleaseQueue* queue, DeferredReleaseStats* stats);
@@ -37,4 +37,26 @@ STATIC_ASSERT(sizeof(bool) == 1, "Expected bool to be 8 byte.");
 #define BIT(x) (1 << x)
 
 // Pass function X with the event as parameter in arg position _1
-#define BIND_EVENT_FUNC(x) std::bind(&x, this, std::placeholders::_1)
\ No newline at end of file
+#define BIND_EVENT_FUNC(x) std::bind(&x, this, std::placeholders::_1)
+
+// Platform detection
+#if defined(_WIN32)
+#define SGS_PLATFORM_WINDOWS 1
+#elif defined(__linux__)
+#define SGS_PLATFORM_LINUX 1
+#endif
+
+#define SGS_CACHE_LINE_SIZE 64
+
+// Branch hints and function attributes for hot/cold path splitting
+#if defined(__GNUC__) || defined(__clang__)
+#define SGS_LIKELY(x) __builtin_expect(!!(x), 1)
+#define SGS_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define SGS_NOINLINE __attribute__((noinline))
+#define SGS_COLD __attribute__((cold))
+#else
+#define SGS_LIKELY(x) (x)
+#define SGS_UNLIKELY(x) (x)
+#define SGS_NOINLINE __declspec(noinline)
+#define SGS_COLD
+#endif
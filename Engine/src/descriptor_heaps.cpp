@@ -0,0 +1,274 @@
+#include "descriptor_heaps.h"
+#include "assertions.h"
+#include "logger.h"
+
+// Free lists hand out the lowest indices first
+static void fillFreeList(uint32* freeList, uint32 capacity)
+{
+    for (uint32 i = 0; i < capacity; i++)
+    {
+        freeList[i] = capacity - 1 - i;
+    }
+}
+
+bool descriptorAllocatorInitialize(DescriptorAllocator* allocator, RhiDevice* device, e_rhiDescriptorHeapType type, uint32 capacity, const char* name)
+{
+    RhiDescriptorHeapDesc desc;
+    desc.type = type;
+    desc.capacity = capacity;
+    allocator->heap = rhiCreateDescriptorHeap(device, desc, name);
+    allocator->capacity = capacity;
+    allocator->freeList = new uint32[capacity];
+    allocator->freeCount = allocator->heap ? capacity : 0;
+    fillFreeList(allocator->freeList, capacity);
+    return allocator->heap != nullptr;
+}
+
+void descriptorAllocatorShutdown(DescriptorAllocator* allocator)
+{
+    SGSASSERT_MSG(allocator->freeCount == allocator->capacity || !allocator->heap, "Descriptors still allocated at shutdown");
+    if (allocator->heap)
+    {
+        rhiDestroyDescriptorHeap(allocator->heap);
+    }
+    delete[] allocator->freeList;
+    allocator->heap = nullptr;
+    allocator->freeList = nullptr;
+    allocator->freeCount = 0;
+}
+
+uint32 descriptorAllocate(DescriptorAllocator* allocator)
+{
+    std::lock_guard<std::mutex> lock(allocator->mutex);
+    if (allocator->freeCount == 0)
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Descriptor heap of %u descriptors is full", allocator->capacity);
+        return DESCRIPTOR_INVALID;
+    }
+    return allocator->freeList[--allocator->freeCount];
+}
+
+void descriptorFree(DescriptorAllocator* allocator, uint32 index)
+{
+    if (index == DESCRIPTOR_INVALID)
+    {
+        return;
+    }
+    SGSASSERT(index < allocator->capacity);
+    std::lock_guard<std::mutex> lock(allocator->mutex);
+    SGSASSERT_MSG(allocator->freeCount < allocator->capacity, "Descriptor freed twice");
+    allocator->freeList[allocator->freeCount++] = index;
+}
+
+bool shaderDescriptorHeapInitialize(ShaderDescriptorHeap* heap, RhiDevice* device, RhiFence* fence, uint32 capacity, uint32 bindlessCapacity, const char* name)
+{
+    SGSASSERT(bindlessCapacity < capacity);
+    RhiDescriptorHeapDesc desc;
+    desc.type = RHI_DESCRIPTOR_HEAP_RESOURCE;
+    desc.capacity = capacity;
+    desc.shaderVisible = true;
+    heap->heap = rhiCreateDescriptorHeap(device, desc, name);
+    heap->fence = fence;
+
+    heap->bindlessCapacity = bindlessCapacity;
+    heap->freeList = new uint32[bindlessCapacity];
+    heap->freeCount = heap->heap ? bindlessCapacity : 0;
+    fillFreeList(heap->freeList, bindlessCapacity);
+    // Nothing can be freed more often than it was allocated
+    heap->retired = new RetiredDescriptor[bindlessCapacity];
+    heap->retiredHead = 0;
+    heap->retiredCount = 0;
+
+    heap->ringCapacity = capacity - bindlessCapacity;
+    heap->ringHead = 0;
+    heap->ringTail = 0;
+    heap->frameHead = 0;
+    heap->frameCount = 0;
+    heap->tables = 0;
+    heap->tableDescriptors = 0;
+    heap->ringFull = 0;
+    return heap->heap != nullptr;
+}
+
+void shaderDescriptorHeapShutdown(ShaderDescriptorHeap* heap)
+{
+    if (heap->heap)
+    {
+        rhiDestroyDescriptorHeap(heap->heap);
+    }
+    delete[] heap->freeList;
+    delete[] heap->retired;
+    heap->heap = nullptr;
+    heap->freeList = nullptr;
+    heap->retired = nullptr;
+    heap->freeCount = 0;
+    heap->retiredCount = 0;
+}
+
+// Called with the bindless mutex held
+static void collectRetired(ShaderDescriptorHeap* heap, uint64 completed)
+{
+    while (heap->retiredCount && heap->retired[heap->retiredHead].fenceValue <= completed)
+    {
+        heap->freeList[heap->freeCount++] = heap->retired[heap->retiredHead].index;
+        heap->retiredHead = (heap->retiredHead + 1) % heap->bindlessCapacity;
+        heap->retiredCount--;
+    }
+}
+
+uint32 shaderDescriptorAllocate(ShaderDescriptorHeap* heap)
+{
+    std::lock_guard<std::mutex> lock(heap->bindlessMutex);
+    if (heap->freeCount == 0)
+    {
+        // Freed descriptors normally come back at the start of a frame; this is for bursts
+        collectRetired(heap, rhiFenceCompletedValue(heap->fence));
+        if (heap->freeCount == 0)
+        {
+            SGSERROR_CAT(LOG_CATEGORY_RENDER, "Bindless descriptor region of %u descriptors is full", heap->bindlessCapacity);
+            return DESCRIPTOR_INVALID;
+        }
+    }
+    return heap->freeList[--heap->freeCount];
+}
+
+void shaderDescriptorFree(ShaderDescriptorHeap* heap, uint32 index, uint64 retireValue)
+{
+    if (index == DESCRIPTOR_INVALID)
+    {
+        return;
+    }
+    SGSASSERT(index < heap->bindlessCapacity);
+    std::lock_guard<std::mutex> lock(heap->bindlessMutex);
+    SGSASSERT_MSG(heap->freeCount + heap->retiredCount < heap->bindlessCapacity, "Bindless descriptor freed twice");
+    uint32 tail = (heap->retiredHead + heap->retiredCount) % heap->bindlessCapacity;
+    heap->retired[tail] = { index, retireValue };
+    heap->retiredCount++;
+}
+
+void shaderDescriptorBeginFrame(ShaderDescriptorHeap* heap)
+{
+    uint64 completed = rhiFenceCompletedValue(heap->fence);
+    while (heap->frameCount && heap->frames[heap->frameHead].fenceValue <= completed)
+    {
+        heap->ringTail = heap->frames[heap->frameHead].end;
+        heap->frameHead = (heap->frameHead + 1) % DESCRIPTOR_RING_MAX_FRAMES;
+        heap->frameCount--;
+    }
+
+    std::lock_guard<std::mutex> lock(heap->bindlessMutex);
+    collectRetired(heap, completed);
+}
+
+uint32 shaderDescriptorAllocateTable(ShaderDescriptorHeap* heap, uint32 count)
+{
+    SGSASSERT(count > 0);
+    // Tables are contiguous: one that would wrap starts over at the beginning of the ring
+    uint64 position = heap->ringHead % heap->ringCapacity;
+    uint64 skip = position + count > heap->ringCapacity ? heap->ringCapacity - position : 0;
+    if (heap->ringHead + skip + count - heap->ringTail > heap->ringCapacity)
+    {
+        heap->ringFull++;
+        SGSWARN_CAT(LOG_CATEGORY_RENDER, "Descriptor ring full: %llu of %u descriptors in use, %u requested",
+            (unsigned long long)(heap->ringHead - heap->ringTail), heap->ringCapacity, count);
+        return DESCRIPTOR_INVALID;
+    }
+    heap->ringHead += skip;
+    uint32 first = heap->bindlessCapacity + (uint32)(heap->ringHead % heap->ringCapacity);
+    heap->ringHead += count;
+    heap->tables++;
+    heap->tableDescriptors += count;
+    return first;
+}
+
+void shaderDescriptorEndFrame(ShaderDescriptorHeap* heap, uint64 fenceValue)
+{
+    // Out of frame slots the newest one takes this frame too, retiring a little later
+    if (heap->frameCount == DESCRIPTOR_RING_MAX_FRAMES)
+    {
+        DescriptorRingFrame& newest = heap->frames[(heap->frameHead + heap->frameCount - 1) % DESCRIPTOR_RING_MAX_FRAMES];
+        newest.fenceValue = fenceValue;
+        newest.end = heap->ringHead;
+        return;
+    }
+    heap->frames[(heap->frameHead + heap->frameCount) % DESCRIPTOR_RING_MAX_FRAMES] = { fenceValue, heap->ringHead };
+    heap->frameCount++;
+}
+
+void shaderDescriptorHeapGetStats(ShaderDescriptorHeap* heap, ShaderDescriptorHeapStats* stats)
+{
+    {
+        std::lock_guard<std::mutex> lock(heap->bindlessMutex);
+        stats->bindlessCapacity = heap->bindlessCapacity;
+        stats->bindlessAllocated = heap->bindlessCapacity - heap->freeCount - heap->retiredCount;
+        stats->bindlessRetired = heap->retiredCount;
+    }
+    stats->ringCapacity = heap->ringCapacity;
+    stats->ringInUse = (uint32)(heap->ringHead - heap->ringTail);
+    stats->tables = heap->tables;
+    stats->tableDescriptors = heap->tableDescriptors;
+    stats->ringFull = heap->ringFull;
+}
+
+void descriptorCopyBatchInitialize(DescriptorCopyBatch* batch, RhiDevice* device)
+{
+    batch->device = device;
+    batch->count = 0;
+    batch->uncounted = 0;
+    batch->stats = DescriptorCopyBatchStats();
+}
+
+static void issueCopies(DescriptorCopyBatch* batch)
+{
+    if (batch->count == 0)
+    {
+        return;
+    }
+    rhiCopyDescriptors(batch->device, batch->copies, batch->count);
+    batch->stats.calls++;
+    batch->count = 0;
+}
+
+void descriptorCopy(DescriptorCopyBatch* batch, RhiDescriptorHeap* destination, uint32 destinationIndex,
+    RhiDescriptorHeap* source, uint32 sourceIndex, uint32 count)
+{
+    batch->stats.copies++;
+    batch->stats.descriptors += count;
+    batch->uncounted += count;
+    if (batch->count)
+    {
+        RhiDescriptorCopy& last = batch->copies[batch->count - 1];
+        if (last.destination == destination && last.source == source &&
+            last.destinationIndex + last.count == destinationIndex && last.sourceIndex + last.count == sourceIndex)
+        {
+            last.count += count;
+            batch->stats.merged++;
+            return;
+        }
+        // One call copies between heaps of one type
+        if (rhiGetDescriptorHeapDesc(last.destination).type != rhiGetDescriptorHeapDesc(destination).type)
+        {
+            issueCopies(batch);
+        }
+    }
+    if (batch->count == DESCRIPTOR_COPY_BATCH)
+    {
+        issueCopies(batch);
+    }
+    batch->copies[batch->count++] = { destination, destinationIndex, source, sourceIndex, count };
+}
+
+void descriptorCopyFlush(DescriptorCopyBatch* batch, RhiCommandList* list)
+{
+    issueCopies(batch);
+    if (list && batch->uncounted)
+    {
+        rhiCmdAddCounter(list, RHI_COUNTER_DESCRIPTOR_COPIES, batch->uncounted);
+        batch->uncounted = 0;
+    }
+}
+
+void descriptorCopyBatchGetStats(const DescriptorCopyBatch* batch, DescriptorCopyBatchStats* stats)
+{
+    *stats = batch->stats;
+}
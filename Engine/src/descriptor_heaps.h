@@ -0,0 +1,138 @@
+#pragma once
+
+#include <mutex>
+
+#include "rhi.h"
+
+// Descriptor management on top of the RHI's descriptor heaps:
+// - DescriptorAllocator hands out single descriptors of a CPU-only heap, where views are written
+//   once and copied from wherever they are used. Allocating and freeing pop and push a free list.
+// - ShaderDescriptorHeap is the shader visible heap. Its first bindlessCapacity descriptors are
+//   the bindless region: an index stays valid until it is freed, so shaders can keep it, and it
+//   is only handed out again once the frames that could still read it completed. The rest is a
+//   ring per frame tables are allocated from linearly, reclaimed a frame at a time as the GPU
+//   finishes them.
+// - DescriptorCopyBatch collects copies and issues them with one rhiCopyDescriptors call,
+//   merging copies that continue the one before.
+
+#define DESCRIPTOR_INVALID 0xffffffff
+#define DESCRIPTOR_RING_MAX_FRAMES 8
+#define DESCRIPTOR_COPY_BATCH 256
+
+// Thread safe
+struct DescriptorAllocator
+{
+    RhiDescriptorHeap* heap;
+    uint32* freeList;
+    uint32 freeCount;
+    uint32 capacity;
+    std::mutex mutex;
+};
+
+bool descriptorAllocatorInitialize(DescriptorAllocator* allocator, RhiDevice* device, e_rhiDescriptorHeapType type, uint32 capacity, const char* name);
+void descriptorAllocatorShutdown(DescriptorAllocator* allocator);
+// DESCRIPTOR_INVALID when the heap is full
+uint32 descriptorAllocate(DescriptorAllocator* allocator);
+// The next allocation may overwrite it: CPU-only descriptors are only read by copies
+void descriptorFree(DescriptorAllocator* allocator, uint32 index);
+
+struct RetiredDescriptor
+{
+    uint32 index;
+    uint64 fenceValue;
+};
+
+struct DescriptorRingFrame
+{
+    uint64 fenceValue;
+    uint64 end;                         // ring position after the frame's last table
+};
+
+struct ShaderDescriptorHeapStats
+{
+    uint32 bindlessCapacity;
+    uint32 bindlessAllocated;
+    uint32 bindlessRetired;             // freed, waiting for the GPU
+    uint32 ringCapacity;
+    uint32 ringInUse;                   // by frames in flight and the current one
+    uint64 tables;
+    uint64 tableDescriptors;
+    uint64 ringFull;                    // table allocations that failed
+};
+
+struct ShaderDescriptorHeap
+{
+    RhiDescriptorHeap* heap;
+    RhiFence* fence;                    // the values freed descriptors and ended frames retire at
+
+    // Bindless region, any thread
+    std::mutex bindlessMutex;
+    uint32 bindlessCapacity;
+    uint32* freeList;
+    uint32 freeCount;
+    RetiredDescriptor* retired;         // FIFO, in the order they were freed
+    uint32 retiredHead;
+    uint32 retiredCount;
+
+    // Ring, the render thread only. Positions grow forever, the descriptor is the position
+    // modulo ringCapacity past the bindless region.
+    uint32 ringCapacity;
+    uint64 ringHead;
+    uint64 ringTail;
+    DescriptorRingFrame frames[DESCRIPTOR_RING_MAX_FRAMES];
+    uint32 frameHead;
+    uint32 frameCount;
+    uint64 tables;
+    uint64 tableDescriptors;
+    uint64 ringFull;
+};
+
+// capacity descriptors, the first bindlessCapacity of them bindless
+bool shaderDescriptorHeapInitialize(ShaderDescriptorHeap* heap, RhiDevice* device, RhiFence* fence, uint32 capacity, uint32 bindlessCapacity, const char* name);
+// Immediate: the GPU must be done with the heap
+void shaderDescriptorHeapShutdown(ShaderDescriptorHeap* heap);
+
+// A stable index in the bindless region, DESCRIPTOR_INVALID when it is full
+uint32 shaderDescriptorAllocate(ShaderDescriptorHeap* heap);
+// Handed out again once the fence reaches retireValue
+void shaderDescriptorFree(ShaderDescriptorHeap* heap, uint32 index, uint64 retireValue);
+
+// Reclaims the ring space and the bindless descriptors the GPU is done with. Call once per
+// frame before allocating its tables.
+void shaderDescriptorBeginFrame(ShaderDescriptorHeap* heap);
+// count contiguous descriptors for one of this frame's tables, DESCRIPTOR_INVALID when the ring
+// is full
+uint32 shaderDescriptorAllocateTable(ShaderDescriptorHeap* heap, uint32 count);
+// The frame's tables are reclaimed once the fence reaches fenceValue
+void shaderDescriptorEndFrame(ShaderDescriptorHeap* heap, uint64 fenceValue);
+
+void shaderDescriptorHeapGetStats(ShaderDescriptorHeap* heap, ShaderDescriptorHeapStats* stats);
+
+struct DescriptorCopyBatchStats
+{
+    uint64 copies;                      // requested
+    uint64 merged;                      // into the copy before
+    uint64 descriptors;
+    uint64 calls;                       // rhiCopyDescriptors calls they took
+};
+
+// One per recording thread
+struct DescriptorCopyBatch
+{
+    RhiDevice* device;
+    RhiDescriptorCopy copies[DESCRIPTOR_COPY_BATCH];
+    uint32 count;
+    uint64 uncounted;                   // copied, not yet added to a list's pass counters
+    DescriptorCopyBatchStats stats;
+};
+
+void descriptorCopyBatchInitialize(DescriptorCopyBatch* batch, RhiDevice* device);
+// Copies go out by themselves when the batch is full or the heap type changes
+void descriptorCopy(DescriptorCopyBatch* batch, RhiDescriptorHeap* destination, uint32 destinationIndex,
+    RhiDescriptorHeap* source, uint32 sourceIndex, uint32 count = 1);
+// Issues the batched copies with one rhiCopyDescriptors call. They count toward list's current
+// pass unless list is nullptr. Copies happen on the CPU timeline: flush before submitting the
+// lists that read them.
+void descriptorCopyFlush(DescriptorCopyBatch* batch, RhiCommandList* list);
+
+void descriptorCopyBatchGetStats(const DescriptorCopyBatch* batch, DescriptorCopyBatchStats* stats);
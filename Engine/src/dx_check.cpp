@@ -0,0 +1,68 @@
+#include <atomic>
+
+#include "dx_check.h"
+#include "logger.h"
+#include "flight_recorder.h"
+
+struct DxFailureRing
+{
+    DxFailure failures[DX_FAILURE_RING_SIZE];
+    std::atomic<uint64> sequences[DX_FAILURE_RING_SIZE];
+    std::atomic<uint64> count;
+};
+
+static DxFailureRing failureRing;
+
+void dxCheckFailed(HRESULT result, const DxCheckSite* site)
+{
+    uint64 sequence = failureRing.count.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32 slot = (uint32)((sequence - 1) % DX_FAILURE_RING_SIZE);
+
+    // The slot's sequence is published last so readers can tell a complete entry
+    failureRing.sequences[slot].store(0, std::memory_order_relaxed);
+    failureRing.failures[slot].result = result;
+    failureRing.failures[slot].site = site;
+    failureRing.failures[slot].sequence = sequence;
+    failureRing.sequences[slot].store(sequence, std::memory_order_release);
+
+    SGSRECORD(FLIGHT_EVENT_MARKER, site->expression, (uint32)result);
+    SGSERROR("%s failed with HRESULT 0x%08X in file %s, line: %d", site->expression, (uint32)result, site->file, site->line);
+
+    DxException exception;
+    exception.errorCode = result;
+    exception.site = site;
+    throw exception;
+}
+
+uint64 dxGetFailureCount()
+{
+    return failureRing.count.load(std::memory_order_relaxed);
+}
+
+uint32 dxGetRecentFailures(DxFailure* out, uint32 maxFailures)
+{
+    uint64 newest = failureRing.count.load(std::memory_order_acquire);
+    uint32 copied = 0;
+
+    for (uint64 sequence = newest; sequence > 0 && copied < maxFailures; sequence--)
+    {
+        if (newest - sequence >= DX_FAILURE_RING_SIZE)
+        {
+            break;
+        }
+
+        uint32 slot = (uint32)((sequence - 1) % DX_FAILURE_RING_SIZE);
+        if (failureRing.sequences[slot].load(std::memory_order_acquire) != sequence)
+        {
+            continue;
+        }
+
+        out[copied] = failureRing.failures[slot];
+        if (failureRing.sequences[slot].load(std::memory_order_acquire) == sequence)
+        {
+            copied++;
+        }
+    }
+
+    return copied;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "defines.h"
+
+#if SGS_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+// Lets the check path build and be benchmarked without the Windows headers
+typedef int32 HRESULT;
+#endif
+
+// HRESULT checking that costs a single predictable branch on success. The expression, file and
+// line live in a static const DxCheckSite per call site (read-only data, no runtime init); the
+// failure path is outlined into dxCheckFailed, which logs, keeps the failure in a ring for later
+// inspection and throws a DxException that owns no heap memory.
+
+#define DX_FAILURE_RING_SIZE 64
+
+struct DxCheckSite
+{
+    const char* expression;
+    const char* file;
+    int32 line;
+};
+
+struct DxFailure
+{
+    HRESULT result;
+    const DxCheckSite* site;
+    uint64 sequence;
+};
+
+struct DxException
+{
+    HRESULT errorCode;
+    const DxCheckSite* site;
+};
+
+SGS_NOINLINE SGS_COLD void dxCheckFailed(HRESULT result, const DxCheckSite* site);
+
+uint64 dxGetFailureCount();
+// Copies up to maxFailures of the most recent failures, newest first. Returns the number copied.
+uint32 dxGetRecentFailures(DxFailure* out, uint32 maxFailures);
+
+#ifndef DX_CHECK
+#define DX_CHECK(x)                                                         \
+{                                                                           \
+    HRESULT hr__ = (x);                                                     \
+    if (SGS_UNLIKELY(hr__ < 0))                                             \
+    {                                                                       \
+        static const DxCheckSite dxCheckSite__ = { #x, __FILE__, __LINE__ }; \
+        dxCheckFailed(hr__, &dxCheckSite__);                                \
+    }                                                                       \
+}
+#endif
+
+#ifndef ThrowIfFailed
+#define ThrowIfFailed(x) DX_CHECK(x)
+#endif
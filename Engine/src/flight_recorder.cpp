@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+
+#include "flight_recorder.h"
+
+#if SGS_PLATFORM_WINDOWS
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+STATIC_ASSERT((FLIGHT_RECORDER_EVENTS_PER_THREAD & (FLIGHT_RECORDER_EVENTS_PER_THREAD - 1)) == 0,
+    "Expected FLIGHT_RECORDER_EVENTS_PER_THREAD to be a power of two.");
+
+struct FlightRecorderState
+{
+    FlightRecorderThread* threads[FLIGHT_RECORDER_MAX_THREADS];
+    std::atomic<uint32> threadCount;    // slots ever handed out
+    std::atomic<bool> dumping;
+
+    // Slots of exited threads, handed to the next thread that registers
+    std::mutex slotMutex;
+    uint32 freeSlots[FLIGHT_RECORDER_MAX_THREADS];
+    uint32 freeSlotCount;
+    std::atomic<uint32> droppedThreads; // registrations with every slot held by a live thread
+
+    // Pairs a timestamp with steady clock nanoseconds so ticks can be converted at dump time
+    uint64 calibrationTimestamp;
+    int64 calibrationNanoseconds;
+    std::atomic<bool> calibrated;
+
+    char dumpPath[260];
+};
+
+static FlightRecorderState recorder;
+
+thread_local FlightRecorderThread* flightRecorderThread = nullptr;
+
+typedef enum e_threadRegistration {
+    THREAD_REGISTRATION_NONE = 0,
+    THREAD_REGISTRATION_ACTIVE = 1,
+    THREAD_REGISTRATION_DONE = 2,      // exited or dropped, never registers again
+}e_threadRegistration;
+
+static thread_local uint32 threadRegistration = THREAD_REGISTRATION_NONE;
+
+static const char* eventNames[FLIGHT_EVENT_TYPE_COUNT] = {
+    "FRAME_BEGIN", "FRAME_END", "FENCE_WAIT_BEGIN", "FENCE_WAIT_END", "RESOURCE_CREATE", "LOG", "MARKER"
+};
+
+static int64 steadyNanoseconds()
+{
+    using namespace std::chrono;
+    return (int64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns the slot when its thread exits. The ring stays in place so a later dump still shows the
+// exited thread's events, until the next owner of the slot overwrites them.
+struct FlightRecorderSlotOwner
+{
+    ~FlightRecorderSlotOwner()
+    {
+        FlightRecorderThread* thread = flightRecorderThread;
+        if (!thread)
+        {
+            return;
+        }
+        flightRecord(FLIGHT_EVENT_MARKER, "thread exit", thread->threadIndex);
+        flightRecorderThread = nullptr;
+        threadRegistration = THREAD_REGISTRATION_DONE;
+
+        std::lock_guard<std::mutex> lock(recorder.slotMutex);
+        recorder.freeSlots[recorder.freeSlotCount++] = thread->threadIndex;
+    }
+};
+
+FlightRecorderThread* flightRecorderRegisterThread()
+{
+    // Events recorded while the thread is torn down, or after it was dropped, are lost
+    if (threadRegistration != THREAD_REGISTRATION_NONE)
+    {
+        return nullptr;
+    }
+
+    bool expected = false;
+    if (recorder.calibrated.compare_exchange_strong(expected, true))
+    {
+        recorder.calibrationTimestamp = flightTimestamp();
+        recorder.calibrationNanoseconds = steadyNanoseconds();
+    }
+
+    FlightRecorderThread* thread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(recorder.slotMutex);
+        if (recorder.freeSlotCount)
+        {
+            // Recording carries on from the previous owner's head, keeping its events readable
+            thread = recorder.threads[recorder.freeSlots[--recorder.freeSlotCount]];
+        }
+        else
+        {
+            uint32 index = recorder.threadCount.load(std::memory_order_relaxed);
+            if (index < FLIGHT_RECORDER_MAX_THREADS)
+            {
+                // Never freed: a dump can happen at any time, even after the thread exited
+                thread = new FlightRecorderThread();
+                thread->threadIndex = index;
+                recorder.threads[index] = thread;
+                recorder.threadCount.store(index + 1, std::memory_order_release);
+            }
+        }
+    }
+
+    if (!thread)
+    {
+        threadRegistration = THREAD_REGISTRATION_DONE;
+        uint32 dropped = recorder.droppedThreads.fetch_add(1, std::memory_order_relaxed) + 1;
+        // Not through the logger, which records into the flight recorder itself
+        fprintf(stderr, "flight recorder: all %d slots are held by live threads, not recording this thread (%u dropped)\n",
+            FLIGHT_RECORDER_MAX_THREADS, dropped);
+        return nullptr;
+    }
+
+    static thread_local FlightRecorderSlotOwner owner;
+    (void)owner;
+    threadRegistration = THREAD_REGISTRATION_ACTIVE;
+    flightRecorderThread = thread;
+    return thread;
+}
+
+void flightRecorderSetDumpFile(const char* path)
+{
+    strncpy(recorder.dumpPath, path, sizeof(recorder.dumpPath) - 1);
+    recorder.dumpPath[sizeof(recorder.dumpPath) - 1] = 0;
+}
+
+static void writeAll(int32 file, const char* text, uint32 length)
+{
+#if SGS_PLATFORM_WINDOWS
+    _write(file, text, length);
+#else
+    while (length > 0)
+    {
+        ssize_t written = write(file, text, length);
+        if (written <= 0)
+        {
+            return;
+        }
+        text += written;
+        length -= (uint32)written;
+    }
+#endif
+}
+
+static void writeLine(int32 dumpFile, const char* text, uint32 length)
+{
+    writeAll(2, text, length);
+    if (dumpFile >= 0)
+    {
+        writeAll(dumpFile, text, length);
+    }
+}
+
+// Line formatting without snprintf, which is not async-signal-safe. Every append is clipped to
+// the line, which keeps room for the newline.
+static uint32 appendText(char* line, uint32 length, uint32 capacity, const char* text, uint32 width, uint32 maxLength)
+{
+    uint32 start = length;
+    for (uint32 i = 0; text[i] && i < maxLength && length < capacity - 1; i++)
+    {
+        line[length++] = text[i];
+    }
+    while (length - start < width && length < capacity - 1)
+    {
+        line[length++] = ' ';
+    }
+    return length;
+}
+
+// Right aligned in width, padded with pad
+static uint32 appendUnsigned(char* line, uint32 length, uint32 capacity, uint64 value, uint32 width, char pad)
+{
+    char digits[20];
+    uint32 count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    for (uint32 i = count; i < width && length < capacity - 1; i++)
+    {
+        line[length++] = pad;
+    }
+    while (count && length < capacity - 1)
+    {
+        line[length++] = digits[--count];
+    }
+    return length;
+}
+
+void flightRecorderDump(const char* reason)
+{
+    bool expected = false;
+    if (!recorder.dumping.compare_exchange_strong(expected, true))
+    {
+        return;
+    }
+
+    int32 dumpFile = -1;
+    if (recorder.dumpPath[0])
+    {
+#if SGS_PLATFORM_WINDOWS
+        dumpFile = _open(recorder.dumpPath, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+        dumpFile = open(recorder.dumpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    }
+
+    // Static so a crashing thread with little stack left can still dump
+    static char line[512];
+    static uint64 cursors[FLIGHT_RECORDER_MAX_THREADS];
+    static uint64 ends[FLIGHT_RECORDER_MAX_THREADS];
+
+    uint32 threadCount = recorder.threadCount.load(std::memory_order_acquire);
+    threadCount = threadCount < FLIGHT_RECORDER_MAX_THREADS ? threadCount : FLIGHT_RECORDER_MAX_THREADS;
+
+    uint64 totalEvents = 0;
+    uint64 firstTimestamp = ~0ull;
+    for (uint32 i = 0; i < threadCount; i++)
+    {
+        FlightRecorderThread* thread = recorder.threads[i];
+        ends[i] = thread ? thread->head.load(std::memory_order_acquire) : 0;
+        cursors[i] = ends[i] > FLIGHT_RECORDER_EVENTS_PER_THREAD ? ends[i] - FLIGHT_RECORDER_EVENTS_PER_THREAD : 0;
+        totalEvents += ends[i] - cursors[i];
+        if (ends[i] > cursors[i])
+        {
+            uint64 timestamp = thread->events[cursors[i] & (FLIGHT_RECORDER_EVENTS_PER_THREAD - 1)].timestamp;
+            firstTimestamp = timestamp < firstTimestamp ? timestamp : firstTimestamp;
+        }
+    }
+
+    const uint32 capacity = sizeof(line);
+    float64 nanosecondsPerTick = 1.0;
+#if FLIGHT_RECORDER_USE_TSC
+    uint64 ticks = flightTimestamp() - recorder.calibrationTimestamp;
+    int64 nanoseconds = steadyNanoseconds() - recorder.calibrationNanoseconds;
+    if (ticks > 0 && nanoseconds > 0)
+    {
+        nanosecondsPerTick = (float64)nanoseconds / (float64)ticks;
+    }
+#endif
+
+    uint32 length = appendText(line, 0, capacity, "==== flight recorder: ", 0, capacity);
+    length = appendText(line, length, capacity, reason ? reason : "dump", 0, 128);
+    length = appendText(line, length, capacity, " (", 0, capacity);
+    length = appendUnsigned(line, length, capacity, threadCount, 0, ' ');
+    length = appendText(line, length, capacity, " threads, ", 0, capacity);
+    length = appendUnsigned(line, length, capacity, totalEvents, 0, ' ');
+    length = appendText(line, length, capacity, " events", 0, capacity);
+    uint32 droppedThreads = recorder.droppedThreads.load(std::memory_order_relaxed);
+    if (droppedThreads)
+    {
+        length = appendText(line, length, capacity, ", ", 0, capacity);
+        length = appendUnsigned(line, length, capacity, droppedThreads, 0, ' ');
+        length = appendText(line, length, capacity, " threads not recorded", 0, capacity);
+    }
+    length = appendText(line, length, capacity, ") ====", 0, capacity);
+    line[length++] = '\n';
+    writeLine(dumpFile, line, length);
+
+    // Merge the per-thread rings by timestamp
+    for (;;)
+    {
+        int32 next = -1;
+        uint64 nextTimestamp = ~0ull;
+        for (uint32 i = 0; i < threadCount; i++)
+        {
+            if (cursors[i] == ends[i])
+            {
+                continue;
+            }
+            uint64 timestamp = recorder.threads[i]->events[cursors[i] & (FLIGHT_RECORDER_EVENTS_PER_THREAD - 1)].timestamp;
+            if (timestamp <= nextTimestamp)
+            {
+                nextTimestamp = timestamp;
+                next = (int32)i;
+            }
+        }
+
+        if (next < 0)
+        {
+            break;
+        }
+
+        const FlightEvent& event = recorder.threads[next]->events[cursors[next] & (FLIGHT_RECORDER_EVENTS_PER_THREAD - 1)];
+        cursors[next]++;
+
+        // Microseconds with three decimals, as fixed point
+        uint64 nanoseconds = (uint64)((float64)(event.timestamp - firstTimestamp) * nanosecondsPerTick);
+        const char* name = event.type < FLIGHT_EVENT_TYPE_COUNT ? eventNames[event.type] : "?";
+        length = appendUnsigned(line, 0, capacity, nanoseconds / 1000, 10, ' ');
+        line[length++] = '.';
+        length = appendUnsigned(line, length, capacity, nanoseconds % 1000, 3, '0');
+        length = appendText(line, length, capacity, " us  thread ", 0, capacity);
+        length = appendUnsigned(line, length, capacity, (uint64)next, 2, ' ');
+        length = appendText(line, length, capacity, "  ", 0, capacity);
+        length = appendText(line, length, capacity, name, 16, capacity);
+        length = appendText(line, length, capacity, " ", 0, capacity);
+        length = appendText(line, length, capacity, event.label ? event.label : "", 48, 48);
+        length = appendText(line, length, capacity, " ", 0, capacity);
+        length = appendUnsigned(line, length, capacity, event.value, 0, ' ');
+        line[length++] = '\n';
+        writeLine(dumpFile, line, length);
+    }
+
+    if (dumpFile >= 0)
+    {
+#if SGS_PLATFORM_WINDOWS
+        _close(dumpFile);
+#else
+        close(dumpFile);
+#endif
+    }
+
+    recorder.dumping.store(false);
+}
+
+#if SGS_PLATFORM_WINDOWS
+
+static LONG WINAPI crashExceptionFilter(EXCEPTION_POINTERS* exception)
+{
+    flightRecorderDump("unhandled exception");
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+void flightRecorderInstallCrashHandlers()
+{
+    SetUnhandledExceptionFilter(crashExceptionFilter);
+}
+
+#else
+
+static void crashSignalHandler(int32 signalNumber)
+{
+    const char* reason = "fatal signal";
+    switch (signalNumber)
+    {
+        case SIGSEGV: reason = "SIGSEGV"; break;
+        case SIGABRT: reason = "SIGABRT"; break;
+        case SIGFPE: reason = "SIGFPE"; break;
+        case SIGILL: reason = "SIGILL"; break;
+        case SIGBUS: reason = "SIGBUS"; break;
+    }
+    flightRecorderDump(reason);
+
+    // SA_RESETHAND restored the default action, let it terminate the process
+    raise(signalNumber);
+}
+
+void flightRecorderInstallCrashHandlers()
+{
+    int32 signals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS };
+    for (int32 signalNumber : signals)
+    {
+        struct sigaction action = {};
+        action.sa_handler = crashSignalHandler;
+        action.sa_flags = SA_RESETHAND;
+        sigemptyset(&action.sa_mask);
+        sigaction(signalNumber, &action, nullptr);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+
+#include "defines.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define FLIGHT_RECORDER_USE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define FLIGHT_RECORDER_USE_TSC 1
+#else
+#include <chrono>
+#endif
+
+// Flight recorder: every thread keeps its last FLIGHT_RECORDER_EVENTS_PER_THREAD engine events in
+// its own ring. Recording is a timestamp read and a 32 byte store, so it stays on in release
+// builds. The rings are dumped as one timeline when an assertion fails or the process crashes.
+
+// Disable the recorder by setting this to 0
+#define FLIGHT_RECORDER_ENABLED 1
+
+#define FLIGHT_RECORDER_EVENTS_PER_THREAD 1024
+// Live threads. An exited thread's slot goes to the next thread that registers; threads beyond
+// this many at once are not recorded and are counted in the dump header.
+#define FLIGHT_RECORDER_MAX_THREADS 64
+
+typedef enum e_flightEventType {
+    FLIGHT_EVENT_FRAME_BEGIN = 0,
+    FLIGHT_EVENT_FRAME_END = 1,
+    FLIGHT_EVENT_FENCE_WAIT_BEGIN = 2,
+    FLIGHT_EVENT_FENCE_WAIT_END = 3,
+    FLIGHT_EVENT_RESOURCE_CREATE = 4,
+    FLIGHT_EVENT_LOG = 5,
+    FLIGHT_EVENT_MARKER = 6,
+    FLIGHT_EVENT_TYPE_COUNT
+}e_flightEventType;
+
+// label must point to static storage (a literal or a format string), it is printed at dump time
+struct FlightEvent
+{
+    uint64 timestamp;
+    const char* label;
+    uint64 value;
+    uint32 type;
+    uint32 reserved;
+};
+
+struct FlightRecorderThread
+{
+    FlightEvent events[FLIGHT_RECORDER_EVENTS_PER_THREAD];
+    std::atomic<uint64> head;
+    uint32 threadIndex;
+};
+
+extern thread_local FlightRecorderThread* flightRecorderThread;
+
+FlightRecorderThread* flightRecorderRegisterThread();
+
+// Dumps every thread's events, merged by time, to stderr and the dump file if one is set.
+// Safe to call from a signal handler: lines are formatted by hand into static storage and written
+// with write, no stdio or allocation. Concurrent dumps are ignored.
+void flightRecorderDump(const char* reason);
+void flightRecorderSetDumpFile(const char* path);
+// Dumps on SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS (Linux) or unhandled SEH exceptions (Windows)
+void flightRecorderInstallCrashHandlers();
+
+inline uint64 flightTimestamp()
+{
+#if FLIGHT_RECORDER_USE_TSC
+    return __rdtsc();
+#else
+    return (uint64)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+inline void flightRecord(e_flightEventType type, const char* label, uint64 value)
+{
+    FlightRecorderThread* thread = flightRecorderThread;
+    if (!thread)
+    {
+        thread = flightRecorderRegisterThread();
+        if (!thread)
+        {
+            return;
+        }
+    }
+
+    uint64 head = thread->head.load(std::memory_order_relaxed);
+    FlightEvent& event = thread->events[head & (FLIGHT_RECORDER_EVENTS_PER_THREAD - 1)];
+    event.timestamp = flightTimestamp();
+    event.label = label;
+    event.value = value;
+    event.type = (uint32)type;
+    thread->head.store(head + 1, std::memory_order_release);
+}
+
+#if FLIGHT_RECORDER_ENABLED == 1
+#define SGSRECORD(type, label, value) flightRecord(type, label, (uint64)(value))
+#else
+#define SGSRECORD(type, label, value)
+#endif
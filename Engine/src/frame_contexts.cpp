@@ -0,0 +1,176 @@
+#include <string.h>
+#include <chrono>
+
+#include "frame_contexts.h"
+#include "assertions.h"
+#include "flight_recorder.h"
+#include "logger.h"
+
+static int64 nowNanoseconds()
+{
+    using namespace std::chrono;
+    return (int64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool frameContextsInitialize(FrameContexts* frames, RhiDevice* device, const FrameContextsConfig& config)
+{
+    frames->device = device;
+    frames->queue = rhiGetQueue(device, RHI_QUEUE_DIRECT);
+    frames->count = config.count < 1 ? 1 : (config.count > FRAME_CONTEXT_MAX ? FRAME_CONTEXT_MAX : config.count);
+    frames->current = 0;
+    frames->fenceValue = 0;
+    frames->frame = 0;
+    frames->recording = false;
+    memset(frames->contexts, 0, sizeof(frames->contexts));
+    frameContextsResetStats(frames);
+    frames->fence = rhiCreateFence(device, 0, "frame contexts fence");
+    if (!frames->fence)
+    {
+        return false;
+    }
+    deferredReleaseInitialize(&frames->releases, frames->fence);
+
+    for (uint32 i = 0; i < frames->count; i++)
+    {
+        FrameContext& context = frames->contexts[i];
+        context.allocator = rhiCreateCommandAllocator(device, RHI_QUEUE_DIRECT, "frame command allocator");
+        if (!context.allocator)
+        {
+            return false;
+        }
+        if (config.uploadBytes)
+        {
+            context.upload = rhiCreateCommittedResource(device, RHI_HEAP_UPLOAD, rhiBufferDesc(config.uploadBytes), RHI_STATE_GENERIC_READ, "frame upload buffer");
+            context.uploadMemory = context.upload ? (uint8*)rhiMapResource(context.upload) : nullptr;
+            if (!context.uploadMemory)
+            {
+                return false;
+            }
+            context.uploadSize = config.uploadBytes;
+        }
+    }
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "frame contexts", frames->count);
+    return true;
+}
+
+void frameContextsShutdown(FrameContexts* frames)
+{
+    if (frames->fence)
+    {
+        frameContextsWaitIdle(frames);
+        deferredReleaseShutdown(&frames->releases);
+    }
+    for (uint32 i = 0; i < frames->count; i++)
+    {
+        FrameContext& context = frames->contexts[i];
+        if (context.upload)
+        {
+            rhiUnmapResource(context.upload);
+            rhiDestroyResource(context.upload);
+        }
+        if (context.allocator)
+        {
+            rhiDestroyCommandAllocator(context.allocator);
+        }
+    }
+    if (frames->fence)
+    {
+        rhiDestroyFence(frames->fence);
+    }
+    frames->fence = nullptr;
+    frames->count = 0;
+}
+
+FrameContext* frameContextsBegin(FrameContexts* frames)
+{
+    SGSASSERT(!frames->recording);
+    FrameContext* context = &frames->contexts[frames->current];
+
+    if (!rhiFenceIsComplete(frames->fence, context->fenceValue))
+    {
+        int64 start = nowNanoseconds();
+        rhiFenceWait(frames->fence, context->fenceValue);
+        frames->statsWaitNanoseconds += nowNanoseconds() - start;
+        frames->statsWaits++;
+    }
+    uint64 completed = rhiFenceCompletedValue(frames->fence);
+
+    // Whatever the GPU has left of earlier frames runs while this one records
+    uint64 inFlight = frames->fenceValue - completed;
+    frames->statsInFlightSum += inFlight;
+    frames->statsOverlappedFrames += inFlight ? 1 : 0;
+    frames->statsFrames++;
+
+    deferredReleaseCollect(&frames->releases);
+    rhiResetCommandAllocator(context->allocator);
+    context->uploadOffset = 0;
+    context->frame = frames->frame;
+    frames->recording = true;
+    return context;
+}
+
+uint64 frameContextsEnd(FrameContexts* frames)
+{
+    SGSASSERT(frames->recording);
+    FrameContext* context = &frames->contexts[frames->current];
+    frames->fenceValue++;
+    rhiQueueSignal(frames->queue, frames->fence, frames->fenceValue);
+    context->fenceValue = frames->fenceValue;
+
+    frames->current = (frames->current + 1) % frames->count;
+    frames->frame++;
+    frames->recording = false;
+    return context->fenceValue;
+}
+
+void frameContextsWaitIdle(FrameContexts* frames)
+{
+    SGSASSERT(!frames->recording);
+    frames->fenceValue++;
+    rhiQueueSignal(frames->queue, frames->fence, frames->fenceValue);
+    rhiFenceWait(frames->fence, frames->fenceValue);
+}
+
+uint64 frameContextsRetireValue(const FrameContexts* frames)
+{
+    return frames->recording ? frames->fenceValue + 1 : frames->fenceValue;
+}
+
+void frameContextsReleaseResource(FrameContexts* frames, RhiResource* resource)
+{
+    deferredReleaseResource(&frames->releases, resource, frameContextsRetireValue(frames));
+}
+
+void* frameContextAllocate(FrameContext* context, uint64 size, uint64 alignment, uint64* offset)
+{
+    SGSASSERT(alignment && (alignment & (alignment - 1)) == 0);
+    uint64 start = (context->uploadOffset + alignment - 1) & ~(alignment - 1);
+    if (start + size > context->uploadSize)
+    {
+        SGSWARN_CAT(LOG_CATEGORY_RENDER, "Frame upload buffer full: %llu of %llu bytes used, %llu requested",
+            (unsigned long long)context->uploadOffset, (unsigned long long)context->uploadSize, (unsigned long long)size);
+        return nullptr;
+    }
+    context->uploadOffset = start + size;
+    *offset = start;
+    return context->uploadMemory + start;
+}
+
+void frameContextsGetStats(const FrameContexts* frames, FrameContextsStats* stats)
+{
+    stats->frames = frames->statsFrames;
+    stats->waits = frames->statsWaits;
+    stats->waitSeconds = (float64)frames->statsWaitNanoseconds * 1e-9;
+    float64 frameCount = frames->statsFrames ? (float64)frames->statsFrames : 1.0;
+    stats->averageFramesInFlight = (float64)frames->statsInFlightSum / frameCount;
+    stats->overlapFraction = (float64)frames->statsOverlappedFrames / frameCount;
+}
+
+void frameContextsResetStats(FrameContexts* frames)
+{
+    frames->statsFrames = 0;
+    frames->statsWaits = 0;
+    frames->statsWaitNanoseconds = 0;
+    frames->statsInFlightSum = 0;
+    frames->statsOverlappedFrames = 0;
+}
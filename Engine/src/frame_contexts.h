@@ -0,0 +1,83 @@
+#pragma once
+
+#include "deferred_release.h"
+#include "rhi.h"
+
+// Frames in flight. Each frame records into one of N contexts that owns everything the GPU may
+// still be reading while the CPU moves on: a command allocator, an upload buffer and the fence
+// value that retires them. frameContextsBegin only waits for the context it is about to reuse,
+// so the CPU runs up to N - 1 frames ahead of the GPU instead of flushing it every frame.
+// Objects retired to the contexts' release queue are destroyed by frameContextsBegin once the
+// frames that used them completed.
+
+#define FRAME_CONTEXT_MAX 4
+
+struct FrameContextsConfig
+{
+    uint32 count = 2;
+    uint64 uploadBytes = 64 * 1024;     // per context, 0 creates no upload buffer
+};
+
+struct FrameContext
+{
+    RhiCommandAllocator* allocator;
+    // Persistently mapped, linear allocation with frameContextAllocate
+    RhiResource* upload;
+    uint8* uploadMemory;
+    uint64 uploadSize;
+    uint64 uploadOffset;
+    uint64 fenceValue;                  // retires this context's last frame, 0 before its first
+    uint64 frame;
+};
+
+struct FrameContextsStats
+{
+    uint64 frames;
+    uint64 waits;                       // frames that blocked on the context they reused
+    float64 waitSeconds;
+    // Measured when a frame begins: how many earlier frames the GPU had not finished yet
+    float64 averageFramesInFlight;
+    float64 overlapFraction;            // frames recorded while the GPU was still busy
+};
+
+struct FrameContexts
+{
+    RhiDevice* device;
+    RhiQueue* queue;
+    RhiFence* fence;
+    FrameContext contexts[FRAME_CONTEXT_MAX];
+    uint32 count;
+    uint32 current;
+    uint64 fenceValue;                  // last value signalled
+    uint64 frame;
+    bool recording;
+    DeferredReleaseQueue releases;
+
+    uint64 statsFrames;
+    uint64 statsWaits;
+    int64 statsWaitNanoseconds;
+    uint64 statsInFlightSum;
+    uint64 statsOverlappedFrames;
+};
+
+bool frameContextsInitialize(FrameContexts* frames, RhiDevice* device, const FrameContextsConfig& config);
+// Waits for the GPU first
+void frameContextsShutdown(FrameContexts* frames);
+
+// Waits until the context that is next in line retired, then resets it for recording
+FrameContext* frameContextsBegin(FrameContexts* frames);
+// Call after the frame's command lists were submitted. Returns the fence value that retires it.
+uint64 frameContextsEnd(FrameContexts* frames);
+// Waits for everything submitted to the queue so far. Not between Begin and End.
+void frameContextsWaitIdle(FrameContexts* frames);
+// Fence value that retires everything submitted so far, and while recording, the current frame
+uint64 frameContextsRetireValue(const FrameContexts* frames);
+// Destroys resource once no frame that may use it is in flight
+void frameContextsReleaseResource(FrameContexts* frames, RhiResource* resource);
+
+// Space in the context's upload buffer, nullptr when it is full. offset is relative to
+// context->upload.
+void* frameContextAllocate(FrameContext* context, uint64 size, uint64 alignment, uint64* offset);
+
+void frameContextsGetStats(const FrameContexts* frames, FrameContextsStats* stats);
+void frameContextsResetStats(FrameContexts* frames);
@@ -0,0 +1,659 @@
+#include <string.h>
+
+#include "frame_graph.h"
+#include "assertions.h"
+#include "logger.h"
+
+// Marks the start of a pass in the key; access words are resource handles, far below it
+#define KEY_PASS 0xfffffffe
+#define KEY_WRITE 0x80000000
+
+static uint64 alignUp(uint64 value, uint64 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void pushKey(FrameGraph* graph, uint32 value)
+{
+    if (graph->keyCount == FRAME_GRAPH_MAX_KEY)
+    {
+        graph->overflow = true;
+        return;
+    }
+    graph->key[graph->keyCount++] = value;
+}
+
+static void clearPlacements(FrameGraph* graph)
+{
+    for (uint32 i = 0; i < FRAME_GRAPH_MAX_RESOURCES; i++)
+    {
+        FrameGraphPlacement& placement = graph->placements[i];
+        placement.resource = nullptr;
+        placement.offset = 0;
+        placement.size = 0;
+        placement.alignment = 1;
+        placement.firstPass = FRAME_GRAPH_INVALID;
+        placement.lastPass = FRAME_GRAPH_INVALID;
+        placement.lastState = RHI_STATE_COMMON;
+    }
+    graph->heap = nullptr;
+}
+
+void frameGraphInitialize(FrameGraph* graph, RhiDevice* device, DeferredReleaseQueue* releases)
+{
+    graph->device = device;
+    graph->releases = releases;
+    graph->compiled = false;
+    graph->compiledKeyCount = 0;
+    graph->orderCount = 0;
+    graph->barrierCount = 0;
+    graph->firstFinalBarrier = 0;
+    graph->stats = FrameGraphStats();
+    clearPlacements(graph);
+    frameGraphBegin(graph);
+}
+
+// retireValue is only used with a release queue
+static void releasePlacedResources(FrameGraph* graph, uint64 retireValue)
+{
+    for (uint32 i = 0; i < FRAME_GRAPH_MAX_RESOURCES; i++)
+    {
+        RhiResource* resource = graph->placements[i].resource;
+        if (!resource)
+        {
+            continue;
+        }
+        if (graph->releases)
+        {
+            deferredReleaseResource(graph->releases, resource, retireValue);
+        }
+        else
+        {
+            rhiDestroyResource(resource);
+        }
+    }
+    if (graph->heap)
+    {
+        if (graph->releases)
+        {
+            deferredReleaseHeap(graph->releases, graph->heap, retireValue);
+        }
+        else
+        {
+            rhiDestroyHeap(graph->heap);
+        }
+    }
+    clearPlacements(graph);
+    graph->compiled = false;
+}
+
+void frameGraphShutdown(FrameGraph* graph)
+{
+    graph->releases = nullptr;
+    releasePlacedResources(graph, 0);
+}
+
+void frameGraphBegin(FrameGraph* graph)
+{
+    graph->resourceCount = 0;
+    graph->passCount = 0;
+    graph->accessCount = 0;
+    graph->keyCount = 0;
+    graph->overflow = false;
+}
+
+static FrameGraphHandle addResource(FrameGraph* graph, const char* name)
+{
+    if (graph->resourceCount == FRAME_GRAPH_MAX_RESOURCES)
+    {
+        SGSASSERT_MSG(false, "Frame graph resource limit reached");
+        graph->overflow = true;
+        return FRAME_GRAPH_INVALID;
+    }
+    FrameGraphResource& resource = graph->resources[graph->resourceCount];
+    resource.name = name;
+    resource.resource = nullptr;
+    resource.imported = false;
+    resource.finalState = RHI_STATE_COMMON;
+    return graph->resourceCount++;
+}
+
+FrameGraphHandle frameGraphCreateTexture(FrameGraph* graph, const char* name, const RhiResourceDesc& desc)
+{
+    SGSASSERT(desc.dimension == RHI_RESOURCE_TEXTURE2D);
+    FrameGraphHandle handle = addResource(graph, name);
+    if (handle == FRAME_GRAPH_INVALID)
+    {
+        return handle;
+    }
+    graph->resources[handle].desc = desc;
+
+    pushKey(graph, 0);
+    pushKey(graph, (uint32)desc.dimension);
+    pushKey(graph, (uint32)desc.width);
+    pushKey(graph, (uint32)(desc.width >> 32));
+    pushKey(graph, desc.height);
+    pushKey(graph, (uint32)desc.arraySize << 16 | desc.mipLevels);
+    pushKey(graph, (uint32)desc.format);
+    pushKey(graph, desc.sampleCount);
+    pushKey(graph, desc.flags);
+    for (uint32 i = 0; i < 4; i++)
+    {
+        uint32 bits;
+        memcpy(&bits, &desc.clearValue[i], sizeof(bits));
+        pushKey(graph, bits);
+    }
+    return handle;
+}
+
+FrameGraphHandle frameGraphImport(FrameGraph* graph, const char* name, RhiResource* resource, uint32 finalState)
+{
+    SGSASSERT(resource);
+    FrameGraphHandle handle = addResource(graph, name);
+    if (handle == FRAME_GRAPH_INVALID)
+    {
+        return handle;
+    }
+    FrameGraphResource& imported = graph->resources[handle];
+    imported.desc = rhiGetResourceDesc(resource);
+    imported.resource = resource;
+    imported.imported = true;
+    imported.finalState = finalState;
+
+    // The resource itself may change every frame, like the back buffer, without changing the plan
+    pushKey(graph, 1);
+    pushKey(graph, finalState);
+    return handle;
+}
+
+uint32 frameGraphAddPass(FrameGraph* graph, const char* name, PFN_frameGraphPass execute, void* userData)
+{
+    if (graph->passCount == FRAME_GRAPH_MAX_PASSES)
+    {
+        SGSASSERT_MSG(false, "Frame graph pass limit reached");
+        graph->overflow = true;
+        return FRAME_GRAPH_INVALID;
+    }
+    FrameGraphPass& pass = graph->passes[graph->passCount];
+    pass.name = name;
+    pass.execute = execute;
+    pass.userData = userData;
+    pass.firstAccess = graph->accessCount;
+    pass.accessCount = 0;
+    pushKey(graph, KEY_PASS);
+    return graph->passCount++;
+}
+
+static void addAccess(FrameGraph* graph, FrameGraphHandle resource, uint32 state, bool write)
+{
+    SGSASSERT_MSG(graph->passCount > 0, "Frame graph accesses need a pass");
+    if (graph->passCount == 0 || resource >= graph->resourceCount || graph->accessCount == FRAME_GRAPH_MAX_ACCESSES)
+    {
+        // Invalid handles come from a limit that was already hit
+        SGSASSERT_MSG(resource == FRAME_GRAPH_INVALID || resource < graph->resourceCount, "Unknown frame graph resource");
+        graph->overflow = true;
+        return;
+    }
+    FrameGraphAccess& access = graph->accesses[graph->accessCount++];
+    access.resource = resource;
+    access.state = state;
+    access.write = write;
+    graph->passes[graph->passCount - 1].accessCount++;
+    pushKey(graph, resource | (write ? KEY_WRITE : 0));
+    pushKey(graph, state);
+}
+
+void frameGraphRead(FrameGraph* graph, FrameGraphHandle resource, uint32 state)
+{
+    addAccess(graph, resource, state, false);
+}
+
+void frameGraphWrite(FrameGraph* graph, FrameGraphHandle resource, uint32 state)
+{
+    addAccess(graph, resource, state, true);
+}
+
+// A pass may declare several accesses to one resource: they are combined at the first one,
+// writes winning over reads, and false is returned for the others
+static bool combinedAccess(const FrameGraph* graph, const FrameGraphPass& pass, uint32 index, uint32* state, bool* write)
+{
+    const FrameGraphAccess* accesses = &graph->accesses[pass.firstAccess];
+    FrameGraphHandle resource = accesses[index].resource;
+    for (uint32 i = 0; i < index; i++)
+    {
+        if (accesses[i].resource == resource)
+        {
+            return false;
+        }
+    }
+
+    uint32 readState = 0;
+    uint32 writeState = 0;
+    *write = false;
+    for (uint32 i = index; i < pass.accessCount; i++)
+    {
+        if (accesses[i].resource != resource)
+        {
+            continue;
+        }
+        if (accesses[i].write)
+        {
+            writeState |= accesses[i].state;
+            *write = true;
+        }
+        else
+        {
+            readState |= accesses[i].state;
+        }
+    }
+    *state = *write ? writeState : readState;
+    return true;
+}
+
+static bool overlaps(uint32 firstA, uint32 lastA, uint32 firstB, uint32 lastB)
+{
+    return firstA <= lastB && firstB <= lastA;
+}
+
+// Kept passes, in declaration order. A pass is kept when it writes an imported resource or
+// something a kept pass reads.
+static void cullPasses(FrameGraph* graph)
+{
+    bool needed[FRAME_GRAPH_MAX_RESOURCES];
+    for (uint32 i = 0; i < graph->resourceCount; i++)
+    {
+        needed[i] = graph->resources[i].imported;
+    }
+
+    bool kept[FRAME_GRAPH_MAX_PASSES];
+    for (uint32 p = graph->passCount; p-- > 0;)
+    {
+        const FrameGraphPass& pass = graph->passes[p];
+        kept[p] = false;
+        for (uint32 i = 0; i < pass.accessCount; i++)
+        {
+            const FrameGraphAccess& access = graph->accesses[pass.firstAccess + i];
+            kept[p] = kept[p] || (access.write && needed[access.resource]);
+        }
+        if (!kept[p])
+        {
+            continue;
+        }
+        for (uint32 i = 0; i < pass.accessCount; i++)
+        {
+            const FrameGraphAccess& access = graph->accesses[pass.firstAccess + i];
+            needed[access.resource] = needed[access.resource] || !access.write;
+        }
+    }
+
+    graph->orderCount = 0;
+    for (uint32 p = 0; p < graph->passCount; p++)
+    {
+        if (kept[p])
+        {
+            graph->order[graph->orderCount++].pass = p;
+        }
+    }
+}
+
+// Lifetimes, sizes and the state each transient resource ends the frame in
+static void computeLifetimes(FrameGraph* graph)
+{
+    for (uint32 k = 0; k < graph->orderCount; k++)
+    {
+        const FrameGraphPass& pass = graph->passes[graph->order[k].pass];
+        for (uint32 i = 0; i < pass.accessCount; i++)
+        {
+            uint32 state;
+            bool write;
+            FrameGraphHandle resource = graph->accesses[pass.firstAccess + i].resource;
+            if (graph->resources[resource].imported || !combinedAccess(graph, pass, i, &state, &write))
+            {
+                continue;
+            }
+            FrameGraphPlacement& placement = graph->placements[resource];
+            if (placement.firstPass == FRAME_GRAPH_INVALID)
+            {
+                placement.firstPass = k;
+                rhiGetAllocationInfo(graph->device, graph->resources[resource].desc, &placement.size, &placement.alignment);
+            }
+            placement.lastPass = k;
+            placement.lastState = state;
+        }
+    }
+}
+
+// Greedy: largest first, each at the lowest offset clear of everything placed whose lifetime
+// overlaps its own. Returns the heap size.
+static uint64 placeResources(FrameGraph* graph)
+{
+    uint32 sorted[FRAME_GRAPH_MAX_RESOURCES];
+    uint32 count = 0;
+    for (uint32 r = 0; r < graph->resourceCount; r++)
+    {
+        if (graph->placements[r].firstPass == FRAME_GRAPH_INVALID)
+        {
+            continue;
+        }
+        uint32 i = count++;
+        for (; i > 0 && graph->placements[sorted[i - 1]].size < graph->placements[r].size; i--)
+        {
+            sorted[i] = sorted[i - 1];
+        }
+        sorted[i] = r;
+    }
+
+    uint64 heapSize = 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        FrameGraphPlacement& placement = graph->placements[sorted[i]];
+        uint64 best = ~0ull;
+        // Candidates are the heap start and the end of every conflicting resource
+        for (uint32 c = 0; c <= i; c++)
+        {
+            const FrameGraphPlacement* candidate = c < i ? &graph->placements[sorted[c]] : nullptr;
+            if (candidate && !overlaps(candidate->firstPass, candidate->lastPass, placement.firstPass, placement.lastPass))
+            {
+                continue;
+            }
+            uint64 offset = candidate ? alignUp(candidate->offset + candidate->size, placement.alignment) : 0;
+            if (offset >= best)
+            {
+                continue;
+            }
+            bool fits = true;
+            for (uint32 j = 0; j < i && fits; j++)
+            {
+                const FrameGraphPlacement& other = graph->placements[sorted[j]];
+                fits = !overlaps(other.firstPass, other.lastPass, placement.firstPass, placement.lastPass) ||
+                    offset + placement.size <= other.offset || other.offset + other.size <= offset;
+            }
+            if (fits)
+            {
+                best = offset;
+            }
+        }
+        placement.offset = best;
+        heapSize = heapSize > best + placement.size ? heapSize : best + placement.size;
+    }
+    return heapSize;
+}
+
+// Whether another placed resource shares memory with this one
+static bool isAliased(const FrameGraph* graph, FrameGraphHandle resource)
+{
+    const FrameGraphPlacement& placement = graph->placements[resource];
+    for (uint32 r = 0; r < graph->resourceCount; r++)
+    {
+        const FrameGraphPlacement& other = graph->placements[r];
+        if (r != resource && other.firstPass != FRAME_GRAPH_INVALID &&
+            placement.offset < other.offset + other.size && other.offset < placement.offset + placement.size)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void pushBarrier(FrameGraph* graph, FrameGraphHandle resource, e_frameGraphBarrierType type, uint32 before, uint32 after)
+{
+    SGSASSERT(graph->barrierCount < FRAME_GRAPH_MAX_BARRIERS);
+    FrameGraphBarrier& barrier = graph->barriers[graph->barrierCount++];
+    barrier.resource = resource;
+    barrier.type = type;
+    barrier.before = before;
+    barrier.after = after;
+}
+
+// Transient resources start every frame in the state they ended the last one in, the state they
+// were created in, so their transitions are known here; the tracker works out imported ones'.
+static void deriveBarriers(FrameGraph* graph)
+{
+    uint32 current[FRAME_GRAPH_MAX_RESOURCES];
+    bool written[FRAME_GRAPH_MAX_RESOURCES];
+    for (uint32 r = 0; r < graph->resourceCount; r++)
+    {
+        current[r] = graph->resources[r].imported ? RESOURCE_STATE_UNKNOWN : graph->placements[r].lastState;
+        written[r] = false;
+    }
+
+    graph->barrierCount = 0;
+    for (uint32 k = 0; k < graph->orderCount; k++)
+    {
+        FrameGraphCompiledPass& compiled = graph->order[k];
+        const FrameGraphPass& pass = graph->passes[compiled.pass];
+        compiled.firstBarrier = graph->barrierCount;
+        for (uint32 i = 0; i < pass.accessCount; i++)
+        {
+            uint32 state;
+            bool write;
+            if (!combinedAccess(graph, pass, i, &state, &write))
+            {
+                continue;
+            }
+            FrameGraphHandle resource = graph->accesses[pass.firstAccess + i].resource;
+            bool imported = graph->resources[resource].imported;
+            bool firstUse = !imported && graph->placements[resource].firstPass == k;
+            if (firstUse && isAliased(graph, resource))
+            {
+                pushBarrier(graph, resource, FRAME_GRAPH_BARRIER_ALIASING, 0, 0);
+            }
+            if (current[resource] != state)
+            {
+                pushBarrier(graph, resource, FRAME_GRAPH_BARRIER_TRANSITION, imported ? RESOURCE_STATE_UNKNOWN : current[resource], state);
+            }
+            else if (state == RHI_STATE_UNORDERED_ACCESS && !firstUse && (write || written[resource]))
+            {
+                pushBarrier(graph, resource, FRAME_GRAPH_BARRIER_UAV, 0, 0);
+            }
+            current[resource] = state;
+            written[resource] = write;
+        }
+        compiled.barrierCount = graph->barrierCount - compiled.firstBarrier;
+    }
+
+    graph->firstFinalBarrier = graph->barrierCount;
+    for (uint32 r = 0; r < graph->resourceCount; r++)
+    {
+        const FrameGraphResource& resource = graph->resources[r];
+        if (resource.imported && current[r] != RESOURCE_STATE_UNKNOWN && current[r] != resource.finalState)
+        {
+            pushBarrier(graph, r, FRAME_GRAPH_BARRIER_TRANSITION, RESOURCE_STATE_UNKNOWN, resource.finalState);
+        }
+    }
+}
+
+static bool createPlacedResources(FrameGraph* graph, uint64 heapSize)
+{
+    if (heapSize == 0)
+    {
+        return true;
+    }
+    RhiHeapDesc heapDesc;
+    heapDesc.size = heapSize;
+    heapDesc.type = RHI_HEAP_DEFAULT;
+    graph->heap = rhiCreateHeap(graph->device, heapDesc, "frame graph heap");
+    if (!graph->heap)
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Creating the %llu byte frame graph heap failed", (unsigned long long)heapSize);
+        return false;
+    }
+
+    for (uint32 r = 0; r < graph->resourceCount; r++)
+    {
+        FrameGraphPlacement& placement = graph->placements[r];
+        if (placement.firstPass == FRAME_GRAPH_INVALID)
+        {
+            continue;
+        }
+        const FrameGraphResource& resource = graph->resources[r];
+        placement.resource = rhiCreatePlacedResource(graph->device, graph->heap, placement.offset, resource.desc,
+            placement.lastState, resource.name);
+        if (!placement.resource)
+        {
+            SGSERROR_CAT(LOG_CATEGORY_RENDER, "Placing frame graph resource %s failed", resource.name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void updateStats(FrameGraph* graph, uint64 heapSize)
+{
+    FrameGraphStats& stats = graph->stats;
+    stats.passes = graph->passCount;
+    stats.culledPasses = graph->passCount - graph->orderCount;
+    stats.transientResources = 0;
+    stats.culledResources = 0;
+    stats.barriers = graph->barrierCount;
+    stats.transientBytes = 0;
+    stats.aliasedBytes = heapSize;
+    stats.peakLiveBytes = 0;
+    for (uint32 r = 0; r < graph->resourceCount; r++)
+    {
+        if (graph->resources[r].imported)
+        {
+            continue;
+        }
+        if (graph->placements[r].firstPass == FRAME_GRAPH_INVALID)
+        {
+            stats.culledResources++;
+            continue;
+        }
+        stats.transientResources++;
+        stats.transientBytes += graph->placements[r].size;
+    }
+
+    for (uint32 k = 0; k < graph->orderCount; k++)
+    {
+        uint64 live = 0;
+        for (uint32 r = 0; r < graph->resourceCount; r++)
+        {
+            const FrameGraphPlacement& placement = graph->placements[r];
+            if (placement.firstPass != FRAME_GRAPH_INVALID && placement.firstPass <= k && k <= placement.lastPass)
+            {
+                live += placement.size;
+            }
+        }
+        stats.peakLiveBytes = live > stats.peakLiveBytes ? live : stats.peakLiveBytes;
+    }
+    stats.compiles++;
+}
+
+static void bindPlacedResources(FrameGraph* graph)
+{
+    for (uint32 r = 0; r < graph->resourceCount; r++)
+    {
+        if (!graph->resources[r].imported)
+        {
+            graph->resources[r].resource = graph->placements[r].resource;
+        }
+    }
+}
+
+bool frameGraphCompile(FrameGraph* graph, uint64 retireValue)
+{
+    if (graph->overflow)
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "The frame graph is over its limits, not compiling it");
+        return false;
+    }
+    if (graph->compiled && graph->keyCount == graph->compiledKeyCount &&
+        memcmp(graph->key, graph->compiledKey, graph->keyCount * sizeof(uint32)) == 0)
+    {
+        graph->stats.cacheHits++;
+        bindPlacedResources(graph);
+        return true;
+    }
+
+    releasePlacedResources(graph, retireValue);
+    cullPasses(graph);
+    computeLifetimes(graph);
+    uint64 heapSize = placeResources(graph);
+    deriveBarriers(graph);
+    if (!createPlacedResources(graph, heapSize))
+    {
+        // Nothing used them yet
+        DeferredReleaseQueue* releases = graph->releases;
+        graph->releases = nullptr;
+        releasePlacedResources(graph, 0);
+        graph->releases = releases;
+        return false;
+    }
+    updateStats(graph, heapSize);
+
+    memcpy(graph->compiledKey, graph->key, graph->keyCount * sizeof(uint32));
+    graph->compiledKeyCount = graph->keyCount;
+    graph->compiled = true;
+    bindPlacedResources(graph);
+    return true;
+}
+
+static void recordBarrier(const FrameGraph* graph, ResourceStateTracker* tracker, const FrameGraphBarrier& barrier)
+{
+    const FrameGraphResource& resource = graph->resources[barrier.resource];
+    switch (barrier.type)
+    {
+        case FRAME_GRAPH_BARRIER_TRANSITION:
+        {
+            if (resource.imported)
+            {
+                resourceStateTransition(tracker, resource.resource, barrier.after);
+            }
+            else
+            {
+                resourceStateBarrier(tracker, rhiTransition(resource.resource, barrier.before, barrier.after));
+            }
+        } break;
+
+        case FRAME_GRAPH_BARRIER_UAV:
+        {
+            resourceStateUav(tracker, resource.resource);
+        } break;
+
+        case FRAME_GRAPH_BARRIER_ALIASING:
+        {
+            // Any of the resources sharing its memory may have been the last one used
+            resourceStateAliasing(tracker, nullptr, resource.resource);
+        } break;
+    }
+}
+
+void frameGraphExecute(FrameGraph* graph, ResourceStateTracker* tracker)
+{
+    SGSASSERT_MSG(graph->compiled, "Executing a frame graph that did not compile");
+    RhiCommandList* list = tracker->list;
+    for (uint32 k = 0; k < graph->orderCount; k++)
+    {
+        const FrameGraphCompiledPass& compiled = graph->order[k];
+        const FrameGraphPass& pass = graph->passes[compiled.pass];
+        rhiCmdBeginPass(list, pass.name);
+        for (uint32 i = 0; i < compiled.barrierCount; i++)
+        {
+            recordBarrier(graph, tracker, graph->barriers[compiled.firstBarrier + i]);
+        }
+        resourceStateFlush(tracker);
+        if (pass.execute)
+        {
+            pass.execute(list, graph, pass.userData);
+        }
+    }
+    rhiCmdEndPass(list);
+
+    for (uint32 i = graph->firstFinalBarrier; i < graph->barrierCount; i++)
+    {
+        recordBarrier(graph, tracker, graph->barriers[i]);
+    }
+    resourceStateFlush(tracker);
+}
+
+RhiResource* frameGraphGetResource(const FrameGraph* graph, FrameGraphHandle resource)
+{
+    SGSASSERT(resource < graph->resourceCount);
+    return graph->resources[resource].resource;
+}
+
+void frameGraphGetStats(const FrameGraph* graph, FrameGraphStats* stats)
+{
+    *stats = graph->stats;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "rhi.h"
+#include "deferred_release.h"
+#include "resource_states.h"
+
+// Declarative frame graph. Every frame the renderer declares its passes, the resources they
+// read and write and the states they need them in, then compiles and executes the graph:
+// - passes that contribute nothing to an imported resource are culled
+// - transient resources live from their first to their last pass, and the ones whose lifetimes
+//   don't overlap share memory in a single placed heap
+// - barriers are derived from the declared states. Transient resources never leave the graph,
+//   so their transitions are worked out at compile time with known before states; imported ones
+//   go through the ResourceStateTracker and end the frame in the state they were imported with.
+// Compiling is cached: as long as a frame declares the same topology, the same resources with
+// the same descs and the same accesses, the previous plan and its placed resources are reused.
+// Compiling only needs a device, the null backend runs it headless.
+//
+// A transient resource's contents don't survive the frame, nor its own passes when its memory
+// is aliased: the first pass writing it must clear or fully overwrite it.
+
+#define FRAME_GRAPH_MAX_RESOURCES 64
+#define FRAME_GRAPH_MAX_PASSES 64
+#define FRAME_GRAPH_MAX_ACCESSES 256
+#define FRAME_GRAPH_MAX_BARRIERS (2 * FRAME_GRAPH_MAX_ACCESSES + FRAME_GRAPH_MAX_RESOURCES)
+#define FRAME_GRAPH_MAX_KEY (16 * FRAME_GRAPH_MAX_RESOURCES + 2 * FRAME_GRAPH_MAX_ACCESSES + FRAME_GRAPH_MAX_PASSES)
+#define FRAME_GRAPH_INVALID 0xffffffff
+
+typedef uint32 FrameGraphHandle;
+
+struct FrameGraph;
+// Records the pass into list; frameGraphGetResource gives the resources it declared
+typedef void (*PFN_frameGraphPass)(RhiCommandList* list, const FrameGraph* graph, void* userData);
+
+typedef enum e_frameGraphBarrierType {
+    FRAME_GRAPH_BARRIER_TRANSITION = 0,
+    FRAME_GRAPH_BARRIER_UAV = 1,
+    FRAME_GRAPH_BARRIER_ALIASING = 2    // the resource takes over memory another one used
+}e_frameGraphBarrierType;
+
+struct FrameGraphResource
+{
+    const char* name;
+    RhiResourceDesc desc;               // transient only
+    RhiResource* resource;              // imported, or the transient's placed resource once compiled
+    bool imported;
+    uint32 finalState;                  // imported only
+};
+
+struct FrameGraphAccess
+{
+    FrameGraphHandle resource;
+    uint32 state;
+    bool write;
+};
+
+struct FrameGraphPass
+{
+    const char* name;
+    PFN_frameGraphPass execute;
+    void* userData;
+    uint32 firstAccess;
+    uint32 accessCount;
+};
+
+// Where a transient resource lives, kept with the compiled plan
+struct FrameGraphPlacement
+{
+    RhiResource* resource;              // nullptr when no pass left after culling uses it
+    uint64 offset;
+    uint64 size;
+    uint64 alignment;
+    uint32 firstPass;                   // compiled pass indices
+    uint32 lastPass;
+    uint32 lastState;                   // what it is left in every frame, and created in
+};
+
+struct FrameGraphBarrier
+{
+    FrameGraphHandle resource;
+    e_frameGraphBarrierType type;
+    uint32 before;                      // transitions of transient resources only
+    uint32 after;
+};
+
+struct FrameGraphCompiledPass
+{
+    uint32 pass;                        // declared pass index
+    uint32 firstBarrier;                // recorded before the pass
+    uint32 barrierCount;
+};
+
+struct FrameGraphStats
+{
+    uint32 passes;                      // declared
+    uint32 culledPasses;
+    uint32 transientResources;          // placed in the heap
+    uint32 culledResources;             // transient, but only used by culled passes
+    uint32 barriers;                    // per execution, imported resources' final transitions included
+    uint64 transientBytes;              // every transient resource in its own memory
+    uint64 aliasedBytes;                // the heap they share
+    uint64 peakLiveBytes;               // most bytes live during one pass, what aliasing could reach at best
+    uint64 compiles;
+    uint64 cacheHits;
+};
+
+// Not thread safe, one per renderer. Too big for the stack.
+struct FrameGraph
+{
+    RhiDevice* device;
+    DeferredReleaseQueue* releases;     // nullptr destroys replaced resources right away
+
+    // Declared since frameGraphBegin
+    FrameGraphResource resources[FRAME_GRAPH_MAX_RESOURCES];
+    uint32 resourceCount;
+    FrameGraphPass passes[FRAME_GRAPH_MAX_PASSES];
+    uint32 passCount;
+    FrameGraphAccess accesses[FRAME_GRAPH_MAX_ACCESSES];
+    uint32 accessCount;
+    uint32 key[FRAME_GRAPH_MAX_KEY];    // everything the compiled plan depends on
+    uint32 keyCount;
+    bool overflow;                      // a limit was hit, the frame can't compile
+
+    // Compiled plan, valid while the declared key matches
+    bool compiled;
+    uint32 compiledKey[FRAME_GRAPH_MAX_KEY];
+    uint32 compiledKeyCount;
+    FrameGraphCompiledPass order[FRAME_GRAPH_MAX_PASSES];
+    uint32 orderCount;
+    FrameGraphPlacement placements[FRAME_GRAPH_MAX_RESOURCES];
+    FrameGraphBarrier barriers[FRAME_GRAPH_MAX_BARRIERS];
+    uint32 barrierCount;
+    uint32 firstFinalBarrier;           // imported resources back to their final states
+    RhiHeap* heap;
+
+    FrameGraphStats stats;
+};
+
+void frameGraphInitialize(FrameGraph* graph, RhiDevice* device, DeferredReleaseQueue* releases);
+// Destroys the placed resources and their heap right away: the GPU must be done with them
+void frameGraphShutdown(FrameGraph* graph);
+
+// Starts declaring a frame
+void frameGraphBegin(FrameGraph* graph);
+FrameGraphHandle frameGraphCreateTexture(FrameGraph* graph, const char* name, const RhiResourceDesc& desc);
+// The resource's states come from the tracker executing the graph, which leaves it in finalState
+FrameGraphHandle frameGraphImport(FrameGraph* graph, const char* name, RhiResource* resource, uint32 finalState);
+// Passes execute in the order they are added; name labels the pass counters
+uint32 frameGraphAddPass(FrameGraph* graph, const char* name, PFN_frameGraphPass execute, void* userData);
+// Accesses of the pass added last
+void frameGraphRead(FrameGraph* graph, FrameGraphHandle resource, uint32 state);
+void frameGraphWrite(FrameGraph* graph, FrameGraphHandle resource, uint32 state);
+
+// Reuses the last plan when the declared frame matches it. Otherwise culls, places and creates
+// the transient resources and derives the barriers; the resources the last plan placed are
+// released at retireValue. Returns false if the frame is over a limit or the heap or a placed
+// resource could not be created.
+bool frameGraphCompile(FrameGraph* graph, uint64 retireValue);
+// Records every pass left after culling into the tracker's list, each after its barriers
+void frameGraphExecute(FrameGraph* graph, ResourceStateTracker* tracker);
+// For passes while executing
+RhiResource* frameGraphGetResource(const FrameGraph* graph, FrameGraphHandle resource);
+
+void frameGraphGetStats(const FrameGraph* graph, FrameGraphStats* stats);
@@ -0,0 +1,236 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "frame_pacer.h"
+
+#if SGS_PLATFORM_WINDOWS
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <time.h>
+#endif
+
+// Margins are kept between these, in nanoseconds
+#define FRAME_PACER_MIN_SPIN_MARGIN 100000.0
+#define FRAME_PACER_MAX_SPIN_MARGIN 4000000.0
+#define FRAME_PACER_MARGIN_RISE 0.2
+#define FRAME_PACER_MARGIN_DECAY 0.02
+
+static int64 nowNanoseconds()
+{
+    using namespace std::chrono;
+    return (int64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+float64 framePacerProcessCpuSeconds()
+{
+#if SGS_PLATFORM_WINDOWS
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        return 0.0;
+    }
+    uint64 kernelTicks = ((uint64)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64 userTicks = ((uint64)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (float64)(kernelTicks + userTicks) * 1e-7;
+#else
+    timespec time;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+    {
+        return 0.0;
+    }
+    return (float64)time.tv_sec + (float64)time.tv_nsec * 1e-9;
+#endif
+}
+
+static void sleepNanoseconds(FramePacer* pacer, int64 duration)
+{
+#if SGS_PLATFORM_WINDOWS
+    if (pacer->timer)
+    {
+        // Relative due times are negative, in 100 ns units
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -(duration / 100);
+        if (SetWaitableTimer((HANDLE)pacer->timer, &dueTime, 0, nullptr, nullptr, FALSE))
+        {
+            WaitForSingleObject((HANDLE)pacer->timer, INFINITE);
+            return;
+        }
+    }
+    Sleep((DWORD)(duration / 1000000));
+#else
+    std::this_thread::sleep_for(std::chrono::nanoseconds(duration));
+#endif
+}
+
+void framePacerInitialize(FramePacer* pacer, const FramePacerConfig& config)
+{
+    *pacer = FramePacer();
+    pacer->config = config;
+    pacer->active = true;
+    pacer->oversleep = config.spinMarginMs * 1e6;
+
+#if SGS_PLATFORM_WINDOWS
+    pacer->timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+
+    pacer->lastFrameEnd = nowNanoseconds();
+    pacer->deadline = pacer->lastFrameEnd;
+    framePacerResetStats(pacer);
+}
+
+void framePacerShutdown(FramePacer* pacer)
+{
+#if SGS_PLATFORM_WINDOWS
+    if (pacer->timer)
+    {
+        CloseHandle((HANDLE)pacer->timer);
+    }
+#endif
+    pacer->timer = nullptr;
+}
+
+void framePacerSetActive(FramePacer* pacer, bool active)
+{
+    pacer->active = active;
+}
+
+void framePacerSetMinimized(FramePacer* pacer, bool minimized)
+{
+    pacer->minimized = minimized;
+}
+
+void framePacerSetTargetFps(FramePacer* pacer, float64 targetFps)
+{
+    pacer->config.targetFps = targetFps;
+}
+
+float64 framePacerCurrentFps(const FramePacer* pacer)
+{
+    const FramePacerConfig& config = pacer->config;
+    float64 fps = config.targetFps;
+    if (pacer->minimized && config.minimizedFps > 0.0)
+    {
+        fps = fps > 0.0 && fps < config.minimizedFps ? fps : config.minimizedFps;
+    }
+    else if (!pacer->active && config.inactiveFps > 0.0)
+    {
+        fps = fps > 0.0 && fps < config.inactiveFps ? fps : config.inactiveFps;
+    }
+    return fps;
+}
+
+static void recordFrame(FramePacer* pacer, int64 frameEnd)
+{
+    float64 frameTime = (float64)(frameEnd - pacer->lastFrameEnd) * 1e-6;
+    pacer->lastFrameEnd = frameEnd;
+
+    pacer->frames++;
+    pacer->frameSum += frameTime;
+    pacer->frameSumSquares += frameTime * frameTime;
+    pacer->frameMax = frameTime > pacer->frameMax ? frameTime : pacer->frameMax;
+}
+
+void framePacerEndFrame(FramePacer* pacer)
+{
+    float64 fps = framePacerCurrentFps(pacer);
+    int64 now = nowNanoseconds();
+
+    if (fps <= 0.0)
+    {
+        pacer->deadline = now;
+        recordFrame(pacer, now);
+        return;
+    }
+
+    int64 interval = (int64)(1e9 / fps);
+    pacer->deadline += interval;
+
+    // A frame that ran more than one interval late starts a new schedule instead of rushing
+    // the following frames to catch up
+    if (now - pacer->deadline > interval)
+    {
+        pacer->deadline = now;
+        recordFrame(pacer, now);
+        return;
+    }
+
+    int64 margin = (int64)pacer->oversleep;
+    int64 sleepFor = pacer->deadline - now - margin;
+    if (sleepFor > 0)
+    {
+        sleepNanoseconds(pacer, sleepFor);
+        int64 woke = nowNanoseconds();
+        pacer->sleepTotal += (float64)(woke - now) * 1e-9;
+
+        if (pacer->config.adaptiveSpin)
+        {
+            // Rises quickly and decays slowly, which settles around a high percentile of the
+            // oversleep instead of its mean; a single very late wake-up only nudges it
+            float64 oversleep = (float64)(woke - now - sleepFor);
+            float64 weight = oversleep > pacer->oversleep ? FRAME_PACER_MARGIN_RISE : FRAME_PACER_MARGIN_DECAY;
+            pacer->oversleep += (oversleep - pacer->oversleep) * weight;
+            pacer->oversleep = pacer->oversleep < FRAME_PACER_MIN_SPIN_MARGIN ? FRAME_PACER_MIN_SPIN_MARGIN : pacer->oversleep;
+            pacer->oversleep = pacer->oversleep > FRAME_PACER_MAX_SPIN_MARGIN ? FRAME_PACER_MAX_SPIN_MARGIN : pacer->oversleep;
+        }
+        now = woke;
+    }
+
+    int64 spinStart = now;
+    while (now < pacer->deadline)
+    {
+        std::this_thread::yield();
+        now = nowNanoseconds();
+    }
+    pacer->spinTotal += (float64)(now - spinStart) * 1e-9;
+
+    recordFrame(pacer, now);
+}
+
+void framePacerGetStats(const FramePacer* pacer, FramePacerStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->frames = pacer->frames;
+    stats->wallSeconds = (float64)(nowNanoseconds() - pacer->statsStart) * 1e-9;
+    stats->cpuSeconds = framePacerProcessCpuSeconds() - pacer->statsCpuStart;
+    stats->cpuUtilization = stats->wallSeconds > 0.0 ? stats->cpuSeconds / stats->wallSeconds : 0.0;
+    stats->sleepSeconds = pacer->sleepTotal;
+    stats->spinSeconds = pacer->spinTotal;
+    stats->spinMarginMs = pacer->oversleep * 1e-6;
+
+    if (pacer->frames > 0)
+    {
+        float64 count = (float64)pacer->frames;
+        stats->averageFrameMs = pacer->frameSum / count;
+        float64 variance = pacer->frameSumSquares / count - stats->averageFrameMs * stats->averageFrameMs;
+        stats->jitterMs = variance > 0.0 ? sqrt(variance) : 0.0;
+        stats->maxFrameMs = pacer->frameMax;
+    }
+}
+
+void framePacerResetStats(FramePacer* pacer)
+{
+    pacer->statsStart = nowNanoseconds();
+    pacer->statsCpuStart = framePacerProcessCpuSeconds();
+    pacer->frames = 0;
+    pacer->frameSum = 0.0;
+    pacer->frameSumSquares = 0.0;
+    pacer->frameMax = 0.0;
+    pacer->sleepTotal = 0.0;
+    pacer->spinTotal = 0.0;
+}
+
+float64 framePacerFpsFromCommandLine(const char* commandLine, float64 fallback)
+{
+    const char* option = commandLine ? strstr(commandLine, "--fps=") : nullptr;
+    if (!option)
+    {
+        return fallback;
+    }
+    return atof(option + strlen("--fps="));
+}
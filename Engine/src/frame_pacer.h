@@ -0,0 +1,72 @@
+#pragma once
+
+#include "defines.h"
+
+// Frame pacing: caps the frame rate and throttles it further while the window is inactive or
+// minimized. framePacerEndFrame sleeps until shortly before the next frame's deadline and spins
+// the rest of the way. The spin margin follows how much the OS has been oversleeping, so coarse
+// timers cost a little more spinning, never a late frame.
+
+struct FramePacerConfig
+{
+    float64 targetFps = 0.0;        // 0 runs uncapped while active
+    float64 inactiveFps = 30.0;     // 0 keeps the active rate when the window loses focus
+    float64 minimizedFps = 10.0;
+    float64 spinMarginMs = 2.0;     // initial margin, adapted to the measured oversleep
+    bool adaptiveSpin = true;
+};
+
+struct FramePacerStats
+{
+    uint64 frames;
+    float64 wallSeconds;
+    float64 cpuSeconds;             // whole process, all threads
+    float64 cpuUtilization;         // cpuSeconds / wallSeconds, 1.0 is one full core
+    float64 averageFrameMs;
+    float64 jitterMs;               // standard deviation of the frame time
+    float64 maxFrameMs;
+    float64 sleepSeconds;
+    float64 spinSeconds;
+    float64 spinMarginMs;           // current margin
+};
+
+struct FramePacer
+{
+    FramePacerConfig config;
+    bool active;
+    bool minimized;
+
+    int64 deadline;                 // nanoseconds on the steady clock
+    int64 lastFrameEnd;
+    float64 oversleep;              // running estimate in nanoseconds
+    void* timer;                    // high resolution waitable timer on Windows
+
+    int64 statsStart;
+    float64 statsCpuStart;
+    uint64 frames;
+    float64 frameSum;
+    float64 frameSumSquares;
+    float64 frameMax;
+    float64 sleepTotal;
+    float64 spinTotal;
+};
+
+void framePacerInitialize(FramePacer* pacer, const FramePacerConfig& config);
+void framePacerShutdown(FramePacer* pacer);
+
+void framePacerSetActive(FramePacer* pacer, bool active);
+void framePacerSetMinimized(FramePacer* pacer, bool minimized);
+void framePacerSetTargetFps(FramePacer* pacer, float64 targetFps);
+// The rate in effect for the current window state, 0 when uncapped
+float64 framePacerCurrentFps(const FramePacer* pacer);
+
+// Call once per frame after Present. Waits for the next frame slot and records the frame time.
+void framePacerEndFrame(FramePacer* pacer);
+
+void framePacerGetStats(const FramePacer* pacer, FramePacerStats* stats);
+void framePacerResetStats(FramePacer* pacer);
+
+// CPU time consumed by the whole process so far
+float64 framePacerProcessCpuSeconds();
+// Looks for --fps=N in a command line, returns fallback if absent
+float64 framePacerFpsFromCommandLine(const char* commandLine, float64 fallback);
@@ -0,0 +1,302 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "frame_timing.h"
+
+static const char* phaseNames[FRAME_TIMING_PHASE_COUNT] = { "wall", "record", "submit", "wait" };
+
+int64 frameTimingNow()
+{
+    using namespace std::chrono;
+    return (int64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32 bucketIndex(uint32 microseconds)
+{
+    if (microseconds < FRAME_TIMING_SUB_BUCKETS)
+    {
+        return microseconds;
+    }
+
+    uint32 exponent = 31;
+    while (!(microseconds & (1u << exponent)))
+    {
+        exponent--;
+    }
+    uint32 subBucket = (microseconds >> (exponent - 4)) & (FRAME_TIMING_SUB_BUCKETS - 1);
+    return (exponent - 3) * FRAME_TIMING_SUB_BUCKETS + subBucket;
+}
+
+// Middle of the bucket, in microseconds
+static float64 bucketValue(uint32 index)
+{
+    if (index < FRAME_TIMING_SUB_BUCKETS)
+    {
+        return (float64)index;
+    }
+
+    uint32 exponent = index / FRAME_TIMING_SUB_BUCKETS + 3;
+    uint32 subBucket = index % FRAME_TIMING_SUB_BUCKETS;
+    float64 width = (float64)(1ull << (exponent - 4));
+    return (float64)(FRAME_TIMING_SUB_BUCKETS + subBucket) * width + width * 0.5;
+}
+
+void frameTimingInitialize(FrameTiming* timing, const FrameTimingConfig& config)
+{
+    timing->config = config;
+    frameTimingReset(timing);
+}
+
+void frameTimingReset(FrameTiming* timing)
+{
+    timing->inFrame = false;
+    timing->sampleCount = 0;
+    timing->hitchThresholdMicroseconds = (uint32)(timing->config.hitchThresholdMs * 1000.0);
+    memset(timing->current, 0, sizeof(timing->current));
+
+    for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
+    {
+        for (uint32 i = 0; i < FRAME_TIMING_BUCKET_COUNT; i++)
+        {
+            timing->buckets[phase][i].store(0, std::memory_order_relaxed);
+        }
+        timing->windowSum[phase].store(0, std::memory_order_relaxed);
+        timing->windowMax[phase].store(0, std::memory_order_relaxed);
+        timing->windowMaxCount[phase] = 0;
+    }
+    timing->frames.store(0, std::memory_order_relaxed);
+    timing->hitches.store(0, std::memory_order_release);
+}
+
+static void closeFrame(FrameTiming* timing, int64 end);
+
+void frameTimingBeginFrame(FrameTiming* timing)
+{
+    // One clock read ends the previous frame and starts this one, so no time falls between them
+    int64 now = frameTimingNow();
+    if (timing->inFrame)
+    {
+        closeFrame(timing, now);
+    }
+
+    timing->frameStart = now;
+    timing->inFrame = true;
+    memset(timing->current, 0, sizeof(timing->current));
+}
+
+void frameTimingBeginPhase(FrameTiming* timing, e_frameTimingPhase phase)
+{
+    timing->phaseStart[phase] = frameTimingNow();
+}
+
+void frameTimingEndPhase(FrameTiming* timing, e_frameTimingPhase phase)
+{
+    timing->current[phase] += (uint32)((frameTimingNow() - timing->phaseStart[phase]) / 1000);
+}
+
+// Single writer: plain load and store instead of read-modify-write, readers see either value
+template<typename T>
+static void atomicAdd(std::atomic<T>& value, T amount)
+{
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+static void addToWindow(FrameTiming* timing, uint32 phase, uint32 microseconds)
+{
+    atomicAdd(timing->buckets[phase][bucketIndex(microseconds)], 1u);
+    atomicAdd(timing->windowSum[phase], (uint64)microseconds);
+
+    uint32 maximum = timing->windowMax[phase].load(std::memory_order_relaxed);
+    if (microseconds > maximum || timing->windowMaxCount[phase] == 0)
+    {
+        timing->windowMax[phase].store(microseconds, std::memory_order_relaxed);
+        timing->windowMaxCount[phase] = 1;
+    }
+    else if (microseconds == maximum)
+    {
+        timing->windowMaxCount[phase]++;
+    }
+}
+
+// Returns true when the last frame holding the maximum left the window
+static bool removeFromWindow(FrameTiming* timing, uint32 phase, uint32 microseconds)
+{
+    atomicAdd(timing->buckets[phase][bucketIndex(microseconds)], (uint32)-1);
+    atomicAdd(timing->windowSum[phase], (uint64)0 - microseconds);
+
+    if (microseconds == timing->windowMax[phase].load(std::memory_order_relaxed))
+    {
+        timing->windowMaxCount[phase]--;
+    }
+    return timing->windowMaxCount[phase] == 0;
+}
+
+static void recomputeWindowMax(FrameTiming* timing, uint32 phase)
+{
+    uint64 windowFrames = timing->sampleCount < FRAME_TIMING_WINDOW ? timing->sampleCount : FRAME_TIMING_WINDOW;
+    uint32 maximum = 0;
+    uint32 count = 0;
+    for (uint64 i = timing->sampleCount - windowFrames; i < timing->sampleCount; i++)
+    {
+        uint32 value = timing->samples[i % FRAME_TIMING_WINDOW].microseconds[phase];
+        if (value > maximum)
+        {
+            maximum = value;
+            count = 0;
+        }
+        count += value == maximum ? 1 : 0;
+    }
+    timing->windowMax[phase].store(maximum, std::memory_order_relaxed);
+    timing->windowMaxCount[phase] = count;
+}
+
+void frameTimingEndFrame(FrameTiming* timing)
+{
+    if (timing->inFrame)
+    {
+        closeFrame(timing, frameTimingNow());
+    }
+}
+
+static void closeFrame(FrameTiming* timing, int64 end)
+{
+    timing->inFrame = false;
+    timing->current[FRAME_TIMING_WALL] = (uint32)((end - timing->frameStart) / 1000);
+
+    FrameTimingSample& sample = timing->samples[timing->sampleCount % FRAME_TIMING_WINDOW];
+    bool evicting = timing->sampleCount >= FRAME_TIMING_WINDOW;
+    bool evictedMax[FRAME_TIMING_PHASE_COUNT] = {};
+    if (evicting)
+    {
+        for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
+        {
+            evictedMax[phase] = removeFromWindow(timing, phase, sample.microseconds[phase]);
+        }
+    }
+
+    // The relative hitch threshold follows the median, seeded once a few frames are in. A median
+    // is one pass over the wall histogram, cheap enough every few frames.
+    uint64 count = timing->sampleCount;
+    if (timing->config.hitchThresholdMs <= 0.0 && count >= FRAME_TIMING_HITCH_MIN_FRAMES &&
+        (count == FRAME_TIMING_HITCH_MIN_FRAMES || count % FRAME_TIMING_HITCH_REFRESH_FRAMES == 0))
+    {
+        float64 median = frameTimingPercentile(timing, FRAME_TIMING_WALL, 50.0);
+        timing->hitchThresholdMicroseconds = (uint32)(median * 1000.0 * timing->config.hitchMultiplier);
+    }
+
+    sample.frame = timing->frames.load(std::memory_order_relaxed);
+    memcpy(sample.microseconds, timing->current, sizeof(sample.microseconds));
+    sample.hitch = timing->hitchThresholdMicroseconds > 0 && sample.microseconds[FRAME_TIMING_WALL] > timing->hitchThresholdMicroseconds;
+    timing->sampleCount++;
+
+    for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
+    {
+        addToWindow(timing, phase, sample.microseconds[phase]);
+        // The evicted frame held the last copy of the maximum: rescan, the new frame included
+        if (evictedMax[phase])
+        {
+            recomputeWindowMax(timing, phase);
+        }
+    }
+
+    if (sample.hitch)
+    {
+        atomicAdd(timing->hitches, (uint64)1);
+    }
+    timing->frames.store(timing->frames.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+float64 frameTimingPercentile(const FrameTiming* timing, e_frameTimingPhase phase, float64 percentile)
+{
+    uint64 total = 0;
+    for (uint32 i = 0; i < FRAME_TIMING_BUCKET_COUNT; i++)
+    {
+        total += timing->buckets[phase][i].load(std::memory_order_relaxed);
+    }
+    if (total == 0)
+    {
+        return 0.0;
+    }
+
+    uint64 rank = (uint64)(percentile * 0.01 * (float64)total + 0.5);
+    rank = rank < 1 ? 1 : rank > total ? total : rank;
+
+    uint64 seen = 0;
+    float64 maximum = (float64)timing->windowMax[phase].load(std::memory_order_relaxed);
+    for (uint32 i = 0; i < FRAME_TIMING_BUCKET_COUNT; i++)
+    {
+        seen += timing->buckets[phase][i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            float64 value = bucketValue(i);
+            return (value < maximum ? value : maximum) * 1e-3;
+        }
+    }
+    return maximum * 1e-3;
+}
+
+void frameTimingGetStats(const FrameTiming* timing, FrameTimingStats* stats)
+{
+    stats->frames = timing->frames.load(std::memory_order_acquire);
+    stats->hitches = timing->hitches.load(std::memory_order_relaxed);
+    stats->windowFrames = (uint32)(stats->frames < FRAME_TIMING_WINDOW ? stats->frames : FRAME_TIMING_WINDOW);
+
+    for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
+    {
+        FrameTimingPhaseStats& phaseStats = stats->phases[phase];
+        phaseStats.p50Ms = frameTimingPercentile(timing, (e_frameTimingPhase)phase, 50.0);
+        phaseStats.p95Ms = frameTimingPercentile(timing, (e_frameTimingPhase)phase, 95.0);
+        phaseStats.p99Ms = frameTimingPercentile(timing, (e_frameTimingPhase)phase, 99.0);
+        phaseStats.maxMs = (float64)timing->windowMax[phase].load(std::memory_order_relaxed) * 1e-3;
+        phaseStats.averageMs = stats->windowFrames
+            ? (float64)timing->windowSum[phase].load(std::memory_order_relaxed) * 1e-3 / (float64)stats->windowFrames : 0.0;
+    }
+}
+
+const char* frameTimingPhaseName(e_frameTimingPhase phase)
+{
+    return phase < FRAME_TIMING_PHASE_COUNT ? phaseNames[phase] : "?";
+}
+
+bool frameTimingWriteCsv(const FrameTiming* timing, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "frame");
+    for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
+    {
+        fprintf(file, ",%s_ms", phaseNames[phase]);
+    }
+    fprintf(file, ",hitch\n");
+
+    uint64 windowFrames = timing->sampleCount < FRAME_TIMING_WINDOW ? timing->sampleCount : FRAME_TIMING_WINDOW;
+    for (uint64 i = timing->sampleCount - windowFrames; i < timing->sampleCount; i++)
+    {
+        const FrameTimingSample& sample = timing->samples[i % FRAME_TIMING_WINDOW];
+        fprintf(file, "%llu", (unsigned long long)sample.frame);
+        for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
+        {
+            fprintf(file, ",%.3f", (float64)sample.microseconds[phase] * 1e-3);
+        }
+        fprintf(file, ",%d\n", sample.hitch ? 1 : 0);
+    }
+
+    FrameTimingStats stats;
+    frameTimingGetStats(timing, &stats);
+    fprintf(file, "# frames %llu, hitches %llu, window %u\n",
+        (unsigned long long)stats.frames, (unsigned long long)stats.hitches, stats.windowFrames);
+    for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
+    {
+        const FrameTimingPhaseStats& phaseStats = stats.phases[phase];
+        fprintf(file, "# %s: avg %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f ms\n", phaseNames[phase],
+            phaseStats.averageMs, phaseStats.p50Ms, phaseStats.p95Ms, phaseStats.p99Ms, phaseStats.maxMs);
+    }
+
+    fclose(file);
+    return true;
+}
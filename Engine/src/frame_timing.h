@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+
+#include "defines.h"
+
+// Per-frame timing. The frame thread marks phases with a steady nanosecond clock; every frame
+// lands in a ring of the last FRAME_TIMING_WINDOW frames and in one log-linear histogram per
+// phase covering the same window. Histogram buckets are atomics updated only by the frame
+// thread, so any thread can ask for percentiles without a lock. Buckets are 1/16 of a power of
+// two wide, percentiles are accurate to about 3%.
+
+#define FRAME_TIMING_WINDOW 1024
+// The relative hitch threshold starts once this many frames are in, then follows the median
+#define FRAME_TIMING_HITCH_MIN_FRAMES 30
+#define FRAME_TIMING_HITCH_REFRESH_FRAMES 16
+// Buckets hold microseconds: 16 linear buckets below 16 us, then 16 per power of two up to 2^32 us
+#define FRAME_TIMING_SUB_BUCKETS 16
+#define FRAME_TIMING_BUCKET_COUNT ((32 - 3) * FRAME_TIMING_SUB_BUCKETS)
+
+typedef enum e_frameTimingPhase {
+    FRAME_TIMING_WALL = 0,      // begin of one frame to begin of the next, pacing included
+    FRAME_TIMING_RECORD = 1,    // CPU time spent recording commands
+    FRAME_TIMING_SUBMIT = 2,    // ExecuteCommandLists and Present
+    FRAME_TIMING_WAIT = 3,      // blocked on the GPU
+    FRAME_TIMING_PHASE_COUNT
+}e_frameTimingPhase;
+
+struct FrameTimingConfig
+{
+    // A frame is a hitch when its wall time exceeds hitchThresholdMs, or when that is 0, when it
+    // exceeds hitchMultiplier times the window's median. The median is taken every
+    // FRAME_TIMING_HITCH_REFRESH_FRAMES frames; the first FRAME_TIMING_HITCH_MIN_FRAMES are never hitches.
+    float64 hitchThresholdMs = 0.0;
+    float64 hitchMultiplier = 2.0;
+};
+
+struct FrameTimingSample
+{
+    uint64 frame;
+    uint32 microseconds[FRAME_TIMING_PHASE_COUNT];
+    bool hitch;
+};
+
+struct FrameTimingPhaseStats
+{
+    float64 p50Ms;
+    float64 p95Ms;
+    float64 p99Ms;
+    float64 maxMs;          // exact, over the window
+    float64 averageMs;
+};
+
+struct FrameTimingStats
+{
+    uint64 frames;          // since the last reset
+    uint64 hitches;         // since the last reset
+    uint32 windowFrames;    // frames the percentiles cover
+    FrameTimingPhaseStats phases[FRAME_TIMING_PHASE_COUNT];
+};
+
+struct FrameTiming
+{
+    FrameTimingConfig config;
+
+    int64 frameStart;
+    int64 phaseStart[FRAME_TIMING_PHASE_COUNT];
+    uint32 current[FRAME_TIMING_PHASE_COUNT];   // microseconds accumulated this frame
+    bool inFrame;
+
+    // Written by the frame thread only
+    FrameTimingSample samples[FRAME_TIMING_WINDOW];
+    uint64 sampleCount;
+    uint32 hitchThresholdMicroseconds;
+    uint32 windowMaxCount[FRAME_TIMING_PHASE_COUNT];    // frames in the window equal to the max
+
+    std::atomic<uint32> buckets[FRAME_TIMING_PHASE_COUNT][FRAME_TIMING_BUCKET_COUNT];
+    std::atomic<uint64> windowSum[FRAME_TIMING_PHASE_COUNT];
+    std::atomic<uint32> windowMax[FRAME_TIMING_PHASE_COUNT];
+    std::atomic<uint64> frames;
+    std::atomic<uint64> hitches;
+};
+
+// FrameTiming is large (about 60 KB), keep it in static storage or on the heap
+void frameTimingInitialize(FrameTiming* timing, const FrameTimingConfig& config);
+void frameTimingReset(FrameTiming* timing);
+
+int64 frameTimingNow();
+
+// Frame thread only. Phases may be entered several times per frame, their time adds up.
+void frameTimingBeginFrame(FrameTiming* timing);
+void frameTimingBeginPhase(FrameTiming* timing, e_frameTimingPhase phase);
+void frameTimingEndPhase(FrameTiming* timing, e_frameTimingPhase phase);
+// Closes the frame that frameTimingBeginFrame opened. Calling frameTimingBeginFrame again
+// closes it too, with the wall time measured up to that call.
+void frameTimingEndFrame(FrameTiming* timing);
+
+// Any thread
+void frameTimingGetStats(const FrameTiming* timing, FrameTimingStats* stats);
+float64 frameTimingPercentile(const FrameTiming* timing, e_frameTimingPhase phase, float64 percentile);
+const char* frameTimingPhaseName(e_frameTimingPhase phase);
+
+// Frame thread only. Writes the frames in the window, oldest first, then the summary as comments.
+bool frameTimingWriteCsv(const FrameTiming* timing, const char* path);
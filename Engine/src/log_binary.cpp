@@ -0,0 +1,446 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "log_binary.h"
+
+struct LogFormatRegistry
+{
+    LogFormatSite sites[LOG_BINARY_MAX_FORMATS];
+    std::atomic<uint32> count;
+    std::atomic<uint32> overflow;
+    std::mutex mutex;
+};
+
+static LogFormatRegistry registry;
+
+// Per file sink state; formats are written the first time one of their records reaches the file.
+struct LogBinaryFile
+{
+    FILE* file;
+    uint8 emitted[LOG_BINARY_MAX_FORMATS / 8];
+};
+
+// Called once per call site through a function-local static.
+uint32 logBinaryRegisterFormat(e_logLevel level, const char* format, const char* file, uint32 line)
+{
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        uint32 id = registry.count.load(std::memory_order_relaxed);
+        if (id < LOG_BINARY_MAX_FORMATS)
+        {
+            LogFormatSite& site = registry.sites[id];
+            site.format = format;
+            site.file = file;
+            site.line = line;
+            site.level = level;
+            registry.count.store(id + 1, std::memory_order_release);
+            return id;
+        }
+    }
+
+    // Out of ids; the call site logs as text from now on. Warned outside the lock, through the
+    // text path, since logging a binary record from here would register another site.
+    if (registry.overflow.fetch_add(1, std::memory_order_relaxed) == 0)
+    {
+        logOutput(LOG_LEVEL_WARN, "Binary log format registry is full (%u formats), %s:%u and later call sites log as text",
+            LOG_BINARY_MAX_FORMATS, file, line);
+    }
+    return LOG_BINARY_FORMAT_OVERFLOW;
+}
+
+uint32 logBinaryOverflowCount()
+{
+    return registry.overflow.load(std::memory_order_relaxed);
+}
+
+const LogFormatSite* logBinaryGetFormat(uint32 id)
+{
+    if (id >= registry.count.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    return &registry.sites[id];
+}
+
+uint64 logBinaryTimestamp()
+{
+    using namespace std::chrono;
+    return (uint64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct LogArgValue
+{
+    e_logArgType type;
+    int64 signedValue;
+    uint64 unsignedValue;
+    float64 floatValue;
+    const char* string;
+    uint16 stringLength;
+};
+
+static bool readArg(const uint8*& cursor, const uint8* end, LogArgValue& value)
+{
+    if (cursor >= end)
+    {
+        return false;
+    }
+
+    value.type = (e_logArgType)*cursor++;
+    if (value.type == LOG_ARG_STRING)
+    {
+        if (end - cursor < 2)
+        {
+            return false;
+        }
+        memcpy(&value.stringLength, cursor, 2);
+        value.string = (const char*)cursor + 2;
+        cursor += 2 + value.stringLength;
+        return cursor <= end;
+    }
+
+    uint32 size = value.type == LOG_ARG_INT32 || value.type == LOG_ARG_UINT32 ? 4 : 8;
+    if (end - cursor < (int64)size)
+    {
+        return false;
+    }
+
+    switch (value.type)
+    {
+        case LOG_ARG_INT32:
+        {
+            int32 narrow;
+            memcpy(&narrow, cursor, 4);
+            value.signedValue = narrow;
+            value.unsignedValue = (uint64)value.signedValue;
+            value.floatValue = (float64)value.signedValue;
+        } break;
+
+        case LOG_ARG_UINT32:
+        {
+            uint32 narrow;
+            memcpy(&narrow, cursor, 4);
+            value.unsignedValue = narrow;
+            value.signedValue = (int64)value.unsignedValue;
+            value.floatValue = (float64)value.unsignedValue;
+        } break;
+
+        case LOG_ARG_INT:
+        {
+            memcpy(&value.signedValue, cursor, 8);
+            value.unsignedValue = (uint64)value.signedValue;
+            value.floatValue = (float64)value.signedValue;
+        } break;
+
+        case LOG_ARG_FLOAT:
+        {
+            memcpy(&value.floatValue, cursor, 8);
+            value.signedValue = (int64)value.floatValue;
+            value.unsignedValue = (uint64)value.signedValue;
+        } break;
+
+        default:
+        {
+            memcpy(&value.unsignedValue, cursor, 8);
+            value.signedValue = (int64)value.unsignedValue;
+            value.floatValue = (float64)value.unsignedValue;
+        } break;
+    }
+    cursor += size;
+    return true;
+}
+
+static uint32 appendPlain(char conversion, const LogArgValue& value, char* out, uint32 length, uint32 outSize)
+{
+    if (conversion == 's')
+    {
+        uint32 stringLength = value.type == LOG_ARG_STRING ? value.stringLength : 0;
+        stringLength = stringLength < outSize - 1 - length ? stringLength : outSize - 1 - length;
+        memcpy(out + length, value.string, stringLength);
+        return length + stringLength;
+    }
+
+    uint64 magnitude = value.unsignedValue;
+    bool negative = conversion != 'u' && value.signedValue < 0;
+    if (negative)
+    {
+        magnitude = (uint64)0 - (uint64)value.signedValue;
+    }
+    char digits[24];
+    uint32 count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (negative)
+    {
+        digits[count++] = '-';
+    }
+    while (count && length < outSize - 1)
+    {
+        out[length++] = digits[--count];
+    }
+    return length;
+}
+
+uint32 logBinaryFormat(const char* format, const uint8* args, uint32 argsSize, char* out, uint32 outSize)
+{
+    const uint8* cursor = args;
+    const uint8* end = args + argsSize;
+    uint32 length = 0;
+
+    if (outSize == 0)
+    {
+        return 0;
+    }
+
+    const char* f = format;
+    while (*f && length < outSize - 1)
+    {
+        if (*f != '%')
+        {
+            out[length++] = *f++;
+            continue;
+        }
+
+        if (f[1] == '%')
+        {
+            out[length++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Plain %d, %u and %s are by far the most common; written directly instead of through snprintf
+        if (f[1] == 'd' || f[1] == 'i' || f[1] == 'u' || f[1] == 's')
+        {
+            LogArgValue value;
+            char conversion = f[1];
+            f += 2;
+            if (!readArg(cursor, end, value))
+            {
+                length += snprintf(out + length, outSize - length, "<missing>");
+                length = length < outSize ? length : outSize - 1;
+                continue;
+            }
+            length = appendPlain(conversion, value, out, length, outSize);
+            continue;
+        }
+
+        // Rebuild the conversion with the widened argument types: %d -> %lld, %hu -> %llu...
+        char spec[48];
+        uint32 specLength = 0;
+        spec[specLength++] = *f++;
+
+        while (*f && strchr("-+ #0", *f) && specLength < 8)
+        {
+            spec[specLength++] = *f++;
+        }
+
+        LogArgValue value;
+        for (uint32 part = 0; part < 2; part++)
+        {
+            if (part == 1)
+            {
+                if (*f != '.')
+                {
+                    break;
+                }
+                spec[specLength++] = *f++;
+            }
+
+            if (*f == '*')
+            {
+                f++;
+                if (readArg(cursor, end, value))
+                {
+                    specLength += snprintf(spec + specLength, 12, "%d", (int32)value.signedValue);
+                }
+            }
+            else
+            {
+                while (*f >= '0' && *f <= '9' && specLength < 24)
+                {
+                    spec[specLength++] = *f++;
+                }
+            }
+        }
+
+        while (*f && strchr("hljztLq", *f))
+        {
+            f++;
+        }
+
+        char conversion = *f;
+        if (!conversion)
+        {
+            break;
+        }
+        f++;
+
+        if (!readArg(cursor, end, value))
+        {
+            length += snprintf(out + length, outSize - length, "<missing>");
+            length = length < outSize ? length : outSize - 1;
+            continue;
+        }
+
+        int32 written = 0;
+        uint32 remaining = outSize - length;
+        switch (conversion)
+        {
+            case 'd':
+            case 'i':
+            {
+                memcpy(spec + specLength, "lld", 4);
+                written = snprintf(out + length, remaining, spec, (long long)value.signedValue);
+            } break;
+
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+            {
+                spec[specLength] = 'l';
+                spec[specLength + 1] = 'l';
+                spec[specLength + 2] = conversion;
+                spec[specLength + 3] = 0;
+                written = snprintf(out + length, remaining, spec, (unsigned long long)value.unsignedValue);
+            } break;
+
+            case 'c':
+            {
+                memcpy(spec + specLength, "c", 2);
+                written = snprintf(out + length, remaining, spec, (int32)value.signedValue);
+            } break;
+
+            case 's':
+            {
+                char string[LOG_RECORD_PAYLOAD_SIZE];
+                uint32 stringLength = value.type == LOG_ARG_STRING ? value.stringLength : 0;
+                memcpy(string, value.string, stringLength);
+                string[stringLength] = 0;
+                memcpy(spec + specLength, "s", 2);
+                written = snprintf(out + length, remaining, spec, string);
+            } break;
+
+            case 'p':
+            {
+                memcpy(spec + specLength, "p", 2);
+                written = snprintf(out + length, remaining, spec, (void*)(uintptr_t)value.unsignedValue);
+            } break;
+
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+            {
+                spec[specLength] = conversion;
+                spec[specLength + 1] = 0;
+                written = snprintf(out + length, remaining, spec, value.floatValue);
+            } break;
+
+            default:
+            {
+                // %n and unknown conversions are skipped
+            } break;
+        }
+
+        if (written > 0)
+        {
+            length += (uint32)written < remaining ? (uint32)written : remaining - 1;
+        }
+    }
+
+    out[length] = 0;
+    return length;
+}
+
+static void binaryFileWriteRecord(void* userData, e_logLevel level, const uint8* payload, uint32 length)
+{
+    LogBinaryFile* binaryFile = (LogBinaryFile*)userData;
+
+    uint32 formatId;
+    memcpy(&formatId, payload, 4);
+    const LogFormatSite* site = logBinaryGetFormat(formatId);
+    if (site && !(binaryFile->emitted[formatId / 8] & BIT(formatId % 8)))
+    {
+        uint8 type = LOG_CHUNK_FORMAT;
+        uint8 siteLevel = (uint8)site->level;
+        uint16 fileLength = (uint16)strlen(site->file);
+        uint16 formatLength = (uint16)strlen(site->format);
+        fwrite(&type, 1, 1, binaryFile->file);
+        fwrite(&formatId, 4, 1, binaryFile->file);
+        fwrite(&siteLevel, 1, 1, binaryFile->file);
+        fwrite(&site->line, 4, 1, binaryFile->file);
+        fwrite(&fileLength, 2, 1, binaryFile->file);
+        fwrite(site->file, 1, fileLength, binaryFile->file);
+        fwrite(&formatLength, 2, 1, binaryFile->file);
+        fwrite(site->format, 1, formatLength, binaryFile->file);
+        binaryFile->emitted[formatId / 8] |= BIT(formatId % 8);
+    }
+
+    uint8 type = LOG_CHUNK_RECORD;
+    uint16 recordLength = (uint16)length;
+    fwrite(&type, 1, 1, binaryFile->file);
+    fwrite(&recordLength, 2, 1, binaryFile->file);
+    fwrite(payload, 1, length, binaryFile->file);
+}
+
+static void binaryFileWriteText(void* userData, e_logLevel level, const char* line, uint32 length)
+{
+    LogBinaryFile* binaryFile = (LogBinaryFile*)userData;
+    uint8 type = LOG_CHUNK_TEXT;
+    uint8 lineLevel = (uint8)level;
+    uint16 lineLength = (uint16)length;
+    fwrite(&type, 1, 1, binaryFile->file);
+    fwrite(&lineLevel, 1, 1, binaryFile->file);
+    fwrite(&lineLength, 2, 1, binaryFile->file);
+    fwrite(line, 1, length, binaryFile->file);
+}
+
+static void binaryFileFlush(void* userData)
+{
+    fflush(((LogBinaryFile*)userData)->file);
+}
+
+static void binaryFileClose(void* userData)
+{
+    LogBinaryFile* binaryFile = (LogBinaryFile*)userData;
+    fclose(binaryFile->file);
+    delete binaryFile;
+}
+
+LogSink logBinaryFileSink(const char* path)
+{
+    LogSink sink;
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        return sink;
+    }
+
+    LogBinaryFileHeader header = {};
+    memcpy(header.magic, LOG_BINARY_MAGIC, 8);
+    header.version = LOG_BINARY_VERSION;
+    header.baseTimestamp = logBinaryTimestamp();
+    header.unixTime = (uint64)time(nullptr);
+    fwrite(&header, sizeof(header), 1, file);
+
+    LogBinaryFile* binaryFile = new LogBinaryFile();
+    binaryFile->file = file;
+
+    sink.write = binaryFileWriteText;
+    sink.writeBinary = binaryFileWriteRecord;
+    sink.flush = binaryFileFlush;
+    sink.close = binaryFileClose;
+    sink.userData = binaryFile;
+    return sink;
+}
\ No newline at end of file
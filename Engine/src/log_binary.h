@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "logger.h"
+
+// Binary logging: each call site registers its format string once and gets an id. The hot path
+// only stores the id, a timestamp and the raw argument bytes; formatting happens on the logger
+// thread for text sinks, or offline with Tools/logdecode for binary log files.
+
+#define LOG_BINARY_MAX_FORMATS 4096
+// Returned once the registry is full. Those call sites log through the text path instead; a
+// record carrying this id has no format and decoders report it as such.
+#define LOG_BINARY_FORMAT_OVERFLOW 0xFFFFFFFFu
+#define LOG_BINARY_MAGIC "SGSBLOG1"
+#define LOG_BINARY_VERSION 1
+// formatId (4 bytes) + timestamp (8 bytes)
+#define LOG_BINARY_HEADER_SIZE 12
+
+typedef enum e_logArgType {
+    LOG_ARG_INT = 1,
+    LOG_ARG_UINT = 2,
+    LOG_ARG_FLOAT = 3,
+    LOG_ARG_STRING = 4,
+    LOG_ARG_POINTER = 5,
+    LOG_ARG_INT32 = 6,      // 32 bit and smaller integers keep 4 bytes in the record
+    LOG_ARG_UINT32 = 7
+}e_logArgType;
+
+// Binary log files are a header followed by chunks, each starting with an e_logChunkType byte.
+//   LOG_CHUNK_FORMAT: uint32 id, uint8 level, uint32 line, uint16 fileLength, file, uint16 formatLength, format
+//   LOG_CHUNK_RECORD: uint16 length, payload (formatId, timestamp, packed arguments)
+//   LOG_CHUNK_TEXT:   uint8 level, uint16 length, already formatted line
+typedef enum e_logChunkType {
+    LOG_CHUNK_FORMAT = 1,
+    LOG_CHUNK_RECORD = 2,
+    LOG_CHUNK_TEXT = 3
+}e_logChunkType;
+
+struct LogBinaryFileHeader
+{
+    char magic[8];
+    uint32 version;
+    uint32 reserved;
+    uint64 baseTimestamp;   // logBinaryTimestamp() when the file was created
+    uint64 unixTime;        // wall clock seconds when the file was created
+};
+
+struct LogFormatSite
+{
+    const char* format;
+    const char* file;
+    uint32 line;
+    e_logLevel level;
+};
+
+uint32 logBinaryRegisterFormat(e_logLevel level, const char* format, const char* file, uint32 line);
+// Call sites that got LOG_BINARY_FORMAT_OVERFLOW
+uint32 logBinaryOverflowCount();
+const LogFormatSite* logBinaryGetFormat(uint32 id);
+// Nanoseconds on a monotonic clock
+uint64 logBinaryTimestamp();
+
+// Formats packed arguments with a printf format string. Returns the written length.
+uint32 logBinaryFormat(const char* format, const uint8* args, uint32 argsSize, char* out, uint32 outSize);
+
+// Writes binary records as-is and text records as text chunks. Decode with Tools/logdecode.
+LogSink logBinaryFileSink(const char* path);
+
+// Payload is formatId, timestamp and packed arguments, at most LOG_RECORD_PAYLOAD_SIZE bytes.
+void logOutputBinary(e_logLevel level, const uint8* payload, uint32 length);
+// Payload is the format pointer and packed arguments, formatted when the record is delivered.
+void logOutputDeferred(e_logLevel level, const uint8* payload, uint32 length);
+
+struct LogArgWriter
+{
+    uint8* cursor;
+    uint8* end;
+};
+
+inline void logPackScalar(LogArgWriter& writer, e_logArgType type, const void* value, uint32 size)
+{
+    if (writer.end - writer.cursor < (int64)size + 1)
+    {
+        writer.end = writer.cursor;
+        return;
+    }
+    *writer.cursor = (uint8)type;
+    memcpy(writer.cursor + 1, value, size);
+    writer.cursor += size + 1;
+}
+
+template<typename T>
+inline typename std::enable_if<(std::is_integral<T>::value && std::is_signed<T>::value) || std::is_enum<T>::value>::type
+logPackArg(LogArgWriter& writer, T value)
+{
+    if (sizeof(T) <= 4)
+    {
+        int32 narrow = (int32)value;
+        logPackScalar(writer, LOG_ARG_INT32, &narrow, 4);
+        return;
+    }
+    int64 widened = (int64)value;
+    logPackScalar(writer, LOG_ARG_INT, &widened, 8);
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+logPackArg(LogArgWriter& writer, T value)
+{
+    if (sizeof(T) <= 4)
+    {
+        uint32 narrow = (uint32)value;
+        logPackScalar(writer, LOG_ARG_UINT32, &narrow, 4);
+        return;
+    }
+    uint64 widened = (uint64)value;
+    logPackScalar(writer, LOG_ARG_UINT, &widened, 8);
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+logPackArg(LogArgWriter& writer, T value)
+{
+    float64 widened = (float64)value;
+    logPackScalar(writer, LOG_ARG_FLOAT, &widened, 8);
+}
+
+template<typename T>
+inline void logPackArg(LogArgWriter& writer, const T* value)
+{
+    uint64 address = (uint64)(uintptr_t)value;
+    logPackScalar(writer, LOG_ARG_POINTER, &address, 8);
+}
+
+// Strings are the one argument that has to be copied; they are truncated to fit the record.
+inline void logPackArg(LogArgWriter& writer, const char* value)
+{
+    if (writer.end - writer.cursor < 3)
+    {
+        writer.end = writer.cursor;
+        return;
+    }
+
+    uint32 available = (uint32)(writer.end - writer.cursor) - 3;
+    uint32 length = value ? (uint32)strlen(value) : 0;
+    length = length < available ? length : available;
+    uint16 storedLength = (uint16)length;
+
+    *writer.cursor = LOG_ARG_STRING;
+    memcpy(writer.cursor + 1, &storedLength, 2);
+    memcpy(writer.cursor + 3, value, length);
+    writer.cursor += 3 + length;
+}
+
+inline void logPackArg(LogArgWriter& writer, char* value)
+{
+    logPackArg(writer, (const char*)value);
+}
+
+inline void logPackArgs(LogArgWriter& writer)
+{
+}
+
+template<typename T, typename... Args>
+inline void logPackArgs(LogArgWriter& writer, T value, Args... rest)
+{
+    logPackArg(writer, value);
+    logPackArgs(writer, rest...);
+}
+
+template<typename... Args>
+inline void logBinaryWrite(e_logLevel level, uint32 formatId, Args... args)
+{
+    uint8 payload[LOG_RECORD_PAYLOAD_SIZE];
+    uint64 timestamp = logBinaryTimestamp();
+    memcpy(payload, &formatId, 4);
+    memcpy(payload + 4, &timestamp, 8);
+
+    LogArgWriter writer;
+    writer.cursor = payload + LOG_BINARY_HEADER_SIZE;
+    writer.end = payload + sizeof(payload);
+    logPackArgs(writer, args...);
+
+    logOutputBinary(level, payload, (uint32)(writer.cursor - payload));
+}
+
+#define SGSLOG_BINARY(level, message, ...)                                                              \
+    {                                                                                                   \
+        static const uint32 sgsLogFormatId = logBinaryRegisterFormat(level, message, __FILE__, __LINE__); \
+        if (sgsLogFormatId != LOG_BINARY_FORMAT_OVERFLOW)                                               \
+        {                                                                                               \
+            logBinaryWrite(level, sgsLogFormatId, ##__VA_ARGS__);                                       \
+        }                                                                                               \
+        else                                                                                            \
+        {                                                                                               \
+            logOutput(level, message, ##__VA_ARGS__);                                                   \
+        }                                                                                               \
+    }
+
+template<typename... Args>
+inline void logOutput(e_logLevel level, const char* message, Args... args)
+{
+    uint8 payload[LOG_RECORD_PAYLOAD_SIZE];
+    memcpy(payload, &message, sizeof(message));
+
+    LogArgWriter writer;
+    writer.cursor = payload + sizeof(message);
+    writer.end = payload + sizeof(payload);
+    logPackArgs(writer, args...);
+
+    logOutputDeferred(level, payload, (uint32)(writer.cursor - payload));
+}
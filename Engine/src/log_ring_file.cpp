@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "log_ring_file.h"
+
+#if SGS_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct LogRingFile
+{
+    uint8* mapping;
+    uint64 size;
+    LogRingFileHeader* header;
+    uint8* data;
+#if SGS_PLATFORM_WINDOWS
+    HANDLE file;
+    HANDLE fileMapping;
+#else
+    int32 file;
+#endif
+};
+
+static uint64 alignRecord(uint64 size)
+{
+    return (size + 7) & ~7ull;
+}
+
+// FNV-1a over the header fields after the checksum and the text
+static uint32 recordChecksum(const LogRingRecordHeader* record, const uint8* text)
+{
+    uint32 hash = 2166136261u;
+    const uint8* fields = (const uint8*)&record->sequence;
+    uint32 fieldsSize = sizeof(LogRingRecordHeader) - 8;
+    for (uint32 i = 0; i < fieldsSize; i++)
+    {
+        hash = (hash ^ fields[i]) * 16777619u;
+    }
+    for (uint32 i = 0; i < record->length; i++)
+    {
+        hash = (hash ^ text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void ringWrite(void* userData, e_logLevel level, const char* line, uint32 length)
+{
+    LogRingFile* ring = (LogRingFile*)userData;
+    LogRingFileHeader* header = ring->header;
+
+    uint64 maxText = header->dataSize / 4 - sizeof(LogRingRecordHeader);
+    length = length < maxText ? length : (uint32)maxText;
+    uint64 recordSize = alignRecord(sizeof(LogRingRecordHeader) + length);
+
+    uint64 cursor = header->writeCursor;
+    if (cursor + recordSize > header->dataSize)
+    {
+        // Mark the tail as padding so the reader knows to wrap, then start over at the front
+        uint64 remaining = header->dataSize - cursor;
+        if (remaining >= sizeof(LogRingRecordHeader))
+        {
+            LogRingRecordHeader padding = {};
+            padding.marker = LOG_RING_RECORD_MARKER;
+            padding.sequence = header->nextSequence;
+            padding.flags = LOG_RING_RECORD_PADDING;
+            padding.checksum = recordChecksum(&padding, nullptr);
+            memcpy(ring->data + cursor, &padding, sizeof(padding));
+        }
+        cursor = 0;
+    }
+
+    LogRingRecordHeader record = {};
+    record.marker = LOG_RING_RECORD_MARKER;
+    record.sequence = header->nextSequence;
+    record.length = (uint16)length;
+    record.level = (uint8)level;
+    record.checksum = recordChecksum(&record, (const uint8*)line);
+
+    memcpy(ring->data + cursor + sizeof(record), line, length);
+    memcpy(ring->data + cursor, &record, sizeof(record));
+
+    // Only published once the record is complete; a crash before this leaves the old cursor
+    header->nextSequence = record.sequence + 1;
+    header->writeCursor = cursor + recordSize;
+}
+
+static void ringFlush(void* userData)
+{
+    LogRingFile* ring = (LogRingFile*)userData;
+#if SGS_PLATFORM_WINDOWS
+    FlushViewOfFile(ring->mapping, 0);
+#else
+    msync(ring->mapping, ring->size, MS_ASYNC);
+#endif
+}
+
+static void ringClose(void* userData)
+{
+    LogRingFile* ring = (LogRingFile*)userData;
+#if SGS_PLATFORM_WINDOWS
+    UnmapViewOfFile(ring->mapping);
+    CloseHandle(ring->fileMapping);
+    CloseHandle(ring->file);
+#else
+    munmap(ring->mapping, ring->size);
+    close(ring->file);
+#endif
+    delete ring;
+}
+
+static bool mapRingFile(LogRingFile* ring, const char* path, uint64 size)
+{
+#if SGS_PLATFORM_WINDOWS
+    ring->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (ring->file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    ring->fileMapping = CreateFileMappingA(ring->file, nullptr, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, nullptr);
+    if (!ring->fileMapping)
+    {
+        CloseHandle(ring->file);
+        return false;
+    }
+
+    ring->mapping = (uint8*)MapViewOfFile(ring->fileMapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+    if (!ring->mapping)
+    {
+        CloseHandle(ring->fileMapping);
+        CloseHandle(ring->file);
+        return false;
+    }
+#else
+    ring->file = open(path, O_RDWR | O_CREAT, 0644);
+    if (ring->file < 0)
+    {
+        return false;
+    }
+
+    if (ftruncate(ring->file, (off_t)size) != 0)
+    {
+        close(ring->file);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->file, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(ring->file);
+        return false;
+    }
+    ring->mapping = (uint8*)mapping;
+#endif
+    return true;
+}
+
+LogSink logRingFileSink(const char* path, uint64 size)
+{
+    LogSink sink;
+    size = size < LOG_RING_MIN_SIZE ? LOG_RING_MIN_SIZE : alignRecord(size);
+
+    LogRingFile* ring = new LogRingFile();
+    if (!mapRingFile(ring, path, size))
+    {
+        delete ring;
+        return sink;
+    }
+
+    ring->size = size;
+    ring->header = (LogRingFileHeader*)ring->mapping;
+    ring->data = ring->mapping + sizeof(LogRingFileHeader);
+
+    LogRingFileHeader* header = ring->header;
+    uint64 dataSize = size - sizeof(LogRingFileHeader);
+    bool reuse = memcmp(header->magic, LOG_RING_FILE_MAGIC, 8) == 0 && header->version == LOG_RING_FILE_VERSION &&
+        header->dataSize == dataSize && header->writeCursor <= dataSize;
+    if (!reuse)
+    {
+        memset(ring->mapping, 0, size);
+        header->version = LOG_RING_FILE_VERSION;
+        header->headerSize = sizeof(LogRingFileHeader);
+        header->dataSize = dataSize;
+        memcpy(header->magic, LOG_RING_FILE_MAGIC, 8);
+    }
+
+    sink.write = ringWrite;
+    sink.flush = ringFlush;
+    sink.close = ringClose;
+    sink.userData = ring;
+    return sink;
+}
+
+static bool validRecord(const uint8* data, uint64 dataSize, uint64 offset, const LogRingRecordHeader*& record)
+{
+    record = (const LogRingRecordHeader*)(data + offset);
+    if (record->marker != LOG_RING_RECORD_MARKER || offset + sizeof(LogRingRecordHeader) + record->length > dataSize)
+    {
+        return false;
+    }
+    return record->checksum == recordChecksum(record, data + offset + sizeof(LogRingRecordHeader));
+}
+
+// Moves offset to the next record that checksums, following the ring. Returns false once a full
+// lap is walked. Skipped bytes that start with a record marker count as torn records.
+static bool nextRecord(const uint8* data, uint64 dataSize, uint64& offset, uint64& walked,
+    const LogRingRecordHeader*& record, uint64* tornRecords)
+{
+    while (walked < dataSize)
+    {
+        if (offset + sizeof(LogRingRecordHeader) > dataSize)
+        {
+            walked += dataSize - offset;
+            offset = 0;
+            continue;
+        }
+
+        if (validRecord(data, dataSize, offset, record))
+        {
+            return true;
+        }
+        if (tornRecords && record->marker == LOG_RING_RECORD_MARKER)
+        {
+            (*tornRecords)++;
+        }
+        offset += 8;
+        walked += 8;
+    }
+    return false;
+}
+
+static void skipRecord(const LogRingRecordHeader* record, uint64 dataSize, uint64& offset, uint64& walked)
+{
+    uint64 recordSize = (record->flags & LOG_RING_RECORD_PADDING) ? dataSize - offset :
+        alignRecord(sizeof(LogRingRecordHeader) + record->length);
+    offset += recordSize;
+    walked += recordSize;
+    if (offset >= dataSize)
+    {
+        offset = 0;
+    }
+}
+
+uint64 logRingFileRead(const uint8* image, uint64 imageSize, PFN_logRingRecordVisitor visitor, void* userData, uint64* tornRecords)
+{
+    if (tornRecords)
+    {
+        *tornRecords = 0;
+    }
+
+    const LogRingFileHeader* header = (const LogRingFileHeader*)image;
+    if (imageSize < sizeof(LogRingFileHeader) || memcmp(header->magic, LOG_RING_FILE_MAGIC, 8) != 0 ||
+        header->headerSize + header->dataSize > imageSize || header->writeCursor > header->dataSize)
+    {
+        return 0;
+    }
+
+    const uint8* data = image + header->headerSize;
+    uint64 dataSize = header->dataSize;
+    const LogRingRecordHeader* record;
+
+    // The oldest data normally sits right after the write cursor, but a record completed right
+    // before a crash sits there too, unpublished. Start at the lowest sequence instead; one lap
+    // from it reaches that record last, past the ones before it. Anything that doesn't checksum
+    // (never written, overwritten halfway or torn by a crash) is skipped.
+    uint64 start = header->writeCursor;
+    uint64 oldestSequence = ~0ull;
+    uint64 offset = header->writeCursor;
+    uint64 walked = 0;
+    while (nextRecord(data, dataSize, offset, walked, record, nullptr))
+    {
+        if (!(record->flags & LOG_RING_RECORD_PADDING) && record->sequence < oldestSequence)
+        {
+            oldestSequence = record->sequence;
+            start = offset;
+        }
+        skipRecord(record, dataSize, offset, walked);
+    }
+
+    offset = start;
+    walked = 0;
+    uint64 visited = 0;
+    uint64 lastSequence = 0;
+    bool anyVisited = false;
+    while (nextRecord(data, dataSize, offset, walked, record, tornRecords))
+    {
+        // Sequences only grow from the oldest record on, anything else is left over from a lap before
+        bool inOrder = !anyVisited || record->sequence > lastSequence;
+        if (!(record->flags & LOG_RING_RECORD_PADDING) && inOrder)
+        {
+            visitor(userData, record->sequence, (e_logLevel)record->level,
+                (const char*)data + offset + sizeof(LogRingRecordHeader), record->length);
+            lastSequence = record->sequence;
+            anyVisited = true;
+            visited++;
+        }
+        skipRecord(record, dataSize, offset, walked);
+    }
+
+    return visited;
+}
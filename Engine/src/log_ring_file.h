@@ -0,0 +1,46 @@
+#pragma once
+
+#include "logger.h"
+
+// Crash-safe log sink: lines are copied into a fixed-size memory-mapped file used as a ring.
+// Writing is a memcpy into the mapping, no syscall. The OS keeps the mapped pages when the
+// process dies, and Tools/logring reads the records back in sequence order using the per-record
+// checksums, skipping a record that was torn by the crash and keeping one completed right before
+// it even though the header never published it.
+
+#define LOG_RING_FILE_MAGIC "SGSLRING"
+#define LOG_RING_FILE_VERSION 1
+#define LOG_RING_RECORD_MARKER 0x52474f4cu   // "LOGR"
+#define LOG_RING_RECORD_PADDING BIT(0)
+#define LOG_RING_MIN_SIZE (64 * 1024)
+
+struct LogRingFileHeader
+{
+    char magic[8];
+    uint32 version;
+    uint32 headerSize;
+    uint64 dataSize;        // bytes of record area following the header
+    uint64 writeCursor;     // offset in the record area where the next record goes
+    uint64 nextSequence;
+};
+
+// Records are 8 byte aligned. The checksum covers the fields after it and the text.
+struct LogRingRecordHeader
+{
+    uint32 marker;
+    uint32 checksum;
+    uint64 sequence;
+    uint16 length;
+    uint8 level;
+    uint8 flags;
+    uint32 reserved;
+};
+
+// size is the whole file size. An existing ring file of the same size is appended to.
+LogSink logRingFileSink(const char* path, uint64 size);
+
+typedef void (*PFN_logRingRecordVisitor)(void* userData, uint64 sequence, e_logLevel level, const char* text, uint32 length);
+
+// Visits the valid records of a ring file image from oldest to newest. Returns how many were
+// visited; tornRecords (optional) receives how many records failed their checksum.
+uint64 logRingFileRead(const uint8* image, uint64 imageSize, PFN_logRingRecordVisitor visitor, void* userData, uint64* tornRecords);
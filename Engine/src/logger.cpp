@@ -1,48 +1,846 @@
 #include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "logger.h"
 #include "assertions.h"
+#include "flight_recorder.h"
+#include "cpu_topology.h"
 
+#if SGS_PLATFORM_WINDOWS
 #include <windows.h>
-    
+#endif
+
+#define LOG_MAX_SINKS 8
+#define LOG_LINE_SIZE (LOG_RECORD_SIZE + 16)
+// Repeated records are summarized at least this often
+#define LOG_REPEAT_REPORT_NS 1000000000ull
+
+#define LOG_RECORD_BINARY BIT(0)
+#define LOG_RECORD_DEFERRED BIT(1)
+
+// One fixed-size slot of a producer ring. Text records (LOG_RECORD_DEFERRED) store the format
+// pointer and the packed arguments built by logOutput, binary records (LOG_RECORD_BINARY) the
+// payload built by logBinaryWrite. Both are formatted only when delivered.
+struct LogRecord
+{
+    uint8 level;
+    uint8 flags;
+    uint16 length;
+    char text[LOG_RECORD_PAYLOAD_SIZE];
+};
+
+STATIC_ASSERT(sizeof(LogRecord) == LOG_RECORD_SIZE, "Expected LogRecord to be LOG_RECORD_SIZE bytes.");
+
+// Single producer (the owning thread), single consumer (the logger thread).
+struct LogRing
+{
+    alignas(SGS_CACHE_LINE_SIZE) std::atomic<uint32> head;     // written by the producer
+    std::atomic<bool> writing;                                  // producer is between beginRecord and commitRecord
+    alignas(SGS_CACHE_LINE_SIZE) std::atomic<uint32> tail;     // written by the consumer
+    alignas(SGS_CACHE_LINE_SIZE) std::atomic<bool> ready;
+    std::atomic<bool> inUse;
+    LogRecord* records;
+    uint32 mask;
+
+    // Consumer-side deduplication of consecutive identical records
+    LogRecord lastRecord;
+    bool hasLastRecord;
+    uint32 repeats;
+    uint64 firstRepeatTime;
+};
+
+struct LoggerState
+{
+    LogConfig config;
+    uint32 ringCapacity = 1024;
+
+    LogSink sinks[LOG_MAX_SINKS];
+    uint32 sinkCount = 0;
+
+    LogRing rings[LOG_MAX_PRODUCER_THREADS];
+    std::atomic<uint32> ringsReserved;
+
+    std::atomic<bool> initialized;
+    std::atomic<bool> running;
+    std::thread thread;
+
+    // Guards flush requests and the stop flag. Producers only take it to wake the logger thread
+    // while it sleeps with every ring empty.
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> sleeping;
+    bool repeatsPending = false;        // logger thread only
+    std::condition_variable flushedCondition;
+    uint64 flushRequested = 0;
+    uint64 flushCompleted = 0;
+    bool stopRequested = false;
+
+    // Serializes sink calls between the logger thread and the synchronous fallback path.
+    std::mutex sinkMutex;
+
+    std::atomic<uint64> written;
+    std::atomic<uint64> dropped;
+};
+
+static LoggerState logger;
+
+struct LogThreadSlot
+{
+    LogRing* ring = nullptr;
+    bool exhausted = false;
+
+    ~LogThreadSlot()
+    {
+        if (ring)
+        {
+            ring->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+static thread_local LogThreadSlot threadSlot;
+static thread_local bool isLoggerThread = false;
+
+static const char* levelStrings[6] = { "[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: " };
+
+std::atomic<uint8> logCategoryLevels[LOG_CATEGORY_COUNT] = {
+    { LOG_LEVEL_TRACE }, { LOG_LEVEL_TRACE }, { LOG_LEVEL_TRACE }, { LOG_LEVEL_TRACE }, { LOG_LEVEL_TRACE }
+};
+std::atomic<uint32> logCategoryRateLimits[LOG_CATEGORY_COUNT];
+
+STATIC_ASSERT(LOG_CATEGORY_COUNT == 5, "Expected a default level for every log category.");
+
 void report_assertion_failure(const char* expression, const char* message, const char* file, int32 line)
 {
     logOutput(LOG_LEVEL_FATAL, "Assertion failure: %s, message '%s', in file %s, line: %d\n", expression, message, file, line);
+    flightRecorderDump("assertion failure");
+}
+
+static uint32 formatLine(char* line, uint32 lineSize, e_logLevel level, const char* text, uint32 textLength)
+{
+    uint32 prefixLength = (uint32)strlen(levelStrings[level]);
+    memcpy(line, levelStrings[level], prefixLength);
+    if (textLength > lineSize - prefixLength - 2)
+    {
+        textLength = lineSize - prefixLength - 2;
+    }
+    memcpy(line + prefixLength, text, textLength);
+    uint32 length = prefixLength + textLength;
+    line[length++] = '\n';
+    line[length] = 0;
+    return length;
 }
 
-void logOutput(e_logLevel level, const char* message, ...)
+static void consoleWrite(void* userData, e_logLevel level, const char* line, uint32 length)
 {
-    const char* levelString[6] = { "[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: " };
     bool isError = level < LOG_LEVEL_WARN;
 
-    const int32 msgLength = 32000;
-    char outMessage[msgLength];
-    char outputMessage[msgLength];
-    memset(outMessage, 0, sizeof(outMessage));
-
-    va_list argPtr;
-    va_start(argPtr, message);
-    vsnprintf(outMessage, msgLength, message, argPtr);
-    va_end(argPtr);
-
-    sprintf_s(outputMessage, "%s%s\n", levelString[level], outMessage);
-
-    if (isError)
-    {
-        HANDLE consoleHandle = GetStdHandle(STD_ERROR_HANDLE);
-        static uint8 levels[6] = { 64, 4, 6, 2, 1, 8 };
-        SetConsoleTextAttribute(consoleHandle, levels[level]);
-        OutputDebugStringA(outputMessage);
-        uint64 length = strlen(outputMessage);
-        LPDWORD number_written = 0;
-        WriteConsoleA(GetStdHandle(STD_ERROR_HANDLE), outputMessage, (DWORD)length, number_written, 0);
-    }
-    else {
-        HANDLE console_handle = GetStdHandle(STD_OUTPUT_HANDLE);
-        static uint8 levels[6] = { 64, 4, 6, 2, 1, 8 };
-        SetConsoleTextAttribute(console_handle, levels[level]);
-        OutputDebugStringA(outputMessage);
-        uint64 length = strlen(outputMessage);
-        LPDWORD number_written = 0;
-        WriteConsoleA(GetStdHandle(STD_OUTPUT_HANDLE), outputMessage, (DWORD)length, number_written, 0);
+#if SGS_PLATFORM_WINDOWS
+    HANDLE consoleHandle = GetStdHandle(isError ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+    static uint8 levels[6] = { 64, 4, 6, 2, 1, 8 };
+    SetConsoleTextAttribute(consoleHandle, levels[level]);
+    OutputDebugStringA(line);
+    DWORD numberWritten = 0;
+    WriteConsoleA(consoleHandle, line, (DWORD)length, &numberWritten, 0);
+#else
+    static const char* colors[6] = { "0;41", "1;31", "1;33", "1;32", "1;34", "1;30" };
+    FILE* stream = isError ? stderr : stdout;
+    fprintf(stream, "\033[%sm%.*s\033[0m", colors[level], (int32)length, line);
+#endif
+}
+
+static void consoleFlush(void* userData)
+{
+    fflush(stdout);
+    fflush(stderr);
+}
+
+static void fileWrite(void* userData, e_logLevel level, const char* line, uint32 length)
+{
+    fwrite(line, 1, length, (FILE*)userData);
+}
+
+static void fileFlush(void* userData)
+{
+    fflush((FILE*)userData);
+}
+
+static void fileClose(void* userData)
+{
+    fclose((FILE*)userData);
+}
+
+static void memoryWrite(void* userData, e_logLevel level, const char* line, uint32 length)
+{
+    LogMemoryBuffer* buffer = (LogMemoryBuffer*)userData;
+    if (buffer->capacity == 0)
+    {
+        return;
+    }
+
+    if (length > buffer->capacity)
+    {
+        line += length - buffer->capacity;
+        length = buffer->capacity;
+    }
+
+    uint32 start = (uint32)(buffer->totalWritten % buffer->capacity);
+    uint32 firstPart = buffer->capacity - start < length ? buffer->capacity - start : length;
+    memcpy(buffer->data + start, line, firstPart);
+    memcpy(buffer->data, line + firstPart, length - firstPart);
+    buffer->totalWritten += length;
+}
+
+LogSink logConsoleSink()
+{
+    LogSink sink;
+    sink.write = consoleWrite;
+    sink.flush = consoleFlush;
+    return sink;
+}
+
+LogSink logFileSink(const char* path)
+{
+    LogSink sink;
+    FILE* file = fopen(path, "wb");
+    if (file)
+    {
+        sink.write = fileWrite;
+        sink.flush = fileFlush;
+        sink.close = fileClose;
+        sink.userData = file;
+    }
+    return sink;
+}
+
+LogSink logMemorySink(LogMemoryBuffer* buffer)
+{
+    LogSink sink;
+    sink.write = memoryWrite;
+    sink.userData = buffer;
+    return sink;
+}
+
+uint32 logMemoryBufferRead(const LogMemoryBuffer* buffer, char* out, uint32 outSize)
+{
+    if (outSize == 0)
+    {
+        return 0;
+    }
+
+    uint32 stored = buffer->totalWritten < buffer->capacity ? (uint32)buffer->totalWritten : buffer->capacity;
+    uint32 skip = stored > outSize - 1 ? stored - (outSize - 1) : 0;
+    uint32 start = buffer->totalWritten < buffer->capacity ? 0 : (uint32)(buffer->totalWritten % buffer->capacity);
+
+    uint32 length = 0;
+    for (uint32 i = skip; i < stored; i++)
+    {
+        out[length++] = buffer->data[(start + i) % buffer->capacity];
+    }
+    out[length] = 0;
+    return length;
+}
+
+bool logAddSink(const LogSink& sink)
+{
+    if (logger.initialized.load() || !sink.write || logger.sinkCount == LOG_MAX_SINKS)
+    {
+        return false;
+    }
+
+    logger.sinks[logger.sinkCount++] = sink;
+    return true;
+}
+
+void logRemoveAllSinks()
+{
+    if (logger.initialized.load())
+    {
+        return;
+    }
+
+    for (uint32 i = 0; i < logger.sinkCount; i++)
+    {
+        if (logger.sinks[i].close)
+        {
+            logger.sinks[i].close(logger.sinks[i].userData);
+        }
+    }
+    logger.sinkCount = 0;
+}
+
+void logSetCategoryLevel(e_logCategory category, e_logLevel level)
+{
+    logCategoryLevels[category].store((uint8)level, std::memory_order_relaxed);
+}
+
+e_logLevel logGetCategoryLevel(e_logCategory category)
+{
+    return (e_logLevel)logCategoryLevels[category].load(std::memory_order_relaxed);
+}
+
+void logSetCategoryRateLimit(e_logCategory category, uint32 messagesPerSecond)
+{
+    logCategoryRateLimits[category].store(messagesPerSecond, std::memory_order_relaxed);
+}
+
+// Fixed one second windows per call site. The first message let through in a new window
+// reports how many were suppressed in the previous ones.
+bool logRateLimitSlow(LogRateLimiter& limiter, uint32 limit, const char* file, int32 line)
+{
+    uint64 now = logBinaryTimestamp();
+    uint64 windowStart = limiter.windowStart.load(std::memory_order_relaxed);
+    if (now - windowStart >= 1000000000ull &&
+        limiter.windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed))
+    {
+        limiter.count.store(0, std::memory_order_relaxed);
+        uint32 suppressed = limiter.suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed)
+        {
+            logOutput(LOG_LEVEL_WARN, "%u messages suppressed by the rate limit at %s:%d", suppressed, file, line);
+        }
+    }
+
+    if (limiter.count.fetch_add(1, std::memory_order_relaxed) < limit)
+    {
+        return true;
+    }
+
+    limiter.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+LogStats logGetStats()
+{
+    LogStats stats;
+    stats.written = logger.written.load(std::memory_order_relaxed);
+    stats.dropped = logger.dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Caller holds sinkMutex. Binary records are only decoded if some sink wants text.
+static void deliverRecord(e_logLevel level, uint8 flags, const char* data, uint32 length)
+{
+    char line[LOG_LINE_SIZE];
+    uint32 lineLength = 0;
+    bool binary = (flags & LOG_RECORD_BINARY) != 0;
+    bool needsLine = logger.sinkCount == 0;
+
+    for (uint32 i = 0; i < logger.sinkCount; i++)
+    {
+        needsLine |= !binary || !logger.sinks[i].writeBinary;
+    }
+
+    if (needsLine)
+    {
+        if (binary)
+        {
+            char text[LOG_RECORD_SIZE];
+            uint32 formatId;
+            memcpy(&formatId, data, 4);
+            const LogFormatSite* site = logBinaryGetFormat(formatId);
+            uint32 textLength = site ? logBinaryFormat(site->format, (const uint8*)data + LOG_BINARY_HEADER_SIZE,
+                length - LOG_BINARY_HEADER_SIZE, text, sizeof(text)) : 0;
+            lineLength = formatLine(line, sizeof(line), level, text, textLength);
+        }
+        else if (flags & LOG_RECORD_DEFERRED)
+        {
+            char text[LOG_RECORD_SIZE];
+            const char* format;
+            memcpy(&format, data, sizeof(format));
+            uint32 textLength = logBinaryFormat(format, (const uint8*)data + sizeof(format),
+                length - sizeof(format), text, sizeof(text));
+            lineLength = formatLine(line, sizeof(line), level, text, textLength);
+        }
+        else
+        {
+            lineLength = formatLine(line, sizeof(line), level, data, length);
+        }
+    }
+
+    if (logger.sinkCount == 0)
+    {
+        consoleWrite(nullptr, level, line, lineLength);
+    }
+
+    for (uint32 i = 0; i < logger.sinkCount; i++)
+    {
+        const LogSink& sink = logger.sinks[i];
+        if (binary && sink.writeBinary)
+        {
+            sink.writeBinary(sink.userData, level, (const uint8*)data, length);
+        }
+        else
+        {
+            sink.write(sink.userData, level, line, lineLength);
+        }
+    }
+    logger.written.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void flushSinks()
+{
+    std::lock_guard<std::mutex> lock(logger.sinkMutex);
+    if (logger.sinkCount == 0)
+    {
+        consoleFlush(nullptr);
+    }
+
+    for (uint32 i = 0; i < logger.sinkCount; i++)
+    {
+        if (logger.sinks[i].flush)
+        {
+            logger.sinks[i].flush(logger.sinks[i].userData);
+        }
+    }
+}
+
+static LogRing* acquireRing()
+{
+    uint32 reserved = logger.ringsReserved.load(std::memory_order_acquire);
+    if (reserved > LOG_MAX_PRODUCER_THREADS)
+    {
+        reserved = LOG_MAX_PRODUCER_THREADS;
+    }
+
+    // Reuse a drained ring left behind by a thread that exited
+    for (uint32 i = 0; i < reserved; i++)
+    {
+        LogRing& ring = logger.rings[i];
+        bool expected = false;
+        if (ring.ready.load(std::memory_order_acquire) &&
+            ring.head.load(std::memory_order_relaxed) == ring.tail.load(std::memory_order_acquire) &&
+            ring.inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        {
+            return &ring;
+        }
+    }
+
+    uint32 index = logger.ringsReserved.fetch_add(1, std::memory_order_acq_rel);
+    if (index >= LOG_MAX_PRODUCER_THREADS)
+    {
+        return nullptr;
+    }
+
+    LogRing& ring = logger.rings[index];
+    ring.records = new LogRecord[logger.ringCapacity];
+    ring.mask = logger.ringCapacity - 1;
+    ring.head.store(0, std::memory_order_relaxed);
+    ring.tail.store(0, std::memory_order_relaxed);
+    ring.inUse.store(true, std::memory_order_relaxed);
+    ring.ready.store(true, std::memory_order_release);
+    return &ring;
+}
+
+static void wakeLogger()
+{
+    // Pairs with the fence in loggerThreadMain: either this sees it sleeping, or it sees the record
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Only the first producer to see it asleep takes the mutex
+    if (logger.sleeping.load(std::memory_order_relaxed) && logger.sleeping.exchange(false, std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(logger.wakeMutex);
+        logger.wakeCondition.notify_one();
+    }
+}
+
+static void endRecord(LogRing* ring)
+{
+    ring->writing.store(false, std::memory_order_release);
+}
+
+// Returns the calling thread's next free slot, or nullptr if the record must take the
+// synchronous path. Sets dropped instead when the ring is full and dropping is allowed.
+// A returned slot must be published with commitRecord; logShutdown waits for it.
+static LogRecord* beginRecord(e_logLevel level, bool& dropped)
+{
+    dropped = false;
+    if (!logger.running.load(std::memory_order_acquire) || isLoggerThread)
+    {
+        return nullptr;
+    }
+
+    if (!threadSlot.ring)
+    {
+        if (threadSlot.exhausted)
+        {
+            return nullptr;
+        }
+
+        threadSlot.ring = acquireRing();
+        if (!threadSlot.ring)
+        {
+            threadSlot.exhausted = true;
+            return nullptr;
+        }
+    }
+
+    LogRing* ring = threadSlot.ring;
+
+    // Pairs with logShutdown: either it sees this record in flight, or this sees it stopping
+    ring->writing.exchange(true, std::memory_order_seq_cst);
+    if (!logger.running.load(std::memory_order_seq_cst))
+    {
+        endRecord(ring);
+        return nullptr;
+    }
+
+    uint32 head = ring->head.load(std::memory_order_relaxed);
+    bool woken = false;
+    while (head - ring->tail.load(std::memory_order_acquire) > ring->mask)
+    {
+        if (!woken)
+        {
+            wakeLogger();
+            woken = true;
+        }
+
+        if (logger.config.dropWhenFull && level > LOG_LEVEL_ERROR)
+        {
+            logger.dropped.fetch_add(1, std::memory_order_relaxed);
+            dropped = true;
+            endRecord(ring);
+            return nullptr;
+        }
+
+        if (!logger.running.load(std::memory_order_acquire))
+        {
+            endRecord(ring);
+            return nullptr;
+        }
+        std::this_thread::yield();
+    }
+
+    return &ring->records[head & ring->mask];
+}
+
+static void commitRecord()
+{
+    LogRing* ring = threadSlot.ring;
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    endRecord(ring);
+    wakeLogger();
+}
+
+// Binary records compare equal when format and arguments match, whatever their timestamp.
+static bool sameRecord(const LogRecord& a, const LogRecord& b)
+{
+    if (a.level != b.level || a.flags != b.flags || a.length != b.length)
+    {
+        return false;
+    }
+
+    if (a.flags & LOG_RECORD_BINARY)
+    {
+        return memcmp(a.text, b.text, 4) == 0 &&
+            memcmp(a.text + LOG_BINARY_HEADER_SIZE, b.text + LOG_BINARY_HEADER_SIZE, a.length - LOG_BINARY_HEADER_SIZE) == 0;
+    }
+    return memcmp(a.text, b.text, a.length) == 0;
+}
+
+// Caller holds sinkMutex.
+static void reportRepeats(LogRing& ring)
+{
+    char text[64];
+    uint32 length = (uint32)snprintf(text, sizeof(text), "last message repeated %u times", ring.repeats);
+    deliverRecord((e_logLevel)ring.lastRecord.level, 0, text, length);
+    ring.repeats = 0;
+}
+
+// Returns how many records were taken off the rings. Pending repeat summaries are written
+// once they are old enough, or right away with reportAllRepeats.
+static uint32 drainRings(bool reportAllRepeats)
+{
+    uint32 processed = 0;
+    uint64 now = 0;
+    logger.repeatsPending = false;
+
+    uint32 reserved = logger.ringsReserved.load(std::memory_order_acquire);
+    if (reserved > LOG_MAX_PRODUCER_THREADS)
+    {
+        reserved = LOG_MAX_PRODUCER_THREADS;
+    }
+
+    for (uint32 i = 0; i < reserved; i++)
+    {
+        LogRing& ring = logger.rings[i];
+        if (!ring.ready.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        uint32 tail = ring.tail.load(std::memory_order_relaxed);
+        uint32 head = ring.head.load(std::memory_order_acquire);
+        if (tail == head && ring.repeats == 0)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(logger.sinkMutex);
+        while (tail != head)
+        {
+            const LogRecord& record = ring.records[tail & ring.mask];
+            if (logger.config.deduplicate && ring.hasLastRecord && sameRecord(record, ring.lastRecord))
+            {
+                if (ring.repeats++ == 0)
+                {
+                    ring.firstRepeatTime = now ? now : (now = logBinaryTimestamp());
+                }
+            }
+            else
+            {
+                if (ring.repeats)
+                {
+                    reportRepeats(ring);
+                }
+                deliverRecord((e_logLevel)record.level, record.flags, record.text, record.length);
+
+                if (logger.config.deduplicate)
+                {
+                    memcpy(&ring.lastRecord, &record, 4 + record.length);
+                    ring.hasLastRecord = true;
+                }
+            }
+
+            tail++;
+            processed++;
+            ring.tail.store(tail, std::memory_order_release);
+        }
+
+        if (ring.repeats)
+        {
+            now = now ? now : logBinaryTimestamp();
+            if (reportAllRepeats || now - ring.firstRepeatTime >= LOG_REPEAT_REPORT_NS)
+            {
+                reportRepeats(ring);
+            }
+            logger.repeatsPending |= ring.repeats != 0;
+        }
+    }
+
+    return processed;
+}
+
+static bool ringsEmpty()
+{
+    uint32 reserved = logger.ringsReserved.load(std::memory_order_acquire);
+    reserved = reserved < LOG_MAX_PRODUCER_THREADS ? reserved : LOG_MAX_PRODUCER_THREADS;
+    for (uint32 i = 0; i < reserved; i++)
+    {
+        const LogRing& ring = logger.rings[i];
+        if (ring.ready.load(std::memory_order_acquire) &&
+            ring.head.load(std::memory_order_acquire) != ring.tail.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void loggerThreadMain()
+{
+    isLoggerThread = true;
+    cpuPlacementAttachThread(ENGINE_THREAD_LOGGER, 0);
+    uint64 flushCompleted = 0;
+
+    for (;;)
+    {
+        uint64 requested;
+        bool stop;
+        {
+            std::lock_guard<std::mutex> lock(logger.wakeMutex);
+            requested = logger.flushRequested;
+            stop = logger.stopRequested;
+        }
+
+        // Everything pushed before `requested` was read is visible to this drain
+        uint32 processed = drainRings(requested != flushCompleted || stop);
+
+        if (requested != flushCompleted)
+        {
+            flushSinks();
+            flushCompleted = requested;
+            std::lock_guard<std::mutex> lock(logger.wakeMutex);
+            logger.flushCompleted = requested;
+            logger.flushedCondition.notify_all();
+        }
+
+        if (processed == 0)
+        {
+            if (stop)
+            {
+                break;
+            }
+
+            // Sleep until a producer, a flush or shutdown wakes it. Pending repeat summaries are the
+            // only thing that needs a timeout.
+            std::unique_lock<std::mutex> lock(logger.wakeMutex);
+            logger.sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (logger.flushRequested == requested && !logger.stopRequested && ringsEmpty())
+            {
+                if (logger.repeatsPending)
+                {
+                    logger.wakeCondition.wait_for(lock, std::chrono::nanoseconds(LOG_REPEAT_REPORT_NS));
+                }
+                else
+                {
+                    logger.wakeCondition.wait(lock);
+                }
+            }
+            logger.sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+    cpuPlacementDetachThread();
+}
+
+bool logInitialize(const LogConfig& config)
+{
+    if (logger.initialized.load())
+    {
+        return false;
+    }
+
+    uint32 capacity = 2;
+    while (capacity < config.ringCapacity)
+    {
+        capacity <<= 1;
+    }
+
+    logger.config = config;
+    logger.ringCapacity = capacity;
+    logger.written.store(0);
+    logger.dropped.store(0);
+    logger.initialized.store(true);
+
+    if (config.async)
+    {
+        logger.stopRequested = false;
+        logger.flushRequested = 0;
+        logger.flushCompleted = 0;
+        logger.thread = std::thread(loggerThreadMain);
+        logger.running.store(true, std::memory_order_release);
+    }
+
+    return true;
+}
+
+void logShutdown()
+{
+    if (!logger.initialized.load())
+    {
+        return;
+    }
+
+    if (logger.running.load())
+    {
+        // New messages take the synchronous path from here on
+        logger.running.store(false, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(logger.wakeMutex);
+            logger.stopRequested = true;
+        }
+        logger.wakeCondition.notify_one();
+        logger.thread.join();
+
+        // Producers that saw running before it was cleared may still be filling a slot.
+        // Every ring is checked, since one may be reserved concurrently with this loop.
+        for (uint32 i = 0; i < LOG_MAX_PRODUCER_THREADS; i++)
+        {
+            while (logger.rings[i].writing.load(std::memory_order_seq_cst))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        // Pick up anything pushed while the logger thread was stopping
+        drainRings(true);
+    }
+
+    flushSinks();
+    logger.initialized.store(false);
+    logRemoveAllSinks();
+}
+
+void logFlush()
+{
+    if (isLoggerThread)
+    {
+        return;
+    }
+
+    if (!logger.running.load(std::memory_order_acquire))
+    {
+        flushSinks();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(logger.wakeMutex);
+    uint64 request = ++logger.flushRequested;
+    logger.wakeCondition.notify_one();
+    logger.flushedCondition.wait(lock, [request] {
+        return logger.flushCompleted >= request || logger.stopRequested;
+    });
+}
+
+void logOutputDeferred(e_logLevel level, const uint8* payload, uint32 length)
+{
+    const char* message;
+    memcpy(&message, payload, sizeof(message));
+    SGSRECORD(FLIGHT_EVENT_LOG, message, level);
+
+    bool dropped;
+    LogRecord* record = beginRecord(level, dropped);
+    if (record)
+    {
+        memcpy(record->text, payload, length);
+        record->length = (uint16)length;
+        record->level = (uint8)level;
+        record->flags = LOG_RECORD_DEFERRED;
+        commitRecord();
+    }
+    else if (!dropped)
+    {
+        std::lock_guard<std::mutex> lock(logger.sinkMutex);
+        deliverRecord(level, LOG_RECORD_DEFERRED, (const char*)payload, length);
+    }
+
+    if (level == LOG_LEVEL_FATAL)
+    {
+        logFlush();
+    }
+}
+
+void logOutputBinary(e_logLevel level, const uint8* payload, uint32 length)
+{
+    uint32 formatId;
+    memcpy(&formatId, payload, 4);
+    const LogFormatSite* site = logBinaryGetFormat(formatId);
+    SGSRECORD(FLIGHT_EVENT_LOG, site ? site->format : "binary log record", level);
+
+    bool dropped;
+    LogRecord* record = beginRecord(level, dropped);
+    if (record)
+    {
+        memcpy(record->text, payload, length);
+        record->length = (uint16)length;
+        record->level = (uint8)level;
+        record->flags = LOG_RECORD_BINARY;
+        commitRecord();
+    }
+    else if (!dropped)
+    {
+        std::lock_guard<std::mutex> lock(logger.sinkMutex);
+        deliverRecord(level, LOG_RECORD_BINARY, (const char*)payload, length);
+    }
+
+    if (level == LOG_LEVEL_FATAL)
+    {
+        logFlush();
     }
 }
\ No newline at end of file
@@ -1,10 +1,24 @@
 #pragma once
 
+#include <atomic>
+
+#include "defines.h"
+
 #define LOG_WARN_ENABLED 1
 #define LOG_INFO_ENABLED 1
 #define LOG_DEBUG_ENABLED 1
 #define LOG_TRACE_ENABLED 1
 
+// Route the SGS* macros through binary deferred-format logging (see log_binary.h)
+#ifndef LOG_BINARY_ENABLED
+#define LOG_BINARY_ENABLED 0
+#endif
+
+// Messages longer than this are truncated, as are string arguments that don't fit a record.
+#define LOG_RECORD_SIZE 512
+#define LOG_RECORD_PAYLOAD_SIZE (LOG_RECORD_SIZE - 4)
+#define LOG_MAX_PRODUCER_THREADS 64
+
 typedef enum e_logLevel {
     LOG_LEVEL_FATAL = 0,
     LOG_LEVEL_ERROR = 1,
@@ -14,34 +28,162 @@ typedef enum e_logLevel {
     LOG_LEVEL_TRACE = 5
 }e_logLevel;
 
-void logOutput(e_logLevel level, const char* message, ...);
+typedef enum e_logCategory {
+    LOG_CATEGORY_GENERAL = 0,
+    LOG_CATEGORY_RENDER = 1,
+    LOG_CATEGORY_IO = 2,
+    LOG_CATEGORY_WINDOW = 3,
+    LOG_CATEGORY_MEMORY = 4,
+    LOG_CATEGORY_COUNT
+}e_logCategory;
+
+// Sinks receive complete lines ("[INFO]: message\n"). With the async backend running they are
+// only ever called from the logger thread, so they don't need to be thread safe.
+typedef void (*PFN_logSinkWrite)(void* userData, e_logLevel level, const char* line, uint32 length);
+// Optional. Receives binary records undecoded; sinks without it get the formatted line instead.
+typedef void (*PFN_logSinkWriteBinary)(void* userData, e_logLevel level, const uint8* payload, uint32 length);
+typedef void (*PFN_logSinkFlush)(void* userData);
+typedef void (*PFN_logSinkClose)(void* userData);
+
+struct LogSink
+{
+    PFN_logSinkWrite write = nullptr;
+    PFN_logSinkWriteBinary writeBinary = nullptr;
+    PFN_logSinkFlush flush = nullptr;
+    PFN_logSinkClose close = nullptr;
+    void* userData = nullptr;
+};
+
+struct LogConfig
+{
+    bool async = true;
+    uint32 ringCapacity = 1024;     // records per producer thread, rounded up to a power of two
+    bool dropWhenFull = false;      // otherwise the producer waits for the logger thread
+    bool deduplicate = true;        // collapse consecutive identical records from one thread
+};
+
+struct LogStats
+{
+    uint64 written;
+    uint64 dropped;
+};
+
+// Keeps the most recent `capacity` bytes of output. Read it after logFlush().
+struct LogMemoryBuffer
+{
+    char* data = nullptr;
+    uint32 capacity = 0;
+    uint64 totalWritten = 0;
+};
+
+// Without logInitialize() every call goes synchronously to the console, like it always did.
+bool logInitialize(const LogConfig& config);
+void logShutdown();
+// Blocks until every record pushed before the call has reached the sinks.
+void logFlush();
+
+// Sinks can only be changed while the logger is not initialized.
+bool logAddSink(const LogSink& sink);
+void logRemoveAllSinks();
+LogStats logGetStats();
+
+LogSink logConsoleSink();
+LogSink logFileSink(const char* path);      // write == nullptr if the file could not be opened
+LogSink logMemorySink(LogMemoryBuffer* buffer);
+// Copies the buffered text in order into out (null terminated), returns the copied length.
+uint32 logMemoryBufferRead(const LogMemoryBuffer* buffer, char* out, uint32 outSize);
 
-#define SGSFATAL(message, ...) logOutput(LOG_LEVEL_FATAL, message, ##__VA_ARGS__);
+// printf style. Only the arguments are copied on the calling thread, the logger thread formats
+// them (see logOutputDeferred in log_binary.h), so message must outlive the record: a literal,
+// as every SGS* macro passes.
+template<typename... Args>
+inline void logOutput(e_logLevel level, const char* message, Args... args);
+
+// Runtime filtering. A category logs every level up to and including its current level.
+extern std::atomic<uint8> logCategoryLevels[LOG_CATEGORY_COUNT];
+extern std::atomic<uint32> logCategoryRateLimits[LOG_CATEGORY_COUNT];
+
+void logSetCategoryLevel(e_logCategory category, e_logLevel level);
+e_logLevel logGetCategoryLevel(e_logCategory category);
+// Messages per second allowed from each call site of the category, 0 disables the limit.
+void logSetCategoryRateLimit(e_logCategory category, uint32 messagesPerSecond);
+
+// One per call site, zero initialized so the static needs no guard.
+struct LogRateLimiter
+{
+    std::atomic<uint64> windowStart;
+    std::atomic<uint32> count;
+    std::atomic<uint32> suppressed;
+};
+
+bool logRateLimitSlow(LogRateLimiter& limiter, uint32 limit, const char* file, int32 line);
+
+inline bool logIsEnabled(e_logCategory category, e_logLevel level)
+{
+    return (uint8)level <= logCategoryLevels[category].load(std::memory_order_relaxed);
+}
+
+inline bool logRateLimitAllow(LogRateLimiter& limiter, e_logCategory category, e_logLevel level, const char* file, int32 line)
+{
+    uint32 limit = logCategoryRateLimits[category].load(std::memory_order_relaxed);
+    return limit == 0 || level == LOG_LEVEL_FATAL || logRateLimitSlow(limiter, limit, file, line);
+}
+
+#if LOG_BINARY_ENABLED == 1
+#define SGSLOG_OUTPUT(level, message, ...) SGSLOG_BINARY(level, message, ##__VA_ARGS__)
+#else
+#define SGSLOG_OUTPUT(level, message, ...) logOutput(level, message, ##__VA_ARGS__);
+#endif
+
+// The level check is a single branch taken before any argument is evaluated
+#define SGSLOG_CAT(category, level, message, ...)                                  \
+    {                                                                              \
+        static LogRateLimiter sgsLogLimiter;                                       \
+        if (logIsEnabled(category, level) &&                                       \
+            logRateLimitAllow(sgsLogLimiter, category, level, __FILE__, __LINE__)) \
+        {                                                                          \
+            SGSLOG_OUTPUT(level, message, ##__VA_ARGS__)                           \
+        }                                                                          \
+    }
+
+#define SGSFATAL(message, ...) SGSLOG_CAT(LOG_CATEGORY_GENERAL, LOG_LEVEL_FATAL, message, ##__VA_ARGS__)
+#define SGSFATAL_CAT(category, message, ...) SGSLOG_CAT(category, LOG_LEVEL_FATAL, message, ##__VA_ARGS__)
 
 #ifndef SGSERROR
-#define SGSERROR(message, ...) logOutput(LOG_LEVEL_ERROR, message, ##__VA_ARGS__);
+#define SGSERROR(message, ...) SGSLOG_CAT(LOG_CATEGORY_GENERAL, LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
+#define SGSERROR_CAT(category, message, ...) SGSLOG_CAT(category, LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
 #endif
 
 #if LOG_WARN_ENABLED == 1
-#define SGSWARN(message, ...) logOutput(LOG_LEVEL_WARN, message, ##__VA_ARGS__);
+#define SGSWARN(message, ...) SGSLOG_CAT(LOG_CATEGORY_GENERAL, LOG_LEVEL_WARN, message, ##__VA_ARGS__)
+#define SGSWARN_CAT(category, message, ...) SGSLOG_CAT(category, LOG_LEVEL_WARN, message, ##__VA_ARGS__)
 #else
 #define SGSWARN(message, ...);
+#define SGSWARN_CAT(category, message, ...);
 #endif
 
 #if LOG_INFO_ENABLED == 1
-#define SGSINFO(message, ...) logOutput(LOG_LEVEL_INFO, message, ##__VA_ARGS__);
+#define SGSINFO(message, ...) SGSLOG_CAT(LOG_CATEGORY_GENERAL, LOG_LEVEL_INFO, message, ##__VA_ARGS__)
+#define SGSINFO_CAT(category, message, ...) SGSLOG_CAT(category, LOG_LEVEL_INFO, message, ##__VA_ARGS__)
 #else
 #define SGSINFO(message, ...)
+#define SGSINFO_CAT(category, message, ...)
 #endif
 
 #if LOG_DEBUG_ENABLED == 1
-#define SGSDEBUG(message, ...) logOutput(LOG_LEVEL_DEBUG, message, ##__VA_ARGS__);
+#define SGSDEBUG(message, ...) SGSLOG_CAT(LOG_CATEGORY_GENERAL, LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
+#define SGSDEBUG_CAT(category, message, ...) SGSLOG_CAT(category, LOG_LEVEL_DEBUG, message, ##__VA_ARGS__)
 #else
 #define SGSDEBUG(message, ...)
+#define SGSDEBUG_CAT(category, message, ...)
 #endif
 
 #if LOG_TRACE_ENABLED == 1
-#define SGSTRACE(message, ...) logOutput(LOG_LEVEL_TRACE, message, ##__VA_ARGS__);
+#define SGSTRACE(message, ...) SGSLOG_CAT(LOG_CATEGORY_GENERAL, LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
+#define SGSTRACE_CAT(category, message, ...) SGSLOG_CAT(category, LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
 #else
 #define SGSTRACE(message, ...)
-#endif
\ No newline at end of file
+#define SGSTRACE_CAT(category, message, ...)
+#endif
+
+#include "log_binary.h"
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel_record.h"
+#include "assertions.h"
+#include "cpu_topology.h"
+#include "flight_recorder.h"
+
+void commandAllocatorPoolInitialize(CommandAllocatorPool* pool, RhiDevice* device, e_rhiQueueType type)
+{
+    pool->device = device;
+    pool->type = type;
+    pool->entries = nullptr;
+    pool->head = 0;
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->created = 0;
+}
+
+void commandAllocatorPoolShutdown(CommandAllocatorPool* pool)
+{
+    SGSASSERT(pool->count == pool->created);
+    for (uint32 i = 0; i < pool->count; i++)
+    {
+        rhiDestroyCommandAllocator(pool->entries[(pool->head + i) % pool->capacity].allocator);
+    }
+    free(pool->entries);
+    pool->entries = nullptr;
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->created = 0;
+}
+
+RhiCommandAllocator* commandAllocatorPoolAcquire(CommandAllocatorPool* pool, RhiFence* fence)
+{
+    // Retired in fence order, so only the oldest can be ready
+    if (pool->count && rhiFenceIsComplete(fence, pool->entries[pool->head].fenceValue))
+    {
+        RhiCommandAllocator* allocator = pool->entries[pool->head].allocator;
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        rhiResetCommandAllocator(allocator);
+        return allocator;
+    }
+    pool->created++;
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "pooled command allocator", pool->created);
+    return rhiCreateCommandAllocator(pool->device, pool->type, "pooled command allocator");
+}
+
+void commandAllocatorPoolRetire(CommandAllocatorPool* pool, RhiCommandAllocator* allocator, uint64 fenceValue)
+{
+    if (pool->count == pool->capacity)
+    {
+        uint32 capacity = pool->capacity ? pool->capacity * 2 : 8;
+        PooledAllocator* entries = (PooledAllocator*)malloc(capacity * sizeof(PooledAllocator));
+        SGSASSERT(entries);
+        for (uint32 i = 0; i < pool->count; i++)
+        {
+            entries[i] = pool->entries[(pool->head + i) % pool->capacity];
+        }
+        free(pool->entries);
+        pool->entries = entries;
+        pool->head = 0;
+        pool->capacity = capacity;
+    }
+    pool->entries[(pool->head + pool->count) % pool->capacity] = { allocator, fenceValue };
+    pool->count++;
+}
+
+// Takes jobs until none are left
+static void recordJobs(ParallelRecorder* recorder, uint32 worker)
+{
+    for (;;)
+    {
+        uint32 index = recorder->nextJob.fetch_add(1, std::memory_order_relaxed);
+        if (index >= recorder->jobCount)
+        {
+            return;
+        }
+        if (!recorder->allocators[worker])
+        {
+            recorder->allocators[worker] = commandAllocatorPoolAcquire(&recorder->pools[worker], recorder->fence);
+        }
+        RhiCommandList* list = recorder->lists[index];
+        rhiBeginCommandList(list, recorder->allocators[worker]);
+        recorder->job(list, index, recorder->userData);
+        rhiEndCommandList(list);
+        recorder->jobsPerWorker[worker]++;
+    }
+}
+
+static void workerMain(ParallelRecorder* recorder, uint32 worker)
+{
+    cpuPlacementAttachThread(ENGINE_THREAD_WORKER, worker - 1);
+    uint64 generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(recorder->mutex);
+            recorder->started.wait(lock, [recorder, generation]() { return recorder->stopping || recorder->generation != generation; });
+            if (recorder->stopping)
+            {
+                break;
+            }
+            generation = recorder->generation;
+        }
+
+        recordJobs(recorder, worker);
+
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        if (--recorder->busyWorkers == 0)
+        {
+            recorder->finished.notify_one();
+        }
+    }
+    cpuPlacementDetachThread();
+}
+
+bool parallelRecorderInitialize(ParallelRecorder* recorder, RhiDevice* device, RhiQueue* queue, RhiFence* fence, uint32 workerCount)
+{
+    recorder->device = device;
+    recorder->queue = queue;
+    recorder->fence = fence;
+    recorder->workerCount = workerCount < 1 ? 1 : (workerCount > PARALLEL_RECORD_MAX_WORKERS ? PARALLEL_RECORD_MAX_WORKERS : workerCount);
+    recorder->listCount = 0;
+    recorder->recordedCount = 0;
+    recorder->jobCount = 0;
+    recorder->generation = 0;
+    recorder->busyWorkers = 0;
+    recorder->stopping = false;
+    recorder->batches = 0;
+    recorder->jobs = 0;
+    memset(recorder->allocators, 0, sizeof(recorder->allocators));
+    memset(recorder->jobsPerWorker, 0, sizeof(recorder->jobsPerWorker));
+
+    // Every queue type accepts lists of its own type
+    e_rhiQueueType type = RHI_QUEUE_DIRECT;
+    for (uint32 i = 0; i < RHI_QUEUE_TYPE_COUNT; i++)
+    {
+        if (rhiGetQueue(device, (e_rhiQueueType)i) == queue)
+        {
+            type = (e_rhiQueueType)i;
+        }
+    }
+    for (uint32 i = 0; i < recorder->workerCount; i++)
+    {
+        commandAllocatorPoolInitialize(&recorder->pools[i], device, type);
+    }
+    // Worker 0 is the thread calling parallelRecord
+    for (uint32 i = 1; i < recorder->workerCount; i++)
+    {
+        recorder->threads[i] = std::thread(workerMain, recorder, i);
+    }
+    return true;
+}
+
+void parallelRecorderShutdown(ParallelRecorder* recorder)
+{
+    {
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        recorder->stopping = true;
+    }
+    recorder->started.notify_all();
+    for (uint32 i = 1; i < recorder->workerCount; i++)
+    {
+        recorder->threads[i].join();
+    }
+
+    for (uint32 i = 0; i < recorder->workerCount; i++)
+    {
+        if (recorder->allocators[i])
+        {
+            commandAllocatorPoolRetire(&recorder->pools[i], recorder->allocators[i], 0);
+            recorder->allocators[i] = nullptr;
+        }
+        commandAllocatorPoolShutdown(&recorder->pools[i]);
+    }
+    for (uint32 i = 0; i < recorder->listCount; i++)
+    {
+        rhiDestroyCommandList(recorder->lists[i]);
+    }
+    recorder->listCount = 0;
+}
+
+void parallelRecord(ParallelRecorder* recorder, uint32 jobCount, PFN_recordJob job, void* userData)
+{
+    SGSASSERT(jobCount <= PARALLEL_RECORD_MAX_JOBS);
+    SGSASSERT(recorder->recordedCount == 0);
+    e_rhiQueueType type = recorder->pools[0].type;
+    while (recorder->listCount < jobCount)
+    {
+        recorder->lists[recorder->listCount++] = rhiCreateCommandList(recorder->device, type, "parallel command list");
+    }
+
+    recorder->job = job;
+    recorder->userData = userData;
+    recorder->jobCount = jobCount;
+    recorder->nextJob.store(0, std::memory_order_relaxed);
+
+    // Few jobs aren't worth waking anybody
+    uint32 helpers = jobCount > 1 ? recorder->workerCount - 1 : 0;
+    if (helpers)
+    {
+        std::lock_guard<std::mutex> lock(recorder->mutex);
+        recorder->busyWorkers = helpers;
+        recorder->generation++;
+    }
+    if (helpers)
+    {
+        recorder->started.notify_all();
+    }
+
+    recordJobs(recorder, 0);
+
+    if (helpers)
+    {
+        std::unique_lock<std::mutex> lock(recorder->mutex);
+        recorder->finished.wait(lock, [recorder]() { return recorder->busyWorkers == 0; });
+    }
+    recorder->recordedCount = jobCount;
+    recorder->batches++;
+    recorder->jobs += jobCount;
+}
+
+void parallelRecordSubmit(ParallelRecorder* recorder, uint64 fenceValue)
+{
+    if (recorder->recordedCount)
+    {
+        rhiQueueSubmit(recorder->queue, recorder->lists, recorder->recordedCount);
+    }
+    recorder->recordedCount = 0;
+    for (uint32 i = 0; i < recorder->workerCount; i++)
+    {
+        if (recorder->allocators[i])
+        {
+            commandAllocatorPoolRetire(&recorder->pools[i], recorder->allocators[i], fenceValue);
+            recorder->allocators[i] = nullptr;
+        }
+    }
+}
+
+void parallelRecorderGetStats(const ParallelRecorder* recorder, ParallelRecordStats* stats)
+{
+    memset(stats, 0, sizeof(ParallelRecordStats));
+    stats->batches = recorder->batches;
+    stats->jobs = recorder->jobs;
+    for (uint32 i = 0; i < recorder->workerCount; i++)
+    {
+        stats->jobsPerWorker[i] = recorder->jobsPerWorker[i];
+        stats->allocatorsCreated += recorder->pools[i].created;
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "rhi.h"
+
+// Parallel command recording. A frame's work is cut into jobs, passes or ranges of draws, and
+// persistent worker threads plus the calling thread record them, one command list per job.
+// parallelRecordSubmit then hands every list to the queue in job order as one submission, so the
+// GPU sees the same stream a single thread would have recorded. Each worker takes its command
+// allocator from its own pool, recycled by fence value: workers never share an allocator and
+// never wait for the GPU to get one.
+
+#define PARALLEL_RECORD_MAX_WORKERS 16
+#define PARALLEL_RECORD_MAX_JOBS 256
+
+// Records job into list, which is open. Runs on any worker, jobs in any order.
+typedef void (*PFN_recordJob)(RhiCommandList* list, uint32 job, void* userData);
+
+struct PooledAllocator
+{
+    RhiCommandAllocator* allocator;
+    uint64 fenceValue;
+};
+
+// Single threaded. Allocators come back with the fence value that retires their lists, and are
+// handed out again once the fence reached it.
+struct CommandAllocatorPool
+{
+    RhiDevice* device;
+    e_rhiQueueType type;
+    PooledAllocator* entries;           // ring, oldest retirement first
+    uint32 head;
+    uint32 count;
+    uint32 capacity;
+    uint32 created;
+};
+
+void commandAllocatorPoolInitialize(CommandAllocatorPool* pool, RhiDevice* device, e_rhiQueueType type);
+// Every allocator must be back in the pool and its fence value complete
+void commandAllocatorPoolShutdown(CommandAllocatorPool* pool);
+// Reset and ready for recording. Creates an allocator when the oldest retired one is still in use.
+RhiCommandAllocator* commandAllocatorPoolAcquire(CommandAllocatorPool* pool, RhiFence* fence);
+void commandAllocatorPoolRetire(CommandAllocatorPool* pool, RhiCommandAllocator* allocator, uint64 fenceValue);
+
+struct ParallelRecordStats
+{
+    uint64 batches;
+    uint64 jobs;
+    uint64 jobsPerWorker[PARALLEL_RECORD_MAX_WORKERS];
+    uint32 allocatorsCreated;
+};
+
+struct ParallelRecorder
+{
+    RhiDevice* device;
+    RhiQueue* queue;
+    RhiFence* fence;
+    uint32 workerCount;                 // including the calling thread
+    std::thread threads[PARALLEL_RECORD_MAX_WORKERS];
+
+    CommandAllocatorPool pools[PARALLEL_RECORD_MAX_WORKERS];
+    RhiCommandAllocator* allocators[PARALLEL_RECORD_MAX_WORKERS];   // acquired this batch
+    RhiCommandList* lists[PARALLEL_RECORD_MAX_JOBS];                // reused, one per job
+    uint32 listCount;
+    uint32 recordedCount;               // lists waiting for parallelRecordSubmit
+
+    // The batch being recorded
+    PFN_recordJob job;
+    void* userData;
+    uint32 jobCount;
+    std::atomic<uint32> nextJob;
+    uint64 jobsPerWorker[PARALLEL_RECORD_MAX_WORKERS];
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    uint64 generation;
+    uint32 busyWorkers;
+    bool stopping;
+    uint64 batches;
+    uint64 jobs;
+};
+
+// fence retires the recorded lists; workerCount is clamped to 1..PARALLEL_RECORD_MAX_WORKERS
+bool parallelRecorderInitialize(ParallelRecorder* recorder, RhiDevice* device, RhiQueue* queue, RhiFence* fence, uint32 workerCount);
+// The GPU must be done with everything submitted through the recorder
+void parallelRecorderShutdown(ParallelRecorder* recorder);
+
+// Records jobs 0..jobCount-1 and returns once every list is closed
+void parallelRecord(ParallelRecorder* recorder, uint32 jobCount, PFN_recordJob job, void* userData);
+// Submits the lists of the last parallelRecord in job order, in one call. The caller signals
+// fenceValue on the queue right after; the allocators the lists used are recycled once it completes.
+void parallelRecordSubmit(ParallelRecorder* recorder, uint64 fenceValue);
+
+void parallelRecorderGetStats(const ParallelRecorder* recorder, ParallelRecordStats* stats);
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pass_stats.h"
+
+static void resetFrame(PassStatsFrame* frame)
+{
+    frame->frame = 0;
+    frame->passCount = 0;
+    memset(&frame->total, 0, sizeof(RhiPassCounters));
+    frame->total.name = "total";
+}
+
+void passStatsInitialize(PassStats* stats)
+{
+    resetFrame(&stats->current);
+    stats->frames = 0;
+}
+
+static bool sameName(const char* a, const char* b)
+{
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+void passStatsAddList(PassStats* stats, const RhiCommandList* list)
+{
+    PassStatsFrame& frame = stats->current;
+    uint32 passCount = 0;
+    const RhiPassCounters* passes = rhiGetPassCounters(list, &passCount);
+    for (uint32 i = 0; i < passCount; i++)
+    {
+        const RhiPassCounters& pass = passes[i];
+        // Frames have a handful of passes, a linear search beats hashing their names
+        uint32 index = 0;
+        while (index < frame.passCount && !sameName(frame.passes[index].name, pass.name))
+        {
+            index++;
+        }
+        if (index == frame.passCount)
+        {
+            if (frame.passCount < PASS_STATS_MAX_PASSES)
+            {
+                memset(&frame.passes[index], 0, sizeof(RhiPassCounters));
+                frame.passes[index].name = pass.name;
+                frame.passCount++;
+            }
+            else
+            {
+                index = PASS_STATS_MAX_PASSES - 1;
+            }
+        }
+
+        for (uint32 counter = 0; counter < RHI_COUNTER_COUNT; counter++)
+        {
+            frame.passes[index].values[counter] += pass.values[counter];
+            frame.total.values[counter] += pass.values[counter];
+        }
+    }
+}
+
+void passStatsEndFrame(PassStats* stats, uint64 frame)
+{
+    stats->current.frame = frame;
+    stats->history[stats->frames % PASS_STATS_HISTORY] = stats->current;
+    stats->frames++;
+    resetFrame(&stats->current);
+}
+
+const PassStatsFrame* passStatsGetFrame(const PassStats* stats, uint32 ago)
+{
+    if (ago >= stats->frames || ago >= PASS_STATS_HISTORY)
+    {
+        return nullptr;
+    }
+    return &stats->history[(stats->frames - 1 - ago) % PASS_STATS_HISTORY];
+}
+
+const char* passStatsPassName(const RhiPassCounters& pass)
+{
+    return pass.name ? pass.name : "unnamed";
+}
+
+static uint64 keptFrames(const PassStats* stats)
+{
+    return stats->frames < PASS_STATS_HISTORY ? stats->frames : PASS_STATS_HISTORY;
+}
+
+static void writeCsvRow(FILE* file, uint64 frame, const RhiPassCounters& pass)
+{
+    fprintf(file, "%llu,%s", (unsigned long long)frame, passStatsPassName(pass));
+    for (uint32 counter = 0; counter < RHI_COUNTER_COUNT; counter++)
+    {
+        fprintf(file, ",%llu", (unsigned long long)pass.values[counter]);
+    }
+    fprintf(file, "\n");
+}
+
+bool passStatsWriteCsv(const PassStats* stats, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "frame,pass");
+    for (uint32 counter = 0; counter < RHI_COUNTER_COUNT; counter++)
+    {
+        fprintf(file, ",%s", rhiCounterName((e_rhiCounter)counter));
+    }
+    fprintf(file, "\n");
+
+    for (uint32 ago = (uint32)keptFrames(stats); ago-- > 0;)
+    {
+        const PassStatsFrame* frame = passStatsGetFrame(stats, ago);
+        for (uint32 i = 0; i < frame->passCount; i++)
+        {
+            writeCsvRow(file, frame->frame, frame->passes[i]);
+        }
+        writeCsvRow(file, frame->frame, frame->total);
+    }
+
+    fclose(file);
+    return true;
+}
+
+// Pass names are engine literals, nothing in them needs escaping
+static void writeJsonCounters(FILE* file, const RhiPassCounters& pass)
+{
+    fprintf(file, "{\"name\": \"%s\"", passStatsPassName(pass));
+    for (uint32 counter = 0; counter < RHI_COUNTER_COUNT; counter++)
+    {
+        fprintf(file, ", \"%s\": %llu", rhiCounterName((e_rhiCounter)counter), (unsigned long long)pass.values[counter]);
+    }
+    fprintf(file, "}");
+}
+
+bool passStatsWriteJson(const PassStats* stats, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "[\n");
+    for (uint32 ago = (uint32)keptFrames(stats); ago-- > 0;)
+    {
+        const PassStatsFrame* frame = passStatsGetFrame(stats, ago);
+        fprintf(file, "  {\"frame\": %llu, \"passes\": [", (unsigned long long)frame->frame);
+        for (uint32 i = 0; i < frame->passCount; i++)
+        {
+            fprintf(file, i ? ",\n    " : "\n    ");
+            writeJsonCounters(file, frame->passes[i]);
+        }
+        fprintf(file, "],\n    \"total\": ");
+        writeJsonCounters(file, frame->total);
+        fprintf(file, ago ? "},\n" : "}\n");
+    }
+    fprintf(file, "]\n");
+
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "rhi.h"
+
+// Per frame command statistics. The pass counters of every list a frame submits are merged by
+// pass name into the frame being built; passStatsEndFrame closes it and keeps it in a ring of
+// the last PASS_STATS_HISTORY frames, which can be written out as CSV or JSON. Lists count only
+// while rhiPassCountersEnabled is set, see rhiCmdBeginPass, so frames are empty with counting
+// off. Used by the thread that submits the frames.
+
+#define PASS_STATS_MAX_PASSES 32
+#define PASS_STATS_HISTORY 128
+
+struct PassStatsFrame
+{
+    uint64 frame;
+    uint32 passCount;
+    RhiPassCounters passes[PASS_STATS_MAX_PASSES];     // in the order they first appeared
+    RhiPassCounters total;
+};
+
+// PassStats is large (about 300 KB), keep it in static storage or on the heap
+struct PassStats
+{
+    PassStatsFrame current;
+    PassStatsFrame history[PASS_STATS_HISTORY];
+    uint64 frames;                      // closed since initialization
+};
+
+void passStatsInitialize(PassStats* stats);
+// list must be closed. Passes past PASS_STATS_MAX_PASSES distinct names count toward the last.
+void passStatsAddList(PassStats* stats, const RhiCommandList* list);
+void passStatsEndFrame(PassStats* stats, uint64 frame);
+
+// ago 0 is the last closed frame. nullptr if that frame is not kept.
+const PassStatsFrame* passStatsGetFrame(const PassStats* stats, uint32 ago);
+// Name of a pass as the dumps write it
+const char* passStatsPassName(const RhiPassCounters& pass);
+
+// Every kept frame, one row per pass and one "total" row per frame
+bool passStatsWriteCsv(const PassStats* stats, const char* path);
+// Every kept frame as an array of {frame, passes: [{name, counters...}], total}
+bool passStatsWriteJson(const PassStats* stats, const char* path);
@@ -0,0 +1,104 @@
+#include <string.h>
+#include <chrono>
+
+#include "render_snapshot.h"
+
+static float64 secondsNow()
+{
+    using namespace std::chrono;
+    return duration<float64>(steady_clock::now().time_since_epoch()).count();
+}
+
+void snapshotExchangeInitialize(SnapshotExchange* exchange, uint32 capacity)
+{
+    for (uint32 i = 0; i < 2; i++)
+    {
+        RenderSnapshot& snapshot = exchange->snapshots[i];
+        memset(&snapshot, 0, sizeof(snapshot));
+        snapshot.transforms = new RenderTransform[capacity];
+        snapshot.draws = new RenderDraw[capacity];
+        snapshot.capacity = capacity;
+    }
+
+    exchange->published = 0;
+    exchange->released = 0;
+    exchange->stopped = false;
+    exchange->simulationWaitSeconds = 0.0;
+    exchange->renderWaitSeconds = 0.0;
+}
+
+void snapshotExchangeShutdown(SnapshotExchange* exchange)
+{
+    for (uint32 i = 0; i < 2; i++)
+    {
+        delete[] exchange->snapshots[i].transforms;
+        delete[] exchange->snapshots[i].draws;
+        exchange->snapshots[i].transforms = nullptr;
+        exchange->snapshots[i].draws = nullptr;
+    }
+}
+
+void snapshotExchangeStop(SnapshotExchange* exchange)
+{
+    {
+        std::lock_guard<std::mutex> lock(exchange->mutex);
+        exchange->stopped = true;
+    }
+    exchange->condition.notify_all();
+}
+
+RenderSnapshot* snapshotBeginWrite(SnapshotExchange* exchange)
+{
+    std::unique_lock<std::mutex> lock(exchange->mutex);
+
+    // Snapshot N reuses the buffer of N - 2, which must have been released
+    float64 start = secondsNow();
+    exchange->condition.wait(lock, [exchange]() {
+        return exchange->stopped || exchange->released + 1 >= exchange->published;
+    });
+    exchange->simulationWaitSeconds += secondsNow() - start;
+
+    if (exchange->stopped)
+    {
+        return nullptr;
+    }
+
+    RenderSnapshot* snapshot = &exchange->snapshots[exchange->published % 2];
+    snapshot->frame = exchange->published;
+    return snapshot;
+}
+
+void snapshotPublish(SnapshotExchange* exchange)
+{
+    {
+        std::lock_guard<std::mutex> lock(exchange->mutex);
+        exchange->published++;
+    }
+    exchange->condition.notify_all();
+}
+
+const RenderSnapshot* snapshotAcquire(SnapshotExchange* exchange)
+{
+    std::unique_lock<std::mutex> lock(exchange->mutex);
+
+    float64 start = secondsNow();
+    exchange->condition.wait(lock, [exchange]() {
+        return exchange->stopped || exchange->published > exchange->released;
+    });
+    exchange->renderWaitSeconds += secondsNow() - start;
+
+    if (exchange->stopped)
+    {
+        return nullptr;
+    }
+    return &exchange->snapshots[exchange->released % 2];
+}
+
+void snapshotRelease(SnapshotExchange* exchange)
+{
+    {
+        std::lock_guard<std::mutex> lock(exchange->mutex);
+        exchange->released++;
+    }
+    exchange->condition.notify_all();
+}
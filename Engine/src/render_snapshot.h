@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+#include "defines.h"
+
+// What the render thread needs to draw one frame, produced by the simulation. Once published a
+// snapshot is immutable until the render thread releases it, so the two threads never share
+// mutable state. Two snapshots alternate: simulation fills frame N+1 while frame N renders.
+
+struct RenderCamera
+{
+    float32 position[3];
+    float32 viewProjection[16];     // column major
+};
+
+struct RenderTransform
+{
+    float32 world[16];              // column major
+};
+
+struct RenderDraw
+{
+    uint32 transform;               // index into RenderSnapshot::transforms
+    uint32 mesh;
+    uint32 material;
+};
+
+struct RenderSnapshot
+{
+    uint64 frame;
+    float64 time;                   // simulation time in seconds
+    float32 clearColor[4];
+    RenderCamera camera;
+
+    RenderTransform* transforms;
+    RenderDraw* draws;
+    uint32 transformCount;
+    uint32 drawCount;
+    uint32 capacity;                // for both arrays
+};
+
+// Hands snapshots from one simulation thread to one render thread. Every published snapshot is
+// rendered, in order; the simulation may run at most one frame ahead of the render thread.
+struct SnapshotExchange
+{
+    RenderSnapshot snapshots[2];
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint64 published;               // snapshots published so far
+    uint64 released;                // snapshots the render thread is done with
+    bool stopped;
+
+    // Time each side spent blocked on the other, in seconds
+    float64 simulationWaitSeconds;
+    float64 renderWaitSeconds;
+};
+
+void snapshotExchangeInitialize(SnapshotExchange* exchange, uint32 capacity);
+void snapshotExchangeShutdown(SnapshotExchange* exchange);
+// Wakes both sides; pending and later calls return nullptr
+void snapshotExchangeStop(SnapshotExchange* exchange);
+
+// Simulation thread. Blocks while the render thread still reads the buffer it would reuse.
+RenderSnapshot* snapshotBeginWrite(SnapshotExchange* exchange);
+void snapshotPublish(SnapshotExchange* exchange);
+
+// Render thread. Blocks until the next snapshot is published.
+const RenderSnapshot* snapshotAcquire(SnapshotExchange* exchange);
+void snapshotRelease(SnapshotExchange* exchange);
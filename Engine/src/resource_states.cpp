@@ -0,0 +1,513 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "resource_states.h"
+#include "assertions.h"
+
+// Marks a registry slot whose resource was unregistered, so probing goes on past it
+#define REGISTRY_TOMBSTONE ((RhiResource*)(uintptr_t)1)
+
+static uint32 hashPointer(const void* pointer)
+{
+    uint64 value = (uint64)(uintptr_t)pointer;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    return (uint32)value;
+}
+
+template<typename T>
+static void reserve(T** items, uint32* capacity, uint32 needed, uint32 minimum)
+{
+    if (needed <= *capacity)
+    {
+        return;
+    }
+    uint32 newCapacity = *capacity ? *capacity : minimum;
+    while (newCapacity < needed)
+    {
+        newCapacity *= 2;
+    }
+    *items = (T*)realloc(*items, newCapacity * sizeof(T));
+    *capacity = newCapacity;
+}
+
+// Registry
+
+static uint32* entryStates(TrackedResource* entry)
+{
+    return entry->states ? entry->states : &entry->state;
+}
+
+static TrackedResource* findEntry(ResourceStateRegistry* registry, RhiResource* resource)
+{
+    if (!registry->capacity)
+    {
+        return nullptr;
+    }
+    uint32 mask = registry->capacity - 1;
+    for (uint32 slot = hashPointer(resource) & mask;; slot = (slot + 1) & mask)
+    {
+        TrackedResource* entry = &registry->entries[slot];
+        if (entry->resource == resource)
+        {
+            return entry;
+        }
+        if (!entry->resource)
+        {
+            return nullptr;
+        }
+    }
+}
+
+static void insertEntry(ResourceStateRegistry* registry, const TrackedResource& tracked)
+{
+    uint32 mask = registry->capacity - 1;
+    uint32 slot = hashPointer(tracked.resource) & mask;
+    while (registry->entries[slot].resource && registry->entries[slot].resource != REGISTRY_TOMBSTONE)
+    {
+        slot = (slot + 1) & mask;
+    }
+    if (registry->entries[slot].resource == REGISTRY_TOMBSTONE)
+    {
+        registry->tombstones--;
+    }
+    registry->entries[slot] = tracked;
+    registry->count++;
+}
+
+// Keeps live entries and tombstones under half the slots, dropping the tombstones on the way
+static void rehashRegistry(ResourceStateRegistry* registry)
+{
+    TrackedResource* old = registry->entries;
+    uint32 oldCapacity = registry->capacity;
+    uint32 capacity = oldCapacity ? oldCapacity : 64;
+    while ((registry->count + 1) * 2 > capacity)
+    {
+        capacity *= 2;
+    }
+
+    registry->entries = (TrackedResource*)calloc(capacity, sizeof(TrackedResource));
+    registry->capacity = capacity;
+    registry->count = 0;
+    registry->tombstones = 0;
+    for (uint32 i = 0; i < oldCapacity; i++)
+    {
+        if (old[i].resource && old[i].resource != REGISTRY_TOMBSTONE)
+        {
+            insertEntry(registry, old[i]);
+        }
+    }
+    free(old);
+}
+
+void resourceStateRegistryInitialize(ResourceStateRegistry* registry)
+{
+    registry->entries = nullptr;
+    registry->capacity = 0;
+    registry->count = 0;
+    registry->tombstones = 0;
+}
+
+void resourceStateRegistryShutdown(ResourceStateRegistry* registry)
+{
+    for (uint32 i = 0; i < registry->capacity; i++)
+    {
+        free(registry->entries[i].states);
+    }
+    free(registry->entries);
+    registry->entries = nullptr;
+    registry->capacity = 0;
+    registry->count = 0;
+    registry->tombstones = 0;
+}
+
+void resourceStateRegister(ResourceStateRegistry* registry, RhiResource* resource, uint32 state)
+{
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    SGSASSERT(!findEntry(registry, resource));
+    if ((registry->count + registry->tombstones + 1) * 2 > registry->capacity)
+    {
+        rehashRegistry(registry);
+    }
+
+    TrackedResource tracked;
+    tracked.resource = resource;
+    tracked.subresourceCount = rhiSubresourceCount(rhiGetResourceDesc(resource));
+    tracked.state = state;
+    tracked.states = nullptr;
+    if (tracked.subresourceCount > 1)
+    {
+        tracked.states = (uint32*)malloc(tracked.subresourceCount * sizeof(uint32));
+        for (uint32 i = 0; i < tracked.subresourceCount; i++)
+        {
+            tracked.states[i] = state;
+        }
+    }
+    insertEntry(registry, tracked);
+}
+
+void resourceStateUnregister(ResourceStateRegistry* registry, RhiResource* resource)
+{
+    if (!resource)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    TrackedResource* entry = findEntry(registry, resource);
+    SGSASSERT(entry);
+    if (entry)
+    {
+        free(entry->states);
+        entry->resource = REGISTRY_TOMBSTONE;
+        entry->states = nullptr;
+        registry->count--;
+        registry->tombstones++;
+    }
+}
+
+uint32 resourceStateGet(ResourceStateRegistry* registry, RhiResource* resource, uint32 subresource)
+{
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    TrackedResource* entry = findEntry(registry, resource);
+    if (!entry)
+    {
+        return RESOURCE_STATE_UNKNOWN;
+    }
+    return entryStates(entry)[subresource == RHI_ALL_SUBRESOURCES ? 0 : subresource];
+}
+
+// Tracker
+
+void resourceStateTrackerInitialize(ResourceStateTracker* tracker, ResourceStateRegistry* registry)
+{
+    memset(tracker, 0, sizeof(ResourceStateTracker));
+    tracker->registry = registry;
+}
+
+void resourceStateTrackerShutdown(ResourceStateTracker* tracker)
+{
+    free(tracker->locals);
+    free(tracker->lookup);
+    free(tracker->states);
+    free(tracker->batch);
+    free(tracker->splits);
+    memset(tracker, 0, sizeof(ResourceStateTracker));
+}
+
+void resourceStateTrackerBegin(ResourceStateTracker* tracker, RhiCommandList* list)
+{
+    SGSASSERT(!tracker->batchCount && !tracker->splitCount);
+    // Only the slots that were used need clearing
+    uint32 mask = tracker->lookupCapacity - 1;
+    for (uint32 i = 0; i < tracker->localCount; i++)
+    {
+        uint32 slot = hashPointer(tracker->locals[i].resource) & mask;
+        while (tracker->lookup[slot])
+        {
+            tracker->lookup[slot] = 0;
+            slot = (slot + 1) & mask;
+        }
+    }
+    tracker->list = list;
+    tracker->localCount = 0;
+    tracker->stateCount = 0;
+}
+
+static void rebuildLookup(ResourceStateTracker* tracker, uint32 capacity)
+{
+    free(tracker->lookup);
+    tracker->lookup = (uint32*)calloc(capacity, sizeof(uint32));
+    tracker->lookupCapacity = capacity;
+    for (uint32 i = 0; i < tracker->localCount; i++)
+    {
+        uint32 slot = hashPointer(tracker->locals[i].resource) & (capacity - 1);
+        while (tracker->lookup[slot])
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        tracker->lookup[slot] = i + 1;
+    }
+}
+
+static LocalResource* findLocal(ResourceStateTracker* tracker, RhiResource* resource)
+{
+    if (tracker->lookupCapacity)
+    {
+        uint32 mask = tracker->lookupCapacity - 1;
+        for (uint32 slot = hashPointer(resource) & mask; tracker->lookup[slot]; slot = (slot + 1) & mask)
+        {
+            LocalResource* local = &tracker->locals[tracker->lookup[slot] - 1];
+            if (local->resource == resource)
+            {
+                return local;
+            }
+        }
+    }
+
+    // First use in this list: every subresource's state is unknown
+    if ((tracker->localCount + 1) * 2 > tracker->lookupCapacity)
+    {
+        rebuildLookup(tracker, tracker->lookupCapacity ? tracker->lookupCapacity * 2 : 64);
+    }
+    reserve(&tracker->locals, &tracker->localCapacity, tracker->localCount + 1, 32);
+    LocalResource* local = &tracker->locals[tracker->localCount++];
+    local->resource = resource;
+    local->subresourceCount = rhiSubresourceCount(rhiGetResourceDesc(resource));
+    local->states = tracker->stateCount;
+    reserve(&tracker->states, &tracker->stateCapacity, tracker->stateCount + 2 * local->subresourceCount, 64);
+    for (uint32 i = 0; i < 2 * local->subresourceCount; i++)
+    {
+        tracker->states[tracker->stateCount++] = RESOURCE_STATE_UNKNOWN;
+    }
+
+    uint32 mask = tracker->lookupCapacity - 1;
+    uint32 slot = hashPointer(resource) & mask;
+    while (tracker->lookup[slot])
+    {
+        slot = (slot + 1) & mask;
+    }
+    tracker->lookup[slot] = tracker->localCount;
+    return local;
+}
+
+static void addBarrier(ResourceStateTracker* tracker, const RhiBarrier& barrier)
+{
+    reserve(&tracker->batch, &tracker->batchCapacity, tracker->batchCount + 1, 32);
+    tracker->batch[tracker->batchCount++] = barrier;
+}
+
+static bool touches(const RhiBarrier& barrier, RhiResource* resource)
+{
+    return barrier.resource == resource || barrier.resourceAfter == resource ||
+        (barrier.type == RHI_BARRIER_UAV && !barrier.resource);
+}
+
+// No command ran since the batch started, so a transition out of the state an earlier one in the
+// batch went to can replace it
+static void queueTransition(ResourceStateTracker* tracker, RhiResource* resource, uint32 subresource, uint32 before, uint32 after, uint32 flags)
+{
+    if (flags)
+    {
+        addBarrier(tracker, rhiTransition(resource, before, after, subresource, flags));
+        if (flags & RHI_BARRIER_FLAG_BEGIN_ONLY)
+        {
+            reserve(&tracker->splits, &tracker->splitCapacity, tracker->splitCount + 1, 8);
+            SplitTransition split = { resource, subresource, before, after };
+            tracker->splits[tracker->splitCount++] = split;
+        }
+        return;
+    }
+
+    for (uint32 i = tracker->batchCount; i-- > 0;)
+    {
+        RhiBarrier& barrier = tracker->batch[i];
+        if (!touches(barrier, resource))
+        {
+            continue;
+        }
+        if (barrier.type != RHI_BARRIER_TRANSITION || barrier.flags || barrier.subresource != subresource)
+        {
+            break;
+        }
+        SGSASSERT(barrier.after == before);
+        tracker->stats.merged++;
+        if (barrier.before == after)
+        {
+            memmove(&barrier, &barrier + 1, (tracker->batchCount - i - 1) * sizeof(RhiBarrier));
+            tracker->batchCount--;
+        }
+        else
+        {
+            barrier.after = after;
+        }
+        return;
+    }
+    addBarrier(tracker, rhiTransition(resource, before, after, subresource));
+}
+
+static void transitionSubresource(ResourceStateTracker* tracker, LocalResource* local, uint32 subresource, uint32 after, uint32 flags)
+{
+    uint32* first = tracker->states + local->states;
+    uint32* current = first + local->subresourceCount;
+    if (current[subresource] == RESOURCE_STATE_UNKNOWN)
+    {
+        first[subresource] = after;
+    }
+    else if (current[subresource] != after)
+    {
+        queueTransition(tracker, local->resource, subresource, current[subresource], after, flags);
+    }
+    current[subresource] = after;
+}
+
+static void transition(ResourceStateTracker* tracker, RhiResource* resource, uint32 after, uint32 subresource, uint32 flags)
+{
+    tracker->stats.transitions++;
+    LocalResource* local = findLocal(tracker, resource);
+    uint32* first = tracker->states + local->states;
+    uint32* current = first + local->subresourceCount;
+    if (subresource != RHI_ALL_SUBRESOURCES)
+    {
+        SGSASSERT(subresource < local->subresourceCount);
+        transitionSubresource(tracker, local, subresource, after, flags);
+        return;
+    }
+
+    // A resource whose subresources all agree takes one barrier for all of them
+    bool uniform = true;
+    for (uint32 i = 1; i < local->subresourceCount && uniform; i++)
+    {
+        uniform = current[i] == current[0];
+    }
+    if (!uniform || local->subresourceCount == 1)
+    {
+        for (uint32 i = 0; i < local->subresourceCount; i++)
+        {
+            transitionSubresource(tracker, local, i, after, flags);
+        }
+        return;
+    }
+
+    if (current[0] != RESOURCE_STATE_UNKNOWN && current[0] != after)
+    {
+        queueTransition(tracker, resource, RHI_ALL_SUBRESOURCES, current[0], after, flags);
+    }
+    for (uint32 i = 0; i < local->subresourceCount; i++)
+    {
+        if (current[i] == RESOURCE_STATE_UNKNOWN)
+        {
+            first[i] = after;
+        }
+        current[i] = after;
+    }
+}
+
+void resourceStateTransition(ResourceStateTracker* tracker, RhiResource* resource, uint32 after, uint32 subresource)
+{
+    transition(tracker, resource, after, subresource, RHI_BARRIER_FLAG_NONE);
+}
+
+void resourceStateBeginTransition(ResourceStateTracker* tracker, RhiResource* resource, uint32 after, uint32 subresource)
+{
+    transition(tracker, resource, after, subresource, RHI_BARRIER_FLAG_BEGIN_ONLY);
+}
+
+void resourceStateEndTransition(ResourceStateTracker* tracker, RhiResource* resource, uint32 subresource)
+{
+    for (uint32 i = 0; i < tracker->splitCount;)
+    {
+        SplitTransition& split = tracker->splits[i];
+        if (split.resource == resource && (subresource == RHI_ALL_SUBRESOURCES || split.subresource == subresource))
+        {
+            addBarrier(tracker, rhiTransition(resource, split.before, split.after, split.subresource, RHI_BARRIER_FLAG_END_ONLY));
+            split = tracker->splits[--tracker->splitCount];
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void resourceStateUav(ResourceStateTracker* tracker, RhiResource* resource)
+{
+    addBarrier(tracker, rhiUavBarrier(resource));
+}
+
+void resourceStateAliasing(ResourceStateTracker* tracker, RhiResource* before, RhiResource* after)
+{
+    addBarrier(tracker, rhiAliasingBarrier(before, after));
+}
+
+void resourceStateBarrier(ResourceStateTracker* tracker, const RhiBarrier& barrier)
+{
+    addBarrier(tracker, barrier);
+}
+
+void resourceStateFlush(ResourceStateTracker* tracker)
+{
+    if (tracker->batchCount)
+    {
+        rhiCmdBarriers(tracker->list, tracker->batch, tracker->batchCount);
+        tracker->stats.barriers += tracker->batchCount;
+        tracker->stats.flushes++;
+        tracker->batchCount = 0;
+    }
+}
+
+bool resourceStateResolve(ResourceStateTracker* tracker, RhiCommandList* fixup)
+{
+    SGSASSERT_MSG(!tracker->batchCount, "barriers were batched after the last flush");
+    SGSASSERT_MSG(!tracker->splitCount, "split transitions were not ended");
+    tracker->batchCount = 0;
+
+    // The batch is empty, its memory collects the fixup barriers
+    ResourceStateRegistry* registry = tracker->registry;
+    {
+        std::lock_guard<std::mutex> lock(registry->mutex);
+        for (uint32 l = 0; l < tracker->localCount; l++)
+        {
+            const LocalResource& local = tracker->locals[l];
+            TrackedResource* entry = findEntry(registry, local.resource);
+            SGSASSERT_MSG(entry, "command list uses a resource that is not registered");
+            if (!entry)
+            {
+                continue;
+            }
+
+            uint32* global = entryStates(entry);
+            const uint32* first = tracker->states + local.states;
+            const uint32* current = first + local.subresourceCount;
+            bool whole = true;
+            for (uint32 i = 0; i < local.subresourceCount && whole; i++)
+            {
+                whole = first[i] != RESOURCE_STATE_UNKNOWN && first[i] == first[0] && global[i] == global[0];
+            }
+
+            if (whole && local.subresourceCount > 1)
+            {
+                if (global[0] != first[0])
+                {
+                    addBarrier(tracker, rhiTransition(local.resource, global[0], first[0]));
+                }
+            }
+            else
+            {
+                for (uint32 i = 0; i < local.subresourceCount; i++)
+                {
+                    if (first[i] != RESOURCE_STATE_UNKNOWN && global[i] != first[i])
+                    {
+                        addBarrier(tracker, rhiTransition(local.resource, global[i], first[i],
+                            local.subresourceCount == 1 ? RHI_ALL_SUBRESOURCES : i));
+                    }
+                }
+            }
+
+            for (uint32 i = 0; i < local.subresourceCount; i++)
+            {
+                if (current[i] != RESOURCE_STATE_UNKNOWN)
+                {
+                    global[i] = current[i];
+                }
+            }
+        }
+    }
+
+    uint32 count = tracker->batchCount;
+    tracker->batchCount = 0;
+    if (!count)
+    {
+        return false;
+    }
+    rhiCmdBarriers(fixup, tracker->batch, count);
+    tracker->stats.resolvedBarriers += count;
+    tracker->stats.fixups++;
+    return true;
+}
+
+void resourceStateTrackerGetStats(const ResourceStateTracker* tracker, ResourceStateTrackerStats* stats)
+{
+    *stats = tracker->stats;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <mutex>
+
+#include "rhi.h"
+
+// Resource state tracking. A ResourceStateRegistry holds the state of every subresource of the
+// resources registered with it, as of the last submitted command list. A ResourceStateTracker
+// records one command list: it only knows the states that list put resources in, so the first
+// time the list uses a subresource the transition into the state it asks for is left pending.
+// resourceStateResolve, called right before the list is submitted and in submission order,
+// compares those first states with the registry, records the transitions that are really needed
+// into a separate list that runs first, and moves the registry on to the list's final states.
+//
+// Transitions requested while recording are collected and merged, A to B then B to C becomes A
+// to C, and reach the list as one batch at resourceStateFlush, which must come before commands
+// that use the resources. Split transitions start with resourceStateBeginTransition and finish
+// at resourceStateEndTransition, giving the GPU the commands in between to do them.
+
+#define RESOURCE_STATE_UNKNOWN 0xffffffff
+
+struct TrackedResource
+{
+    RhiResource* resource;              // nullptr for an empty slot, the tombstone for a removed one
+    uint32 subresourceCount;
+    uint32 state;                       // the only subresource's state
+    uint32* states;                     // every subresource's, nullptr when there is only one
+};
+
+// Thread safe. Resources are registered with the state they are in and unregistered before they
+// are destroyed.
+struct ResourceStateRegistry
+{
+    std::mutex mutex;
+    TrackedResource* entries;           // open addressing on the resource pointer
+    uint32 capacity;                    // power of two
+    uint32 count;
+    uint32 tombstones;
+};
+
+void resourceStateRegistryInitialize(ResourceStateRegistry* registry);
+void resourceStateRegistryShutdown(ResourceStateRegistry* registry);
+// Every subresource starts in state
+void resourceStateRegister(ResourceStateRegistry* registry, RhiResource* resource, uint32 state);
+void resourceStateUnregister(ResourceStateRegistry* registry, RhiResource* resource);
+// RESOURCE_STATE_UNKNOWN for resources that are not registered
+uint32 resourceStateGet(ResourceStateRegistry* registry, RhiResource* resource, uint32 subresource);
+
+struct ResourceStateTrackerStats
+{
+    uint64 transitions;                 // requested
+    uint64 merged;                      // folded into a transition of the same batch
+    uint64 barriers;                    // recorded into tracked lists
+    uint64 flushes;                     // rhiCmdBarriers calls they took
+    uint64 resolvedBarriers;            // recorded into fixup lists at submit
+    uint64 fixups;                      // resolves that needed a fixup list
+};
+
+struct LocalResource
+{
+    RhiResource* resource;
+    uint32 subresourceCount;
+    uint32 states;                      // offset of the first states, then the current ones, in ResourceStateTracker::states
+};
+
+struct SplitTransition
+{
+    RhiResource* resource;
+    uint32 subresource;
+    uint32 before;
+    uint32 after;
+};
+
+// Used by the list's recording thread; resolving also locks the registry
+struct ResourceStateTracker
+{
+    ResourceStateRegistry* registry;
+    RhiCommandList* list;
+
+    LocalResource* locals;              // resources the list used, in first use order
+    uint32 localCount;
+    uint32 localCapacity;
+    uint32* lookup;                     // local index + 1 by resource pointer, 0 for empty
+    uint32 lookupCapacity;              // power of two
+    uint32* states;
+    uint32 stateCount;
+    uint32 stateCapacity;
+
+    RhiBarrier* batch;                  // waiting for the next flush
+    uint32 batchCount;
+    uint32 batchCapacity;
+    SplitTransition* splits;            // begun and not ended yet
+    uint32 splitCount;
+    uint32 splitCapacity;
+
+    ResourceStateTrackerStats stats;
+};
+
+void resourceStateTrackerInitialize(ResourceStateTracker* tracker, ResourceStateRegistry* registry);
+void resourceStateTrackerShutdown(ResourceStateTracker* tracker);
+// Call right after rhiBeginCommandList. Forgets every local state, keeps the stats.
+void resourceStateTrackerBegin(ResourceStateTracker* tracker, RhiCommandList* list);
+
+void resourceStateTransition(ResourceStateTracker* tracker, RhiResource* resource, uint32 after, uint32 subresource = RHI_ALL_SUBRESOURCES);
+// A transition on a subresource's first use in the list has nothing to split, it is resolved at
+// submit like any other and the end does nothing
+void resourceStateBeginTransition(ResourceStateTracker* tracker, RhiResource* resource, uint32 after, uint32 subresource = RHI_ALL_SUBRESOURCES);
+void resourceStateEndTransition(ResourceStateTracker* tracker, RhiResource* resource, uint32 subresource = RHI_ALL_SUBRESOURCES);
+// Orders unordered access to resource, or to every resource when it is nullptr
+void resourceStateUav(ResourceStateTracker* tracker, RhiResource* resource);
+// Batched with the transitions, tracked states don't change
+void resourceStateAliasing(ResourceStateTracker* tracker, RhiResource* before, RhiResource* after);
+// Batched as is, for resources the list doesn't track because the caller knows their states
+void resourceStateBarrier(ResourceStateTracker* tracker, const RhiBarrier& barrier);
+// Records the batched barriers with one rhiCmdBarriers call
+void resourceStateFlush(ResourceStateTracker* tracker);
+
+// Call after rhiEndCommandList and right before submitting. Records the transitions from the
+// registry's states to the ones the list expects into fixup, which must be recording, and
+// returns false if there were none and fixup need not be submitted. Otherwise submit fixup
+// right before the list.
+bool resourceStateResolve(ResourceStateTracker* tracker, RhiCommandList* fixup);
+
+void resourceStateTrackerGetStats(const ResourceStateTracker* tracker, ResourceStateTrackerStats* stats);
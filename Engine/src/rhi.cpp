@@ -0,0 +1,607 @@
+#include <string.h>
+
+#include "rhi_backend.h"
+#include "assertions.h"
+#include "logger.h"
+
+// Pass counters cost one predictable branch per command, nothing when compiled out
+#define RHI_COUNT(list, counter, amount)                        \
+    {                                                           \
+        if (RHI_PASS_COUNTERS_ACTIVE())                         \
+        {                                                       \
+            (list)->counters[counter] += (amount);              \
+        }                                                       \
+    }
+
+bool rhiPassCountersEnabled = true;
+
+RhiDevice* rhiCreateDevice(const RhiDeviceConfig& config)
+{
+    RhiDevice* device = nullptr;
+    switch (config.backend)
+    {
+        case RHI_BACKEND_NULL: device = rhiCreateNullDevice(config); break;
+        case RHI_BACKEND_D3D12: device = rhiCreateD3D12Device(config); break;
+        default: break;
+    }
+
+    if (device)
+    {
+        SGSINFO_CAT(LOG_CATEGORY_RENDER, "Created %s RHI device", rhiBackendName(config.backend));
+    }
+    else
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Could not create a %s RHI device", rhiBackendName(config.backend));
+    }
+    return device;
+}
+
+void rhiDestroyDevice(RhiDevice* device)
+{
+    device->functions->destroyDevice(device);
+}
+
+e_rhiBackend rhiGetBackend(const RhiDevice* device)
+{
+    return device->backend;
+}
+
+const char* rhiBackendName(e_rhiBackend backend)
+{
+    switch (backend)
+    {
+        case RHI_BACKEND_NULL: return "null";
+        case RHI_BACKEND_D3D12: return "d3d12";
+        default: return "unknown";
+    }
+}
+
+uint32 rhiGetMsaaQualityLevels(RhiDevice* device, e_rhiFormat format, uint32 sampleCount)
+{
+    return device->functions->msaaQualityLevels(device, format, sampleCount);
+}
+
+bool rhiNullGetStats(RhiDevice* device, RhiNullStats* stats)
+{
+    return device->backend == RHI_BACKEND_NULL && rhiNullDeviceStats(device, stats);
+}
+
+uint32 rhiFormatBytesPerPixel(e_rhiFormat format)
+{
+    switch (format)
+    {
+        case RHI_FORMAT_RGBA8_UNORM: return 4;
+        case RHI_FORMAT_BGRA8_UNORM: return 4;
+        case RHI_FORMAT_RGBA16_FLOAT: return 8;
+        case RHI_FORMAT_R32_FLOAT: return 4;
+        case RHI_FORMAT_RG32_FLOAT: return 8;
+        case RHI_FORMAT_RGB32_FLOAT: return 12;
+        case RHI_FORMAT_RGBA32_FLOAT: return 16;
+        case RHI_FORMAT_R16_UINT: return 2;
+        case RHI_FORMAT_R32_UINT: return 4;
+        case RHI_FORMAT_D24_UNORM_S8_UINT: return 4;
+        case RHI_FORMAT_D32_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+const char* rhiFormatName(e_rhiFormat format)
+{
+    switch (format)
+    {
+        case RHI_FORMAT_RGBA8_UNORM: return "rgba8_unorm";
+        case RHI_FORMAT_BGRA8_UNORM: return "bgra8_unorm";
+        case RHI_FORMAT_RGBA16_FLOAT: return "rgba16_float";
+        case RHI_FORMAT_R32_FLOAT: return "r32_float";
+        case RHI_FORMAT_RG32_FLOAT: return "rg32_float";
+        case RHI_FORMAT_RGB32_FLOAT: return "rgb32_float";
+        case RHI_FORMAT_RGBA32_FLOAT: return "rgba32_float";
+        case RHI_FORMAT_R16_UINT: return "r16_uint";
+        case RHI_FORMAT_R32_UINT: return "r32_uint";
+        case RHI_FORMAT_D24_UNORM_S8_UINT: return "d24_unorm_s8_uint";
+        case RHI_FORMAT_D32_FLOAT: return "d32_float";
+        default: return "unknown";
+    }
+}
+
+RhiQueue* rhiGetQueue(RhiDevice* device, e_rhiQueueType type)
+{
+    return device->queues[type];
+}
+
+void rhiQueueSubmit(RhiQueue* queue, RhiCommandList* const* lists, uint32 count)
+{
+    if (SGS_VALIDATION_ENABLED(VALIDATION_TIER_FULL))
+    {
+        for (uint32 i = 0; i < count; i++)
+        {
+            SGSVALIDATE(!lists[i]->recording, "command list submitted while recording");
+            SGSVALIDATE(lists[i]->type == queue->type, "command list submitted to a queue of another type");
+        }
+    }
+    queue->device->functions->queueSubmit(queue, lists, count);
+}
+
+void rhiQueueSignal(RhiQueue* queue, RhiFence* fence, uint64 value)
+{
+    queue->device->functions->queueSignal(queue, fence, value);
+}
+
+void rhiQueueWait(RhiQueue* queue, RhiFence* fence, uint64 value)
+{
+    queue->device->functions->queueWait(queue, fence, value);
+}
+
+RhiFence* rhiCreateFence(RhiDevice* device, uint64 initialValue, const char* name)
+{
+    return device->functions->createFence(device, initialValue, name);
+}
+
+void rhiDestroyFence(RhiFence* fence)
+{
+    fence->device->functions->destroyFence(fence);
+}
+
+uint64 rhiFenceCompletedValue(RhiFence* fence)
+{
+    return fence->device->functions->fenceCompletedValue(fence);
+}
+
+bool rhiFenceIsComplete(RhiFence* fence, uint64 value)
+{
+    return fence->device->functions->fenceCompletedValue(fence) >= value;
+}
+
+void rhiFenceWait(RhiFence* fence, uint64 value)
+{
+    fence->device->functions->fenceWait(fence, value);
+}
+
+uint32 rhiFenceWaitMany(RhiFence* const* fences, const uint64* values, uint32 count, bool waitAll)
+{
+    SGSASSERT(count > 0 && count <= RHI_MAX_WAIT_FENCES);
+    if (SGS_VALIDATION_ENABLED(VALIDATION_TIER_FULL))
+    {
+        for (uint32 i = 1; i < count; i++)
+        {
+            SGSVALIDATE(fences[i]->device == fences[0]->device, "rhiFenceWaitMany on fences of different devices");
+        }
+    }
+    return fences[0]->device->functions->fenceWaitMany(fences, values, count, waitAll);
+}
+
+void rhiFenceOnComplete(RhiFence* fence, uint64 value, PFN_rhiFenceCallback callback, void* userData)
+{
+    fence->device->functions->fenceOnComplete(fence, value, callback, userData);
+}
+
+RhiCommandAllocator* rhiCreateCommandAllocator(RhiDevice* device, e_rhiQueueType type, const char* name)
+{
+    return device->functions->createCommandAllocator(device, type, name);
+}
+
+void rhiDestroyCommandAllocator(RhiCommandAllocator* allocator)
+{
+    allocator->device->functions->destroyCommandAllocator(allocator);
+}
+
+void rhiResetCommandAllocator(RhiCommandAllocator* allocator)
+{
+    allocator->device->functions->resetCommandAllocator(allocator);
+}
+
+RhiCommandList* rhiCreateCommandList(RhiDevice* device, e_rhiQueueType type, const char* name)
+{
+    return device->functions->createCommandList(device, type, name);
+}
+
+void rhiDestroyCommandList(RhiCommandList* list)
+{
+    list->functions->destroyCommandList(list);
+}
+
+void rhiBeginCommandList(RhiCommandList* list, RhiCommandAllocator* allocator)
+{
+    SGSASSERT(!list->recording);
+    SGSASSERT(allocator->type == list->type);
+    list->recording = true;
+    list->passCount = 1;
+    memset(&list->passes[0], 0, sizeof(RhiPassCounters));
+    list->counters = list->passes[0].values;
+    list->functions->beginCommandList(list, allocator);
+}
+
+static bool passIsEmpty(const RhiPassCounters& pass)
+{
+    for (uint32 i = 0; i < RHI_COUNTER_COUNT; i++)
+    {
+        if (pass.values[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// An unnamed pass nothing was recorded in is reused or dropped
+static void openPass(RhiCommandList* list, const char* name)
+{
+    RhiPassCounters& current = list->passes[list->passCount - 1];
+    if ((current.name || !passIsEmpty(current)) && list->passCount < RHI_MAX_PASSES_PER_LIST)
+    {
+        list->passCount++;
+    }
+    RhiPassCounters& pass = list->passes[list->passCount - 1];
+    if (&pass != &current || passIsEmpty(current))
+    {
+        memset(&pass, 0, sizeof(RhiPassCounters));
+        pass.name = name;
+    }
+    list->counters = pass.values;
+}
+
+void rhiEndCommandList(RhiCommandList* list)
+{
+    SGSASSERT(list->recording);
+    list->functions->endCommandList(list);
+    list->recording = false;
+    const RhiPassCounters& last = list->passes[list->passCount - 1];
+    if (!last.name && passIsEmpty(last))
+    {
+        list->passCount--;
+    }
+}
+
+void rhiCmdBeginPass(RhiCommandList* list, const char* name)
+{
+    SGSASSERT_DEBUG(list->recording);
+    if (RHI_PASS_COUNTERS_ACTIVE())
+    {
+        openPass(list, name);
+    }
+}
+
+void rhiCmdEndPass(RhiCommandList* list)
+{
+    SGSASSERT_DEBUG(list->recording);
+    if (RHI_PASS_COUNTERS_ACTIVE())
+    {
+        openPass(list, nullptr);
+    }
+}
+
+void rhiCmdAddCounter(RhiCommandList* list, e_rhiCounter counter, uint64 amount)
+{
+    SGSASSERT_DEBUG(list->recording);
+    SGSASSERT(counter < RHI_COUNTER_COUNT);
+    RHI_COUNT(list, counter, amount);
+}
+
+const RhiPassCounters* rhiGetPassCounters(const RhiCommandList* list, uint32* passCount)
+{
+    *passCount = list->recording ? 0 : list->passCount;
+    return list->passes;
+}
+
+const char* rhiCounterName(e_rhiCounter counter)
+{
+    switch (counter)
+    {
+        case RHI_COUNTER_DRAWS: return "draws";
+        case RHI_COUNTER_DISPATCHES: return "dispatches";
+        case RHI_COUNTER_BARRIERS: return "barriers";
+        case RHI_COUNTER_STATE_CHANGES: return "state_changes";
+        case RHI_COUNTER_DESCRIPTOR_COPIES: return "descriptor_copies";
+        case RHI_COUNTER_UPLOAD_BYTES: return "upload_bytes";
+        case RHI_COUNTER_CLEARS: return "clears";
+        case RHI_COUNTER_COPIES: return "copies";
+        default: return "unknown";
+    }
+}
+
+RhiHeap* rhiCreateHeap(RhiDevice* device, const RhiHeapDesc& desc, const char* name)
+{
+    return device->functions->createHeap(device, desc, name);
+}
+
+void rhiDestroyHeap(RhiHeap* heap)
+{
+    heap->device->functions->destroyHeap(heap);
+}
+
+const RhiHeapDesc& rhiGetHeapDesc(const RhiHeap* heap)
+{
+    return heap->desc;
+}
+
+void rhiGetAllocationInfo(RhiDevice* device, const RhiResourceDesc& desc, uint64* size, uint64* alignment)
+{
+    device->functions->allocationInfo(device, desc, size, alignment);
+}
+
+void rhiGetCopyableFootprint(RhiDevice* device, const RhiResourceDesc& desc, uint32* rowPitch, uint64* totalBytes)
+{
+    device->functions->copyableFootprint(device, desc, rowPitch, totalBytes);
+}
+
+RhiResource* rhiCreateCommittedResource(RhiDevice* device, e_rhiHeapType heapType, const RhiResourceDesc& desc, uint32 initialState, const char* name)
+{
+    return device->functions->createCommittedResource(device, heapType, desc, initialState, name);
+}
+
+RhiResource* rhiCreatePlacedResource(RhiDevice* device, RhiHeap* heap, uint64 offset, const RhiResourceDesc& desc, uint32 initialState, const char* name)
+{
+    return device->functions->createPlacedResource(device, heap, offset, desc, initialState, name);
+}
+
+void rhiDestroyResource(RhiResource* resource)
+{
+    if (resource)
+    {
+        resource->device->functions->destroyResource(resource);
+    }
+}
+
+const RhiResourceDesc& rhiGetResourceDesc(const RhiResource* resource)
+{
+    return resource->desc;
+}
+
+uint64 rhiResourceMemorySize(const RhiResource* resource)
+{
+    if (resource->heap)
+    {
+        return 0;
+    }
+    uint64 size;
+    uint64 alignment;
+    resource->device->functions->allocationInfo(resource->device, resource->desc, &size, &alignment);
+    return size;
+}
+
+void* rhiMapResource(RhiResource* resource)
+{
+    SGSASSERT(resource->desc.dimension == RHI_RESOURCE_BUFFER && resource->heapType != RHI_HEAP_DEFAULT);
+    return resource->device->functions->mapResource(resource);
+}
+
+void rhiUnmapResource(RhiResource* resource)
+{
+    resource->device->functions->unmapResource(resource);
+}
+
+RhiDescriptorHeap* rhiCreateDescriptorHeap(RhiDevice* device, const RhiDescriptorHeapDesc& desc, const char* name)
+{
+    SGSASSERT(desc.capacity > 0);
+    SGSASSERT(!desc.shaderVisible || desc.type == RHI_DESCRIPTOR_HEAP_RESOURCE);
+    return device->functions->createDescriptorHeap(device, desc, name);
+}
+
+void rhiDestroyDescriptorHeap(RhiDescriptorHeap* heap)
+{
+    heap->device->functions->destroyDescriptorHeap(heap);
+}
+
+const RhiDescriptorHeapDesc& rhiGetDescriptorHeapDesc(const RhiDescriptorHeap* heap)
+{
+    return heap->desc;
+}
+
+static e_rhiDescriptorHeapType viewHeapType(e_rhiViewType type)
+{
+    switch (type)
+    {
+        case RHI_VIEW_RENDER_TARGET: return RHI_DESCRIPTOR_HEAP_RENDER_TARGET;
+        case RHI_VIEW_DEPTH_STENCIL: return RHI_DESCRIPTOR_HEAP_DEPTH_STENCIL;
+        default: return RHI_DESCRIPTOR_HEAP_RESOURCE;
+    }
+}
+
+void rhiWriteView(RhiDescriptorHeap* heap, uint32 index, e_rhiViewType type, RhiResource* resource)
+{
+    SGSASSERT(index < heap->desc.capacity);
+    SGSASSERT(viewHeapType(type) == heap->desc.type);
+    SGSASSERT(type != RHI_VIEW_CONSTANT_BUFFER || (resource->desc.dimension == RHI_RESOURCE_BUFFER && resource->desc.width % 256 == 0));
+    heap->device->functions->writeView(heap, index, type, resource);
+}
+
+void rhiCopyDescriptors(RhiDevice* device, const RhiDescriptorCopy* copies, uint32 count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (SGS_VALIDATION_ENABLED(VALIDATION_TIER_FULL))
+    {
+        for (uint32 i = 0; i < count; i++)
+        {
+            const RhiDescriptorCopy& copy = copies[i];
+            SGSVALIDATE(copy.destination->desc.type == copies[0].destination->desc.type && copy.source->desc.type == copy.destination->desc.type,
+                "rhiCopyDescriptors between heaps of different types");
+            SGSVALIDATE(!copy.source->desc.shaderVisible, "rhiCopyDescriptors from a shader visible heap");
+            SGSVALIDATE(copy.destinationIndex + copy.count <= copy.destination->desc.capacity &&
+                copy.sourceIndex + copy.count <= copy.source->desc.capacity, "rhiCopyDescriptors past the end of a heap");
+        }
+    }
+    device->functions->copyDescriptors(device, copies, count);
+}
+
+RhiPipeline* rhiCreatePipeline(RhiDevice* device, const RhiPipelineDesc& desc, const char* name)
+{
+    return device->functions->createPipeline(device, desc, name);
+}
+
+void rhiDestroyPipeline(RhiPipeline* pipeline)
+{
+    pipeline->device->functions->destroyPipeline(pipeline);
+}
+
+RhiSwapChain* rhiCreateSwapChain(RhiDevice* device, RhiQueue* queue, const RhiSwapChainDesc& desc)
+{
+    SGSASSERT(desc.bufferCount >= 2 && desc.bufferCount <= RHI_MAX_SWAPCHAIN_BUFFERS);
+    return device->functions->createSwapChain(device, queue, desc);
+}
+
+void rhiDestroySwapChain(RhiSwapChain* swapChain)
+{
+    swapChain->device->functions->destroySwapChain(swapChain);
+}
+
+bool rhiResizeSwapChain(RhiSwapChain* swapChain, uint32 width, uint32 height)
+{
+    return swapChain->device->functions->resizeSwapChain(swapChain, width, height);
+}
+
+uint32 rhiSwapChainBufferCount(const RhiSwapChain* swapChain)
+{
+    return swapChain->bufferCount;
+}
+
+uint32 rhiSwapChainCurrentIndex(const RhiSwapChain* swapChain)
+{
+    return swapChain->currentIndex;
+}
+
+RhiResource* rhiSwapChainBuffer(RhiSwapChain* swapChain, uint32 index)
+{
+    return swapChain->buffers[index];
+}
+
+void rhiPresent(RhiSwapChain* swapChain, uint32 syncInterval)
+{
+    swapChain->device->functions->present(swapChain, syncInterval);
+}
+
+void rhiCmdBarriers(RhiCommandList* list, const RhiBarrier* barriers, uint32 count)
+{
+    SGSASSERT_DEBUG(list->recording);
+    if (count)
+    {
+        RHI_COUNT(list, RHI_COUNTER_BARRIERS, count);
+        list->functions->cmdBarriers(list, barriers, count);
+    }
+}
+
+void rhiCmdSetRenderTargets(RhiCommandList* list, RhiResource* const* colors, uint32 colorCount, RhiResource* depthStencil)
+{
+    SGSASSERT_DEBUG(list->recording);
+    SGSASSERT(colorCount <= RHI_MAX_RENDER_TARGETS);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetRenderTargets(list, colors, colorCount, depthStencil);
+}
+
+void rhiCmdClearRenderTarget(RhiCommandList* list, RhiResource* target, const float32 color[4])
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_CLEARS, 1);
+    list->functions->cmdClearRenderTarget(list, target, color);
+}
+
+void rhiCmdClearDepthStencil(RhiCommandList* list, RhiResource* target, float32 depth, uint8 stencil)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_CLEARS, 1);
+    list->functions->cmdClearDepthStencil(list, target, depth, stencil);
+}
+
+void rhiCmdSetViewport(RhiCommandList* list, const RhiViewport& viewport)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetViewport(list, viewport);
+}
+
+void rhiCmdSetScissor(RhiCommandList* list, const RhiRect& rect)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetScissor(list, rect);
+}
+
+void rhiCmdSetPipeline(RhiCommandList* list, RhiPipeline* pipeline)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetPipeline(list, pipeline);
+}
+
+void rhiCmdSetConstants(RhiCommandList* list, const void* values, uint32 count, uint32 firstValue)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetConstants(list, values, count, firstValue);
+}
+
+void rhiCmdSetDescriptorHeap(RhiCommandList* list, RhiDescriptorHeap* heap)
+{
+    SGSASSERT_DEBUG(list->recording);
+    SGSASSERT(heap->desc.shaderVisible);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetDescriptorHeap(list, heap);
+}
+
+void rhiCmdSetDescriptorTable(RhiCommandList* list, uint32 firstDescriptor)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetDescriptorTable(list, firstDescriptor);
+}
+
+void rhiCmdSetVertexBuffer(RhiCommandList* list, uint32 slot, RhiResource* buffer, uint64 offset, uint32 size, uint32 stride)
+{
+    SGSASSERT_DEBUG(list->recording);
+    SGSASSERT(slot < RHI_MAX_VERTEX_BUFFERS);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetVertexBuffer(list, slot, buffer, offset, size, stride);
+}
+
+void rhiCmdSetIndexBuffer(RhiCommandList* list, RhiResource* buffer, uint64 offset, uint32 size, e_rhiFormat format)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_STATE_CHANGES, 1);
+    list->functions->cmdSetIndexBuffer(list, buffer, offset, size, format);
+}
+
+void rhiCmdDraw(RhiCommandList* list, uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_DRAWS, 1);
+    list->functions->cmdDraw(list, vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+void rhiCmdDrawIndexed(RhiCommandList* list, uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset, uint32 firstInstance)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_DRAWS, 1);
+    list->functions->cmdDrawIndexed(list, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+}
+
+void rhiCmdDispatch(RhiCommandList* list, uint32 groupsX, uint32 groupsY, uint32 groupsZ)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_DISPATCHES, 1);
+    list->functions->cmdDispatch(list, groupsX, groupsY, groupsZ);
+}
+
+void rhiCmdCopyBuffer(RhiCommandList* list, RhiResource* destination, uint64 destinationOffset, RhiResource* source, uint64 sourceOffset, uint64 size)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_COPIES, 1);
+    RHI_COUNT(list, RHI_COUNTER_UPLOAD_BYTES, source->heapType == RHI_HEAP_UPLOAD ? size : 0);
+    list->functions->cmdCopyBuffer(list, destination, destinationOffset, source, sourceOffset, size);
+}
+
+void rhiCmdCopyTextureToBuffer(RhiCommandList* list, RhiResource* buffer, RhiResource* texture)
+{
+    SGSASSERT_DEBUG(list->recording);
+    SGSASSERT(buffer->desc.dimension == RHI_RESOURCE_BUFFER && texture->desc.dimension == RHI_RESOURCE_TEXTURE2D);
+    RHI_COUNT(list, RHI_COUNTER_COPIES, 1);
+    list->functions->cmdCopyTextureToBuffer(list, buffer, texture);
+}
+
+void rhiCmdResolve(RhiCommandList* list, RhiResource* destination, RhiResource* source)
+{
+    SGSASSERT_DEBUG(list->recording);
+    RHI_COUNT(list, RHI_COUNTER_COPIES, 1);
+    list->functions->cmdResolve(list, destination, source);
+}
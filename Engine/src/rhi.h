@@ -0,0 +1,503 @@
+#pragma once
+
+#include "defines.h"
+#include "validation.h"
+
+// Render hardware interface: the engine's view of a GPU. Queues, command allocators and lists,
+// fences, heaps, resources, descriptor heaps, pipelines and swapchains are opaque objects created through a device,
+// and the backend picked when the device is created implements them:
+// - D3D12 drives a real GPU on Windows
+// - null records commands into a compact in-memory stream and retires submissions on a modeled
+//   GPU timeline, so submission, synchronization and pacing code runs and can be measured on any
+//   machine
+//
+// The model is D3D12's. Command memory belongs to allocators, which may only be reset once the
+// GPU is done with everything recorded into them. Resource states are explicit and changed with
+// barriers. Fences are 64 bit values signalled by queues. A command list and its allocator are
+// used by one thread at a time; queues, fences and resource creation may be used from any thread.
+
+struct RhiDevice;
+struct RhiQueue;
+struct RhiCommandAllocator;
+struct RhiCommandList;
+struct RhiFence;
+struct RhiHeap;
+struct RhiResource;
+struct RhiDescriptorHeap;
+struct RhiPipeline;
+struct RhiSwapChain;
+
+typedef enum e_rhiBackend {
+    RHI_BACKEND_NULL = 0,
+    RHI_BACKEND_D3D12 = 1,
+    RHI_BACKEND_COUNT
+}e_rhiBackend;
+
+typedef enum e_rhiQueueType {
+    RHI_QUEUE_DIRECT = 0,
+    RHI_QUEUE_COMPUTE = 1,
+    RHI_QUEUE_COPY = 2,
+    RHI_QUEUE_TYPE_COUNT
+}e_rhiQueueType;
+
+typedef enum e_rhiFormat {
+    RHI_FORMAT_UNKNOWN = 0,
+    RHI_FORMAT_RGBA8_UNORM = 1,
+    RHI_FORMAT_BGRA8_UNORM = 2,
+    RHI_FORMAT_RGBA16_FLOAT = 3,
+    RHI_FORMAT_R32_FLOAT = 4,
+    RHI_FORMAT_RG32_FLOAT = 5,
+    RHI_FORMAT_RGB32_FLOAT = 6,
+    RHI_FORMAT_RGBA32_FLOAT = 7,
+    RHI_FORMAT_R16_UINT = 8,
+    RHI_FORMAT_R32_UINT = 9,
+    RHI_FORMAT_D24_UNORM_S8_UINT = 10,
+    RHI_FORMAT_D32_FLOAT = 11,
+    RHI_FORMAT_COUNT
+}e_rhiFormat;
+
+// Same bits as D3D12_RESOURCE_STATES, so the D3D12 backend passes them through
+typedef enum e_rhiResourceState {
+    RHI_STATE_COMMON = 0,
+    RHI_STATE_PRESENT = 0,
+    RHI_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+    RHI_STATE_INDEX_BUFFER = 0x2,
+    RHI_STATE_RENDER_TARGET = 0x4,
+    RHI_STATE_UNORDERED_ACCESS = 0x8,
+    RHI_STATE_DEPTH_WRITE = 0x10,
+    RHI_STATE_DEPTH_READ = 0x20,
+    RHI_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+    RHI_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+    RHI_STATE_SHADER_RESOURCE = 0x40 | 0x80,
+    RHI_STATE_INDIRECT_ARGUMENT = 0x200,
+    RHI_STATE_COPY_DEST = 0x400,
+    RHI_STATE_COPY_SOURCE = 0x800,
+    RHI_STATE_RESOLVE_DEST = 0x1000,
+    RHI_STATE_RESOLVE_SOURCE = 0x2000,
+    RHI_STATE_GENERIC_READ = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800
+}e_rhiResourceState;
+
+typedef enum e_rhiHeapType {
+    RHI_HEAP_DEFAULT = 0,           // GPU memory
+    RHI_HEAP_UPLOAD = 1,            // CPU writes, GPU reads
+    RHI_HEAP_READBACK = 2           // GPU writes, CPU reads
+}e_rhiHeapType;
+
+typedef enum e_rhiResourceDimension {
+    RHI_RESOURCE_BUFFER = 0,
+    RHI_RESOURCE_TEXTURE2D = 1
+}e_rhiResourceDimension;
+
+typedef enum e_rhiResourceFlags {
+    RHI_RESOURCE_FLAG_NONE = 0,
+    RHI_RESOURCE_FLAG_RENDER_TARGET = BIT(0),
+    RHI_RESOURCE_FLAG_DEPTH_STENCIL = BIT(1),
+    RHI_RESOURCE_FLAG_UNORDERED_ACCESS = BIT(2)
+}e_rhiResourceFlags;
+
+#define RHI_MAX_SWAPCHAIN_BUFFERS 4
+#define RHI_MAX_RENDER_TARGETS 8
+#define RHI_MAX_VERTEX_BUFFERS 8
+#define RHI_MAX_VERTEX_ATTRIBUTES 8
+#define RHI_ALL_SUBRESOURCES 0xffffffff
+// Fences one rhiFenceWaitMany call can wait on
+#define RHI_MAX_WAIT_FENCES 64
+// Passes one command list keeps counters for, see rhiCmdBeginPass
+#define RHI_MAX_PASSES_PER_LIST 32
+
+// Pass counters are compiled in with validation, define this to 0 or 1 to override
+#ifndef RHI_PASS_COUNTERS_ENABLED
+#define RHI_PASS_COUNTERS_ENABLED (SGS_VALIDATION_MAX_TIER > VALIDATION_TIER_OFF)
+#endif
+
+struct RhiResourceDesc
+{
+    e_rhiResourceDimension dimension = RHI_RESOURCE_BUFFER;
+    uint64 width = 0;               // in bytes for buffers
+    uint32 height = 1;
+    uint16 arraySize = 1;
+    uint16 mipLevels = 1;
+    e_rhiFormat format = RHI_FORMAT_UNKNOWN;
+    uint32 sampleCount = 1;
+    uint32 flags = RHI_RESOURCE_FLAG_NONE;
+    // Optimized clear value of render targets; depth in [0] and stencil in [1] for depth buffers
+    float32 clearValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+inline RhiResourceDesc rhiBufferDesc(uint64 size, uint32 flags = RHI_RESOURCE_FLAG_NONE)
+{
+    RhiResourceDesc desc;
+    desc.width = size;
+    desc.flags = flags;
+    return desc;
+}
+
+inline RhiResourceDesc rhiTexture2DDesc(e_rhiFormat format, uint32 width, uint32 height, uint32 flags = RHI_RESOURCE_FLAG_NONE, uint32 sampleCount = 1)
+{
+    RhiResourceDesc desc;
+    desc.dimension = RHI_RESOURCE_TEXTURE2D;
+    desc.width = width;
+    desc.height = height;
+    desc.format = format;
+    desc.sampleCount = sampleCount;
+    desc.flags = flags;
+    if (format == RHI_FORMAT_D24_UNORM_S8_UINT || format == RHI_FORMAT_D32_FLOAT)
+    {
+        desc.clearValue[0] = 1.0f;
+    }
+    return desc;
+}
+
+// Subresource index of a mip level in an array slice, as D3D12 numbers them
+inline uint32 rhiSubresourceIndex(const RhiResourceDesc& desc, uint32 mip, uint32 slice)
+{
+    return mip + slice * desc.mipLevels;
+}
+
+inline uint32 rhiSubresourceCount(const RhiResourceDesc& desc)
+{
+    return desc.dimension == RHI_RESOURCE_BUFFER ? 1 : (uint32)desc.mipLevels * desc.arraySize;
+}
+
+typedef enum e_rhiBarrierType {
+    RHI_BARRIER_TRANSITION = 0,
+    RHI_BARRIER_UAV = 1,            // orders unordered access to resource, all resources if null
+    RHI_BARRIER_ALIASING = 2        // resource hands its memory over to resourceAfter
+}e_rhiBarrierType;
+
+// Split transitions: the GPU may start a begin-only transition right away and must have finished
+// it at the matching end-only one, which repeats its states. The resource is unusable in between.
+typedef enum e_rhiBarrierFlags {
+    RHI_BARRIER_FLAG_NONE = 0,
+    RHI_BARRIER_FLAG_BEGIN_ONLY = BIT(0),
+    RHI_BARRIER_FLAG_END_ONLY = BIT(1)
+}e_rhiBarrierFlags;
+
+struct RhiBarrier
+{
+    e_rhiBarrierType type;
+    RhiResource* resource;
+    RhiResource* resourceAfter;
+    uint32 subresource;
+    uint32 before;                  // e_rhiResourceState bits
+    uint32 after;
+    uint32 flags;                   // e_rhiBarrierFlags, transitions only
+};
+
+inline RhiBarrier rhiTransition(RhiResource* resource, uint32 before, uint32 after, uint32 subresource = RHI_ALL_SUBRESOURCES,
+    uint32 flags = RHI_BARRIER_FLAG_NONE)
+{
+    RhiBarrier barrier = { RHI_BARRIER_TRANSITION, resource, nullptr, subresource, before, after, flags };
+    return barrier;
+}
+
+inline RhiBarrier rhiUavBarrier(RhiResource* resource)
+{
+    RhiBarrier barrier = { RHI_BARRIER_UAV, resource, nullptr, RHI_ALL_SUBRESOURCES, 0, 0, RHI_BARRIER_FLAG_NONE };
+    return barrier;
+}
+
+inline RhiBarrier rhiAliasingBarrier(RhiResource* before, RhiResource* after)
+{
+    RhiBarrier barrier = { RHI_BARRIER_ALIASING, before, after, RHI_ALL_SUBRESOURCES, 0, 0, RHI_BARRIER_FLAG_NONE };
+    return barrier;
+}
+
+struct RhiHeapDesc
+{
+    uint64 size = 0;
+    e_rhiHeapType type = RHI_HEAP_DEFAULT;
+};
+
+typedef enum e_rhiDescriptorHeapType {
+    RHI_DESCRIPTOR_HEAP_RESOURCE = 0,       // constant buffer, shader resource and unordered access views
+    RHI_DESCRIPTOR_HEAP_RENDER_TARGET = 1,
+    RHI_DESCRIPTOR_HEAP_DEPTH_STENCIL = 2,
+    RHI_DESCRIPTOR_HEAP_TYPE_COUNT
+}e_rhiDescriptorHeapType;
+
+typedef enum e_rhiViewType {
+    RHI_VIEW_SHADER_RESOURCE = 0,
+    RHI_VIEW_UNORDERED_ACCESS = 1,
+    RHI_VIEW_CONSTANT_BUFFER = 2,
+    RHI_VIEW_RENDER_TARGET = 3,
+    RHI_VIEW_DEPTH_STENCIL = 4,
+    RHI_VIEW_TYPE_COUNT
+}e_rhiViewType;
+
+struct RhiDescriptorHeapDesc
+{
+    e_rhiDescriptorHeapType type = RHI_DESCRIPTOR_HEAP_RESOURCE;
+    uint32 capacity = 0;
+    // Resource heaps only. Shader visible heaps are what descriptor tables point into; they are
+    // copied to, never from.
+    bool shaderVisible = false;
+};
+
+// count descriptors from source to destination, heaps of the same type
+struct RhiDescriptorCopy
+{
+    RhiDescriptorHeap* destination;
+    uint32 destinationIndex;
+    RhiDescriptorHeap* source;
+    uint32 sourceIndex;
+    uint32 count;
+};
+
+struct RhiViewport
+{
+    float32 x;
+    float32 y;
+    float32 width;
+    float32 height;
+    float32 minDepth;
+    float32 maxDepth;
+};
+
+struct RhiRect
+{
+    int32 left;
+    int32 top;
+    int32 right;
+    int32 bottom;
+};
+
+struct RhiVertexAttribute
+{
+    const char* semantic;
+    uint32 semanticIndex;
+    e_rhiFormat format;
+    uint32 offset;
+    uint32 slot;
+};
+
+// Graphics pipelines take a vertex and optionally a pixel shader, compute pipelines only the
+// compute shader. Shaders are compiled bytecode. Every pipeline gets a root signature of
+// rootConstantCount 32 bit values at b0, visible to all stages. With descriptorTable it also
+// takes a table into the bound shader visible heap, set with rhiCmdSetDescriptorTable: the same
+// descriptors as unbounded shader resource views at t0 space1 and unordered access views at u0
+// space2, so shaders index resources instead of binding them.
+struct RhiPipelineDesc
+{
+    const void* vertexShader = nullptr;
+    uint64 vertexShaderSize = 0;
+    const void* pixelShader = nullptr;
+    uint64 pixelShaderSize = 0;
+    const void* computeShader = nullptr;
+    uint64 computeShaderSize = 0;
+
+    RhiVertexAttribute attributes[RHI_MAX_VERTEX_ATTRIBUTES];
+    uint32 attributeCount = 0;
+    e_rhiFormat colorFormats[RHI_MAX_RENDER_TARGETS];
+    uint32 colorCount = 0;
+    e_rhiFormat depthFormat = RHI_FORMAT_UNKNOWN;
+    uint32 sampleCount = 1;
+    uint32 rootConstantCount = 0;
+    bool descriptorTable = false;
+    bool depthTest = true;
+    bool depthWrite = true;
+};
+
+struct RhiSwapChainDesc
+{
+    void* window = nullptr;         // HWND for D3D12, ignored by the null backend
+    uint32 width = 0;
+    uint32 height = 0;
+    uint32 bufferCount = 2;
+    e_rhiFormat format = RHI_FORMAT_RGBA8_UNORM;
+};
+
+// Modeled GPU of the null backend. A submission starts submitLatency after it was submitted, or
+// when the previous one on its queue finished, and takes the sum of its commands' costs.
+struct RhiNullConfig
+{
+    float64 submitLatencyNanoseconds = 20000.0;
+    float64 nanosecondsPerCommand = 10.0;
+    float64 nanosecondsPerDraw = 150.0;
+    float64 nanosecondsPerDispatch = 500.0;
+    float64 nanosecondsPerBarrier = 100.0;
+    float64 nanosecondsPerClearedPixel = 0.05;
+    float64 nanosecondsPerCopiedByte = 0.02;
+    // Presents wait for the next vblank when this is non zero and the sync interval is
+    float64 vsyncIntervalNanoseconds = 0.0;
+    // Present blocks while this many earlier presents haven't been shown, like DXGI
+    uint32 maxFrameLatency = 3;
+};
+
+struct RhiDeviceConfig
+{
+    e_rhiBackend backend = RHI_BACKEND_NULL;
+    bool debugLayer = false;
+    RhiNullConfig null;
+};
+
+// What the null backend's GPU has executed so far
+struct RhiNullStats
+{
+    uint64 submissions;
+    uint64 commandLists;
+    uint64 commands;
+    uint64 streamBytes;
+    uint64 draws;
+    uint64 barriers;
+    uint64 barrierMismatches;       // transitions whose before state was not the resource's state
+    uint64 descriptorCopyCalls;     // rhiCopyDescriptors calls, done on the CPU timeline
+    uint64 descriptorsCopied;
+    float64 gpuBusySeconds;
+};
+
+// What a pass recorded. State changes are pipeline, root constant, descriptor heap and table,
+// vertex and index buffer, render target, viewport and scissor binds that reached the list.
+typedef enum e_rhiCounter {
+    RHI_COUNTER_DRAWS = 0,
+    RHI_COUNTER_DISPATCHES = 1,
+    RHI_COUNTER_BARRIERS = 2,           // barriers, not barrier calls
+    RHI_COUNTER_STATE_CHANGES = 3,
+    RHI_COUNTER_DESCRIPTOR_COPIES = 4,
+    RHI_COUNTER_UPLOAD_BYTES = 5,       // copied out of upload heaps
+    RHI_COUNTER_CLEARS = 6,
+    RHI_COUNTER_COPIES = 7,             // buffer and texture copies, resolves
+    RHI_COUNTER_COUNT
+}e_rhiCounter;
+
+struct RhiPassCounters
+{
+    const char* name;                   // nullptr for commands outside any pass
+    uint64 values[RHI_COUNTER_COUNT];
+};
+
+// Returns nullptr if the backend is not available on this platform or the device can't be created
+RhiDevice* rhiCreateDevice(const RhiDeviceConfig& config);
+void rhiDestroyDevice(RhiDevice* device);
+e_rhiBackend rhiGetBackend(const RhiDevice* device);
+const char* rhiBackendName(e_rhiBackend backend);
+// 0 when the format doesn't support that many samples
+uint32 rhiGetMsaaQualityLevels(RhiDevice* device, e_rhiFormat format, uint32 sampleCount);
+// False for other backends
+bool rhiNullGetStats(RhiDevice* device, RhiNullStats* stats);
+
+uint32 rhiFormatBytesPerPixel(e_rhiFormat format);
+const char* rhiFormatName(e_rhiFormat format);
+
+// Queues exist as long as their device, one of each type
+RhiQueue* rhiGetQueue(RhiDevice* device, e_rhiQueueType type);
+// Lists run in order, as one submission
+void rhiQueueSubmit(RhiQueue* queue, RhiCommandList* const* lists, uint32 count);
+void rhiQueueSignal(RhiQueue* queue, RhiFence* fence, uint64 value);
+// Work submitted to queue after this waits on the GPU until fence reaches value
+void rhiQueueWait(RhiQueue* queue, RhiFence* fence, uint64 value);
+
+RhiFence* rhiCreateFence(RhiDevice* device, uint64 initialValue, const char* name);
+void rhiDestroyFence(RhiFence* fence);
+uint64 rhiFenceCompletedValue(RhiFence* fence);
+// Never blocks
+bool rhiFenceIsComplete(RhiFence* fence, uint64 value);
+// Blocks the calling thread until fence reaches value
+void rhiFenceWait(RhiFence* fence, uint64 value);
+// Blocks until every fence reached its value, or with waitAll false until one did, and returns
+// the index of one that did. The fences belong to one device.
+uint32 rhiFenceWaitMany(RhiFence* const* fences, const uint64* values, uint32 count, bool waitAll);
+
+typedef void (*PFN_rhiFenceCallback)(uint64 value, void* userData);
+// Runs callback once fence reaches value: right away if it already has, otherwise on a thread
+// of the backend's choosing. Callbacks should be short and must not destroy fences; the ones
+// still pending when their fence is destroyed never run.
+void rhiFenceOnComplete(RhiFence* fence, uint64 value, PFN_rhiFenceCallback callback, void* userData);
+
+RhiCommandAllocator* rhiCreateCommandAllocator(RhiDevice* device, e_rhiQueueType type, const char* name);
+void rhiDestroyCommandAllocator(RhiCommandAllocator* allocator);
+// Every list recorded from the allocator must have completed on the GPU
+void rhiResetCommandAllocator(RhiCommandAllocator* allocator);
+
+RhiCommandList* rhiCreateCommandList(RhiDevice* device, e_rhiQueueType type, const char* name);
+void rhiDestroyCommandList(RhiCommandList* list);
+// Starts recording into allocator's memory. The list may be submitted again only after the
+// next end.
+void rhiBeginCommandList(RhiCommandList* list, RhiCommandAllocator* allocator);
+void rhiEndCommandList(RhiCommandList* list);
+
+RhiHeap* rhiCreateHeap(RhiDevice* device, const RhiHeapDesc& desc, const char* name);
+void rhiDestroyHeap(RhiHeap* heap);
+const RhiHeapDesc& rhiGetHeapDesc(const RhiHeap* heap);
+
+// Size and alignment a placed resource needs in a heap
+void rhiGetAllocationInfo(RhiDevice* device, const RhiResourceDesc& desc, uint64* size, uint64* alignment);
+// Layout of a texture's first subresource copied into a buffer
+void rhiGetCopyableFootprint(RhiDevice* device, const RhiResourceDesc& desc, uint32* rowPitch, uint64* totalBytes);
+
+RhiResource* rhiCreateCommittedResource(RhiDevice* device, e_rhiHeapType heapType, const RhiResourceDesc& desc, uint32 initialState, const char* name);
+RhiResource* rhiCreatePlacedResource(RhiDevice* device, RhiHeap* heap, uint64 offset, const RhiResourceDesc& desc, uint32 initialState, const char* name);
+// Immediate: the GPU must be done with the resource
+void rhiDestroyResource(RhiResource* resource);
+const RhiResourceDesc& rhiGetResourceDesc(const RhiResource* resource);
+// Memory the resource holds on its own: 0 for placed resources, whose memory is their heap's
+uint64 rhiResourceMemorySize(const RhiResource* resource);
+// Buffers in upload and readback heaps only. Returns nullptr on failure.
+void* rhiMapResource(RhiResource* resource);
+void rhiUnmapResource(RhiResource* resource);
+
+// Descriptors are written and copied on the CPU timeline, right away: the GPU must be done with
+// a shader visible descriptor before it is overwritten. CPU-only heaps are scratch space the
+// views are written into and copied from.
+RhiDescriptorHeap* rhiCreateDescriptorHeap(RhiDevice* device, const RhiDescriptorHeapDesc& desc, const char* name);
+// Immediate: the GPU must be done with the heap
+void rhiDestroyDescriptorHeap(RhiDescriptorHeap* heap);
+const RhiDescriptorHeapDesc& rhiGetDescriptorHeapDesc(const RhiDescriptorHeap* heap);
+// A view of the whole resource into a heap of the matching type. Buffers get raw shader
+// resource and unordered access views; constant buffer views need a width that is a multiple
+// of 256.
+void rhiWriteView(RhiDescriptorHeap* heap, uint32 index, e_rhiViewType type, RhiResource* resource);
+// All copies of one call go between heaps of one type
+void rhiCopyDescriptors(RhiDevice* device, const RhiDescriptorCopy* copies, uint32 count);
+
+RhiPipeline* rhiCreatePipeline(RhiDevice* device, const RhiPipelineDesc& desc, const char* name);
+void rhiDestroyPipeline(RhiPipeline* pipeline);
+
+// Buffers start in the PRESENT state. Resizing needs the GPU done with every buffer.
+RhiSwapChain* rhiCreateSwapChain(RhiDevice* device, RhiQueue* queue, const RhiSwapChainDesc& desc);
+void rhiDestroySwapChain(RhiSwapChain* swapChain);
+bool rhiResizeSwapChain(RhiSwapChain* swapChain, uint32 width, uint32 height);
+uint32 rhiSwapChainBufferCount(const RhiSwapChain* swapChain);
+uint32 rhiSwapChainCurrentIndex(const RhiSwapChain* swapChain);
+RhiResource* rhiSwapChainBuffer(RhiSwapChain* swapChain, uint32 index);
+// Queues the current buffer for display and moves on to the next one
+void rhiPresent(RhiSwapChain* swapChain, uint32 syncInterval);
+
+// Commands. Clears and render target binds take the resources; the backend owns their views.
+void rhiCmdBarriers(RhiCommandList* list, const RhiBarrier* barriers, uint32 count);
+void rhiCmdSetRenderTargets(RhiCommandList* list, RhiResource* const* colors, uint32 colorCount, RhiResource* depthStencil);
+void rhiCmdClearRenderTarget(RhiCommandList* list, RhiResource* target, const float32 color[4]);
+void rhiCmdClearDepthStencil(RhiCommandList* list, RhiResource* target, float32 depth, uint8 stencil);
+void rhiCmdSetViewport(RhiCommandList* list, const RhiViewport& viewport);
+void rhiCmdSetScissor(RhiCommandList* list, const RhiRect& rect);
+void rhiCmdSetPipeline(RhiCommandList* list, RhiPipeline* pipeline);
+void rhiCmdSetConstants(RhiCommandList* list, const void* values, uint32 count, uint32 firstValue);
+// A shader visible resource heap, before tables are set
+void rhiCmdSetDescriptorHeap(RhiCommandList* list, RhiDescriptorHeap* heap);
+// Points the table of the pipeline set last at firstDescriptor of the bound heap
+void rhiCmdSetDescriptorTable(RhiCommandList* list, uint32 firstDescriptor);
+void rhiCmdSetVertexBuffer(RhiCommandList* list, uint32 slot, RhiResource* buffer, uint64 offset, uint32 size, uint32 stride);
+void rhiCmdSetIndexBuffer(RhiCommandList* list, RhiResource* buffer, uint64 offset, uint32 size, e_rhiFormat format);
+void rhiCmdDraw(RhiCommandList* list, uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance);
+void rhiCmdDrawIndexed(RhiCommandList* list, uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset, uint32 firstInstance);
+void rhiCmdDispatch(RhiCommandList* list, uint32 groupsX, uint32 groupsY, uint32 groupsZ);
+void rhiCmdCopyBuffer(RhiCommandList* list, RhiResource* destination, uint64 destinationOffset, RhiResource* source, uint64 sourceOffset, uint64 size);
+// Copies the texture's first subresource into buffer with the layout from rhiGetCopyableFootprint
+void rhiCmdCopyTextureToBuffer(RhiCommandList* list, RhiResource* buffer, RhiResource* texture);
+void rhiCmdResolve(RhiCommandList* list, RhiResource* destination, RhiResource* source);
+
+// Per pass counters. Every command counts toward the pass begun last on its list; commands
+// outside a pass count toward an unnamed one. Passes past RHI_MAX_PASSES_PER_LIST count toward
+// the last. Counting compiles out with RHI_PASS_COUNTERS_ENABLED 0, the default for builds
+// capped at VALIDATION_TIER_OFF. Otherwise it costs a branch per command while
+// rhiPassCountersEnabled is set, whatever the runtime validation tier. Lists recorded with
+// counting off report no passes. name must point to static storage.
+extern bool rhiPassCountersEnabled;
+#define RHI_PASS_COUNTERS_ACTIVE() (RHI_PASS_COUNTERS_ENABLED && rhiPassCountersEnabled)
+void rhiCmdBeginPass(RhiCommandList* list, const char* name);
+void rhiCmdEndPass(RhiCommandList* list);
+// Work the RHI doesn't see, like descriptor copies or writes into persistently mapped upload memory
+void rhiCmdAddCounter(RhiCommandList* list, e_rhiCounter counter, uint64 amount);
+// Passes of the last recording, valid until the list is begun again. Empty while it records.
+const RhiPassCounters* rhiGetPassCounters(const RhiCommandList* list, uint32* passCount);
+const char* rhiCounterName(e_rhiCounter counter);
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "rhi.h"
+
+// What an RHI backend implements. Only rhi.cpp and the backends include this. Backend objects
+// derive from the base objects below; the public functions in rhi.cpp check nothing beyond
+// assertions, count commands for the pass counters and forward to the device's table.
+
+struct RhiBackendFunctions
+{
+    void (*destroyDevice)(RhiDevice* device);
+    uint32 (*msaaQualityLevels)(RhiDevice* device, e_rhiFormat format, uint32 sampleCount);
+
+    void (*queueSubmit)(RhiQueue* queue, RhiCommandList* const* lists, uint32 count);
+    void (*queueSignal)(RhiQueue* queue, RhiFence* fence, uint64 value);
+    void (*queueWait)(RhiQueue* queue, RhiFence* fence, uint64 value);
+
+    RhiFence* (*createFence)(RhiDevice* device, uint64 initialValue, const char* name);
+    void (*destroyFence)(RhiFence* fence);
+    uint64 (*fenceCompletedValue)(RhiFence* fence);
+    void (*fenceWait)(RhiFence* fence, uint64 value);
+    uint32 (*fenceWaitMany)(RhiFence* const* fences, const uint64* values, uint32 count, bool waitAll);
+    void (*fenceOnComplete)(RhiFence* fence, uint64 value, PFN_rhiFenceCallback callback, void* userData);
+
+    RhiCommandAllocator* (*createCommandAllocator)(RhiDevice* device, e_rhiQueueType type, const char* name);
+    void (*destroyCommandAllocator)(RhiCommandAllocator* allocator);
+    void (*resetCommandAllocator)(RhiCommandAllocator* allocator);
+    RhiCommandList* (*createCommandList)(RhiDevice* device, e_rhiQueueType type, const char* name);
+    void (*destroyCommandList)(RhiCommandList* list);
+    void (*beginCommandList)(RhiCommandList* list, RhiCommandAllocator* allocator);
+    void (*endCommandList)(RhiCommandList* list);
+
+    RhiHeap* (*createHeap)(RhiDevice* device, const RhiHeapDesc& desc, const char* name);
+    void (*destroyHeap)(RhiHeap* heap);
+    void (*allocationInfo)(RhiDevice* device, const RhiResourceDesc& desc, uint64* size, uint64* alignment);
+    void (*copyableFootprint)(RhiDevice* device, const RhiResourceDesc& desc, uint32* rowPitch, uint64* totalBytes);
+    RhiResource* (*createCommittedResource)(RhiDevice* device, e_rhiHeapType heapType, const RhiResourceDesc& desc, uint32 initialState, const char* name);
+    RhiResource* (*createPlacedResource)(RhiDevice* device, RhiHeap* heap, uint64 offset, const RhiResourceDesc& desc, uint32 initialState, const char* name);
+    void (*destroyResource)(RhiResource* resource);
+    void* (*mapResource)(RhiResource* resource);
+    void (*unmapResource)(RhiResource* resource);
+
+    RhiDescriptorHeap* (*createDescriptorHeap)(RhiDevice* device, const RhiDescriptorHeapDesc& desc, const char* name);
+    void (*destroyDescriptorHeap)(RhiDescriptorHeap* heap);
+    void (*writeView)(RhiDescriptorHeap* heap, uint32 index, e_rhiViewType type, RhiResource* resource);
+    void (*copyDescriptors)(RhiDevice* device, const RhiDescriptorCopy* copies, uint32 count);
+
+    RhiPipeline* (*createPipeline)(RhiDevice* device, const RhiPipelineDesc& desc, const char* name);
+    void (*destroyPipeline)(RhiPipeline* pipeline);
+
+    RhiSwapChain* (*createSwapChain)(RhiDevice* device, RhiQueue* queue, const RhiSwapChainDesc& desc);
+    void (*destroySwapChain)(RhiSwapChain* swapChain);
+    bool (*resizeSwapChain)(RhiSwapChain* swapChain, uint32 width, uint32 height);
+    void (*present)(RhiSwapChain* swapChain, uint32 syncInterval);
+
+    void (*cmdBarriers)(RhiCommandList* list, const RhiBarrier* barriers, uint32 count);
+    void (*cmdSetRenderTargets)(RhiCommandList* list, RhiResource* const* colors, uint32 colorCount, RhiResource* depthStencil);
+    void (*cmdClearRenderTarget)(RhiCommandList* list, RhiResource* target, const float32 color[4]);
+    void (*cmdClearDepthStencil)(RhiCommandList* list, RhiResource* target, float32 depth, uint8 stencil);
+    void (*cmdSetViewport)(RhiCommandList* list, const RhiViewport& viewport);
+    void (*cmdSetScissor)(RhiCommandList* list, const RhiRect& rect);
+    void (*cmdSetPipeline)(RhiCommandList* list, RhiPipeline* pipeline);
+    void (*cmdSetConstants)(RhiCommandList* list, const void* values, uint32 count, uint32 firstValue);
+    void (*cmdSetDescriptorHeap)(RhiCommandList* list, RhiDescriptorHeap* heap);
+    void (*cmdSetDescriptorTable)(RhiCommandList* list, uint32 firstDescriptor);
+    void (*cmdSetVertexBuffer)(RhiCommandList* list, uint32 slot, RhiResource* buffer, uint64 offset, uint32 size, uint32 stride);
+    void (*cmdSetIndexBuffer)(RhiCommandList* list, RhiResource* buffer, uint64 offset, uint32 size, e_rhiFormat format);
+    void (*cmdDraw)(RhiCommandList* list, uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance);
+    void (*cmdDrawIndexed)(RhiCommandList* list, uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset, uint32 firstInstance);
+    void (*cmdDispatch)(RhiCommandList* list, uint32 groupsX, uint32 groupsY, uint32 groupsZ);
+    void (*cmdCopyBuffer)(RhiCommandList* list, RhiResource* destination, uint64 destinationOffset, RhiResource* source, uint64 sourceOffset, uint64 size);
+    void (*cmdCopyTextureToBuffer)(RhiCommandList* list, RhiResource* buffer, RhiResource* texture);
+    void (*cmdResolve)(RhiCommandList* list, RhiResource* destination, RhiResource* source);
+};
+
+struct RhiDevice
+{
+    const RhiBackendFunctions* functions;
+    e_rhiBackend backend;
+    RhiQueue* queues[RHI_QUEUE_TYPE_COUNT];
+};
+
+struct RhiQueue
+{
+    RhiDevice* device;
+    e_rhiQueueType type;
+};
+
+struct RhiFence
+{
+    RhiDevice* device;
+};
+
+struct RhiCommandAllocator
+{
+    RhiDevice* device;
+    e_rhiQueueType type;
+};
+
+struct RhiCommandList
+{
+    // Copied from the device, commands are the hot path
+    const RhiBackendFunctions* functions;
+    RhiDevice* device;
+    e_rhiQueueType type;
+    bool recording;
+    // Set up by rhiBeginCommandList; counters points at the values of passes[passCount - 1]
+    uint64* counters;
+    uint32 passCount;
+    RhiPassCounters passes[RHI_MAX_PASSES_PER_LIST];
+};
+
+struct RhiHeap
+{
+    RhiDevice* device;
+    RhiHeapDesc desc;
+};
+
+struct RhiResource
+{
+    RhiDevice* device;
+    RhiResourceDesc desc;
+    e_rhiHeapType heapType;
+    RhiHeap* heap;                  // placed resources only
+};
+
+struct RhiDescriptorHeap
+{
+    RhiDevice* device;
+    RhiDescriptorHeapDesc desc;
+};
+
+struct RhiPipeline
+{
+    RhiDevice* device;
+    bool compute;
+};
+
+struct RhiSwapChain
+{
+    RhiDevice* device;
+    RhiQueue* queue;
+    RhiResource* buffers[RHI_MAX_SWAPCHAIN_BUFFERS];
+    uint32 bufferCount;
+    uint32 currentIndex;
+};
+
+RhiDevice* rhiCreateNullDevice(const RhiDeviceConfig& config);
+bool rhiNullDeviceStats(RhiDevice* device, RhiNullStats* stats);
+// nullptr where D3D12 doesn't exist
+RhiDevice* rhiCreateD3D12Device(const RhiDeviceConfig& config);
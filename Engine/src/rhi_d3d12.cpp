@@ -0,0 +1,1500 @@
+#include "rhi_backend.h"
+
+#if SGS_PLATFORM_WINDOWS
+
+#include <limits.h>
+#include <string.h>
+#include <mutex>
+
+#include "utils.h"
+#include "assertions.h"
+#include "dx_check.h"
+#include "flight_recorder.h"
+#include "logger.h"
+#include "validation.h"
+
+using Microsoft::WRL::ComPtr;
+
+// D3D12 backend. Render target and depth views live in CPU-only descriptor heaps owned by the
+// device; resources created with the render target or depth stencil flag get a view at creation
+// and commands look them up, so callers never see those descriptors. Every other view goes
+// through RhiDescriptorHeaps.
+
+#define D3D12_RTV_POOL_SIZE 256
+#define D3D12_DSV_POOL_SIZE 64
+#define D3D12_NO_DESCRIPTOR 0xffffffff
+#define D3D12_BARRIER_BATCH 32
+// Ranges per CopyDescriptors call
+#define D3D12_DESCRIPTOR_COPY_BATCH 64
+#define D3D12_SUBMIT_BATCH 256
+// Idle wait events kept per device; a burst beyond this closes the extra ones
+#define D3D12_EVENT_POOL_SIZE 64
+
+struct D3D12DescriptorPool
+{
+    ComPtr<ID3D12DescriptorHeap> heap;
+    D3D12_CPU_DESCRIPTOR_HANDLE start;
+    uint32 increment;
+    uint32* freeList;
+    uint32 freeCount;
+    std::mutex mutex;
+};
+
+struct D3D12Queue : RhiQueue
+{
+    ComPtr<ID3D12CommandQueue> handle;
+};
+
+// Auto-reset events for fence waits. Creating and closing one per wait costs two kernel calls;
+// a pooled event is reset by the wait that consumed it and goes straight back.
+struct D3D12EventPool
+{
+    HANDLE events[D3D12_EVENT_POOL_SIZE];
+    uint32 count;
+    std::mutex mutex;
+};
+
+struct D3D12Device : RhiDevice
+{
+    ComPtr<IDXGIFactory4> factory;
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12Device1> device1;  // multi-fence waits, null before Windows 10 1703
+    D3D12EventPool eventPool;
+    D3D12Queue queueStorage[RHI_QUEUE_TYPE_COUNT];
+    D3D12DescriptorPool rtvPool;
+    D3D12DescriptorPool dsvPool;
+};
+
+struct D3D12FenceCallback
+{
+    uint64 value;
+    PFN_rhiFenceCallback callback;
+    void* userData;
+    HANDLE event;
+    HANDLE wait;                    // thread pool wait on event
+    volatile LONG fired;            // set by the thread pool once the callback returned
+    D3D12FenceCallback* next;
+};
+
+struct D3D12Fence : RhiFence
+{
+    ComPtr<ID3D12Fence> handle;
+    // Registered callbacks; fired ones are reclaimed on the next registration or at destruction
+    D3D12FenceCallback* callbacks;
+    std::mutex callbackMutex;
+};
+
+struct D3D12CommandAllocator : RhiCommandAllocator
+{
+    ComPtr<ID3D12CommandAllocator> handle;
+};
+
+struct D3D12DescriptorHeap;
+
+struct D3D12CommandList : RhiCommandList
+{
+    ComPtr<ID3D12GraphicsCommandList> handle;
+    bool computeBound;              // root constants go to the compute root signature
+    uint32 tableParameter;          // root parameter of the bound pipeline's descriptor table
+    D3D12DescriptorHeap* descriptorHeap;
+};
+
+struct D3D12Heap : RhiHeap
+{
+    ComPtr<ID3D12Heap> handle;
+};
+
+struct D3D12Resource : RhiResource
+{
+    ComPtr<ID3D12Resource> handle;
+    uint32 rtv;
+    uint32 dsv;
+};
+
+struct D3D12DescriptorHeap : RhiDescriptorHeap
+{
+    ComPtr<ID3D12DescriptorHeap> handle;
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuStart;
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuStart;   // shader visible heaps only
+    uint32 increment;
+};
+
+struct D3D12Pipeline : RhiPipeline
+{
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> state;
+    uint32 tableParameter;
+};
+
+struct D3D12SwapChain : RhiSwapChain
+{
+    ComPtr<IDXGISwapChain> handle;
+    ComPtr<IDXGISwapChain3> handle3;
+    D3D12Resource bufferStorage[RHI_MAX_SWAPCHAIN_BUFFERS];
+    RhiSwapChainDesc desc;
+};
+
+static DXGI_FORMAT toDxgiFormat(e_rhiFormat format)
+{
+    switch (format)
+    {
+        case RHI_FORMAT_RGBA8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case RHI_FORMAT_BGRA8_UNORM: return DXGI_FORMAT_B8G8R8A8_UNORM;
+        case RHI_FORMAT_RGBA16_FLOAT: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case RHI_FORMAT_R32_FLOAT: return DXGI_FORMAT_R32_FLOAT;
+        case RHI_FORMAT_RG32_FLOAT: return DXGI_FORMAT_R32G32_FLOAT;
+        case RHI_FORMAT_RGB32_FLOAT: return DXGI_FORMAT_R32G32B32_FLOAT;
+        case RHI_FORMAT_RGBA32_FLOAT: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case RHI_FORMAT_R16_UINT: return DXGI_FORMAT_R16_UINT;
+        case RHI_FORMAT_R32_UINT: return DXGI_FORMAT_R32_UINT;
+        case RHI_FORMAT_D24_UNORM_S8_UINT: return DXGI_FORMAT_D24_UNORM_S8_UINT;
+        case RHI_FORMAT_D32_FLOAT: return DXGI_FORMAT_D32_FLOAT;
+        default: return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+static D3D12_COMMAND_LIST_TYPE toCommandListType(e_rhiQueueType type)
+{
+    switch (type)
+    {
+        case RHI_QUEUE_COMPUTE: return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+        case RHI_QUEUE_COPY: return D3D12_COMMAND_LIST_TYPE_COPY;
+        default: return D3D12_COMMAND_LIST_TYPE_DIRECT;
+    }
+}
+
+static D3D12_HEAP_TYPE toHeapType(e_rhiHeapType type)
+{
+    switch (type)
+    {
+        case RHI_HEAP_UPLOAD: return D3D12_HEAP_TYPE_UPLOAD;
+        case RHI_HEAP_READBACK: return D3D12_HEAP_TYPE_READBACK;
+        default: return D3D12_HEAP_TYPE_DEFAULT;
+    }
+}
+
+static D3D12_RESOURCE_DESC toResourceDesc(const RhiResourceDesc& desc)
+{
+    D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
+    if (desc.flags & RHI_RESOURCE_FLAG_RENDER_TARGET)
+    {
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    }
+    if (desc.flags & RHI_RESOURCE_FLAG_DEPTH_STENCIL)
+    {
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+    }
+    if (desc.flags & RHI_RESOURCE_FLAG_UNORDERED_ACCESS)
+    {
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    }
+
+    if (desc.dimension == RHI_RESOURCE_BUFFER)
+    {
+        return CD3DX12_RESOURCE_DESC::Buffer(desc.width, flags);
+    }
+    return CD3DX12_RESOURCE_DESC::Tex2D(toDxgiFormat(desc.format), desc.width, desc.height,
+        desc.arraySize, desc.mipLevels, desc.sampleCount, 0, flags);
+}
+
+static void setName(ID3D12Object* object, const char* name)
+{
+    if (name && SGS_VALIDATION_ENABLED(VALIDATION_TIER_LIGHT))
+    {
+        wchar_t wideName[128];
+        MultiByteToWideChar(CP_UTF8, 0, name, -1, wideName, 128);
+        wideName[127] = 0;
+        SGSNAME(object, wideName);
+    }
+}
+
+static bool initializeDescriptorPool(ID3D12Device* device, D3D12DescriptorPool* pool, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32 capacity)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDescription = {};
+    heapDescription.NumDescriptors = capacity;
+    heapDescription.Type = type;
+    heapDescription.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    if (FAILED(device->CreateDescriptorHeap(&heapDescription, IID_PPV_ARGS(pool->heap.GetAddressOf()))))
+    {
+        return false;
+    }
+
+    pool->start = pool->heap->GetCPUDescriptorHandleForHeapStart();
+    pool->increment = device->GetDescriptorHandleIncrementSize(type);
+    pool->freeList = new uint32[capacity];
+    pool->freeCount = capacity;
+    for (uint32 i = 0; i < capacity; i++)
+    {
+        pool->freeList[i] = capacity - 1 - i;
+    }
+    return true;
+}
+
+static uint32 allocateDescriptor(D3D12DescriptorPool* pool)
+{
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    if (pool->freeCount == 0)
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Out of render target or depth stencil views");
+        return D3D12_NO_DESCRIPTOR;
+    }
+    return pool->freeList[--pool->freeCount];
+}
+
+static void freeDescriptor(D3D12DescriptorPool* pool, uint32 index)
+{
+    if (index != D3D12_NO_DESCRIPTOR)
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->freeList[pool->freeCount++] = index;
+    }
+}
+
+static D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle(const D3D12DescriptorPool* pool, uint32 index)
+{
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(pool->start, index, pool->increment);
+}
+
+static D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle(RhiResource* resource)
+{
+    D3D12Device* device = (D3D12Device*)resource->device;
+    return descriptorHandle(&device->rtvPool, ((D3D12Resource*)resource)->rtv);
+}
+
+static D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle(RhiResource* resource)
+{
+    D3D12Device* device = (D3D12Device*)resource->device;
+    return descriptorHandle(&device->dsvPool, ((D3D12Resource*)resource)->dsv);
+}
+
+static uint32 d3d12MsaaQualityLevels(RhiDevice* rhiDevice, e_rhiFormat format, uint32 sampleCount)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msaaQualityLevels;
+    msaaQualityLevels.Format = toDxgiFormat(format);
+    msaaQualityLevels.SampleCount = sampleCount;
+    msaaQualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
+    msaaQualityLevels.NumQualityLevels = 0;
+
+    DX_CHECK(device->device->CheckFeatureSupport(
+        D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS,
+        &msaaQualityLevels,
+        sizeof(msaaQualityLevels)));
+    return msaaQualityLevels.NumQualityLevels;
+}
+
+// Queues and fences
+
+static void d3d12QueueSubmit(RhiQueue* queue, RhiCommandList* const* lists, uint32 count)
+{
+    ID3D12CommandList* handles[D3D12_SUBMIT_BATCH];
+    while (count)
+    {
+        uint32 batch = count < D3D12_SUBMIT_BATCH ? count : D3D12_SUBMIT_BATCH;
+        for (uint32 i = 0; i < batch; i++)
+        {
+            handles[i] = ((D3D12CommandList*)lists[i])->handle.Get();
+        }
+        ((D3D12Queue*)queue)->handle->ExecuteCommandLists(batch, handles);
+        lists += batch;
+        count -= batch;
+    }
+}
+
+static void d3d12QueueSignal(RhiQueue* queue, RhiFence* fence, uint64 value)
+{
+    DX_CHECK(((D3D12Queue*)queue)->handle->Signal(((D3D12Fence*)fence)->handle.Get(), value));
+}
+
+static void d3d12QueueWait(RhiQueue* queue, RhiFence* fence, uint64 value)
+{
+    DX_CHECK(((D3D12Queue*)queue)->handle->Wait(((D3D12Fence*)fence)->handle.Get(), value));
+}
+
+static HANDLE acquireEvent(D3D12Device* device)
+{
+    {
+        std::lock_guard<std::mutex> lock(device->eventPool.mutex);
+        if (device->eventPool.count)
+        {
+            return device->eventPool.events[--device->eventPool.count];
+        }
+    }
+    return CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+}
+
+// Only for events that are not signalled and have no pending SetEventOnCompletion
+static void releaseEvent(D3D12Device* device, HANDLE event)
+{
+    {
+        std::lock_guard<std::mutex> lock(device->eventPool.mutex);
+        if (device->eventPool.count < D3D12_EVENT_POOL_SIZE)
+        {
+            device->eventPool.events[device->eventPool.count++] = event;
+            return;
+        }
+    }
+    CloseHandle(event);
+}
+
+static RhiFence* d3d12CreateFence(RhiDevice* rhiDevice, uint64 initialValue, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12Fence* fence = new D3D12Fence();
+    fence->device = device;
+    fence->callbacks = nullptr;
+    if (FAILED(device->device->CreateFence(initialValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence->handle))))
+    {
+        delete fence;
+        return nullptr;
+    }
+    setName(fence->handle.Get(), name);
+    return fence;
+}
+
+// Unregistering blocks until a running callback returned, so never call this from one
+static void freeCallback(D3D12Device* device, D3D12FenceCallback* entry)
+{
+    UnregisterWaitEx(entry->wait, INVALID_HANDLE_VALUE);
+    if (entry->fired)
+    {
+        releaseEvent(device, entry->event);
+    }
+    else
+    {
+        // Still armed by SetEventOnCompletion, it must not be reused
+        CloseHandle(entry->event);
+    }
+    delete entry;
+}
+
+static void d3d12DestroyFence(RhiFence* rhiFence)
+{
+    D3D12Fence* fence = (D3D12Fence*)rhiFence;
+    D3D12FenceCallback* entry;
+    {
+        std::lock_guard<std::mutex> lock(fence->callbackMutex);
+        entry = fence->callbacks;
+        fence->callbacks = nullptr;
+    }
+    while (entry)
+    {
+        D3D12FenceCallback* next = entry->next;
+        freeCallback((D3D12Device*)fence->device, entry);
+        entry = next;
+    }
+    delete fence;
+}
+
+static uint64 d3d12FenceCompletedValue(RhiFence* fence)
+{
+    return ((D3D12Fence*)fence)->handle->GetCompletedValue();
+}
+
+static void d3d12FenceWait(RhiFence* rhiFence, uint64 value)
+{
+    D3D12Fence* fence = (D3D12Fence*)rhiFence;
+    if (fence->handle->GetCompletedValue() < value)
+    {
+        D3D12Device* device = (D3D12Device*)fence->device;
+        HANDLE eventHandle = acquireEvent(device);
+
+        DX_CHECK(fence->handle->SetEventOnCompletion(value, eventHandle));
+
+        SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_BEGIN, "fence", value);
+        WaitForSingleObject(eventHandle, INFINITE);
+        SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_END, "fence", value);
+        releaseEvent(device, eventHandle);
+    }
+}
+
+static uint32 d3d12FenceWaitMany(RhiFence* const* fences, const uint64* values, uint32 count, bool waitAll)
+{
+    D3D12Device* device = (D3D12Device*)fences[0]->device;
+    ID3D12Fence* handles[RHI_MAX_WAIT_FENCES];
+    uint32 pending = 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        handles[i] = ((D3D12Fence*)fences[i])->handle.Get();
+        bool complete = handles[i]->GetCompletedValue() >= values[i];
+        if (complete && !waitAll)
+        {
+            return i;
+        }
+        pending += complete ? 0 : 1;
+    }
+    if (pending == 0)
+    {
+        return count - 1;
+    }
+
+    SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_BEGIN, "fences", count);
+    if (device->device1)
+    {
+        HANDLE eventHandle = acquireEvent(device);
+        D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags = waitAll ? D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL : D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY;
+        DX_CHECK(device->device1->SetEventOnMultipleFenceCompletion(handles, values, count, flags, eventHandle));
+        WaitForSingleObject(eventHandle, INFINITE);
+        releaseEvent(device, eventHandle);
+    }
+    else if (waitAll)
+    {
+        for (uint32 i = 0; i < count; i++)
+        {
+            d3d12FenceWait(fences[i], values[i]);
+        }
+    }
+    else
+    {
+        HANDLE events[RHI_MAX_WAIT_FENCES];
+        for (uint32 i = 0; i < count; i++)
+        {
+            events[i] = acquireEvent(device);
+            DX_CHECK(handles[i]->SetEventOnCompletion(values[i], events[i]));
+        }
+        DWORD signalled = WaitForMultipleObjects(count, events, FALSE, INFINITE) - WAIT_OBJECT_0;
+        for (uint32 i = 0; i < count; i++)
+        {
+            // The others stay armed and would wake a later wait
+            if (i == signalled)
+            {
+                releaseEvent(device, events[i]);
+            }
+            else
+            {
+                CloseHandle(events[i]);
+            }
+        }
+    }
+    SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_END, "fences", count);
+
+    for (uint32 i = 0; i < count; i++)
+    {
+        if (handles[i]->GetCompletedValue() >= values[i] && !waitAll)
+        {
+            return i;
+        }
+    }
+    return count - 1;
+}
+
+// Thread pool callback. Takes no locks, so unregistering the wait under one can't deadlock.
+static VOID CALLBACK d3d12FenceCallbackFired(PVOID context, BOOLEAN timedOut)
+{
+    D3D12FenceCallback* entry = (D3D12FenceCallback*)context;
+    entry->callback(entry->value, entry->userData);
+    InterlockedExchange(&entry->fired, 1);
+}
+
+static void d3d12FenceOnComplete(RhiFence* rhiFence, uint64 value, PFN_rhiFenceCallback callback, void* userData)
+{
+    D3D12Fence* fence = (D3D12Fence*)rhiFence;
+    D3D12Device* device = (D3D12Device*)fence->device;
+    if (fence->handle->GetCompletedValue() >= value)
+    {
+        callback(value, userData);
+        return;
+    }
+
+    D3D12FenceCallback* entry = new D3D12FenceCallback();
+    entry->value = value;
+    entry->callback = callback;
+    entry->userData = userData;
+    entry->event = acquireEvent(device);
+    entry->fired = 0;
+    DX_CHECK(fence->handle->SetEventOnCompletion(value, entry->event));
+
+    D3D12FenceCallback* reclaim = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(fence->callbackMutex);
+        if (!RegisterWaitForSingleObject(&entry->wait, entry->event, d3d12FenceCallbackFired, entry, INFINITE, WT_EXECUTEONLYONCE))
+        {
+            SGSERROR_CAT(LOG_CATEGORY_RENDER, "RegisterWaitForSingleObject failed (%lu), fence callback dropped", GetLastError());
+            CloseHandle(entry->event);
+            delete entry;
+            return;
+        }
+        entry->next = fence->callbacks;
+        fence->callbacks = entry;
+
+        // Unlink the fired ones here, free them outside the lock
+        D3D12FenceCallback** link = &fence->callbacks;
+        while (*link)
+        {
+            D3D12FenceCallback* current = *link;
+            if (current->fired)
+            {
+                *link = current->next;
+                current->next = reclaim;
+                reclaim = current;
+            }
+            else
+            {
+                link = &current->next;
+            }
+        }
+    }
+    while (reclaim)
+    {
+        D3D12FenceCallback* next = reclaim->next;
+        freeCallback(device, reclaim);
+        reclaim = next;
+    }
+}
+
+// Command allocators and lists
+
+static RhiCommandAllocator* d3d12CreateCommandAllocator(RhiDevice* rhiDevice, e_rhiQueueType type, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12CommandAllocator* allocator = new D3D12CommandAllocator();
+    allocator->device = device;
+    allocator->type = type;
+    if (FAILED(device->device->CreateCommandAllocator(toCommandListType(type), IID_PPV_ARGS(allocator->handle.GetAddressOf()))))
+    {
+        delete allocator;
+        return nullptr;
+    }
+    setName(allocator->handle.Get(), name);
+    return allocator;
+}
+
+static void d3d12DestroyCommandAllocator(RhiCommandAllocator* allocator)
+{
+    delete (D3D12CommandAllocator*)allocator;
+}
+
+static void d3d12ResetCommandAllocator(RhiCommandAllocator* allocator)
+{
+    DX_CHECK(((D3D12CommandAllocator*)allocator)->handle->Reset());
+}
+
+static RhiCommandList* d3d12CreateCommandList(RhiDevice* rhiDevice, e_rhiQueueType type, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+
+    // D3D12 wants an allocator to create a list with; a temporary one does, the list starts closed
+    ComPtr<ID3D12CommandAllocator> allocator;
+    if (FAILED(device->device->CreateCommandAllocator(toCommandListType(type), IID_PPV_ARGS(allocator.GetAddressOf()))))
+    {
+        return nullptr;
+    }
+
+    D3D12CommandList* list = new D3D12CommandList();
+    list->functions = device->functions;
+    list->device = device;
+    list->type = type;
+    list->recording = false;
+    list->computeBound = false;
+    list->tableParameter = 0;
+    list->descriptorHeap = nullptr;
+    if (FAILED(device->device->CreateCommandList(0, toCommandListType(type), allocator.Get(), nullptr,
+        IID_PPV_ARGS(list->handle.GetAddressOf()))))
+    {
+        delete list;
+        return nullptr;
+    }
+    setName(list->handle.Get(), name);
+    list->handle->Close();
+    return list;
+}
+
+static void d3d12DestroyCommandList(RhiCommandList* list)
+{
+    delete (D3D12CommandList*)list;
+}
+
+static void d3d12BeginCommandList(RhiCommandList* rhiList, RhiCommandAllocator* allocator)
+{
+    D3D12CommandList* list = (D3D12CommandList*)rhiList;
+    DX_CHECK(list->handle->Reset(((D3D12CommandAllocator*)allocator)->handle.Get(), nullptr));
+    list->computeBound = false;
+    list->descriptorHeap = nullptr;
+}
+
+static void d3d12EndCommandList(RhiCommandList* list)
+{
+    DX_CHECK(((D3D12CommandList*)list)->handle->Close());
+}
+
+// Heaps and resources
+
+static RhiHeap* d3d12CreateHeap(RhiDevice* rhiDevice, const RhiHeapDesc& desc, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12_HEAP_DESC heapDescription = {};
+    heapDescription.SizeInBytes = desc.size;
+    heapDescription.Properties = CD3DX12_HEAP_PROPERTIES(toHeapType(desc.type));
+    heapDescription.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+    heapDescription.Flags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+
+    D3D12Heap* heap = new D3D12Heap();
+    heap->device = device;
+    heap->desc = desc;
+    if (FAILED(device->device->CreateHeap(&heapDescription, IID_PPV_ARGS(heap->handle.GetAddressOf()))))
+    {
+        delete heap;
+        return nullptr;
+    }
+    setName(heap->handle.Get(), name);
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "heap", desc.size);
+    return heap;
+}
+
+static void d3d12DestroyHeap(RhiHeap* heap)
+{
+    delete (D3D12Heap*)heap;
+}
+
+static void d3d12AllocationInfo(RhiDevice* rhiDevice, const RhiResourceDesc& desc, uint64* size, uint64* alignment)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12_RESOURCE_DESC resourceDescription = toResourceDesc(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO info = device->device->GetResourceAllocationInfo(0, 1, &resourceDescription);
+    *size = info.SizeInBytes;
+    *alignment = info.Alignment;
+}
+
+static void d3d12CopyableFootprint(RhiDevice* rhiDevice, const RhiResourceDesc& desc, uint32* rowPitch, uint64* totalBytes)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12_RESOURCE_DESC resourceDescription = toResourceDesc(desc);
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+    device->device->GetCopyableFootprints(&resourceDescription, 0, 1, 0, &footprint, nullptr, nullptr, totalBytes);
+    *rowPitch = footprint.Footprint.RowPitch;
+}
+
+// Clear value and views for render targets and depth buffers
+static bool finishResource(D3D12Device* device, D3D12Resource* resource, const char* name)
+{
+    setName(resource->handle.Get(), name);
+    resource->rtv = D3D12_NO_DESCRIPTOR;
+    resource->dsv = D3D12_NO_DESCRIPTOR;
+    if (resource->desc.flags & RHI_RESOURCE_FLAG_RENDER_TARGET)
+    {
+        resource->rtv = allocateDescriptor(&device->rtvPool);
+        if (resource->rtv == D3D12_NO_DESCRIPTOR)
+        {
+            return false;
+        }
+        device->device->CreateRenderTargetView(resource->handle.Get(), nullptr, descriptorHandle(&device->rtvPool, resource->rtv));
+    }
+    if (resource->desc.flags & RHI_RESOURCE_FLAG_DEPTH_STENCIL)
+    {
+        resource->dsv = allocateDescriptor(&device->dsvPool);
+        if (resource->dsv == D3D12_NO_DESCRIPTOR)
+        {
+            return false;
+        }
+        device->device->CreateDepthStencilView(resource->handle.Get(), nullptr, descriptorHandle(&device->dsvPool, resource->dsv));
+    }
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "resource", resource->desc.width * resource->desc.height);
+    return true;
+}
+
+static const D3D12_CLEAR_VALUE* optimizedClearValue(const RhiResourceDesc& desc, D3D12_CLEAR_VALUE* clearValue)
+{
+    clearValue->Format = toDxgiFormat(desc.format);
+    if (desc.flags & RHI_RESOURCE_FLAG_DEPTH_STENCIL)
+    {
+        clearValue->DepthStencil.Depth = desc.clearValue[0];
+        clearValue->DepthStencil.Stencil = (uint8)desc.clearValue[1];
+        return clearValue;
+    }
+    if (desc.flags & RHI_RESOURCE_FLAG_RENDER_TARGET)
+    {
+        memcpy(clearValue->Color, desc.clearValue, sizeof(clearValue->Color));
+        return clearValue;
+    }
+    return nullptr;
+}
+
+static void d3d12DestroyResource(RhiResource* rhiResource)
+{
+    D3D12Resource* resource = (D3D12Resource*)rhiResource;
+    D3D12Device* device = (D3D12Device*)resource->device;
+    freeDescriptor(&device->rtvPool, resource->rtv);
+    freeDescriptor(&device->dsvPool, resource->dsv);
+    delete resource;
+}
+
+static RhiResource* d3d12CreateCommittedResource(RhiDevice* rhiDevice, e_rhiHeapType heapType, const RhiResourceDesc& desc, uint32 initialState, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12Resource* resource = new D3D12Resource();
+    resource->device = device;
+    resource->desc = desc;
+    resource->heapType = heapType;
+
+    CD3DX12_HEAP_PROPERTIES heapProperties(toHeapType(heapType));
+    D3D12_RESOURCE_DESC resourceDescription = toResourceDesc(desc);
+    D3D12_CLEAR_VALUE clearValue = {};
+    if (FAILED(device->device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDescription,
+        (D3D12_RESOURCE_STATES)initialState,
+        optimizedClearValue(desc, &clearValue),
+        IID_PPV_ARGS(resource->handle.GetAddressOf()))))
+    {
+        delete resource;
+        return nullptr;
+    }
+    if (!finishResource(device, resource, name))
+    {
+        d3d12DestroyResource(resource);
+        return nullptr;
+    }
+    return resource;
+}
+
+static RhiResource* d3d12CreatePlacedResource(RhiDevice* rhiDevice, RhiHeap* heap, uint64 offset, const RhiResourceDesc& desc, uint32 initialState, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12Resource* resource = new D3D12Resource();
+    resource->device = device;
+    resource->desc = desc;
+    resource->heapType = heap->desc.type;
+    resource->heap = heap;
+
+    D3D12_RESOURCE_DESC resourceDescription = toResourceDesc(desc);
+    D3D12_CLEAR_VALUE clearValue = {};
+    if (FAILED(device->device->CreatePlacedResource(
+        ((D3D12Heap*)heap)->handle.Get(),
+        offset,
+        &resourceDescription,
+        (D3D12_RESOURCE_STATES)initialState,
+        optimizedClearValue(desc, &clearValue),
+        IID_PPV_ARGS(resource->handle.GetAddressOf()))))
+    {
+        delete resource;
+        return nullptr;
+    }
+    if (!finishResource(device, resource, name))
+    {
+        d3d12DestroyResource(resource);
+        return nullptr;
+    }
+    return resource;
+}
+
+static void* d3d12MapResource(RhiResource* rhiResource)
+{
+    D3D12Resource* resource = (D3D12Resource*)rhiResource;
+    // Upload buffers are only written, don't let the CPU cache pretend otherwise
+    D3D12_RANGE nothingRead = { 0, 0 };
+    void* data = nullptr;
+    if (FAILED(resource->handle->Map(0, resource->heapType == RHI_HEAP_UPLOAD ? &nothingRead : nullptr, &data)))
+    {
+        return nullptr;
+    }
+    return data;
+}
+
+static void d3d12UnmapResource(RhiResource* rhiResource)
+{
+    D3D12Resource* resource = (D3D12Resource*)rhiResource;
+    D3D12_RANGE nothingWritten = { 0, 0 };
+    resource->handle->Unmap(0, resource->heapType == RHI_HEAP_READBACK ? &nothingWritten : nullptr);
+}
+
+// Descriptors
+
+static D3D12_DESCRIPTOR_HEAP_TYPE toDescriptorHeapType(e_rhiDescriptorHeapType type)
+{
+    switch (type)
+    {
+        case RHI_DESCRIPTOR_HEAP_RENDER_TARGET: return D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        case RHI_DESCRIPTOR_HEAP_DEPTH_STENCIL: return D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+        default: return D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    }
+}
+
+static RhiDescriptorHeap* d3d12CreateDescriptorHeap(RhiDevice* rhiDevice, const RhiDescriptorHeapDesc& desc, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12_DESCRIPTOR_HEAP_DESC heapDescription = {};
+    heapDescription.NumDescriptors = desc.capacity;
+    heapDescription.Type = toDescriptorHeapType(desc.type);
+    heapDescription.Flags = desc.shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+    D3D12DescriptorHeap* heap = new D3D12DescriptorHeap();
+    heap->device = device;
+    heap->desc = desc;
+    if (FAILED(device->device->CreateDescriptorHeap(&heapDescription, IID_PPV_ARGS(heap->handle.GetAddressOf()))))
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Could not create descriptor heap %s of %u descriptors", name ? name : "", desc.capacity);
+        delete heap;
+        return nullptr;
+    }
+    setName(heap->handle.Get(), name);
+    heap->cpuStart = heap->handle->GetCPUDescriptorHandleForHeapStart();
+    heap->gpuStart = {};
+    if (desc.shaderVisible)
+    {
+        heap->gpuStart = heap->handle->GetGPUDescriptorHandleForHeapStart();
+    }
+    heap->increment = device->device->GetDescriptorHandleIncrementSize(heapDescription.Type);
+    return heap;
+}
+
+static void d3d12DestroyDescriptorHeap(RhiDescriptorHeap* heap)
+{
+    delete (D3D12DescriptorHeap*)heap;
+}
+
+static void d3d12WriteView(RhiDescriptorHeap* rhiHeap, uint32 index, e_rhiViewType type, RhiResource* rhiResource)
+{
+    D3D12DescriptorHeap* heap = (D3D12DescriptorHeap*)rhiHeap;
+    D3D12Device* device = (D3D12Device*)heap->device;
+    ID3D12Resource* resource = ((D3D12Resource*)rhiResource)->handle.Get();
+    CD3DX12_CPU_DESCRIPTOR_HANDLE destination(heap->cpuStart, index, heap->increment);
+    bool buffer = rhiResource->desc.dimension == RHI_RESOURCE_BUFFER;
+    switch (type)
+    {
+        case RHI_VIEW_SHADER_RESOURCE:
+        {
+            if (!buffer)
+            {
+                device->device->CreateShaderResourceView(resource, nullptr, destination);
+                break;
+            }
+            D3D12_SHADER_RESOURCE_VIEW_DESC view = {};
+            view.Format = DXGI_FORMAT_R32_TYPELESS;
+            view.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+            view.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            view.Buffer.NumElements = (UINT)(rhiResource->desc.width / 4);
+            view.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
+            device->device->CreateShaderResourceView(resource, &view, destination);
+        } break;
+
+        case RHI_VIEW_UNORDERED_ACCESS:
+        {
+            if (!buffer)
+            {
+                device->device->CreateUnorderedAccessView(resource, nullptr, nullptr, destination);
+                break;
+            }
+            D3D12_UNORDERED_ACCESS_VIEW_DESC view = {};
+            view.Format = DXGI_FORMAT_R32_TYPELESS;
+            view.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+            view.Buffer.NumElements = (UINT)(rhiResource->desc.width / 4);
+            view.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_RAW;
+            device->device->CreateUnorderedAccessView(resource, nullptr, &view, destination);
+        } break;
+
+        case RHI_VIEW_CONSTANT_BUFFER:
+        {
+            D3D12_CONSTANT_BUFFER_VIEW_DESC view = { resource->GetGPUVirtualAddress(), (UINT)rhiResource->desc.width };
+            device->device->CreateConstantBufferView(&view, destination);
+        } break;
+
+        case RHI_VIEW_RENDER_TARGET:
+        {
+            device->device->CreateRenderTargetView(resource, nullptr, destination);
+        } break;
+
+        case RHI_VIEW_DEPTH_STENCIL:
+        {
+            device->device->CreateDepthStencilView(resource, nullptr, destination);
+        } break;
+
+        default:
+        {
+        } break;
+    }
+}
+
+static void d3d12CopyDescriptors(RhiDevice* rhiDevice, const RhiDescriptorCopy* copies, uint32 count)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12_DESCRIPTOR_HEAP_TYPE type = toDescriptorHeapType(copies[0].destination->desc.type);
+    D3D12_CPU_DESCRIPTOR_HANDLE destinations[D3D12_DESCRIPTOR_COPY_BATCH];
+    D3D12_CPU_DESCRIPTOR_HANDLE sources[D3D12_DESCRIPTOR_COPY_BATCH];
+    UINT sizes[D3D12_DESCRIPTOR_COPY_BATCH];
+    while (count)
+    {
+        uint32 batch = count < D3D12_DESCRIPTOR_COPY_BATCH ? count : D3D12_DESCRIPTOR_COPY_BATCH;
+        for (uint32 i = 0; i < batch; i++)
+        {
+            const D3D12DescriptorHeap* destination = (const D3D12DescriptorHeap*)copies[i].destination;
+            const D3D12DescriptorHeap* source = (const D3D12DescriptorHeap*)copies[i].source;
+            destinations[i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(destination->cpuStart, copies[i].destinationIndex, destination->increment);
+            sources[i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(source->cpuStart, copies[i].sourceIndex, source->increment);
+            sizes[i] = copies[i].count;
+        }
+        device->device->CopyDescriptors(batch, destinations, sizes, batch, sources, sizes, type);
+        copies += batch;
+        count -= batch;
+    }
+}
+
+// Pipelines
+
+static RhiPipeline* d3d12CreatePipeline(RhiDevice* rhiDevice, const RhiPipelineDesc& desc, const char* name)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    bool compute = desc.computeShader != nullptr;
+
+    CD3DX12_ROOT_PARAMETER parameters[2];
+    uint32 parameterCount = 0;
+    if (desc.rootConstantCount)
+    {
+        parameters[parameterCount++].InitAsConstants(desc.rootConstantCount, 0);
+    }
+    // Both ranges cover the whole table from its start, in their own register spaces
+    CD3DX12_DESCRIPTOR_RANGE ranges[2];
+    ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 1, 0);
+    ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, UINT_MAX, 0, 2, 0);
+    uint32 tableParameter = parameterCount;
+    if (desc.descriptorTable)
+    {
+        parameters[parameterCount++].InitAsDescriptorTable(2, ranges);
+    }
+    CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDescription(parameterCount, parameters, 0, nullptr,
+        compute ? D3D12_ROOT_SIGNATURE_FLAG_NONE : D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+    ComPtr<ID3DBlob> serialized;
+    ComPtr<ID3DBlob> errors;
+    if (FAILED(D3D12SerializeRootSignature(&rootSignatureDescription, D3D_ROOT_SIGNATURE_VERSION_1, &serialized, &errors)))
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Root signature of %s: %s", name ? name : "pipeline",
+            errors ? (const char*)errors->GetBufferPointer() : "serialization failed");
+        return nullptr;
+    }
+
+    D3D12Pipeline* pipeline = new D3D12Pipeline();
+    pipeline->device = device;
+    pipeline->compute = compute;
+    pipeline->tableParameter = tableParameter;
+    if (FAILED(device->device->CreateRootSignature(0, serialized->GetBufferPointer(), serialized->GetBufferSize(),
+        IID_PPV_ARGS(pipeline->rootSignature.GetAddressOf()))))
+    {
+        delete pipeline;
+        return nullptr;
+    }
+
+    HRESULT result;
+    if (compute)
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC stateDescription = {};
+        stateDescription.pRootSignature = pipeline->rootSignature.Get();
+        stateDescription.CS = { desc.computeShader, (SIZE_T)desc.computeShaderSize };
+        result = device->device->CreateComputePipelineState(&stateDescription, IID_PPV_ARGS(pipeline->state.GetAddressOf()));
+    }
+    else
+    {
+        D3D12_INPUT_ELEMENT_DESC elements[RHI_MAX_VERTEX_ATTRIBUTES];
+        for (uint32 i = 0; i < desc.attributeCount; i++)
+        {
+            const RhiVertexAttribute& attribute = desc.attributes[i];
+            elements[i] = { attribute.semantic, attribute.semanticIndex, toDxgiFormat(attribute.format), attribute.slot,
+                attribute.offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+        }
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC stateDescription = {};
+        stateDescription.pRootSignature = pipeline->rootSignature.Get();
+        stateDescription.VS = { desc.vertexShader, (SIZE_T)desc.vertexShaderSize };
+        stateDescription.PS = { desc.pixelShader, (SIZE_T)desc.pixelShaderSize };
+        stateDescription.InputLayout = { elements, desc.attributeCount };
+        stateDescription.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+        stateDescription.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+        stateDescription.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+        stateDescription.DepthStencilState.DepthEnable = desc.depthTest && desc.depthFormat != RHI_FORMAT_UNKNOWN;
+        stateDescription.DepthStencilState.DepthWriteMask = desc.depthWrite ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+        stateDescription.SampleMask = UINT_MAX;
+        stateDescription.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        stateDescription.NumRenderTargets = desc.colorCount;
+        for (uint32 i = 0; i < desc.colorCount; i++)
+        {
+            stateDescription.RTVFormats[i] = toDxgiFormat(desc.colorFormats[i]);
+        }
+        stateDescription.DSVFormat = toDxgiFormat(desc.depthFormat);
+        stateDescription.SampleDesc.Count = desc.sampleCount;
+        result = device->device->CreateGraphicsPipelineState(&stateDescription, IID_PPV_ARGS(pipeline->state.GetAddressOf()));
+    }
+
+    if (FAILED(result))
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Could not create pipeline %s", name ? name : "");
+        delete pipeline;
+        return nullptr;
+    }
+    setName(pipeline->state.Get(), name);
+    return pipeline;
+}
+
+static void d3d12DestroyPipeline(RhiPipeline* pipeline)
+{
+    delete (D3D12Pipeline*)pipeline;
+}
+
+// Swapchains
+
+static void releaseSwapChainBuffers(D3D12SwapChain* swapChain)
+{
+    D3D12Device* device = (D3D12Device*)swapChain->device;
+    for (uint32 i = 0; i < swapChain->bufferCount; i++)
+    {
+        D3D12Resource& buffer = swapChain->bufferStorage[i];
+        freeDescriptor(&device->rtvPool, buffer.rtv);
+        buffer.rtv = D3D12_NO_DESCRIPTOR;
+        buffer.handle.Reset();
+    }
+}
+
+static bool acquireSwapChainBuffers(D3D12SwapChain* swapChain)
+{
+    D3D12Device* device = (D3D12Device*)swapChain->device;
+    RhiResourceDesc desc = rhiTexture2DDesc(swapChain->desc.format, swapChain->desc.width, swapChain->desc.height, RHI_RESOURCE_FLAG_RENDER_TARGET);
+    for (uint32 i = 0; i < swapChain->bufferCount; i++)
+    {
+        D3D12Resource& buffer = swapChain->bufferStorage[i];
+        buffer.device = device;
+        buffer.desc = desc;
+        buffer.heapType = RHI_HEAP_DEFAULT;
+        if (FAILED(swapChain->handle->GetBuffer(i, IID_PPV_ARGS(buffer.handle.GetAddressOf()))) ||
+            !finishResource(device, &buffer, "swapchain image"))
+        {
+            return false;
+        }
+        swapChain->buffers[i] = &buffer;
+    }
+    swapChain->currentIndex = swapChain->handle3 ? swapChain->handle3->GetCurrentBackBufferIndex() : 0;
+    return true;
+}
+
+static RhiSwapChain* d3d12CreateSwapChain(RhiDevice* rhiDevice, RhiQueue* queue, const RhiSwapChainDesc& desc)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    D3D12SwapChain* swapChain = new D3D12SwapChain();
+    swapChain->device = device;
+    swapChain->queue = queue;
+    swapChain->desc = desc;
+    swapChain->bufferCount = desc.bufferCount;
+    swapChain->currentIndex = 0;
+
+    // Flip model swapchains can't be multisampled; MSAA renders elsewhere and resolves
+    DXGI_SWAP_CHAIN_DESC swapChainDescription = {};
+    swapChainDescription.BufferDesc.Width = desc.width;
+    swapChainDescription.BufferDesc.Height = desc.height;
+    swapChainDescription.BufferDesc.RefreshRate.Numerator = 60;
+    swapChainDescription.BufferDesc.RefreshRate.Denominator = 1;
+    swapChainDescription.BufferDesc.Format = toDxgiFormat(desc.format);
+    swapChainDescription.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+    swapChainDescription.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+    swapChainDescription.SampleDesc.Count = 1;
+    swapChainDescription.SampleDesc.Quality = 0;
+    swapChainDescription.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapChainDescription.BufferCount = desc.bufferCount;
+    swapChainDescription.OutputWindow = (HWND)desc.window;
+    swapChainDescription.Windowed = true;
+    swapChainDescription.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    swapChainDescription.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+
+    if (FAILED(device->factory->CreateSwapChain(((D3D12Queue*)queue)->handle.Get(), &swapChainDescription,
+        swapChain->handle.GetAddressOf())))
+    {
+        delete swapChain;
+        return nullptr;
+    }
+    swapChain->handle.As(&swapChain->handle3);
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "swapchain", desc.bufferCount);
+
+    for (uint32 i = 0; i < RHI_MAX_SWAPCHAIN_BUFFERS; i++)
+    {
+        swapChain->bufferStorage[i].rtv = D3D12_NO_DESCRIPTOR;
+        swapChain->bufferStorage[i].dsv = D3D12_NO_DESCRIPTOR;
+    }
+    if (!acquireSwapChainBuffers(swapChain))
+    {
+        releaseSwapChainBuffers(swapChain);
+        delete swapChain;
+        return nullptr;
+    }
+    return swapChain;
+}
+
+static void d3d12DestroySwapChain(RhiSwapChain* rhiSwapChain)
+{
+    D3D12SwapChain* swapChain = (D3D12SwapChain*)rhiSwapChain;
+    releaseSwapChainBuffers(swapChain);
+    delete swapChain;
+}
+
+static bool d3d12ResizeSwapChain(RhiSwapChain* rhiSwapChain, uint32 width, uint32 height)
+{
+    D3D12SwapChain* swapChain = (D3D12SwapChain*)rhiSwapChain;
+    releaseSwapChainBuffers(swapChain);
+    swapChain->desc.width = width;
+    swapChain->desc.height = height;
+    DX_CHECK(swapChain->handle->ResizeBuffers(
+        swapChain->bufferCount,
+        width, height,
+        toDxgiFormat(swapChain->desc.format),
+        DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH));
+    return acquireSwapChainBuffers(swapChain);
+}
+
+static void d3d12Present(RhiSwapChain* rhiSwapChain, uint32 syncInterval)
+{
+    D3D12SwapChain* swapChain = (D3D12SwapChain*)rhiSwapChain;
+    swapChain->handle->Present(syncInterval, 0);
+    swapChain->currentIndex = swapChain->handle3 ? swapChain->handle3->GetCurrentBackBufferIndex() :
+        (swapChain->currentIndex + 1) % swapChain->bufferCount;
+}
+
+// Commands
+
+static ID3D12Resource* nativeResource(RhiResource* resource)
+{
+    return resource ? ((D3D12Resource*)resource)->handle.Get() : nullptr;
+}
+
+static void d3d12CmdBarriers(RhiCommandList* list, const RhiBarrier* barriers, uint32 count)
+{
+    D3D12_RESOURCE_BARRIER batch[D3D12_BARRIER_BATCH];
+    while (count)
+    {
+        uint32 batchCount = count < D3D12_BARRIER_BATCH ? count : D3D12_BARRIER_BATCH;
+        for (uint32 i = 0; i < batchCount; i++)
+        {
+            const RhiBarrier& barrier = barriers[i];
+            switch (barrier.type)
+            {
+                case RHI_BARRIER_UAV:
+                {
+                    batch[i] = CD3DX12_RESOURCE_BARRIER::UAV(nativeResource(barrier.resource));
+                } break;
+
+                case RHI_BARRIER_ALIASING:
+                {
+                    batch[i] = CD3DX12_RESOURCE_BARRIER::Aliasing(nativeResource(barrier.resource), nativeResource(barrier.resourceAfter));
+                } break;
+
+                default:
+                {
+                    D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+                    if (barrier.flags & RHI_BARRIER_FLAG_BEGIN_ONLY)
+                    {
+                        flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+                    }
+                    else if (barrier.flags & RHI_BARRIER_FLAG_END_ONLY)
+                    {
+                        flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+                    }
+                    batch[i] = CD3DX12_RESOURCE_BARRIER::Transition(nativeResource(barrier.resource),
+                        (D3D12_RESOURCE_STATES)barrier.before, (D3D12_RESOURCE_STATES)barrier.after, barrier.subresource, flags);
+                } break;
+            }
+        }
+        ((D3D12CommandList*)list)->handle->ResourceBarrier(batchCount, batch);
+        barriers += batchCount;
+        count -= batchCount;
+    }
+}
+
+static void d3d12CmdSetRenderTargets(RhiCommandList* list, RhiResource* const* colors, uint32 colorCount, RhiResource* depthStencil)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE colorViews[RHI_MAX_RENDER_TARGETS];
+    for (uint32 i = 0; i < colorCount; i++)
+    {
+        colorViews[i] = rtvHandle(colors[i]);
+    }
+    D3D12_CPU_DESCRIPTOR_HANDLE depthView;
+    if (depthStencil)
+    {
+        depthView = dsvHandle(depthStencil);
+    }
+    ((D3D12CommandList*)list)->handle->OMSetRenderTargets(colorCount, colorViews, false, depthStencil ? &depthView : nullptr);
+}
+
+static void d3d12CmdClearRenderTarget(RhiCommandList* list, RhiResource* target, const float32 color[4])
+{
+    ((D3D12CommandList*)list)->handle->ClearRenderTargetView(rtvHandle(target), color, 0, nullptr);
+}
+
+static void d3d12CmdClearDepthStencil(RhiCommandList* list, RhiResource* target, float32 depth, uint8 stencil)
+{
+    ((D3D12CommandList*)list)->handle->ClearDepthStencilView(dsvHandle(target), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
+}
+
+static void d3d12CmdSetViewport(RhiCommandList* list, const RhiViewport& viewport)
+{
+    D3D12_VIEWPORT native = { viewport.x, viewport.y, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth };
+    ((D3D12CommandList*)list)->handle->RSSetViewports(1, &native);
+}
+
+static void d3d12CmdSetScissor(RhiCommandList* list, const RhiRect& rect)
+{
+    D3D12_RECT native = { rect.left, rect.top, rect.right, rect.bottom };
+    ((D3D12CommandList*)list)->handle->RSSetScissorRects(1, &native);
+}
+
+static void d3d12CmdSetPipeline(RhiCommandList* rhiList, RhiPipeline* rhiPipeline)
+{
+    D3D12CommandList* list = (D3D12CommandList*)rhiList;
+    D3D12Pipeline* pipeline = (D3D12Pipeline*)rhiPipeline;
+    if (pipeline->compute)
+    {
+        list->handle->SetComputeRootSignature(pipeline->rootSignature.Get());
+    }
+    else
+    {
+        list->handle->SetGraphicsRootSignature(pipeline->rootSignature.Get());
+        list->handle->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+    list->handle->SetPipelineState(pipeline->state.Get());
+    list->computeBound = pipeline->compute;
+    list->tableParameter = pipeline->tableParameter;
+}
+
+static void d3d12CmdSetConstants(RhiCommandList* rhiList, const void* values, uint32 count, uint32 firstValue)
+{
+    D3D12CommandList* list = (D3D12CommandList*)rhiList;
+    if (list->computeBound)
+    {
+        list->handle->SetComputeRoot32BitConstants(0, count, values, firstValue);
+    }
+    else
+    {
+        list->handle->SetGraphicsRoot32BitConstants(0, count, values, firstValue);
+    }
+}
+
+static void d3d12CmdSetDescriptorHeap(RhiCommandList* rhiList, RhiDescriptorHeap* heap)
+{
+    D3D12CommandList* list = (D3D12CommandList*)rhiList;
+    list->descriptorHeap = (D3D12DescriptorHeap*)heap;
+    ID3D12DescriptorHeap* heaps[] = { list->descriptorHeap->handle.Get() };
+    list->handle->SetDescriptorHeaps(1, heaps);
+}
+
+static void d3d12CmdSetDescriptorTable(RhiCommandList* rhiList, uint32 firstDescriptor)
+{
+    D3D12CommandList* list = (D3D12CommandList*)rhiList;
+    SGSASSERT(list->descriptorHeap);
+    CD3DX12_GPU_DESCRIPTOR_HANDLE table(list->descriptorHeap->gpuStart, firstDescriptor, list->descriptorHeap->increment);
+    if (list->computeBound)
+    {
+        list->handle->SetComputeRootDescriptorTable(list->tableParameter, table);
+    }
+    else
+    {
+        list->handle->SetGraphicsRootDescriptorTable(list->tableParameter, table);
+    }
+}
+
+static void d3d12CmdSetVertexBuffer(RhiCommandList* list, uint32 slot, RhiResource* buffer, uint64 offset, uint32 size, uint32 stride)
+{
+    D3D12_VERTEX_BUFFER_VIEW view;
+    view.BufferLocation = nativeResource(buffer)->GetGPUVirtualAddress() + offset;
+    view.SizeInBytes = size;
+    view.StrideInBytes = stride;
+    ((D3D12CommandList*)list)->handle->IASetVertexBuffers(slot, 1, &view);
+}
+
+static void d3d12CmdSetIndexBuffer(RhiCommandList* list, RhiResource* buffer, uint64 offset, uint32 size, e_rhiFormat format)
+{
+    D3D12_INDEX_BUFFER_VIEW view;
+    view.BufferLocation = nativeResource(buffer)->GetGPUVirtualAddress() + offset;
+    view.SizeInBytes = size;
+    view.Format = toDxgiFormat(format);
+    ((D3D12CommandList*)list)->handle->IASetIndexBuffer(&view);
+}
+
+static void d3d12CmdDraw(RhiCommandList* list, uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance)
+{
+    ((D3D12CommandList*)list)->handle->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+static void d3d12CmdDrawIndexed(RhiCommandList* list, uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset, uint32 firstInstance)
+{
+    ((D3D12CommandList*)list)->handle->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+}
+
+static void d3d12CmdDispatch(RhiCommandList* list, uint32 groupsX, uint32 groupsY, uint32 groupsZ)
+{
+    ((D3D12CommandList*)list)->handle->Dispatch(groupsX, groupsY, groupsZ);
+}
+
+static void d3d12CmdCopyBuffer(RhiCommandList* list, RhiResource* destination, uint64 destinationOffset, RhiResource* source, uint64 sourceOffset, uint64 size)
+{
+    ((D3D12CommandList*)list)->handle->CopyBufferRegion(nativeResource(destination), destinationOffset, nativeResource(source), sourceOffset, size);
+}
+
+static void d3d12CmdCopyTextureToBuffer(RhiCommandList* list, RhiResource* buffer, RhiResource* texture)
+{
+    D3D12Device* device = (D3D12Device*)list->device;
+    D3D12_RESOURCE_DESC textureDescription = toResourceDesc(texture->desc);
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+    device->device->GetCopyableFootprints(&textureDescription, 0, 1, 0, &footprint, nullptr, nullptr, nullptr);
+
+    CD3DX12_TEXTURE_COPY_LOCATION destination(nativeResource(buffer), footprint);
+    CD3DX12_TEXTURE_COPY_LOCATION source(nativeResource(texture), 0);
+    ((D3D12CommandList*)list)->handle->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+}
+
+static void d3d12CmdResolve(RhiCommandList* list, RhiResource* destination, RhiResource* source)
+{
+    ((D3D12CommandList*)list)->handle->ResolveSubresource(nativeResource(destination), 0, nativeResource(source), 0,
+        toDxgiFormat(destination->desc.format));
+}
+
+// Device
+
+static void d3d12DestroyDevice(RhiDevice* rhiDevice)
+{
+    D3D12Device* device = (D3D12Device*)rhiDevice;
+    for (uint32 i = 0; i < device->eventPool.count; i++)
+    {
+        CloseHandle(device->eventPool.events[i]);
+    }
+    delete[] device->rtvPool.freeList;
+    delete[] device->dsvPool.freeList;
+    delete device;
+}
+
+static const RhiBackendFunctions d3d12Functions = {
+    d3d12DestroyDevice,
+    d3d12MsaaQualityLevels,
+
+    d3d12QueueSubmit,
+    d3d12QueueSignal,
+    d3d12QueueWait,
+
+    d3d12CreateFence,
+    d3d12DestroyFence,
+    d3d12FenceCompletedValue,
+    d3d12FenceWait,
+    d3d12FenceWaitMany,
+    d3d12FenceOnComplete,
+
+    d3d12CreateCommandAllocator,
+    d3d12DestroyCommandAllocator,
+    d3d12ResetCommandAllocator,
+    d3d12CreateCommandList,
+    d3d12DestroyCommandList,
+    d3d12BeginCommandList,
+    d3d12EndCommandList,
+
+    d3d12CreateHeap,
+    d3d12DestroyHeap,
+    d3d12AllocationInfo,
+    d3d12CopyableFootprint,
+    d3d12CreateCommittedResource,
+    d3d12CreatePlacedResource,
+    d3d12DestroyResource,
+    d3d12MapResource,
+    d3d12UnmapResource,
+
+    d3d12CreateDescriptorHeap,
+    d3d12DestroyDescriptorHeap,
+    d3d12WriteView,
+    d3d12CopyDescriptors,
+
+    d3d12CreatePipeline,
+    d3d12DestroyPipeline,
+
+    d3d12CreateSwapChain,
+    d3d12DestroySwapChain,
+    d3d12ResizeSwapChain,
+    d3d12Present,
+
+    d3d12CmdBarriers,
+    d3d12CmdSetRenderTargets,
+    d3d12CmdClearRenderTarget,
+    d3d12CmdClearDepthStencil,
+    d3d12CmdSetViewport,
+    d3d12CmdSetScissor,
+    d3d12CmdSetPipeline,
+    d3d12CmdSetConstants,
+    d3d12CmdSetDescriptorHeap,
+    d3d12CmdSetDescriptorTable,
+    d3d12CmdSetVertexBuffer,
+    d3d12CmdSetIndexBuffer,
+    d3d12CmdDraw,
+    d3d12CmdDrawIndexed,
+    d3d12CmdDispatch,
+    d3d12CmdCopyBuffer,
+    d3d12CmdCopyTextureToBuffer,
+    d3d12CmdResolve,
+};
+
+RhiDevice* rhiCreateD3D12Device(const RhiDeviceConfig& config)
+{
+    STATIC_ASSERT((uint32)RHI_STATE_RENDER_TARGET == (uint32)D3D12_RESOURCE_STATE_RENDER_TARGET, "RHI states must match D3D12");
+    STATIC_ASSERT((uint32)RHI_STATE_COPY_SOURCE == (uint32)D3D12_RESOURCE_STATE_COPY_SOURCE, "RHI states must match D3D12");
+    STATIC_ASSERT((uint32)RHI_STATE_RESOLVE_SOURCE == (uint32)D3D12_RESOURCE_STATE_RESOLVE_SOURCE, "RHI states must match D3D12");
+    STATIC_ASSERT((uint32)RHI_STATE_GENERIC_READ == (uint32)D3D12_RESOURCE_STATE_GENERIC_READ, "RHI states must match D3D12");
+
+    if (config.debugLayer)
+    {
+        ComPtr<ID3D12Debug> debugController;
+        if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController))))
+        {
+            debugController->EnableDebugLayer();
+        }
+    }
+
+    D3D12Device* device = new D3D12Device();
+    device->functions = &d3d12Functions;
+    device->backend = RHI_BACKEND_D3D12;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&device->factory))))
+    {
+        delete device;
+        return nullptr;
+    }
+
+    // TODO: Enumerate hardware adapters and pick the most suitable one
+    if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device->device))))
+    {
+        SGSWARN_CAT(LOG_CATEGORY_RENDER, "No hardware D3D12 device, falling back to WARP");
+        ComPtr<IDXGIAdapter> warpAdapter;
+        device->factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter));
+        if (FAILED(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device->device))))
+        {
+            delete device;
+            return nullptr;
+        }
+    }
+
+    device->device.As(&device->device1);
+    device->eventPool.count = 0;
+
+    static const char* queueNames[RHI_QUEUE_TYPE_COUNT] = { "direct queue", "compute queue", "copy queue" };
+    for (uint32 i = 0; i < RHI_QUEUE_TYPE_COUNT; i++)
+    {
+        D3D12Queue& queue = device->queueStorage[i];
+        queue.device = device;
+        queue.type = (e_rhiQueueType)i;
+        D3D12_COMMAND_QUEUE_DESC queueDescription = {};
+        queueDescription.Type = toCommandListType((e_rhiQueueType)i);
+        queueDescription.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        if (FAILED(device->device->CreateCommandQueue(&queueDescription, IID_PPV_ARGS(queue.handle.GetAddressOf()))))
+        {
+            d3d12DestroyDevice(device);
+            return nullptr;
+        }
+        setName(queue.handle.Get(), queueNames[i]);
+        device->queues[i] = &queue;
+    }
+
+    if (!initializeDescriptorPool(device->device.Get(), &device->rtvPool, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_RTV_POOL_SIZE) ||
+        !initializeDescriptorPool(device->device.Get(), &device->dsvPool, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, D3D12_DSV_POOL_SIZE))
+    {
+        d3d12DestroyDevice(device);
+        return nullptr;
+    }
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "d3d12 device", 0);
+    return device;
+}
+
+#else
+
+RhiDevice* rhiCreateD3D12Device(const RhiDeviceConfig& config)
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,1275 @@
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "rhi_backend.h"
+#include "assertions.h"
+#include "flight_recorder.h"
+#include "logger.h"
+#include "timeline_fence.h"
+
+// Null backend. Commands are appended to their allocator's memory as an 8 byte header and a
+// payload padded to 8 bytes, 24 bytes for a draw. A submission is replayed on the submitting
+// thread: the replay applies what the CPU can observe (buffer copies, clear colors read back
+// through copies, resource states) and adds up the modeled GPU cost. Fences complete when the
+// modeled GPU reaches them on the wall clock, so waits take as long as the modeled work: each
+// device runs a completion thread that signals the fences' timelines at those times, and waits
+// and callbacks are the timeline fence's.
+
+// Outstanding signals per fence; a signal beyond this waits for the oldest to complete
+#define NULL_FENCE_MAX_PENDING 256
+#define NULL_MAX_PRESENTS_QUEUED 16
+#define NULL_PLACEMENT_ALIGNMENT (64 * 1024)
+#define NULL_MSAA_PLACEMENT_ALIGNMENT (4 * 1024 * 1024)
+#define NULL_ROW_PITCH_ALIGNMENT 256
+
+typedef enum e_nullCommandType {
+    NULL_COMMAND_BARRIERS = 0,
+    NULL_COMMAND_SET_RENDER_TARGETS = 1,
+    NULL_COMMAND_CLEAR_RENDER_TARGET = 2,
+    NULL_COMMAND_CLEAR_DEPTH_STENCIL = 3,
+    NULL_COMMAND_SET_VIEWPORT = 4,
+    NULL_COMMAND_SET_SCISSOR = 5,
+    NULL_COMMAND_SET_PIPELINE = 6,
+    NULL_COMMAND_SET_CONSTANTS = 7,
+    NULL_COMMAND_SET_VERTEX_BUFFER = 8,
+    NULL_COMMAND_SET_INDEX_BUFFER = 9,
+    NULL_COMMAND_DRAW = 10,
+    NULL_COMMAND_DRAW_INDEXED = 11,
+    NULL_COMMAND_DISPATCH = 12,
+    NULL_COMMAND_COPY_BUFFER = 13,
+    NULL_COMMAND_COPY_TEXTURE_TO_BUFFER = 14,
+    NULL_COMMAND_RESOLVE = 15,
+    NULL_COMMAND_SET_DESCRIPTOR_HEAP = 16,
+    NULL_COMMAND_SET_DESCRIPTOR_TABLE = 17
+}e_nullCommandType;
+
+struct NullCommandHeader
+{
+    uint16 type;
+    uint16 size;                    // header included
+    uint32 count;                   // array length of variable sized commands
+};
+
+struct NullBarrierRecord
+{
+    RhiResource* resource;
+    RhiResource* resourceAfter;
+    uint32 type;
+    uint32 subresource;
+    uint32 before;
+    uint32 after;
+    uint32 flags;
+};
+
+struct NullClearRecord
+{
+    RhiResource* target;
+    float32 values[4];
+};
+
+struct NullVertexBufferRecord
+{
+    RhiResource* buffer;
+    uint64 offset;
+    uint32 slot;
+    uint32 size;
+    uint32 stride;
+    uint32 reserved;
+};
+
+struct NullIndexBufferRecord
+{
+    RhiResource* buffer;
+    uint64 offset;
+    uint32 size;
+    uint32 format;
+};
+
+struct NullDrawRecord
+{
+    uint32 count;
+    uint32 instanceCount;
+    uint32 first;
+    int32 vertexOffset;
+    uint32 firstInstance;
+    uint32 reserved;
+};
+
+struct NullCopyRecord
+{
+    RhiResource* destination;
+    RhiResource* source;
+    uint64 destinationOffset;
+    uint64 sourceOffset;
+    uint64 size;
+};
+
+// The largest barrier batch that fits one command
+#define NULL_MAX_BARRIERS_PER_COMMAND ((0xffff - sizeof(NullCommandHeader)) / sizeof(NullBarrierRecord))
+
+struct NullQueue : RhiQueue
+{
+    int64 busyUntil;                // modeled GPU time the queue's last work finishes
+};
+
+struct NullFence;
+
+struct NullDevice : RhiDevice
+{
+    RhiNullConfig config;
+    NullQueue queueStorage[RHI_QUEUE_TYPE_COUNT];
+    int64 origin;                   // vblanks are multiples of the interval from here
+
+    // Held while replaying, signalling and presenting: the modeled GPU runs one thing at a time
+    std::mutex timelineMutex;
+    RhiNullStats stats;
+
+    // Guards the fence list, every fence's pending signals and the completion thread's state
+    std::mutex fenceMutex;
+    std::condition_variable fencesChanged;
+    std::condition_variable retired;
+    NullFence* fences;
+    bool retiring;                  // the completion thread signals timelines outside fenceMutex
+    bool stopping;
+    std::thread completionThread;
+};
+
+struct NullFenceSignal
+{
+    uint64 value;
+    int64 time;
+};
+
+struct NullFence : RhiFence
+{
+    TimelineFence timeline;
+    uint64 lastSignalled;
+    NullFenceSignal pending[NULL_FENCE_MAX_PENDING];
+    uint32 pendingHead;
+    uint32 pendingCount;
+    NullFence* next;
+};
+
+struct NullCommandList;
+
+struct NullCommandAllocator : RhiCommandAllocator
+{
+    uint8* memory;
+    uint64 size;
+    uint64 capacity;
+};
+
+struct NullCommandList : RhiCommandList
+{
+    NullCommandAllocator* allocator;
+    uint64 begin;
+    uint64 end;
+    uint32 commandCount;
+};
+
+struct NullHeap : RhiHeap
+{
+    uint8* memory;                  // only allocated once a buffer is placed in the heap
+};
+
+struct NullResource : RhiResource
+{
+    uint8* memory;                  // buffers only
+    bool ownsMemory;
+    // State of every subresource as the modeled GPU sees it, checked against barriers
+    uint32* states;
+    // What the last clear or resolve left in the texture, copies read this back
+    float32 contents[4];
+};
+
+// What a view was written for, so copies move something observable
+struct NullDescriptor
+{
+    RhiResource* resource;
+    e_rhiViewType type;             // RHI_VIEW_TYPE_COUNT for never written
+};
+
+struct NullDescriptorHeap : RhiDescriptorHeap
+{
+    NullDescriptor* descriptors;
+};
+
+struct NullPipeline : RhiPipeline
+{
+};
+
+struct NullSwapChain : RhiSwapChain
+{
+    RhiSwapChainDesc desc;
+    int64 presentTimes[NULL_MAX_PRESENTS_QUEUED];
+    uint64 presentCount;
+};
+
+static int64 nowNanoseconds()
+{
+    using namespace std::chrono;
+    return (int64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void sleepUntil(int64 time)
+{
+    int64 remaining = time - nowNanoseconds();
+    if (remaining > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining));
+    }
+}
+
+static uint64 alignUp(uint64 value, uint64 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static uint32 nullMsaaQualityLevels(RhiDevice* device, e_rhiFormat format, uint32 sampleCount)
+{
+    bool supported = rhiFormatBytesPerPixel(format) > 0 &&
+        (sampleCount == 1 || sampleCount == 2 || sampleCount == 4 || sampleCount == 8);
+    return supported ? 1 : 0;
+}
+
+// Fences
+
+// Called with fenceMutex held. Pops the signals of fence that are due and returns the highest.
+static uint64 popDueSignals(NullFence* fence, int64 now)
+{
+    uint64 value = 0;
+    while (fence->pendingCount && fence->pending[fence->pendingHead].time <= now)
+    {
+        value = fence->pending[fence->pendingHead].value;
+        fence->pendingHead = (fence->pendingHead + 1) % NULL_FENCE_MAX_PENDING;
+        fence->pendingCount--;
+    }
+    return value;
+}
+
+// Lets a caller that polls or waits see completions without waiting for the completion thread
+static void retireDueSignals(NullFence* fence)
+{
+    NullDevice* device = (NullDevice*)fence->device;
+    uint64 value;
+    {
+        std::lock_guard<std::mutex> lock(device->fenceMutex);
+        value = popDueSignals(fence, nowNanoseconds());
+    }
+    if (value)
+    {
+        timelineFenceSignal(&fence->timeline, value);
+    }
+}
+
+struct NullRetirement
+{
+    NullFence* fence;
+    uint64 value;
+};
+
+// Signals every fence's timeline when the modeled GPU reaches it
+static void nullCompletionThread(NullDevice* device)
+{
+    const uint32 batchSize = 64;
+    NullRetirement due[batchSize];
+    std::unique_lock<std::mutex> lock(device->fenceMutex);
+    while (!device->stopping)
+    {
+        int64 now = nowNanoseconds();
+        int64 earliest = INT64_MAX;
+        uint32 dueCount = 0;
+        for (NullFence* fence = device->fences; fence && dueCount < batchSize; fence = fence->next)
+        {
+            uint64 value = popDueSignals(fence, now);
+            if (value)
+            {
+                due[dueCount++] = { fence, value };
+            }
+            if (fence->pendingCount && fence->pending[fence->pendingHead].time < earliest)
+            {
+                earliest = fence->pending[fence->pendingHead].time;
+            }
+        }
+
+        if (dueCount)
+        {
+            // Callbacks run from here and may signal fences, which takes fenceMutex
+            device->retiring = true;
+            lock.unlock();
+            for (uint32 i = 0; i < dueCount; i++)
+            {
+                timelineFenceSignal(&due[i].fence->timeline, due[i].value);
+            }
+            lock.lock();
+            device->retiring = false;
+            device->retired.notify_all();
+        }
+        else if (earliest == INT64_MAX)
+        {
+            device->fencesChanged.wait(lock);
+        }
+        else
+        {
+            device->fencesChanged.wait_for(lock, std::chrono::nanoseconds(earliest - now));
+        }
+    }
+}
+
+static RhiFence* nullCreateFence(RhiDevice* rhiDevice, uint64 initialValue, const char* name)
+{
+    NullDevice* device = (NullDevice*)rhiDevice;
+    NullFence* fence = new NullFence();
+    fence->device = device;
+    timelineFenceInitialize(&fence->timeline, initialValue);
+    fence->lastSignalled = initialValue;
+    fence->pendingHead = 0;
+    fence->pendingCount = 0;
+
+    std::lock_guard<std::mutex> lock(device->fenceMutex);
+    fence->next = device->fences;
+    device->fences = fence;
+    return fence;
+}
+
+static void nullDestroyFence(RhiFence* rhiFence)
+{
+    NullFence* fence = (NullFence*)rhiFence;
+    NullDevice* device = (NullDevice*)fence->device;
+    {
+        std::unique_lock<std::mutex> lock(device->fenceMutex);
+        // The completion thread may hold this fence in its batch
+        device->retired.wait(lock, [device]() { return !device->retiring; });
+        NullFence** link = &device->fences;
+        while (*link != fence)
+        {
+            link = &(*link)->next;
+        }
+        *link = fence->next;
+    }
+    timelineFenceShutdown(&fence->timeline);
+    delete fence;
+}
+
+static uint64 nullFenceCompletedValue(RhiFence* rhiFence)
+{
+    NullFence* fence = (NullFence*)rhiFence;
+    retireDueSignals(fence);
+    return timelineFenceCompletedValue(&fence->timeline);
+}
+
+static void nullFenceWait(RhiFence* rhiFence, uint64 value)
+{
+    NullFence* fence = (NullFence*)rhiFence;
+    retireDueSignals(fence);
+    if (!timelineFenceIsComplete(&fence->timeline, value))
+    {
+        SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_BEGIN, "fence", value);
+        timelineFenceWait(&fence->timeline, value);
+        SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_END, "fence", value);
+    }
+}
+
+static uint32 nullFenceWaitMany(RhiFence* const* fences, const uint64* values, uint32 count, bool waitAll)
+{
+    TimelineFence* timelines[RHI_MAX_WAIT_FENCES];
+    for (uint32 i = 0; i < count; i++)
+    {
+        retireDueSignals((NullFence*)fences[i]);
+        timelines[i] = &((NullFence*)fences[i])->timeline;
+    }
+    SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_BEGIN, "fences", count);
+    int32 index = timelineFenceWaitMany(timelines, values, count, waitAll);
+    SGSRECORD(FLIGHT_EVENT_FENCE_WAIT_END, "fences", count);
+    return (uint32)index;
+}
+
+static void nullFenceOnComplete(RhiFence* rhiFence, uint64 value, PFN_rhiFenceCallback callback, void* userData)
+{
+    NullFence* fence = (NullFence*)rhiFence;
+    retireDueSignals(fence);
+    timelineFenceOnComplete(&fence->timeline, value, callback, userData);
+}
+
+// Completion time of value on the modeled GPU, or -1 if nothing signals it yet
+static int64 fenceValueTime(NullFence* fence, uint64 value)
+{
+    if (timelineFenceIsComplete(&fence->timeline, value))
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(((NullDevice*)fence->device)->fenceMutex);
+    for (uint32 i = 0; i < fence->pendingCount; i++)
+    {
+        const NullFenceSignal& signal = fence->pending[(fence->pendingHead + i) % NULL_FENCE_MAX_PENDING];
+        if (signal.value >= value)
+        {
+            return signal.time;
+        }
+    }
+    // Popped by a retirement that hasn't reached the timeline yet: it is in the past
+    return value <= fence->lastSignalled ? 0 : -1;
+}
+
+static void nullQueueSignal(RhiQueue* rhiQueue, RhiFence* rhiFence, uint64 value)
+{
+    NullQueue* queue = (NullQueue*)rhiQueue;
+    NullFence* fence = (NullFence*)rhiFence;
+    NullDevice* device = (NullDevice*)queue->device;
+
+    int64 time;
+    {
+        std::lock_guard<std::mutex> timelineLock(device->timelineMutex);
+        int64 now = nowNanoseconds();
+        time = queue->busyUntil > now ? queue->busyUntil : now;
+    }
+
+    std::unique_lock<std::mutex> lock(device->fenceMutex);
+    if (value <= fence->lastSignalled)
+    {
+        SGSWARN_CAT(LOG_CATEGORY_RENDER, "Null fence signalled with %llu after %llu, ignored",
+            (unsigned long long)value, (unsigned long long)fence->lastSignalled);
+        return;
+    }
+    fence->lastSignalled = value;
+
+    // An idle queue reaches the signal right away
+    if (fence->pendingCount == 0 && time <= nowNanoseconds())
+    {
+        lock.unlock();
+        timelineFenceSignal(&fence->timeline, value);
+        return;
+    }
+
+    while (fence->pendingCount == NULL_FENCE_MAX_PENDING)
+    {
+        uint64 oldest = fence->pending[fence->pendingHead].value;
+        lock.unlock();
+        timelineFenceWait(&fence->timeline, oldest);
+        lock.lock();
+    }
+    NullFenceSignal& signal = fence->pending[(fence->pendingHead + fence->pendingCount) % NULL_FENCE_MAX_PENDING];
+    signal.value = value;
+    signal.time = time;
+    fence->pendingCount++;
+    lock.unlock();
+    device->fencesChanged.notify_one();
+}
+
+static void nullQueueWait(RhiQueue* rhiQueue, RhiFence* rhiFence, uint64 value)
+{
+    NullQueue* queue = (NullQueue*)rhiQueue;
+    NullDevice* device = (NullDevice*)queue->device;
+    int64 time = fenceValueTime((NullFence*)rhiFence, value);
+    if (time < 0)
+    {
+        // A real queue would stall until someone signals; the model can't see the future
+        SGSWARN_CAT(LOG_CATEGORY_RENDER, "Null queue waits on fence value %llu that nothing signals yet", (unsigned long long)value);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(device->timelineMutex);
+    if (time > queue->busyUntil)
+    {
+        queue->busyUntil = time;
+    }
+}
+
+// Command recording
+
+static void nullGrowAllocator(NullCommandAllocator* allocator, uint64 required)
+{
+    uint64 capacity = allocator->capacity ? allocator->capacity * 2 : 64 * 1024;
+    while (capacity < required)
+    {
+        capacity *= 2;
+    }
+    uint8* memory = new uint8[capacity];
+    if (allocator->size)
+    {
+        memcpy(memory, allocator->memory, allocator->size);
+    }
+    delete[] allocator->memory;
+    allocator->memory = memory;
+    allocator->capacity = capacity;
+}
+
+// Returns where the payload goes
+static inline uint8* nullAppend(NullCommandList* list, uint16 type, uint32 payloadSize, uint32 count)
+{
+    NullCommandAllocator* allocator = list->allocator;
+    uint32 size = (uint32)(sizeof(NullCommandHeader) + alignUp(payloadSize, 8));
+    if (SGS_UNLIKELY(allocator->size + size > allocator->capacity))
+    {
+        nullGrowAllocator(allocator, allocator->size + size);
+    }
+
+    uint8* command = allocator->memory + allocator->size;
+    NullCommandHeader header = { type, (uint16)size, count };
+    memcpy(command, &header, sizeof(header));
+    allocator->size += size;
+    list->commandCount++;
+    return command + sizeof(NullCommandHeader);
+}
+
+template <typename T>
+static inline void nullRecord(RhiCommandList* list, uint16 type, const T& payload)
+{
+    memcpy(nullAppend((NullCommandList*)list, type, sizeof(T), 1), &payload, sizeof(T));
+}
+
+static RhiCommandAllocator* nullCreateCommandAllocator(RhiDevice* device, e_rhiQueueType type, const char* name)
+{
+    NullCommandAllocator* allocator = new NullCommandAllocator();
+    allocator->device = device;
+    allocator->type = type;
+    allocator->memory = nullptr;
+    allocator->size = 0;
+    allocator->capacity = 0;
+    return allocator;
+}
+
+static void nullDestroyCommandAllocator(RhiCommandAllocator* rhiAllocator)
+{
+    NullCommandAllocator* allocator = (NullCommandAllocator*)rhiAllocator;
+    delete[] allocator->memory;
+    delete allocator;
+}
+
+static void nullResetCommandAllocator(RhiCommandAllocator* allocator)
+{
+    ((NullCommandAllocator*)allocator)->size = 0;
+}
+
+static RhiCommandList* nullCreateCommandList(RhiDevice* device, e_rhiQueueType type, const char* name)
+{
+    NullCommandList* list = new NullCommandList();
+    list->functions = device->functions;
+    list->device = device;
+    list->type = type;
+    list->recording = false;
+    list->allocator = nullptr;
+    list->begin = 0;
+    list->end = 0;
+    list->commandCount = 0;
+    return list;
+}
+
+static void nullDestroyCommandList(RhiCommandList* list)
+{
+    delete (NullCommandList*)list;
+}
+
+static void nullBeginCommandList(RhiCommandList* rhiList, RhiCommandAllocator* allocator)
+{
+    NullCommandList* list = (NullCommandList*)rhiList;
+    list->allocator = (NullCommandAllocator*)allocator;
+    list->begin = list->allocator->size;
+    list->end = list->begin;
+    list->commandCount = 0;
+}
+
+static void nullEndCommandList(RhiCommandList* rhiList)
+{
+    NullCommandList* list = (NullCommandList*)rhiList;
+    list->end = list->allocator->size;
+}
+
+static void nullCmdBarriers(RhiCommandList* list, const RhiBarrier* barriers, uint32 count)
+{
+    while (count)
+    {
+        uint32 batch = count < NULL_MAX_BARRIERS_PER_COMMAND ? count : (uint32)NULL_MAX_BARRIERS_PER_COMMAND;
+        uint8* payload = nullAppend((NullCommandList*)list, NULL_COMMAND_BARRIERS, batch * sizeof(NullBarrierRecord), batch);
+        for (uint32 i = 0; i < batch; i++)
+        {
+            NullBarrierRecord record = { barriers[i].resource, barriers[i].resourceAfter, (uint32)barriers[i].type,
+                barriers[i].subresource, barriers[i].before, barriers[i].after, barriers[i].flags };
+            memcpy(payload + i * sizeof(record), &record, sizeof(record));
+        }
+        barriers += batch;
+        count -= batch;
+    }
+}
+
+static void nullCmdSetRenderTargets(RhiCommandList* list, RhiResource* const* colors, uint32 colorCount, RhiResource* depthStencil)
+{
+    uint8* payload = nullAppend((NullCommandList*)list, NULL_COMMAND_SET_RENDER_TARGETS, (colorCount + 1) * sizeof(RhiResource*), colorCount);
+    memcpy(payload, &depthStencil, sizeof(depthStencil));
+    if (colorCount)
+    {
+        memcpy(payload + sizeof(depthStencil), colors, colorCount * sizeof(RhiResource*));
+    }
+}
+
+static void nullCmdClearRenderTarget(RhiCommandList* list, RhiResource* target, const float32 color[4])
+{
+    NullClearRecord record = { target, { color[0], color[1], color[2], color[3] } };
+    nullRecord(list, NULL_COMMAND_CLEAR_RENDER_TARGET, record);
+}
+
+static void nullCmdClearDepthStencil(RhiCommandList* list, RhiResource* target, float32 depth, uint8 stencil)
+{
+    NullClearRecord record = { target, { depth, (float32)stencil, 0.0f, 0.0f } };
+    nullRecord(list, NULL_COMMAND_CLEAR_DEPTH_STENCIL, record);
+}
+
+static void nullCmdSetViewport(RhiCommandList* list, const RhiViewport& viewport)
+{
+    nullRecord(list, NULL_COMMAND_SET_VIEWPORT, viewport);
+}
+
+static void nullCmdSetScissor(RhiCommandList* list, const RhiRect& rect)
+{
+    nullRecord(list, NULL_COMMAND_SET_SCISSOR, rect);
+}
+
+static void nullCmdSetPipeline(RhiCommandList* list, RhiPipeline* pipeline)
+{
+    nullRecord(list, NULL_COMMAND_SET_PIPELINE, pipeline);
+}
+
+static void nullCmdSetConstants(RhiCommandList* list, const void* values, uint32 count, uint32 firstValue)
+{
+    uint8* payload = nullAppend((NullCommandList*)list, NULL_COMMAND_SET_CONSTANTS, (count + 1) * sizeof(uint32), count);
+    memcpy(payload, &firstValue, sizeof(firstValue));
+    memcpy(payload + sizeof(firstValue), values, count * sizeof(uint32));
+}
+
+static void nullCmdSetDescriptorHeap(RhiCommandList* list, RhiDescriptorHeap* heap)
+{
+    nullRecord(list, NULL_COMMAND_SET_DESCRIPTOR_HEAP, heap);
+}
+
+static void nullCmdSetDescriptorTable(RhiCommandList* list, uint32 firstDescriptor)
+{
+    nullRecord(list, NULL_COMMAND_SET_DESCRIPTOR_TABLE, firstDescriptor);
+}
+
+static void nullCmdSetVertexBuffer(RhiCommandList* list, uint32 slot, RhiResource* buffer, uint64 offset, uint32 size, uint32 stride)
+{
+    NullVertexBufferRecord record = { buffer, offset, slot, size, stride, 0 };
+    nullRecord(list, NULL_COMMAND_SET_VERTEX_BUFFER, record);
+}
+
+static void nullCmdSetIndexBuffer(RhiCommandList* list, RhiResource* buffer, uint64 offset, uint32 size, e_rhiFormat format)
+{
+    NullIndexBufferRecord record = { buffer, offset, size, (uint32)format };
+    nullRecord(list, NULL_COMMAND_SET_INDEX_BUFFER, record);
+}
+
+static void nullCmdDraw(RhiCommandList* list, uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance)
+{
+    NullDrawRecord record = { vertexCount, instanceCount, firstVertex, 0, firstInstance, 0 };
+    nullRecord(list, NULL_COMMAND_DRAW, record);
+}
+
+static void nullCmdDrawIndexed(RhiCommandList* list, uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset, uint32 firstInstance)
+{
+    NullDrawRecord record = { indexCount, instanceCount, firstIndex, vertexOffset, firstInstance, 0 };
+    nullRecord(list, NULL_COMMAND_DRAW_INDEXED, record);
+}
+
+static void nullCmdDispatch(RhiCommandList* list, uint32 groupsX, uint32 groupsY, uint32 groupsZ)
+{
+    uint32 groups[3] = { groupsX, groupsY, groupsZ };
+    nullRecord(list, NULL_COMMAND_DISPATCH, groups);
+}
+
+static void nullCmdCopyBuffer(RhiCommandList* list, RhiResource* destination, uint64 destinationOffset, RhiResource* source, uint64 sourceOffset, uint64 size)
+{
+    NullCopyRecord record = { destination, source, destinationOffset, sourceOffset, size };
+    nullRecord(list, NULL_COMMAND_COPY_BUFFER, record);
+}
+
+static void nullCmdCopyTextureToBuffer(RhiCommandList* list, RhiResource* buffer, RhiResource* texture)
+{
+    NullCopyRecord record = { buffer, texture, 0, 0, 0 };
+    nullRecord(list, NULL_COMMAND_COPY_TEXTURE_TO_BUFFER, record);
+}
+
+static void nullCmdResolve(RhiCommandList* list, RhiResource* destination, RhiResource* source)
+{
+    NullCopyRecord record = { destination, source, 0, 0, 0 };
+    nullRecord(list, NULL_COMMAND_RESOLVE, record);
+}
+
+// Replay
+
+static void checkState(NullDevice* device, NullResource* resource, uint32 subresource, uint32 expected)
+{
+    if (resource->states[subresource] != expected)
+    {
+        device->stats.barrierMismatches++;
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Barrier expects state 0x%x, subresource %u is in 0x%x",
+            expected, subresource, resource->states[subresource]);
+    }
+}
+
+static void replayBarrier(NullDevice* device, const NullBarrierRecord& barrier)
+{
+    if (barrier.type != RHI_BARRIER_TRANSITION)
+    {
+        return;
+    }
+
+    NullResource* resource = (NullResource*)barrier.resource;
+    uint32 subresourceCount = rhiSubresourceCount(resource->desc);
+    uint32 first = barrier.subresource == RHI_ALL_SUBRESOURCES ? 0 : barrier.subresource;
+    uint32 last = barrier.subresource == RHI_ALL_SUBRESOURCES ? subresourceCount : barrier.subresource + 1;
+    // The modeled GPU finishes split transitions at their end
+    bool changes = !(barrier.flags & RHI_BARRIER_FLAG_BEGIN_ONLY);
+    for (uint32 i = first; i < last; i++)
+    {
+        checkState(device, resource, i, barrier.before);
+        if (changes)
+        {
+            resource->states[i] = barrier.after;
+        }
+    }
+}
+
+// What a copy of the texture holds: its last clear color, in the texture's layout
+static void fillFromContents(NullDevice* device, NullResource* buffer, NullResource* texture)
+{
+    if (!buffer->memory)
+    {
+        return;
+    }
+
+    uint32 rowPitch;
+    uint64 totalBytes;
+    rhiGetCopyableFootprint(device, texture->desc, &rowPitch, &totalBytes);
+    totalBytes = totalBytes < buffer->desc.width ? totalBytes : buffer->desc.width;
+
+    uint8 pixel[16] = {};
+    uint32 pixelSize = rhiFormatBytesPerPixel(texture->desc.format);
+    if (texture->desc.format == RHI_FORMAT_RGBA8_UNORM || texture->desc.format == RHI_FORMAT_BGRA8_UNORM)
+    {
+        for (uint32 i = 0; i < 4; i++)
+        {
+            float32 value = texture->contents[i] < 0.0f ? 0.0f : texture->contents[i] > 1.0f ? 1.0f : texture->contents[i];
+            pixel[i] = (uint8)(value * 255.0f + 0.5f);
+        }
+        if (texture->desc.format == RHI_FORMAT_BGRA8_UNORM)
+        {
+            uint8 red = pixel[0];
+            pixel[0] = pixel[2];
+            pixel[2] = red;
+        }
+    }
+    else if (pixelSize == 16)
+    {
+        memcpy(pixel, texture->contents, 16);
+    }
+
+    for (uint64 row = 0; row * rowPitch < totalBytes; row++)
+    {
+        uint8* destination = buffer->memory + row * rowPitch;
+        uint64 rowBytes = totalBytes - row * rowPitch < rowPitch ? totalBytes - row * rowPitch : rowPitch;
+        for (uint64 x = 0; x + pixelSize <= rowBytes; x += pixelSize)
+        {
+            memcpy(destination + x, pixel, pixelSize);
+        }
+    }
+}
+
+// Returns the modeled GPU time of the list in nanoseconds. Called with the timeline mutex held.
+static float64 replayCommandList(NullDevice* device, NullCommandList* list)
+{
+    const RhiNullConfig& config = device->config;
+    float64 cost = 0.0;
+    const uint8* cursor = list->allocator->memory + list->begin;
+    const uint8* end = list->allocator->memory + list->end;
+    while (cursor < end)
+    {
+        NullCommandHeader header;
+        memcpy(&header, cursor, sizeof(header));
+        const uint8* payload = cursor + sizeof(header);
+        cost += config.nanosecondsPerCommand;
+
+        switch (header.type)
+        {
+            case NULL_COMMAND_BARRIERS:
+            {
+                for (uint32 i = 0; i < header.count; i++)
+                {
+                    NullBarrierRecord barrier;
+                    memcpy(&barrier, payload + i * sizeof(barrier), sizeof(barrier));
+                    replayBarrier(device, barrier);
+                }
+                cost += header.count * config.nanosecondsPerBarrier;
+                device->stats.barriers += header.count;
+            } break;
+
+            case NULL_COMMAND_CLEAR_RENDER_TARGET:
+            case NULL_COMMAND_CLEAR_DEPTH_STENCIL:
+            {
+                NullClearRecord clear;
+                memcpy(&clear, payload, sizeof(clear));
+                NullResource* target = (NullResource*)clear.target;
+                memcpy(target->contents, clear.values, sizeof(clear.values));
+                cost += (float64)target->desc.width * target->desc.height * target->desc.sampleCount * config.nanosecondsPerClearedPixel;
+            } break;
+
+            case NULL_COMMAND_DRAW:
+            case NULL_COMMAND_DRAW_INDEXED:
+            {
+                cost += config.nanosecondsPerDraw;
+                device->stats.draws++;
+            } break;
+
+            case NULL_COMMAND_DISPATCH:
+            {
+                cost += config.nanosecondsPerDispatch;
+            } break;
+
+            case NULL_COMMAND_COPY_BUFFER:
+            {
+                NullCopyRecord copy;
+                memcpy(&copy, payload, sizeof(copy));
+                NullResource* destination = (NullResource*)copy.destination;
+                NullResource* source = (NullResource*)copy.source;
+                if (destination->memory && source->memory)
+                {
+                    memmove(destination->memory + copy.destinationOffset, source->memory + copy.sourceOffset, copy.size);
+                }
+                cost += (float64)copy.size * config.nanosecondsPerCopiedByte;
+            } break;
+
+            case NULL_COMMAND_COPY_TEXTURE_TO_BUFFER:
+            {
+                NullCopyRecord copy;
+                memcpy(&copy, payload, sizeof(copy));
+                NullResource* texture = (NullResource*)copy.source;
+                fillFromContents(device, (NullResource*)copy.destination, texture);
+                cost += (float64)texture->desc.width * texture->desc.height * rhiFormatBytesPerPixel(texture->desc.format) * config.nanosecondsPerCopiedByte;
+            } break;
+
+            case NULL_COMMAND_RESOLVE:
+            {
+                NullCopyRecord copy;
+                memcpy(&copy, payload, sizeof(copy));
+                NullResource* destination = (NullResource*)copy.destination;
+                NullResource* source = (NullResource*)copy.source;
+                memcpy(destination->contents, source->contents, sizeof(source->contents));
+                cost += (float64)source->desc.width * source->desc.height * source->desc.sampleCount * config.nanosecondsPerClearedPixel;
+            } break;
+
+            default:
+            {
+                // State setting costs only the per command time
+            } break;
+        }
+
+        cursor += header.size;
+    }
+
+    device->stats.commands += list->commandCount;
+    device->stats.streamBytes += list->end - list->begin;
+    return cost;
+}
+
+static void nullQueueSubmit(RhiQueue* rhiQueue, RhiCommandList* const* lists, uint32 count)
+{
+    NullQueue* queue = (NullQueue*)rhiQueue;
+    NullDevice* device = (NullDevice*)queue->device;
+
+    std::lock_guard<std::mutex> lock(device->timelineMutex);
+    float64 cost = 0.0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        cost += replayCommandList(device, (NullCommandList*)lists[i]);
+    }
+
+    int64 start = nowNanoseconds() + (int64)device->config.submitLatencyNanoseconds;
+    start = queue->busyUntil > start ? queue->busyUntil : start;
+    queue->busyUntil = start + (int64)cost;
+
+    device->stats.submissions++;
+    device->stats.commandLists += count;
+    device->stats.gpuBusySeconds += cost * 1e-9;
+}
+
+// Heaps and resources
+
+static RhiHeap* nullCreateHeap(RhiDevice* device, const RhiHeapDesc& desc, const char* name)
+{
+    NullHeap* heap = new NullHeap();
+    heap->device = device;
+    heap->desc = desc;
+    heap->memory = nullptr;
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "null heap", desc.size);
+    return heap;
+}
+
+static void nullDestroyHeap(RhiHeap* rhiHeap)
+{
+    NullHeap* heap = (NullHeap*)rhiHeap;
+    delete[] heap->memory;
+    delete heap;
+}
+
+static void nullAllocationInfo(RhiDevice* device, const RhiResourceDesc& desc, uint64* size, uint64* alignment)
+{
+    uint64 bytes = desc.width;
+    if (desc.dimension == RHI_RESOURCE_TEXTURE2D)
+    {
+        bytes = 0;
+        uint64 width = desc.width;
+        uint64 height = desc.height;
+        for (uint32 mip = 0; mip < desc.mipLevels; mip++)
+        {
+            bytes += width * height * rhiFormatBytesPerPixel(desc.format);
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        bytes *= (uint64)desc.arraySize * desc.sampleCount;
+    }
+    *alignment = desc.sampleCount > 1 ? NULL_MSAA_PLACEMENT_ALIGNMENT : NULL_PLACEMENT_ALIGNMENT;
+    *size = alignUp(bytes ? bytes : 1, *alignment);
+}
+
+static void nullCopyableFootprint(RhiDevice* device, const RhiResourceDesc& desc, uint32* rowPitch, uint64* totalBytes)
+{
+    uint32 rowSize = (uint32)desc.width * rhiFormatBytesPerPixel(desc.format);
+    *rowPitch = (uint32)alignUp(rowSize, NULL_ROW_PITCH_ALIGNMENT);
+    *totalBytes = (uint64)*rowPitch * (desc.height - 1) + rowSize;
+}
+
+static NullResource* newResource(RhiDevice* device, e_rhiHeapType heapType, const RhiResourceDesc& desc, uint32 initialState)
+{
+    NullResource* resource = new NullResource();
+    resource->device = device;
+    resource->desc = desc;
+    resource->heapType = heapType;
+    resource->heap = nullptr;
+    resource->memory = nullptr;
+    resource->ownsMemory = false;
+    uint32 subresourceCount = rhiSubresourceCount(desc);
+    resource->states = new uint32[subresourceCount];
+    for (uint32 i = 0; i < subresourceCount; i++)
+    {
+        resource->states[i] = initialState;
+    }
+    memcpy(resource->contents, desc.clearValue, sizeof(resource->contents));
+    return resource;
+}
+
+static RhiResource* nullCreateCommittedResource(RhiDevice* device, e_rhiHeapType heapType, const RhiResourceDesc& desc, uint32 initialState, const char* name)
+{
+    NullResource* resource = newResource(device, heapType, desc, initialState);
+    if (desc.dimension == RHI_RESOURCE_BUFFER)
+    {
+        resource->memory = new uint8[desc.width];
+        memset(resource->memory, 0, desc.width);
+        resource->ownsMemory = true;
+    }
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "null resource", desc.width * desc.height);
+    return resource;
+}
+
+static RhiResource* nullCreatePlacedResource(RhiDevice* device, RhiHeap* rhiHeap, uint64 offset, const RhiResourceDesc& desc, uint32 initialState, const char* name)
+{
+    NullHeap* heap = (NullHeap*)rhiHeap;
+    uint64 size;
+    uint64 alignment;
+    nullAllocationInfo(device, desc, &size, &alignment);
+    if (offset % alignment != 0 || offset + size > heap->desc.size)
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Placed resource of %llu bytes at %llu does not fit its heap",
+            (unsigned long long)size, (unsigned long long)offset);
+        return nullptr;
+    }
+
+    NullResource* resource = newResource(device, heap->desc.type, desc, initialState);
+    resource->heap = heap;
+    if (desc.dimension == RHI_RESOURCE_BUFFER)
+    {
+        if (!heap->memory)
+        {
+            heap->memory = new uint8[heap->desc.size];
+            memset(heap->memory, 0, heap->desc.size);
+        }
+        resource->memory = heap->memory + offset;
+    }
+    return resource;
+}
+
+static void nullDestroyResource(RhiResource* rhiResource)
+{
+    NullResource* resource = (NullResource*)rhiResource;
+    if (resource->ownsMemory)
+    {
+        delete[] resource->memory;
+    }
+    delete[] resource->states;
+    delete resource;
+}
+
+static void* nullMapResource(RhiResource* resource)
+{
+    return ((NullResource*)resource)->memory;
+}
+
+static void nullUnmapResource(RhiResource* resource)
+{
+}
+
+// Descriptors
+
+static RhiDescriptorHeap* nullCreateDescriptorHeap(RhiDevice* device, const RhiDescriptorHeapDesc& desc, const char* name)
+{
+    NullDescriptorHeap* heap = new NullDescriptorHeap();
+    heap->device = device;
+    heap->desc = desc;
+    heap->descriptors = new NullDescriptor[desc.capacity];
+    for (uint32 i = 0; i < desc.capacity; i++)
+    {
+        heap->descriptors[i] = { nullptr, RHI_VIEW_TYPE_COUNT };
+    }
+    return heap;
+}
+
+static void nullDestroyDescriptorHeap(RhiDescriptorHeap* rhiHeap)
+{
+    NullDescriptorHeap* heap = (NullDescriptorHeap*)rhiHeap;
+    delete[] heap->descriptors;
+    delete heap;
+}
+
+static void nullWriteView(RhiDescriptorHeap* heap, uint32 index, e_rhiViewType type, RhiResource* resource)
+{
+    ((NullDescriptorHeap*)heap)->descriptors[index] = { resource, type };
+}
+
+static void nullCopyDescriptors(RhiDevice* rhiDevice, const RhiDescriptorCopy* copies, uint32 count)
+{
+    NullDevice* device = (NullDevice*)rhiDevice;
+    uint64 copied = 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        const RhiDescriptorCopy& copy = copies[i];
+        memmove(((NullDescriptorHeap*)copy.destination)->descriptors + copy.destinationIndex,
+            ((NullDescriptorHeap*)copy.source)->descriptors + copy.sourceIndex, copy.count * sizeof(NullDescriptor));
+        copied += copy.count;
+    }
+
+    std::lock_guard<std::mutex> lock(device->timelineMutex);
+    device->stats.descriptorCopyCalls++;
+    device->stats.descriptorsCopied += copied;
+}
+
+static RhiPipeline* nullCreatePipeline(RhiDevice* device, const RhiPipelineDesc& desc, const char* name)
+{
+    NullPipeline* pipeline = new NullPipeline();
+    pipeline->device = device;
+    pipeline->compute = desc.computeShader != nullptr;
+    return pipeline;
+}
+
+static void nullDestroyPipeline(RhiPipeline* pipeline)
+{
+    delete (NullPipeline*)pipeline;
+}
+
+// Swapchains
+
+static void createSwapChainBuffers(NullSwapChain* swapChain)
+{
+    RhiResourceDesc desc = rhiTexture2DDesc(swapChain->desc.format, swapChain->desc.width, swapChain->desc.height, RHI_RESOURCE_FLAG_RENDER_TARGET);
+    for (uint32 i = 0; i < swapChain->bufferCount; i++)
+    {
+        swapChain->buffers[i] = newResource(swapChain->device, RHI_HEAP_DEFAULT, desc, RHI_STATE_PRESENT);
+    }
+    swapChain->currentIndex = 0;
+}
+
+static RhiSwapChain* nullCreateSwapChain(RhiDevice* device, RhiQueue* queue, const RhiSwapChainDesc& desc)
+{
+    NullSwapChain* swapChain = new NullSwapChain();
+    swapChain->device = device;
+    swapChain->queue = queue;
+    swapChain->desc = desc;
+    swapChain->bufferCount = desc.bufferCount;
+    swapChain->presentCount = 0;
+    createSwapChainBuffers(swapChain);
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "null swapchain", desc.bufferCount);
+    return swapChain;
+}
+
+static void nullDestroySwapChain(RhiSwapChain* swapChain)
+{
+    for (uint32 i = 0; i < swapChain->bufferCount; i++)
+    {
+        nullDestroyResource(swapChain->buffers[i]);
+    }
+    delete (NullSwapChain*)swapChain;
+}
+
+static bool nullResizeSwapChain(RhiSwapChain* rhiSwapChain, uint32 width, uint32 height)
+{
+    NullSwapChain* swapChain = (NullSwapChain*)rhiSwapChain;
+    for (uint32 i = 0; i < swapChain->bufferCount; i++)
+    {
+        nullDestroyResource(swapChain->buffers[i]);
+    }
+    swapChain->desc.width = width;
+    swapChain->desc.height = height;
+    createSwapChainBuffers(swapChain);
+    return true;
+}
+
+// The flip happens on the queue after everything submitted before it. With vsync it waits for
+// the next vblank and holds the queue until then.
+static void nullPresent(RhiSwapChain* rhiSwapChain, uint32 syncInterval)
+{
+    NullSwapChain* swapChain = (NullSwapChain*)rhiSwapChain;
+    NullDevice* device = (NullDevice*)swapChain->device;
+    NullQueue* queue = (NullQueue*)swapChain->queue;
+
+    int64 oldest;
+    {
+        std::lock_guard<std::mutex> lock(device->timelineMutex);
+        NullResource* buffer = (NullResource*)swapChain->buffers[swapChain->currentIndex];
+        checkState(device, buffer, 0, RHI_STATE_PRESENT);
+
+        int64 now = nowNanoseconds();
+        int64 shown = queue->busyUntil > now ? queue->busyUntil : now;
+        float64 interval = device->config.vsyncIntervalNanoseconds * syncInterval;
+        if (interval > 0.0)
+        {
+            int64 vblanks = (int64)((float64)(shown - device->origin) / interval) + 1;
+            shown = device->origin + (int64)((float64)vblanks * interval);
+            queue->busyUntil = shown;
+        }
+
+        swapChain->presentTimes[swapChain->presentCount % NULL_MAX_PRESENTS_QUEUED] = shown;
+        swapChain->presentCount++;
+        swapChain->currentIndex = (swapChain->currentIndex + 1) % swapChain->bufferCount;
+
+        uint32 latency = device->config.maxFrameLatency;
+        latency = latency < 1 ? 1 : latency > NULL_MAX_PRESENTS_QUEUED ? NULL_MAX_PRESENTS_QUEUED : latency;
+        oldest = swapChain->presentCount > latency ?
+            swapChain->presentTimes[(swapChain->presentCount - latency - 1) % NULL_MAX_PRESENTS_QUEUED] : 0;
+    }
+
+    // Like DXGI, block while maxFrameLatency presents are still waiting to be shown
+    sleepUntil(oldest);
+}
+
+// Device
+
+static void nullDestroyDevice(RhiDevice* rhiDevice)
+{
+    NullDevice* device = (NullDevice*)rhiDevice;
+    {
+        std::lock_guard<std::mutex> lock(device->fenceMutex);
+        SGSASSERT(!device->fences);
+        device->stopping = true;
+    }
+    device->fencesChanged.notify_one();
+    device->completionThread.join();
+    delete device;
+}
+
+static const RhiBackendFunctions nullFunctions = {
+    nullDestroyDevice,
+    nullMsaaQualityLevels,
+
+    nullQueueSubmit,
+    nullQueueSignal,
+    nullQueueWait,
+
+    nullCreateFence,
+    nullDestroyFence,
+    nullFenceCompletedValue,
+    nullFenceWait,
+    nullFenceWaitMany,
+    nullFenceOnComplete,
+
+    nullCreateCommandAllocator,
+    nullDestroyCommandAllocator,
+    nullResetCommandAllocator,
+    nullCreateCommandList,
+    nullDestroyCommandList,
+    nullBeginCommandList,
+    nullEndCommandList,
+
+    nullCreateHeap,
+    nullDestroyHeap,
+    nullAllocationInfo,
+    nullCopyableFootprint,
+    nullCreateCommittedResource,
+    nullCreatePlacedResource,
+    nullDestroyResource,
+    nullMapResource,
+    nullUnmapResource,
+
+    nullCreateDescriptorHeap,
+    nullDestroyDescriptorHeap,
+    nullWriteView,
+    nullCopyDescriptors,
+
+    nullCreatePipeline,
+    nullDestroyPipeline,
+
+    nullCreateSwapChain,
+    nullDestroySwapChain,
+    nullResizeSwapChain,
+    nullPresent,
+
+    nullCmdBarriers,
+    nullCmdSetRenderTargets,
+    nullCmdClearRenderTarget,
+    nullCmdClearDepthStencil,
+    nullCmdSetViewport,
+    nullCmdSetScissor,
+    nullCmdSetPipeline,
+    nullCmdSetConstants,
+    nullCmdSetDescriptorHeap,
+    nullCmdSetDescriptorTable,
+    nullCmdSetVertexBuffer,
+    nullCmdSetIndexBuffer,
+    nullCmdDraw,
+    nullCmdDrawIndexed,
+    nullCmdDispatch,
+    nullCmdCopyBuffer,
+    nullCmdCopyTextureToBuffer,
+    nullCmdResolve,
+};
+
+RhiDevice* rhiCreateNullDevice(const RhiDeviceConfig& config)
+{
+    NullDevice* device = new NullDevice();
+    device->functions = &nullFunctions;
+    device->backend = RHI_BACKEND_NULL;
+    device->config = config.null;
+    device->origin = nowNanoseconds();
+    device->stats = RhiNullStats();
+    for (uint32 i = 0; i < RHI_QUEUE_TYPE_COUNT; i++)
+    {
+        NullQueue& queue = device->queueStorage[i];
+        queue.device = device;
+        queue.type = (e_rhiQueueType)i;
+        queue.busyUntil = 0;
+        device->queues[i] = &queue;
+    }
+    device->fences = nullptr;
+    device->retiring = false;
+    device->stopping = false;
+    device->completionThread = std::thread(nullCompletionThread, device);
+    return device;
+}
+
+bool rhiNullDeviceStats(RhiDevice* rhiDevice, RhiNullStats* stats)
+{
+    NullDevice* device = (NullDevice*)rhiDevice;
+    std::lock_guard<std::mutex> lock(device->timelineMutex);
+    *stats = device->stats;
+    return true;
+}
@@ -0,0 +1,186 @@
+#include <math.h>
+#include <string.h>
+
+#include "scene.h"
+
+#define SCENE_MESH_COUNT 4
+#define SCENE_MATERIAL_COUNT 8
+
+// xorshift, so a seed always produces the same scene
+static uint32 nextRandom(uint32* state)
+{
+    uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static float32 randomRange(uint32* state, float32 low, float32 high)
+{
+    return low + (high - low) * (float32)(nextRandom(state) & 0xFFFFFF) / (float32)0xFFFFFF;
+}
+
+void matrixMultiply(float32* out, const float32* a, const float32* b)
+{
+    float32 result[16];
+    for (uint32 column = 0; column < 4; column++)
+    {
+        for (uint32 row = 0; row < 4; row++)
+        {
+            result[column * 4 + row] =
+                a[0 * 4 + row] * b[column * 4 + 0] +
+                a[1 * 4 + row] * b[column * 4 + 1] +
+                a[2 * 4 + row] * b[column * 4 + 2] +
+                a[3 * 4 + row] * b[column * 4 + 3];
+        }
+    }
+    memcpy(out, result, sizeof(result));
+}
+
+static void perspective(float32* out, float32 fovY, float32 aspect, float32 nearZ, float32 farZ)
+{
+    float32 f = 1.0f / tanf(fovY * 0.5f);
+    memset(out, 0, sizeof(float32) * 16);
+    out[0] = f / aspect;
+    out[5] = f;
+    out[10] = farZ / (nearZ - farZ);
+    out[11] = -1.0f;
+    out[14] = nearZ * farZ / (nearZ - farZ);
+}
+
+static void lookAt(float32* out, const float32* eye, const float32* target)
+{
+    float32 forward[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+    float32 length = sqrtf(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+    for (uint32 i = 0; i < 3; i++)
+    {
+        forward[i] /= length;
+    }
+
+    // up is +y; right = forward x up, trueUp = right x forward
+    float32 right[3] = { -forward[2], 0.0f, forward[0] };
+    length = sqrtf(right[0] * right[0] + right[2] * right[2]);
+    right[0] /= length;
+    right[2] /= length;
+    float32 up[3] = {
+        right[1] * forward[2] - right[2] * forward[1],
+        right[2] * forward[0] - right[0] * forward[2],
+        right[0] * forward[1] - right[1] * forward[0]
+    };
+
+    out[0] = right[0]; out[4] = right[1]; out[8] = right[2];
+    out[1] = up[0]; out[5] = up[1]; out[9] = up[2];
+    out[2] = -forward[0]; out[6] = -forward[1]; out[10] = -forward[2];
+    out[3] = 0.0f; out[7] = 0.0f; out[11] = 0.0f;
+    out[12] = -(right[0] * eye[0] + right[1] * eye[1] + right[2] * eye[2]);
+    out[13] = -(up[0] * eye[0] + up[1] * eye[1] + up[2] * eye[2]);
+    out[14] = forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2];
+    out[15] = 1.0f;
+}
+
+void sceneInitialize(Scene* scene, uint32 objectCount, uint32 seed)
+{
+    scene->objects = new SceneObject[objectCount];
+    scene->objectCount = objectCount;
+    scene->time = 0.0;
+    scene->halfExtent = 50.0f;
+    scene->aspectRatio = 16.0f / 9.0f;
+
+    uint32 state = seed ? seed : 1;
+    for (uint32 i = 0; i < objectCount; i++)
+    {
+        SceneObject& object = scene->objects[i];
+        for (uint32 axis = 0; axis < 3; axis++)
+        {
+            object.position[axis] = randomRange(&state, -scene->halfExtent, scene->halfExtent);
+            object.velocity[axis] = randomRange(&state, -5.0f, 5.0f);
+        }
+        object.yaw = randomRange(&state, 0.0f, 6.2831853f);
+        object.spin = randomRange(&state, -3.0f, 3.0f);
+        object.scale = randomRange(&state, 0.25f, 2.0f);
+        object.mesh = nextRandom(&state) % SCENE_MESH_COUNT;
+        object.material = nextRandom(&state) % SCENE_MATERIAL_COUNT;
+    }
+}
+
+void sceneShutdown(Scene* scene)
+{
+    delete[] scene->objects;
+    scene->objects = nullptr;
+    scene->objectCount = 0;
+}
+
+void sceneUpdate(Scene* scene, float32 deltaSeconds)
+{
+    scene->time += deltaSeconds;
+    float32 extent = scene->halfExtent;
+
+    for (uint32 i = 0; i < scene->objectCount; i++)
+    {
+        SceneObject& object = scene->objects[i];
+        for (uint32 axis = 0; axis < 3; axis++)
+        {
+            object.position[axis] += object.velocity[axis] * deltaSeconds;
+            if (object.position[axis] > extent || object.position[axis] < -extent)
+            {
+                object.velocity[axis] = -object.velocity[axis];
+                object.position[axis] = object.position[axis] > extent ? extent : -extent;
+            }
+        }
+        object.yaw += object.spin * deltaSeconds;
+        if (object.yaw > 6.2831853f || object.yaw < -6.2831853f)
+        {
+            object.yaw = fmodf(object.yaw, 6.2831853f);
+        }
+    }
+}
+
+void sceneWriteSnapshot(const Scene* scene, RenderSnapshot* snapshot)
+{
+    snapshot->time = scene->time;
+
+    float32 pulse = 0.5f + 0.5f * sinf((float32)scene->time * 0.5f);
+    snapshot->clearColor[0] = 0.69f * pulse;
+    snapshot->clearColor[1] = 0.77f;
+    snapshot->clearColor[2] = 0.87f;
+    snapshot->clearColor[3] = 1.0f;
+
+    // The camera orbits the box
+    float32 angle = (float32)scene->time * 0.2f;
+    float32 distance = scene->halfExtent * 2.5f;
+    RenderCamera& camera = snapshot->camera;
+    camera.position[0] = cosf(angle) * distance;
+    camera.position[1] = scene->halfExtent * 0.75f;
+    camera.position[2] = sinf(angle) * distance;
+
+    float32 target[3] = { 0.0f, 0.0f, 0.0f };
+    float32 view[16];
+    float32 projection[16];
+    lookAt(view, camera.position, target);
+    perspective(projection, 1.0471976f, scene->aspectRatio, 0.1f, 1000.0f);
+    matrixMultiply(camera.viewProjection, projection, view);
+
+    uint32 count = scene->objectCount < snapshot->capacity ? scene->objectCount : snapshot->capacity;
+    for (uint32 i = 0; i < count; i++)
+    {
+        const SceneObject& object = scene->objects[i];
+        float32 c = cosf(object.yaw) * object.scale;
+        float32 s = sinf(object.yaw) * object.scale;
+
+        // Scale, rotation around y, translation
+        float32* world = snapshot->transforms[i].world;
+        world[0] = c;     world[4] = 0.0f;         world[8] = s;     world[12] = object.position[0];
+        world[1] = 0.0f;  world[5] = object.scale; world[9] = 0.0f;  world[13] = object.position[1];
+        world[2] = -s;    world[6] = 0.0f;         world[10] = c;    world[14] = object.position[2];
+        world[3] = 0.0f;  world[7] = 0.0f;         world[11] = 0.0f; world[15] = 1.0f;
+
+        RenderDraw& draw = snapshot->draws[i];
+        draw.transform = i;
+        draw.mesh = object.mesh;
+        draw.material = object.material;
+    }
+    snapshot->transformCount = count;
+    snapshot->drawCount = count;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+#include "render_snapshot.h"
+
+// A headless test scene: objects bouncing inside a box, spinning, watched by an orbiting camera.
+// It needs no window or device, so the simulation/render pipeline can be exercised and
+// benchmarked anywhere.
+
+struct SceneObject
+{
+    float32 position[3];
+    float32 velocity[3];
+    float32 yaw;
+    float32 spin;           // radians per second
+    float32 scale;
+    uint32 mesh;
+    uint32 material;
+};
+
+struct Scene
+{
+    SceneObject* objects;
+    uint32 objectCount;
+    float64 time;
+    float32 halfExtent;     // objects stay inside [-halfExtent, halfExtent] on every axis
+    float32 aspectRatio;
+};
+
+void sceneInitialize(Scene* scene, uint32 objectCount, uint32 seed);
+void sceneShutdown(Scene* scene);
+
+void sceneUpdate(Scene* scene, float32 deltaSeconds);
+// Fills every field of the snapshot except frame. Objects beyond the snapshot capacity are not drawn.
+void sceneWriteSnapshot(const Scene* scene, RenderSnapshot* snapshot);
+
+// out = a * b, column major 4x4
+void matrixMultiply(float32* out, const float32* a, const float32* b);
@@ -0,0 +1,430 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "startup_graph.h"
+#include "assertions.h"
+#include "cpu_topology.h"
+#include "logger.h"
+
+static int64 nowNanoseconds()
+{
+    using namespace std::chrono;
+    return (int64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool isFinished(e_startupTaskState state)
+{
+    return state == STARTUP_TASK_DONE || state == STARTUP_TASK_FAILED || state == STARTUP_TASK_SKIPPED;
+}
+
+void startupGraphInitialize(StartupGraph* graph)
+{
+    graph->taskCount = 0;
+    graph->readyCount = 0;
+    graph->outstanding = 0;
+    graph->threadCount = 0;
+    graph->origin = nowNanoseconds();
+    graph->runStart = 0;
+    graph->runEnd = 0;
+}
+
+uint32 startupGraphAddTask(StartupGraph* graph, const char* name, PFN_startupTask run, void* userData, uint32 flags)
+{
+    SGSASSERT(graph->taskCount < STARTUP_GRAPH_MAX_TASKS);
+    uint32 index = graph->taskCount++;
+    StartupTask& task = graph->tasks[index];
+    memset(&task, 0, sizeof(task));
+    task.name = name;
+    task.run = run;
+    task.userData = userData;
+    task.flags = flags;
+    task.state = STARTUP_TASK_PENDING;
+    return index;
+}
+
+void startupGraphAddDependency(StartupGraph* graph, uint32 task, uint32 dependency)
+{
+    // Dependencies can only point backwards, so the graph can't have cycles
+    SGSASSERT(dependency < task && task < graph->taskCount);
+    StartupTask& dependent = graph->tasks[task];
+    SGSASSERT(dependent.dependencyCount < STARTUP_GRAPH_MAX_DEPENDENCIES);
+    dependent.dependencies[dependent.dependencyCount++] = dependency;
+}
+
+// Called with the mutex held once a task reached a final state
+static void finishTask(StartupGraph* graph, uint32 index)
+{
+    StartupTask& finished = graph->tasks[index];
+    if (finished.scheduled)
+    {
+        graph->outstanding--;
+    }
+
+    for (uint32 i = index + 1; i < graph->taskCount; i++)
+    {
+        StartupTask& task = graph->tasks[i];
+        if (!task.scheduled || task.state != STARTUP_TASK_PENDING)
+        {
+            continue;
+        }
+        for (uint32 d = 0; d < task.dependencyCount; d++)
+        {
+            if (task.dependencies[d] == index && --task.remaining == 0)
+            {
+                graph->ready[graph->readyCount++] = i;
+            }
+        }
+    }
+    graph->condition.notify_all();
+}
+
+// Runs a pending task whose dependencies are done, releasing the lock meanwhile
+static void runTask(StartupGraph* graph, uint32 index, uint32 thread, std::unique_lock<std::mutex>& lock)
+{
+    StartupTask& task = graph->tasks[index];
+    task.state = STARTUP_TASK_RUNNING;
+    task.thread = thread;
+    task.start = nowNanoseconds() - graph->origin;
+
+    lock.unlock();
+    bool succeeded = task.run(task.userData);
+    lock.lock();
+
+    task.end = nowNanoseconds() - graph->origin;
+    task.state = succeeded ? STARTUP_TASK_DONE : STARTUP_TASK_FAILED;
+    if (!succeeded)
+    {
+        SGSERROR("Startup task '%s' failed", task.name);
+    }
+    finishTask(graph, index);
+}
+
+static void skipTask(StartupGraph* graph, uint32 index, uint32 thread)
+{
+    StartupTask& task = graph->tasks[index];
+    task.state = STARTUP_TASK_SKIPPED;
+    task.thread = thread;
+    task.start = nowNanoseconds() - graph->origin;
+    task.end = task.start;
+    finishTask(graph, index);
+}
+
+static void schedule(StartupGraph* graph, uint32 index)
+{
+    StartupTask& task = graph->tasks[index];
+    if (task.scheduled || task.state != STARTUP_TASK_PENDING)
+    {
+        return;
+    }
+    task.scheduled = true;
+    graph->outstanding++;
+    for (uint32 d = 0; d < task.dependencyCount; d++)
+    {
+        schedule(graph, task.dependencies[d]);
+    }
+}
+
+static void workerMain(StartupGraph* graph, uint32 thread)
+{
+    std::unique_lock<std::mutex> lock(graph->mutex);
+    for (;;)
+    {
+        // Oldest ready task this thread may run
+        uint32 slot = graph->readyCount;
+        for (uint32 i = 0; i < graph->readyCount; i++)
+        {
+            if (thread == 0 || !(graph->tasks[graph->ready[i]].flags & STARTUP_TASK_MAIN_THREAD))
+            {
+                slot = i;
+                break;
+            }
+        }
+
+        if (slot == graph->readyCount)
+        {
+            if (graph->outstanding == 0)
+            {
+                break;
+            }
+            graph->condition.wait(lock);
+            continue;
+        }
+
+        uint32 index = graph->ready[slot];
+        memmove(&graph->ready[slot], &graph->ready[slot + 1], (graph->readyCount - slot - 1) * sizeof(uint32));
+        graph->readyCount--;
+
+        // startupGraphRequire may have taken it in the meantime
+        StartupTask& task = graph->tasks[index];
+        if (task.state != STARTUP_TASK_PENDING)
+        {
+            continue;
+        }
+
+        bool dependenciesDone = true;
+        for (uint32 d = 0; d < task.dependencyCount; d++)
+        {
+            dependenciesDone = dependenciesDone && graph->tasks[task.dependencies[d]].state == STARTUP_TASK_DONE;
+        }
+        if (dependenciesDone)
+        {
+            runTask(graph, index, thread, lock);
+        }
+        else
+        {
+            skipTask(graph, index, thread);
+        }
+    }
+}
+
+bool startupGraphRun(StartupGraph* graph, uint32 threadCount)
+{
+    if (threadCount == 0)
+    {
+        // Startup tasks mostly wait on the driver or the disk, so even one core gains from two
+        threadCount = std::thread::hardware_concurrency();
+        threadCount = threadCount < 2 ? 2 : threadCount;
+    }
+    threadCount = threadCount > STARTUP_GRAPH_MAX_THREADS ? STARTUP_GRAPH_MAX_THREADS : threadCount;
+
+    {
+        std::lock_guard<std::mutex> lock(graph->mutex);
+        graph->threadCount = threadCount;
+        graph->runStart = nowNanoseconds() - graph->origin;
+        for (uint32 i = 0; i < graph->taskCount; i++)
+        {
+            if (!(graph->tasks[i].flags & STARTUP_TASK_LAZY))
+            {
+                schedule(graph, i);
+            }
+        }
+
+        for (uint32 i = 0; i < graph->taskCount; i++)
+        {
+            StartupTask& task = graph->tasks[i];
+            if (!task.scheduled || task.state != STARTUP_TASK_PENDING)
+            {
+                continue;
+            }
+            task.remaining = 0;
+            for (uint32 d = 0; d < task.dependencyCount; d++)
+            {
+                task.remaining += isFinished(graph->tasks[task.dependencies[d]].state) ? 0 : 1;
+            }
+            if (task.remaining == 0)
+            {
+                graph->ready[graph->readyCount++] = i;
+            }
+        }
+    }
+
+    std::thread workers[STARTUP_GRAPH_MAX_THREADS];
+    for (uint32 i = 1; i < threadCount; i++)
+    {
+        // The calling thread keeps its own placement
+        workers[i] = std::thread([graph, i]() {
+            cpuPlacementAttachThread(ENGINE_THREAD_WORKER, i - 1);
+            workerMain(graph, i);
+            cpuPlacementDetachThread();
+        });
+    }
+    workerMain(graph, 0);
+    for (uint32 i = 1; i < threadCount; i++)
+    {
+        workers[i].join();
+    }
+
+    std::lock_guard<std::mutex> lock(graph->mutex);
+    graph->runEnd = nowNanoseconds() - graph->origin;
+    bool succeeded = true;
+    for (uint32 i = 0; i < graph->taskCount; i++)
+    {
+        const StartupTask& task = graph->tasks[i];
+        succeeded = succeeded && (!task.scheduled || task.state == STARTUP_TASK_DONE);
+    }
+    return succeeded;
+}
+
+static bool requireLocked(StartupGraph* graph, uint32 index, std::unique_lock<std::mutex>& lock)
+{
+    StartupTask& task = graph->tasks[index];
+    for (;;)
+    {
+        if (task.state == STARTUP_TASK_DONE)
+        {
+            return true;
+        }
+        if (task.state == STARTUP_TASK_FAILED || task.state == STARTUP_TASK_SKIPPED)
+        {
+            return false;
+        }
+        if (task.state == STARTUP_TASK_RUNNING)
+        {
+            graph->condition.wait(lock);
+            continue;
+        }
+
+        // Dependencies first. The lock is released while they run, so look again afterwards.
+        bool waited = false;
+        for (uint32 d = 0; d < task.dependencyCount && !waited; d++)
+        {
+            uint32 dependency = task.dependencies[d];
+            if (graph->tasks[dependency].state == STARTUP_TASK_DONE)
+            {
+                continue;
+            }
+            if (!requireLocked(graph, dependency, lock))
+            {
+                if (task.state == STARTUP_TASK_PENDING)
+                {
+                    skipTask(graph, index, STARTUP_GRAPH_MAX_THREADS);
+                }
+                return false;
+            }
+            waited = true;
+        }
+        if (waited)
+        {
+            continue;
+        }
+
+        runTask(graph, index, STARTUP_GRAPH_MAX_THREADS, lock);
+        return task.state == STARTUP_TASK_DONE;
+    }
+}
+
+bool startupGraphRequire(StartupGraph* graph, uint32 task)
+{
+    SGSASSERT(task < graph->taskCount);
+    std::unique_lock<std::mutex> lock(graph->mutex);
+    return requireLocked(graph, task, lock);
+}
+
+// Walks back from the task that finished last, always through the dependency that finished
+// last: the chain that actually decided when startup was over
+static int64 criticalPath(const StartupGraph* graph, bool* onPath)
+{
+    memset(onPath, 0, sizeof(bool) * STARTUP_GRAPH_MAX_TASKS);
+
+    uint32 last = graph->taskCount;
+    for (uint32 i = 0; i < graph->taskCount; i++)
+    {
+        const StartupTask& task = graph->tasks[i];
+        if (task.scheduled && isFinished(task.state) && (last == graph->taskCount || task.end > graph->tasks[last].end))
+        {
+            last = i;
+        }
+    }
+
+    int64 length = 0;
+    while (last != graph->taskCount)
+    {
+        const StartupTask& task = graph->tasks[last];
+        onPath[last] = true;
+        length += task.end - task.start;
+
+        uint32 previous = graph->taskCount;
+        for (uint32 d = 0; d < task.dependencyCount; d++)
+        {
+            uint32 dependency = task.dependencies[d];
+            if (previous == graph->taskCount || graph->tasks[dependency].end > graph->tasks[previous].end)
+            {
+                previous = dependency;
+            }
+        }
+        last = previous;
+    }
+    return length;
+}
+
+void startupGraphGetStats(StartupGraph* graph, StartupGraphStats* stats)
+{
+    std::lock_guard<std::mutex> lock(graph->mutex);
+    memset(stats, 0, sizeof(*stats));
+
+    int64 taskNanoseconds = 0;
+    for (uint32 i = 0; i < graph->taskCount; i++)
+    {
+        const StartupTask& task = graph->tasks[i];
+        if (task.state == STARTUP_TASK_PENDING)
+        {
+            stats->tasksDeferred++;
+            continue;
+        }
+        if (task.state == STARTUP_TASK_FAILED || task.state == STARTUP_TASK_SKIPPED)
+        {
+            stats->tasksFailed++;
+        }
+        if (task.scheduled && isFinished(task.state))
+        {
+            stats->tasksRun++;
+            taskNanoseconds += task.end - task.start;
+        }
+    }
+
+    bool onPath[STARTUP_GRAPH_MAX_TASKS];
+    stats->wallSeconds = (float64)(graph->runEnd - graph->runStart) * 1e-9;
+    stats->taskSeconds = (float64)taskNanoseconds * 1e-9;
+    stats->criticalPathSeconds = (float64)criticalPath(graph, onPath) * 1e-9;
+}
+
+void startupGraphReport(StartupGraph* graph)
+{
+    StartupGraphStats stats;
+    startupGraphGetStats(graph, &stats);
+
+    std::lock_guard<std::mutex> lock(graph->mutex);
+    SGSINFO("Startup: %.2f ms on %u threads, %.2f ms of task time, critical path %.2f ms (%u tasks, %u failed, %u deferred)",
+        stats.wallSeconds * 1e3, graph->threadCount, stats.taskSeconds * 1e3, stats.criticalPathSeconds * 1e3,
+        stats.tasksRun, stats.tasksFailed, stats.tasksDeferred);
+
+    bool onPath[STARTUP_GRAPH_MAX_TASKS];
+    criticalPath(graph, onPath);
+
+    // Start order; tasks that never ran go last
+    uint32 order[STARTUP_GRAPH_MAX_TASKS];
+    for (uint32 i = 0; i < graph->taskCount; i++)
+    {
+        uint32 j = i;
+        const StartupTask& task = graph->tasks[i];
+        int64 start = task.state == STARTUP_TASK_PENDING ? INT64_MAX : task.start;
+        while (j > 0)
+        {
+            const StartupTask& other = graph->tasks[order[j - 1]];
+            int64 otherStart = other.state == STARTUP_TASK_PENDING ? INT64_MAX : other.start;
+            if (otherStart <= start)
+            {
+                break;
+            }
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    for (uint32 i = 0; i < graph->taskCount; i++)
+    {
+        const StartupTask& task = graph->tasks[order[i]];
+        if (task.state == STARTUP_TASK_PENDING)
+        {
+            SGSINFO("    %-28s %12s", task.name, "deferred");
+            continue;
+        }
+
+        const char* outcome = task.state == STARTUP_TASK_FAILED ? " failed" : task.state == STARTUP_TASK_SKIPPED ? " skipped" : "";
+        char where[24];
+        if (task.thread == STARTUP_GRAPH_MAX_THREADS)
+        {
+            snprintf(where, sizeof(where), "%s", task.scheduled ? "required" : "on demand");
+        }
+        else
+        {
+            snprintf(where, sizeof(where), "thread %u", task.thread);
+        }
+        SGSINFO("  %c %-28s %9.2f ms %9.2f ms  %s%s", onPath[order[i]] ? '*' : ' ', task.name,
+            (float64)(task.start - graph->runStart) * 1e-6, (float64)(task.end - task.start) * 1e-6, where, outcome);
+    }
+}
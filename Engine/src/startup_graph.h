@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+#include "defines.h"
+
+// Startup as a dependency graph of init tasks. startupGraphRun executes every eager task on a
+// small pool of threads, each one as soon as its dependencies finished. Lazy tasks only run
+// when something requires them, either an eager task depending on them or startupGraphRequire
+// at the first point of use. Every task is timed and startupGraphReport logs the result.
+
+#define STARTUP_GRAPH_MAX_TASKS 64
+#define STARTUP_GRAPH_MAX_DEPENDENCIES 8
+#define STARTUP_GRAPH_MAX_THREADS 8
+
+typedef enum e_startupTaskFlags {
+    STARTUP_TASK_LAZY = 1 << 0,         // not run by startupGraphRun unless an eager task needs it
+    STARTUP_TASK_MAIN_THREAD = 1 << 1   // only run on the thread calling startupGraphRun
+}e_startupTaskFlags;
+
+typedef enum e_startupTaskState {
+    STARTUP_TASK_PENDING = 0,
+    STARTUP_TASK_RUNNING = 1,
+    STARTUP_TASK_DONE = 2,
+    STARTUP_TASK_FAILED = 3,
+    STARTUP_TASK_SKIPPED = 4            // a dependency failed
+}e_startupTaskState;
+
+// Returns false on failure; tasks depending on it are skipped
+typedef bool (*PFN_startupTask)(void* userData);
+
+struct StartupTask
+{
+    const char* name;
+    PFN_startupTask run;
+    void* userData;
+    uint32 flags;
+    uint32 dependencies[STARTUP_GRAPH_MAX_DEPENDENCIES];
+    uint32 dependencyCount;
+
+    // Guarded by the graph mutex
+    e_startupTaskState state;
+    uint32 remaining;                   // unfinished dependencies while the graph runs
+    bool scheduled;                     // part of the current startupGraphRun
+    int64 start;                        // nanoseconds since startupGraphInitialize
+    int64 end;
+    uint32 thread;                      // pool thread, STARTUP_GRAPH_MAX_THREADS for startupGraphRequire
+};
+
+struct StartupGraph
+{
+    StartupTask tasks[STARTUP_GRAPH_MAX_TASKS];
+    uint32 taskCount;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32 ready[STARTUP_GRAPH_MAX_TASKS];
+    uint32 readyCount;
+    uint32 outstanding;                 // scheduled tasks not finished yet
+    uint32 threadCount;                 // of the last run
+    int64 origin;
+    int64 runStart;
+    int64 runEnd;
+};
+
+struct StartupGraphStats
+{
+    uint32 tasksRun;
+    uint32 tasksFailed;                 // failed or skipped
+    uint32 tasksDeferred;               // lazy tasks nothing required yet
+    float64 wallSeconds;                // of startupGraphRun
+    float64 taskSeconds;                // sum over the tasks it ran
+    float64 criticalPathSeconds;        // longest chain of dependencies that ran back to back
+};
+
+void startupGraphInitialize(StartupGraph* graph);
+
+// Returns the task index. Dependencies must be added before the graph runs.
+uint32 startupGraphAddTask(StartupGraph* graph, const char* name, PFN_startupTask run, void* userData, uint32 flags = 0);
+void startupGraphAddDependency(StartupGraph* graph, uint32 task, uint32 dependency);
+
+// Runs every eager task and whatever they depend on, blocks until all finished. threadCount
+// includes the calling thread; 0 uses the hardware thread count. Returns false if a task failed.
+bool startupGraphRun(StartupGraph* graph, uint32 threadCount);
+
+// Runs a task and its dependencies on the calling thread the first time it is required, waits
+// if another thread is running it. Safe from any thread, also from inside another task.
+bool startupGraphRequire(StartupGraph* graph, uint32 task);
+
+void startupGraphGetStats(StartupGraph* graph, StartupGraphStats* stats);
+// Logs one line per task in start order, critical path tasks marked with '*'
+void startupGraphReport(StartupGraph* graph);
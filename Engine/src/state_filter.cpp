@@ -0,0 +1,212 @@
+#include <string.h>
+
+#include "state_filter.h"
+#include "assertions.h"
+
+void stateFilterInitialize(StateFilter* filter, bool enabled)
+{
+    memset(filter, 0, sizeof(StateFilter));
+    filter->enabled = enabled;
+}
+
+void stateFilterBegin(StateFilter* filter, RhiCommandList* list)
+{
+    filter->list = list;
+    stateFilterInvalidate(filter);
+}
+
+void stateFilterInvalidate(StateFilter* filter)
+{
+    filter->valid = 0;
+    filter->validVertexBuffers = 0;
+    filter->validConstants = 0;
+}
+
+// Counts the call and returns true if it can be dropped
+static bool filterCall(StateFilter* filter, e_stateFilterCall call, bool unchanged)
+{
+    filter->stats.calls[call]++;
+    uint32 bit = 1u << call;
+    if (filter->enabled && (filter->valid & bit) && unchanged)
+    {
+        filter->stats.filtered[call]++;
+        return true;
+    }
+    filter->valid |= bit;
+    return false;
+}
+
+void stateFilterSetViewport(StateFilter* filter, const RhiViewport& viewport)
+{
+    bool unchanged = memcmp(&filter->viewport, &viewport, sizeof(RhiViewport)) == 0;
+    if (filterCall(filter, STATE_FILTER_VIEWPORT, unchanged))
+    {
+        return;
+    }
+    filter->viewport = viewport;
+    rhiCmdSetViewport(filter->list, viewport);
+}
+
+void stateFilterSetScissor(StateFilter* filter, const RhiRect& rect)
+{
+    bool unchanged = memcmp(&filter->scissor, &rect, sizeof(RhiRect)) == 0;
+    if (filterCall(filter, STATE_FILTER_SCISSOR, unchanged))
+    {
+        return;
+    }
+    filter->scissor = rect;
+    rhiCmdSetScissor(filter->list, rect);
+}
+
+void stateFilterSetRenderTargets(StateFilter* filter, RhiResource* const* colors, uint32 colorCount, RhiResource* depthStencil)
+{
+    SGSASSERT(colorCount <= RHI_MAX_RENDER_TARGETS);
+    bool unchanged = filter->colorCount == colorCount && filter->depthStencil == depthStencil &&
+        (colorCount == 0 || memcmp(filter->colors, colors, colorCount * sizeof(RhiResource*)) == 0);
+    if (filterCall(filter, STATE_FILTER_RENDER_TARGETS, unchanged))
+    {
+        return;
+    }
+    if (colorCount)
+    {
+        memcpy(filter->colors, colors, colorCount * sizeof(RhiResource*));
+    }
+    filter->colorCount = colorCount;
+    filter->depthStencil = depthStencil;
+    rhiCmdSetRenderTargets(filter->list, colors, colorCount, depthStencil);
+}
+
+void stateFilterSetPipeline(StateFilter* filter, RhiPipeline* pipeline)
+{
+    if (filterCall(filter, STATE_FILTER_PIPELINE, filter->pipeline == pipeline))
+    {
+        return;
+    }
+    // A new root signature drops whatever root constants and table were set
+    filter->validConstants = 0;
+    filter->valid &= ~(1u << STATE_FILTER_DESCRIPTOR_TABLE);
+    filter->pipeline = pipeline;
+    rhiCmdSetPipeline(filter->list, pipeline);
+}
+
+void stateFilterSetConstants(StateFilter* filter, const void* values, uint32 count, uint32 firstValue)
+{
+    SGSASSERT(firstValue + count <= STATE_FILTER_MAX_CONSTANTS);
+    const uint32* source = (const uint32*)values;
+    filter->stats.calls[STATE_FILTER_CONSTANTS]++;
+    filter->stats.constantValues += count;
+    if (!filter->enabled)
+    {
+        rhiCmdSetConstants(filter->list, values, count, firstValue);
+        return;
+    }
+
+    // Narrow the call down to the span of values that changed
+    uint32 first = count;
+    uint32 last = 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+        uint32 index = firstValue + i;
+        if (!(filter->validConstants & (1ull << index)) || filter->constants[index] != source[i])
+        {
+            first = first < i ? first : i;
+            last = i;
+            filter->constants[index] = source[i];
+            filter->validConstants |= 1ull << index;
+        }
+    }
+
+    if (first == count)
+    {
+        filter->stats.filtered[STATE_FILTER_CONSTANTS]++;
+        filter->stats.constantValuesFiltered += count;
+        return;
+    }
+    uint32 changed = last - first + 1;
+    filter->stats.constantValuesFiltered += count - changed;
+    rhiCmdSetConstants(filter->list, source + first, changed, firstValue + first);
+}
+
+void stateFilterSetVertexBuffer(StateFilter* filter, uint32 slot, RhiResource* buffer, uint64 offset, uint32 size, uint32 stride)
+{
+    SGSASSERT(slot < RHI_MAX_VERTEX_BUFFERS);
+    StateFilterVertexBuffer& bound = filter->vertexBuffers[slot];
+    uint32 bit = 1u << slot;
+    filter->stats.calls[STATE_FILTER_VERTEX_BUFFER]++;
+    if (filter->enabled && (filter->validVertexBuffers & bit) &&
+        bound.buffer == buffer && bound.offset == offset && bound.size == size && bound.stride == stride)
+    {
+        filter->stats.filtered[STATE_FILTER_VERTEX_BUFFER]++;
+        return;
+    }
+    filter->validVertexBuffers |= bit;
+    bound.buffer = buffer;
+    bound.offset = offset;
+    bound.size = size;
+    bound.stride = stride;
+    rhiCmdSetVertexBuffer(filter->list, slot, buffer, offset, size, stride);
+}
+
+void stateFilterSetIndexBuffer(StateFilter* filter, RhiResource* buffer, uint64 offset, uint32 size, e_rhiFormat format)
+{
+    bool unchanged = filter->indexBuffer == buffer && filter->indexOffset == offset &&
+        filter->indexSize == size && filter->indexFormat == format;
+    if (filterCall(filter, STATE_FILTER_INDEX_BUFFER, unchanged))
+    {
+        return;
+    }
+    filter->indexBuffer = buffer;
+    filter->indexOffset = offset;
+    filter->indexSize = size;
+    filter->indexFormat = format;
+    rhiCmdSetIndexBuffer(filter->list, buffer, offset, size, format);
+}
+
+void stateFilterSetDescriptorHeap(StateFilter* filter, RhiDescriptorHeap* heap)
+{
+    if (filterCall(filter, STATE_FILTER_DESCRIPTOR_HEAP, filter->descriptorHeap == heap))
+    {
+        return;
+    }
+    // The table pointed into the old heap
+    filter->valid &= ~(1u << STATE_FILTER_DESCRIPTOR_TABLE);
+    filter->descriptorHeap = heap;
+    rhiCmdSetDescriptorHeap(filter->list, heap);
+}
+
+void stateFilterSetDescriptorTable(StateFilter* filter, uint32 firstDescriptor)
+{
+    if (filterCall(filter, STATE_FILTER_DESCRIPTOR_TABLE, filter->descriptorTable == firstDescriptor))
+    {
+        return;
+    }
+    filter->descriptorTable = firstDescriptor;
+    rhiCmdSetDescriptorTable(filter->list, firstDescriptor);
+}
+
+void stateFilterGetStats(const StateFilter* filter, StateFilterStats* stats)
+{
+    *stats = filter->stats;
+}
+
+void stateFilterResetStats(StateFilter* filter)
+{
+    memset(&filter->stats, 0, sizeof(StateFilterStats));
+}
+
+const char* stateFilterCallName(e_stateFilterCall call)
+{
+    switch (call)
+    {
+        case STATE_FILTER_VIEWPORT: return "viewport";
+        case STATE_FILTER_SCISSOR: return "scissor";
+        case STATE_FILTER_RENDER_TARGETS: return "render targets";
+        case STATE_FILTER_PIPELINE: return "pipeline";
+        case STATE_FILTER_CONSTANTS: return "constants";
+        case STATE_FILTER_VERTEX_BUFFER: return "vertex buffer";
+        case STATE_FILTER_INDEX_BUFFER: return "index buffer";
+        case STATE_FILTER_DESCRIPTOR_HEAP: return "descriptor heap";
+        case STATE_FILTER_DESCRIPTOR_TABLE: return "descriptor table";
+        default: return "unknown";
+    }
+}
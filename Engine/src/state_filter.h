@@ -0,0 +1,91 @@
+#pragma once
+
+#include "rhi.h"
+
+// Redundant state filtering. A StateFilter shadows what is bound on one command list and drops
+// binds that would set what is already there before they reach the backend. Draws, dispatches,
+// clears, copies and barriers don't change bound state and go to the list directly.
+//
+// Shadow state starts out unknown at stateFilterBegin, like a freshly opened list. Binding a
+// different pipeline forgets the root constants and the descriptor table, since every pipeline has
+// its own root signature, and binding a different descriptor heap forgets the table as well.
+// Anything that binds state on the list without going through the filter must be followed by
+// stateFilterInvalidate. Used by the list's recording thread only.
+
+// Root constants shadowed per list. D3D12 root signatures hold 64 values at most.
+#define STATE_FILTER_MAX_CONSTANTS 64
+
+typedef enum e_stateFilterCall {
+    STATE_FILTER_VIEWPORT = 0,
+    STATE_FILTER_SCISSOR = 1,
+    STATE_FILTER_RENDER_TARGETS = 2,
+    STATE_FILTER_PIPELINE = 3,
+    STATE_FILTER_CONSTANTS = 4,
+    STATE_FILTER_VERTEX_BUFFER = 5,
+    STATE_FILTER_INDEX_BUFFER = 6,
+    STATE_FILTER_DESCRIPTOR_HEAP = 7,
+    STATE_FILTER_DESCRIPTOR_TABLE = 8,
+    STATE_FILTER_CALL_COUNT
+}e_stateFilterCall;
+
+struct StateFilterStats
+{
+    uint64 calls[STATE_FILTER_CALL_COUNT];      // made to the filter
+    uint64 filtered[STATE_FILTER_CALL_COUNT];   // dropped because nothing changed
+    uint64 constantValues;                      // root constant values passed in
+    uint64 constantValuesFiltered;              // unchanged values cut from the calls that went through
+};
+
+struct StateFilterVertexBuffer
+{
+    RhiResource* buffer;
+    uint64 offset;
+    uint32 size;
+    uint32 stride;
+};
+
+struct StateFilter
+{
+    RhiCommandList* list;
+    bool enabled;                       // off forwards every call, for comparisons
+
+    uint32 valid;                       // e_stateFilterCall bits for everything but constants and vertex buffers
+    uint32 validVertexBuffers;          // slot bits
+    uint64 validConstants;              // value bits
+    RhiViewport viewport;
+    RhiRect scissor;
+    RhiResource* colors[RHI_MAX_RENDER_TARGETS];
+    uint32 colorCount;
+    RhiResource* depthStencil;
+    RhiPipeline* pipeline;
+    uint32 constants[STATE_FILTER_MAX_CONSTANTS];
+    StateFilterVertexBuffer vertexBuffers[RHI_MAX_VERTEX_BUFFERS];
+    RhiResource* indexBuffer;
+    uint64 indexOffset;
+    uint32 indexSize;
+    e_rhiFormat indexFormat;
+    RhiDescriptorHeap* descriptorHeap;
+    uint32 descriptorTable;
+
+    StateFilterStats stats;
+};
+
+void stateFilterInitialize(StateFilter* filter, bool enabled = true);
+// Call right after rhiBeginCommandList. Forgets all shadow state, keeps the stats.
+void stateFilterBegin(StateFilter* filter, RhiCommandList* list);
+void stateFilterInvalidate(StateFilter* filter);
+
+void stateFilterSetViewport(StateFilter* filter, const RhiViewport& viewport);
+void stateFilterSetScissor(StateFilter* filter, const RhiRect& rect);
+void stateFilterSetRenderTargets(StateFilter* filter, RhiResource* const* colors, uint32 colorCount, RhiResource* depthStencil);
+void stateFilterSetPipeline(StateFilter* filter, RhiPipeline* pipeline);
+// Only the values that changed are set, as one call covering the first to the last of them
+void stateFilterSetConstants(StateFilter* filter, const void* values, uint32 count, uint32 firstValue);
+void stateFilterSetVertexBuffer(StateFilter* filter, uint32 slot, RhiResource* buffer, uint64 offset, uint32 size, uint32 stride);
+void stateFilterSetIndexBuffer(StateFilter* filter, RhiResource* buffer, uint64 offset, uint32 size, e_rhiFormat format);
+void stateFilterSetDescriptorHeap(StateFilter* filter, RhiDescriptorHeap* heap);
+void stateFilterSetDescriptorTable(StateFilter* filter, uint32 firstDescriptor);
+
+void stateFilterGetStats(const StateFilter* filter, StateFilterStats* stats);
+void stateFilterResetStats(StateFilter* filter);
+const char* stateFilterCallName(e_stateFilterCall call);
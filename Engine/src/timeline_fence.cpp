@@ -0,0 +1,214 @@
+#include <stdlib.h>
+#include <chrono>
+
+#include "timeline_fence.h"
+#include "assertions.h"
+
+// Callbacks run in batches of this many, outside the fence mutex
+#define TIMELINE_CALLBACK_BATCH 16
+// Poll interval for waiters that didn't fit in a fence's waiter list
+#define TIMELINE_POLL_NANOSECONDS 1000000
+
+void timelineFenceInitialize(TimelineFence* fence, uint64 initialValue)
+{
+    fence->completed.store(initialValue, std::memory_order_relaxed);
+    fence->callbacks = nullptr;
+    fence->callbackCount = 0;
+    fence->callbackCapacity = 0;
+    fence->waiterCount = 0;
+}
+
+void timelineFenceShutdown(TimelineFence* fence)
+{
+    SGSASSERT(fence->waiterCount == 0);
+    free(fence->callbacks);
+    fence->callbacks = nullptr;
+    fence->callbackCount = 0;
+    fence->callbackCapacity = 0;
+}
+
+static void runDueCallbacks(TimelineFence* fence)
+{
+    for (;;)
+    {
+        TimelineCallback due[TIMELINE_CALLBACK_BATCH];
+        uint32 dueCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(fence->mutex);
+            uint64 completed = fence->completed.load(std::memory_order_relaxed);
+            uint32 i = 0;
+            while (i < fence->callbackCount && dueCount < TIMELINE_CALLBACK_BATCH)
+            {
+                if (fence->callbacks[i].value <= completed)
+                {
+                    due[dueCount++] = fence->callbacks[i];
+                    fence->callbacks[i] = fence->callbacks[--fence->callbackCount];
+                }
+                else
+                {
+                    i++;
+                }
+            }
+        }
+        if (dueCount == 0)
+        {
+            return;
+        }
+        for (uint32 i = 0; i < dueCount; i++)
+        {
+            due[i].function(due[i].value, due[i].userData);
+        }
+    }
+}
+
+void timelineFenceSignal(TimelineFence* fence, uint64 value)
+{
+    bool hasCallbacks;
+    {
+        std::lock_guard<std::mutex> lock(fence->mutex);
+        if (value <= fence->completed.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        fence->completed.store(value, std::memory_order_release);
+
+        // Under the fence mutex: a waiter unregisters under it before it goes away
+        for (uint32 i = 0; i < fence->waiterCount; i++)
+        {
+            TimelineWaiter* waiter = fence->waiters[i];
+            std::lock_guard<std::mutex> waiterLock(waiter->mutex);
+            waiter->wake.notify_all();
+        }
+        hasCallbacks = fence->callbackCount > 0;
+    }
+    fence->reached.notify_all();
+
+    if (hasCallbacks)
+    {
+        runDueCallbacks(fence);
+    }
+}
+
+bool timelineFenceWait(TimelineFence* fence, uint64 value, int64 timeoutNanoseconds)
+{
+    if (timelineFenceIsComplete(fence, value))
+    {
+        return true;
+    }
+    if (timeoutNanoseconds == 0)
+    {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(fence->mutex);
+    auto reached = [fence, value]() { return fence->completed.load(std::memory_order_relaxed) >= value; };
+    if (timeoutNanoseconds < 0)
+    {
+        fence->reached.wait(lock, reached);
+        return true;
+    }
+    return fence->reached.wait_for(lock, std::chrono::nanoseconds(timeoutNanoseconds), reached);
+}
+
+static bool waitSatisfied(TimelineFence* const* fences, const uint64* values, uint32 count, bool waitAll, int32* index)
+{
+    for (uint32 i = 0; i < count; i++)
+    {
+        bool complete = timelineFenceIsComplete(fences[i], values[i]);
+        if (complete && !waitAll)
+        {
+            *index = (int32)i;
+            return true;
+        }
+        if (!complete && waitAll)
+        {
+            return false;
+        }
+    }
+    *index = waitAll ? (int32)count - 1 : -1;
+    return waitAll;
+}
+
+int32 timelineFenceWaitMany(TimelineFence* const* fences, const uint64* values, uint32 count, bool waitAll, int64 timeoutNanoseconds)
+{
+    SGSASSERT(count > 0);
+    int32 index = -1;
+    if (waitSatisfied(fences, values, count, waitAll, &index) || timeoutNanoseconds == 0)
+    {
+        return index;
+    }
+
+    TimelineWaiter waiter;
+    bool polling = false;
+    for (uint32 i = 0; i < count; i++)
+    {
+        std::lock_guard<std::mutex> lock(fences[i]->mutex);
+        if (fences[i]->waiterCount < TIMELINE_FENCE_MAX_WAITERS)
+        {
+            fences[i]->waiters[fences[i]->waiterCount++] = &waiter;
+        }
+        else
+        {
+            polling = true;
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(timeoutNanoseconds < 0 ? 0 : timeoutNanoseconds);
+    {
+        // Checked under the waiter mutex, which signallers take to notify: no wakeup gets lost
+        std::unique_lock<std::mutex> lock(waiter.mutex);
+        while (!waitSatisfied(fences, values, count, waitAll, &index))
+        {
+            if (timeoutNanoseconds >= 0 && std::chrono::steady_clock::now() >= deadline)
+            {
+                index = -1;
+                break;
+            }
+            if (polling)
+            {
+                waiter.wake.wait_for(lock, std::chrono::nanoseconds(TIMELINE_POLL_NANOSECONDS));
+            }
+            else if (timeoutNanoseconds < 0)
+            {
+                waiter.wake.wait(lock);
+            }
+            else
+            {
+                waiter.wake.wait_until(lock, deadline);
+            }
+        }
+    }
+
+    for (uint32 i = 0; i < count; i++)
+    {
+        std::lock_guard<std::mutex> lock(fences[i]->mutex);
+        for (uint32 j = 0; j < fences[i]->waiterCount; j++)
+        {
+            if (fences[i]->waiters[j] == &waiter)
+            {
+                fences[i]->waiters[j] = fences[i]->waiters[--fences[i]->waiterCount];
+                break;
+            }
+        }
+    }
+    return index;
+}
+
+void timelineFenceOnComplete(TimelineFence* fence, uint64 value, PFN_timelineCallback callback, void* userData)
+{
+    {
+        std::lock_guard<std::mutex> lock(fence->mutex);
+        if (fence->completed.load(std::memory_order_relaxed) < value)
+        {
+            if (fence->callbackCount == fence->callbackCapacity)
+            {
+                fence->callbackCapacity = fence->callbackCapacity ? fence->callbackCapacity * 2 : 16;
+                fence->callbacks = (TimelineCallback*)realloc(fence->callbacks, fence->callbackCapacity * sizeof(TimelineCallback));
+                SGSASSERT(fence->callbacks);
+            }
+            fence->callbacks[fence->callbackCount++] = { value, callback, userData };
+            return;
+        }
+    }
+    callback(value, userData);
+}
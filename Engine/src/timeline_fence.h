@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "defines.h"
+
+// CPU timeline fence: a 64 bit value that only grows. Threads block until it reaches a value,
+// alone or together with other fences, and callbacks can be attached to values. Everything is
+// released by timelineFenceSignal, so waits are a mutex and a condition variable, never a kernel
+// object per wait. The null RHI backend builds its fences on this; CPU jobs that line up with
+// GPU fences can use it directly.
+
+// Threads that can be in timelineFenceWaitMany on one fence at once; more fall back to polling
+#define TIMELINE_FENCE_MAX_WAITERS 16
+
+typedef void (*PFN_timelineCallback)(uint64 value, void* userData);
+
+struct TimelineCallback
+{
+    uint64 value;
+    PFN_timelineCallback function;
+    void* userData;
+};
+
+// One thread waiting on several fences at once
+struct TimelineWaiter
+{
+    std::mutex mutex;
+    std::condition_variable wake;
+};
+
+struct TimelineFence
+{
+    std::atomic<uint64> completed;
+    std::mutex mutex;
+    std::condition_variable reached;
+
+    TimelineCallback* callbacks;    // unordered
+    uint32 callbackCount;
+    uint32 callbackCapacity;
+    TimelineWaiter* waiters[TIMELINE_FENCE_MAX_WAITERS];
+    uint32 waiterCount;
+};
+
+void timelineFenceInitialize(TimelineFence* fence, uint64 initialValue);
+// Callbacks still attached are dropped without running. No thread may be waiting.
+void timelineFenceShutdown(TimelineFence* fence);
+
+// Raises the completed value; values at or below it are ignored. Wakes the waiters it satisfied,
+// then runs the callbacks that became due on the calling thread, in no particular order.
+void timelineFenceSignal(TimelineFence* fence, uint64 value);
+
+inline uint64 timelineFenceCompletedValue(const TimelineFence* fence)
+{
+    return fence->completed.load(std::memory_order_acquire);
+}
+
+inline bool timelineFenceIsComplete(const TimelineFence* fence, uint64 value)
+{
+    return timelineFenceCompletedValue(fence) >= value;
+}
+
+// timeoutNanoseconds < 0 waits forever. False on timeout.
+bool timelineFenceWait(TimelineFence* fence, uint64 value, int64 timeoutNanoseconds = -1);
+// Waits until every fence reached its value, or with waitAll false, until one did. Returns the
+// index of a fence that reached its value, or -1 on timeout.
+int32 timelineFenceWaitMany(TimelineFence* const* fences, const uint64* values, uint32 count, bool waitAll, int64 timeoutNanoseconds = -1);
+
+// Runs callback once the fence reaches value: right away on the calling thread if it already
+// has, otherwise on the thread that signals it. Callbacks may signal fences and attach callbacks.
+void timelineFenceOnComplete(TimelineFence* fence, uint64 value, PFN_timelineCallback callback, void* userData);
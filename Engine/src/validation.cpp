@@ -0,0 +1,55 @@
+#include <string.h>
+
+#include "validation.h"
+#include "logger.h"
+
+e_validationTier validationTier = SGS_VALIDATION_MAX_TIER;
+
+void validationInitialize(e_validationTier tier)
+{
+    if (tier > SGS_VALIDATION_MAX_TIER)
+    {
+        SGSWARN("Validation tier %s is not compiled in, using %s", validationTierName(tier), validationTierName(SGS_VALIDATION_MAX_TIER));
+        tier = SGS_VALIDATION_MAX_TIER;
+    }
+
+    validationTier = tier < VALIDATION_TIER_OFF ? VALIDATION_TIER_OFF : tier;
+    SGSINFO("Validation tier: %s", validationTierName(validationTier));
+}
+
+const char* validationTierName(e_validationTier tier)
+{
+    switch (tier)
+    {
+        case VALIDATION_TIER_OFF: return "off";
+        case VALIDATION_TIER_LIGHT: return "light";
+        case VALIDATION_TIER_FULL: return "full";
+    }
+    return "unknown";
+}
+
+e_validationTier validationTierFromCommandLine(const char* commandLine, e_validationTier fallback)
+{
+    const char* option = commandLine ? strstr(commandLine, "--validation=") : nullptr;
+    if (!option)
+    {
+        return fallback;
+    }
+
+    option += strlen("--validation=");
+    if (strncmp(option, "off", 3) == 0)
+    {
+        return VALIDATION_TIER_OFF;
+    }
+    if (strncmp(option, "light", 5) == 0)
+    {
+        return VALIDATION_TIER_LIGHT;
+    }
+    if (strncmp(option, "full", 4) == 0)
+    {
+        return VALIDATION_TIER_FULL;
+    }
+
+    SGSWARN("Unknown validation tier in '%s'", option);
+    return fallback;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.h"
+
+// Validation tiers, picked once at startup:
+//   off   - nothing is checked, no debug layer, objects are not named
+//   light - assertions and object names, no debug layer
+//   full  - everything: debug layer, SGSASSERT_DEBUG and resource state validation (SGSVALIDATE)
+// SGS_VALIDATION_MAX_TIER caps the tiers compiled in. Checks above it compile away entirely;
+// checks below it cost one predictable branch on a global when the runtime tier disables them.
+
+#define VALIDATION_TIER_OFF 0
+#define VALIDATION_TIER_LIGHT 1
+#define VALIDATION_TIER_FULL 2
+
+#ifndef SGS_VALIDATION_MAX_TIER
+#define SGS_VALIDATION_MAX_TIER VALIDATION_TIER_FULL
+#endif
+
+typedef int32 e_validationTier;
+
+// Written by validationInitialize before any other engine thread starts
+extern e_validationTier validationTier;
+
+void validationInitialize(e_validationTier tier);
+const char* validationTierName(e_validationTier tier);
+// Looks for --validation=off|light|full in a command line, returns fallback if absent
+e_validationTier validationTierFromCommandLine(const char* commandLine, e_validationTier fallback);
+
+#define SGS_VALIDATION_ENABLED(tier) (SGS_VALIDATION_MAX_TIER >= (tier) && validationTier >= (tier))
+
+// Debug names for D3D12 objects
+#define SGSNAME(object, name)                                   \
+    {                                                           \
+        if (SGS_VALIDATION_ENABLED(VALIDATION_TIER_LIGHT))      \
+        {                                                       \
+            (object)->SetName(name);                            \
+        }                                                       \
+    }
@@ -0,0 +1,130 @@
+#include "window_events.h"
+
+static const char* eventTypeNames[WINDOW_EVENT_TYPE_COUNT] = {
+    "NONE", "CLOSE", "RESIZE", "ACTIVATE", "KEY_DOWN", "KEY_UP", "MOUSE_MOVE", "MOUSE_BUTTON", "MOUSE_WHEEL"
+};
+
+void windowEventQueueInitialize(WindowEventQueue* queue, uint32 capacity, bool singleProducer)
+{
+    uint32 size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    queue->cells = new WindowEventCell[size];
+    for (uint32 i = 0; i < size; i++)
+    {
+        queue->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    queue->mask = size - 1;
+    queue->singleProducer = singleProducer;
+    queue->tail = 0;
+    queue->dropped.store(0, std::memory_order_relaxed);
+    queue->head.store(0, std::memory_order_release);
+}
+
+void windowEventQueueShutdown(WindowEventQueue* queue)
+{
+    delete[] queue->cells;
+    queue->cells = nullptr;
+    queue->mask = 0;
+}
+
+// A cell is free for position p when its sequence is p, and holds the event of position p once
+// the producer sets it to p + 1. The consumer hands it back for the next lap with p + capacity.
+bool windowEventPush(WindowEventQueue* queue, const WindowEvent& event)
+{
+    uint64 position = queue->head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        WindowEventCell& cell = queue->cells[position & queue->mask];
+        uint64 sequence = cell.sequence.load(std::memory_order_acquire);
+        int64 difference = (int64)(sequence - position);
+
+        if (difference == 0)
+        {
+            if (queue->singleProducer)
+            {
+                queue->head.store(position + 1, std::memory_order_relaxed);
+                cell.event = event;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            if (queue->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.event = event;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            queue->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = queue->head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+static bool eventReady(WindowEventQueue* queue)
+{
+    const WindowEventCell& cell = queue->cells[queue->tail & queue->mask];
+    return cell.sequence.load(std::memory_order_acquire) == queue->tail + 1;
+}
+
+bool windowEventPop(WindowEventQueue* queue, WindowEvent* event)
+{
+    if (!eventReady(queue))
+    {
+        return false;
+    }
+
+    WindowEventCell& cell = queue->cells[queue->tail & queue->mask];
+    *event = cell.event;
+    cell.sequence.store(queue->tail + queue->mask + 1, std::memory_order_release);
+    queue->tail++;
+    return true;
+}
+
+static bool coalesces(uint32 type)
+{
+    return type == WINDOW_EVENT_RESIZE || type == WINDOW_EVENT_MOUSE_MOVE;
+}
+
+void windowEventDrain(WindowEventQueue* queue, WindowEventBatch* batch)
+{
+    batch->count = 0;
+    batch->popped = 0;
+    batch->moreAvailable = false;
+
+    WindowEvent event;
+    while (batch->count < WINDOW_EVENT_BATCH_SIZE && windowEventPop(queue, &event))
+    {
+        batch->popped++;
+
+        // Only adjacent events merge, so a click still sees the cursor position it happened at
+        if (batch->count > 0 && coalesces(event.type) && batch->events[batch->count - 1].type == event.type)
+        {
+            batch->events[batch->count - 1] = event;
+            continue;
+        }
+        batch->events[batch->count++] = event;
+    }
+
+    batch->moreAvailable = batch->count == WINDOW_EVENT_BATCH_SIZE && eventReady(queue);
+}
+
+uint64 windowEventDroppedCount(WindowEventQueue* queue)
+{
+    return queue->dropped.load(std::memory_order_relaxed);
+}
+
+const char* windowEventTypeName(uint32 type)
+{
+    return type < WINDOW_EVENT_TYPE_COUNT ? eventTypeNames[type] : "?";
+}
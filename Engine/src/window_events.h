@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+
+#include "defines.h"
+
+// Window events travel from the window thread, which owns the message loop, to the frame thread.
+// The window procedure pushes compact events into a bounded lock-free queue and never waits on
+// the frame thread. Once per frame the frame thread drains everything pending into a batch,
+// coalescing resize storms and mouse motion so a burst costs one entry.
+
+#define WINDOW_EVENT_QUEUE_DEFAULT_CAPACITY 4096
+#define WINDOW_EVENT_BATCH_SIZE 256
+
+typedef enum e_windowEventType {
+    WINDOW_EVENT_NONE = 0,
+    WINDOW_EVENT_CLOSE = 1,
+    WINDOW_EVENT_RESIZE = 2,        // a = width, b = height
+    WINDOW_EVENT_ACTIVATE = 3,      // a = 1 when the app gained focus
+    WINDOW_EVENT_KEY_DOWN = 4,      // a = virtual key, b = repeat count
+    WINDOW_EVENT_KEY_UP = 5,        // a = virtual key
+    WINDOW_EVENT_MOUSE_MOVE = 6,    // a = x, b = y
+    WINDOW_EVENT_MOUSE_BUTTON = 7,  // a = button, b = 1 when pressed
+    WINDOW_EVENT_MOUSE_WHEEL = 8,   // a = delta (signed)
+    WINDOW_EVENT_TYPE_COUNT
+}e_windowEventType;
+
+struct WindowEvent
+{
+    uint32 type;
+    int32 a;
+    int32 b;
+    uint32 time;    // milliseconds, as reported by the platform
+};
+
+STATIC_ASSERT(sizeof(WindowEvent) == 16, "Expected WindowEvent to be 16 bytes.");
+
+struct WindowEventCell
+{
+    std::atomic<uint64> sequence;
+    WindowEvent event;
+};
+
+// Bounded multi-producer, single-consumer queue. Each cell carries a sequence number that tells
+// producers and the consumer whose turn it is, so neither side takes a lock. A queue created with
+// singleProducer claims cells without a compare-exchange; only one thread may push to it then.
+struct WindowEventQueue
+{
+    alignas(SGS_CACHE_LINE_SIZE) std::atomic<uint64> head;     // next cell to claim, producers
+    alignas(SGS_CACHE_LINE_SIZE) uint64 tail;                  // next cell to read, consumer only
+    alignas(SGS_CACHE_LINE_SIZE) std::atomic<uint64> dropped;
+    WindowEventCell* cells;
+    uint64 mask;
+    bool singleProducer;
+};
+
+// What one drain produced. Resizes and mouse moves are folded into their latest value; keys,
+// buttons, focus and close keep their order.
+struct WindowEventBatch
+{
+    WindowEvent events[WINDOW_EVENT_BATCH_SIZE];
+    uint32 count;
+    uint32 popped;          // events taken off the queue, before coalescing
+    bool moreAvailable;     // the batch filled up; drain again to get the rest
+};
+
+// capacity is rounded up to a power of two
+void windowEventQueueInitialize(WindowEventQueue* queue, uint32 capacity, bool singleProducer);
+void windowEventQueueShutdown(WindowEventQueue* queue);
+
+// Safe from any thread unless the queue is single producer. Returns false and counts a drop when
+// the queue is full.
+bool windowEventPush(WindowEventQueue* queue, const WindowEvent& event);
+// Consumer only
+bool windowEventPop(WindowEventQueue* queue, WindowEvent* event);
+// Consumer only. Pops until the queue is empty or the batch is full.
+void windowEventDrain(WindowEventQueue* queue, WindowEventBatch* batch);
+
+uint64 windowEventDroppedCount(WindowEventQueue* queue);
+const char* windowEventTypeName(uint32 type);
@@ -1,4 +1,11 @@
 #include <iostream>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #ifndef UNICODE
 #define UNICODE
@@ -7,156 +14,135 @@
 #include "defines.h"
 #include "utils.h"
 #include "logger.h"
+#include "flight_recorder.h"
+#include "assertions.h"
+#include "validation.h"
+#include "window_events.h"
+#include "frame_pacer.h"
+#include "frame_timing.h"
+#include "pass_stats.h"
+#include "render_snapshot.h"
+#include "scene.h"
+#include "batch_render.h"
+#include "startup_graph.h"
+#include "console_variables.h"
+#include "cpu_topology.h"
+#include "rhi.h"
+#include "frame_contexts.h"
+#include "resource_states.h"
+#include "frame_graph.h"
 
 #define global_variable static;
 #define internal static;
 #define local_persist static;
 
-using Microsoft::WRL::ComPtr;
-//using namespace std;
-//using namespace DirectX;
-
-#define FAILED(hr)      (((HRESULT)(hr)) < 0)
-
-struct DxException
-{
-    DxException(HRESULT hr, const std::wstring& functionName, const std::wstring& filename, int lineNumber)
-        : m_errorCode(hr), m_functionName(functionName), m_filename(filename), m_lineNumber(lineNumber) {}
-    HRESULT m_errorCode = S_OK;
-    std::wstring m_functionName;
-    std::wstring m_filename;
-    int32_t m_lineNumber = -1;
-};
-
-inline std::wstring AnsiToWString(const std::string& str)
-{
-    WCHAR buffer[512];
-    MultiByteToWideChar(CP_ACP, 0, str.c_str(), -1, buffer, 512);
-    return std::wstring(buffer);
-}
-
-#ifndef DX_CHECK
-#define DX_CHECK(x)                                                   \
-{                                                                     \
-    HRESULT hr__ = (x);                                               \
-    std::wstring wfn = AnsiToWString(__FILE__);                       \
-    if(FAILED(hr__)) { throw DxException(hr__, L#x, wfn, __LINE__); } \
-}                                                                     
-#endif
-//std::cout << "[ERROR]"<< hr__ <<std::endl;
-//if(FAILED(hr__)) { std::cout << "[ERROR]"<< hr__ <<std::endl; }    \        
-
-struct D3DFence
-{
-    Microsoft::WRL::ComPtr<ID3D12Fence> handle;
-    uint64_t currentFence = 0;
-};
-
-struct D3DDescriptorSizes
-{
-    uint32_t rtv;
-    uint32_t dsv;
-    uint32_t srv_uav_cbv;
-};
-
-struct D3DSwapChain
-{
-    Microsoft::WRL::ComPtr<IDXGISwapChain> handle;
-    static const uint32_t bufferCount = 2;
-    uint32_t currentBackBuffer = 0;
-    Microsoft::WRL::ComPtr<ID3D12Resource> imageBuffer[bufferCount];
-    Microsoft::WRL::ComPtr<ID3D12Resource> depthStencilBuffer;
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtvHeap;
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsvHeap;
-};
-
-struct D3DComponents
-{
-    Microsoft::WRL::ComPtr<IDXGIFactory4> dxgiFactory;
-    Microsoft::WRL::ComPtr<ID3D12Device> logicalDevice;
-    D3DSwapChain swapChain;
-};
-
-struct D3DCommands
-{
-    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue;
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> directCmdListAlloc;
-    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
-};
-
-struct WindowImageInfo
-{
-    DXGI_FORMAT backBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-    DXGI_FORMAT depthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
-    uint32_t clientWidth = 800;
-    uint32_t clientHeight = 600;
-    D3D12_VIEWPORT screenViewport;
-    D3D12_RECT scissorRect;
-};
-
-struct D3DSyncPrimitives
-{
-    D3DFence fence;
-};
-
-struct D3DFeaturesSupport
-{
-    bool msaa4xState = false;
-    uint32_t msaa4xQuality;
-};
+// Asks the window thread to destroy the window and leave its message loop
+#define WM_APP_SHUTDOWN (WM_APP + 1)
 
 struct D3DApp
 {
+    // Only touched by the simulation (main) thread
     bool running = false;
     HWND windowHandle;
     HINSTANCE hInstance;
-} d3dApp;
-
-struct D3DDevice
-{
-    Microsoft::WRL::ComPtr<IDXGIFactory4> dxgiFactory;
-    Microsoft::WRL::ComPtr<ID3D12Device> logicalDevice;
-
-    D3DFeaturesSupport features;
-    D3DDescriptorSizes descriptorSizes;
 
-    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue;
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> directCmdListAlloc;
-    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
-};
+    // Window thread; created the window and runs its message loop
+    std::thread windowThread;
+    std::mutex windowMutex;
+    std::condition_variable windowCreated;
+    bool windowReady = false;
+    WindowEventQueue events;
+
+    // The simulation thread runs the scene and publishes a snapshot per frame; the render thread
+    // records, submits and waits for the GPU on the previous one
+    Scene scene;
+    SnapshotExchange snapshots;
+    std::thread renderThread;
+
+    FramePacer pacer;       // simulation thread
+    FrameTiming timing;     // written by the render thread
+    char frameCsvPath[260];
+    PassStats passStats;    // written by the render thread
+    char passStatsPath[260];
+
+    // Init tasks, see BuildStartupGraph. Kept after startup so lazy tasks can still be required.
+    StartupGraph startup;
+    uint32 msaaTask;
+    const char* commandLine;
+
+    // Registered in RegisterConsoleVariables before anything reads them
+    struct
+    {
+        ConsoleVariable* windowWidth;
+        ConsoleVariable* windowHeight;
+        ConsoleVariable* swapChainBuffers;
+        ConsoleVariable* msaa;
+        ConsoleVariable* backend;
+        ConsoleVariable* framesInFlight;
+        ConsoleVariable* fps;
+        ConsoleVariable* logLevel;
+        ConsoleVariable* passCounters;
+        ConsoleVariable* threadPlacement;
+        ConsoleVariable* placements[ENGINE_THREAD_COUNT];
+    } cvars;
+} d3dApp;
 
-struct D3DState
+// Everything the renderer owns. The render thread is the only user once startup finished.
+struct RenderState
 {
-    D3DDevice device;
-    D3DSwapChain swapChain;
-
-    D3DFence fence;
-
-    DXGI_FORMAT backBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-    DXGI_FORMAT depthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
-    uint32_t clientWidth = 800;
-    uint32_t clientHeight = 600;
-    D3D12_VIEWPORT screenViewport;
-    D3D12_RECT scissorRect;
-
-} D3DState;
-
-ID3D12Resource* CurrentBackBuffer()
+    RhiDevice* device;
+    RhiQueue* queue;
+    RhiCommandList* commandList;
+    // Runs ahead of commandList with the transitions its first uses need, see resourceStateResolve
+    RhiCommandList* fixupList;
+    // Command allocators, upload memory and the frame fence, one set per frame in flight
+    FrameContexts frames;
+    uint32 framesInFlight = 2;      // render.frames_in_flight
+
+    RhiSwapChain* swapChain;
+    uint32 bufferCount = 2;         // swapchain.buffers
+    // States of the swapchain buffers; the tracker records commandList's barriers
+    ResourceStateRegistry resourceStates;
+    ResourceStateTracker barriers;
+    // Declared by DrawFrame every frame; owns the depth and MSAA targets
+    FrameGraph frameGraph;
+
+    e_rhiBackend backend = RHI_BACKEND_D3D12;
+    e_rhiFormat backBufferFormat = RHI_FORMAT_RGBA8_UNORM;
+    e_rhiFormat depthStencilFormat = RHI_FORMAT_D24_UNORM_S8_UINT;
+    bool msaa4xState = false;
+    uint32 msaa4xQuality;
+    uint32 clientWidth = 800;
+    uint32 clientHeight = 600;
+    RhiViewport screenViewport;
+    RhiRect scissorRect;
+    // Latest client size from WM_SIZE, width << 32 | height, 0 when there is nothing to do
+    std::atomic<uint64> requestedSize;
+} renderState;
+
+RhiResource* CurrentBackBuffer()
 {
-    return D3DState.swapChain.imageBuffer[D3DState.swapChain.currentBackBuffer].Get();
+    return rhiSwapChainBuffer(renderState.swapChain, rhiSwapChainCurrentIndex(renderState.swapChain));
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE CurrentBackBufferView()
+// Runs on the window thread. Messages become WindowEvents for the frame thread; nothing here may
+// wait on rendering.
+static void PushWindowEvent(e_windowEventType type, int32 a, int32 b)
 {
-    return CD3DX12_CPU_DESCRIPTOR_HANDLE(
-        D3DState.swapChain.rtvHeap->GetCPUDescriptorHandleForHeapStart(),
-        D3DState.swapChain.currentBackBuffer,
-        D3DState.device.descriptorSizes.rtv);
-}
+    WindowEvent event;
+    event.type = type;
+    event.a = a;
+    event.b = b;
+    event.time = (uint32)GetMessageTime();
 
-D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView()
-{
-    return D3DState.swapChain.dsvHeap->GetCPUDescriptorHandleForHeapStart();
+    if (!windowEventPush(&d3dApp.events, event) && type == WINDOW_EVENT_CLOSE)
+    {
+        // Input can be dropped under pressure, a close request can't
+        while (!windowEventPush(&d3dApp.events, event))
+        {
+            std::this_thread::yield();
+        }
+    }
 }
 
 LRESULT CALLBACK
@@ -168,28 +154,66 @@ MainWindowCallback(HWND window, UINT message, WPARAM wParam, LPARAM lParam)
     {
         case WM_SIZE:
         {
-            logOutput(LOG_LEVEL_INFO, "WM_SIZE\n");
-            //OutputDebugStringA("WM_SIZE\n");
+            PushWindowEvent(WINDOW_EVENT_RESIZE, (int32)LOWORD(lParam), (int32)HIWORD(lParam));
         } break;
 
         case WM_DESTROY:
         {
-            d3dApp.running = false;
-            logOutput(LOG_LEVEL_INFO, "WM_DESTROY\n");
-            //OutputDebugStringA("WM_DESTROY\n");
+            SGSINFO_CAT(LOG_CATEGORY_WINDOW, "WM_DESTROY\n");
+            PostQuitMessage(0);
         } break;
 
         case WM_CLOSE:
         {
-            d3dApp.running = false;
-            logOutput(LOG_LEVEL_INFO, "WM_CLOSE\n");
-            //OutputDebugStringA("WM_CLOSE\n");
+            // The frame thread decides when to shut down, see WM_APP_SHUTDOWN
+            PushWindowEvent(WINDOW_EVENT_CLOSE, 0, 0);
         } break;
 
         case WM_ACTIVATEAPP:
         {
-            logOutput(LOG_LEVEL_INFO, "WM_ACTIVATEAPP\n");
-            //OutputDebugStringA("WM_ACTIVATEAPP\n");
+            PushWindowEvent(WINDOW_EVENT_ACTIVATE, wParam ? 1 : 0, 0);
+        } break;
+
+        case WM_KEYDOWN:
+        case WM_SYSKEYDOWN:
+        {
+            PushWindowEvent(WINDOW_EVENT_KEY_DOWN, (int32)wParam, (int32)(lParam & 0xFFFF));
+            result = DefWindowProc(window, message, wParam, lParam);
+        } break;
+
+        case WM_KEYUP:
+        case WM_SYSKEYUP:
+        {
+            PushWindowEvent(WINDOW_EVENT_KEY_UP, (int32)wParam, 0);
+            result = DefWindowProc(window, message, wParam, lParam);
+        } break;
+
+        case WM_MOUSEMOVE:
+        {
+            PushWindowEvent(WINDOW_EVENT_MOUSE_MOVE, (int32)(int16)LOWORD(lParam), (int32)(int16)HIWORD(lParam));
+        } break;
+
+        case WM_LBUTTONDOWN:
+        case WM_LBUTTONUP:
+        case WM_RBUTTONDOWN:
+        case WM_RBUTTONUP:
+        case WM_MBUTTONDOWN:
+        case WM_MBUTTONUP:
+        {
+            int32 button = (message == WM_LBUTTONDOWN || message == WM_LBUTTONUP) ? 0 :
+                (message == WM_RBUTTONDOWN || message == WM_RBUTTONUP) ? 1 : 2;
+            int32 pressed = (message == WM_LBUTTONDOWN || message == WM_RBUTTONDOWN || message == WM_MBUTTONDOWN) ? 1 : 0;
+            PushWindowEvent(WINDOW_EVENT_MOUSE_BUTTON, button, pressed);
+        } break;
+
+        case WM_MOUSEWHEEL:
+        {
+            PushWindowEvent(WINDOW_EVENT_MOUSE_WHEEL, (int32)GET_WHEEL_DELTA_WPARAM(wParam), 0);
+        } break;
+
+        case WM_APP_SHUTDOWN:
+        {
+            DestroyWindow(window);
         } break;
             
         default:
@@ -215,6 +239,10 @@ bool InitWindow()
     windowClass.lpszMenuName = 0;
     windowClass.lpszClassName = L"MainWindow";
 
+    // The client area gets the requested size, the frame goes around it
+    RECT windowRect = { 0, 0, (LONG)renderState.clientWidth, (LONG)renderState.clientHeight };
+    AdjustWindowRect(&windowRect, WS_OVERLAPPEDWINDOW, false);
+
     if (!RegisterClass(&windowClass))
     {
         // TODO: handle error
@@ -229,8 +257,8 @@ bool InitWindow()
         WS_OVERLAPPEDWINDOW | WS_VISIBLE,
         CW_USEDEFAULT,
         CW_USEDEFAULT,
-        CW_USEDEFAULT,
-        CW_USEDEFAULT,
+        windowRect.right - windowRect.left,
+        windowRect.bottom - windowRect.top,
         0,
         0,
         d3dApp.hInstance,
@@ -246,314 +274,693 @@ bool InitWindow()
     return true;
 }
 
-void InitDirect3D()
+// A window belongs to the thread that created it, so the window thread creates it and then pumps
+// its messages until WM_QUIT. GetMessage blocks, the thread sleeps when there is no input.
+void WindowThreadMain()
 {
-   // init Direct3D 12
-    ComPtr<ID3D12Debug> debugController;
-    D3D12GetDebugInterface(IID_PPV_ARGS(&debugController));
-    debugController->EnableDebugLayer();
+    cpuPlacementAttachThread(ENGINE_THREAD_WINDOW, 0);
+    bool created = InitWindow();
+    {
+        std::lock_guard<std::mutex> lock(d3dApp.windowMutex);
+        d3dApp.windowReady = true;
+        if (!created)
+        {
+            d3dApp.windowHandle = 0;
+        }
+    }
+    d3dApp.windowCreated.notify_one();
 
-    // TODO: Manage possible errors
-    DX_CHECK(CreateDXGIFactory1(IID_PPV_ARGS(&D3DState.device.dxgiFactory)));
+    if (!created)
+    {
+        cpuPlacementDetachThread();
+        return;
+    }
 
-    // Get hardware adapter
-    // TODO: Enumerate hardware adapters and pick the most suitable one
-    HRESULT deviceResult = D3D12CreateDevice(
-        nullptr, 
-        D3D_FEATURE_LEVEL_11_0, 
-        IID_PPV_ARGS(&D3DState.device.logicalDevice));
+    MSG message = {};
+    while (GetMessage(&message, 0, 0, 0) > 0)
+    {
+        TranslateMessage(&message);
+        DispatchMessage(&message);
+    }
+    cpuPlacementDetachThread();
+}
+
+bool StartWindowThread()
+{
+    // Only the window procedure pushes, and it only runs on the window thread
+    windowEventQueueInitialize(&d3dApp.events, WINDOW_EVENT_QUEUE_DEFAULT_CAPACITY, true);
+    d3dApp.windowThread = std::thread(WindowThreadMain);
+
+    std::unique_lock<std::mutex> lock(d3dApp.windowMutex);
+    d3dApp.windowCreated.wait(lock, []() { return d3dApp.windowReady; });
+    return d3dApp.windowHandle != 0;
+}
 
-    // If no hardware device, get WARP device
-    if (FAILED(deviceResult))
+void StopWindowThread()
+{
+    if (d3dApp.windowHandle)
     {
-        // TODO: Warn the user about not found hardware device
-        ComPtr<IDXGIAdapter> pWarpAdapter;
-        D3DState.device.dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&pWarpAdapter));
+        PostMessage(d3dApp.windowHandle, WM_APP_SHUTDOWN, 0, 0);
+    }
+    d3dApp.windowThread.join();
 
-        DX_CHECK(D3D12CreateDevice(
-            pWarpAdapter.Get(),
-            D3D_FEATURE_LEVEL_11_0,
-            IID_PPV_ARGS(&D3DState.device.logicalDevice)));
+    uint64 dropped = windowEventDroppedCount(&d3dApp.events);
+    if (dropped)
+    {
+        SGSWARN_CAT(LOG_CATEGORY_WINDOW, "%llu window events dropped, the event queue was full", (unsigned long long)dropped);
     }
+    windowEventQueueShutdown(&d3dApp.events);
+}
 
-    // synchcronitzation primitives
-    DX_CHECK(D3DState.device.logicalDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE,
-        IID_PPV_ARGS(&D3DState.fence.handle)));
+// Startup tasks. Each one is a node of the startup graph built in BuildStartupGraph; the
+// dependencies are declared there.
+bool InitRenderDevice(void* userData)
+{
+    RhiDeviceConfig config;
+    config.backend = renderState.backend;
+    config.debugLayer = SGS_VALIDATION_ENABLED(VALIDATION_TIER_FULL);
+    renderState.device = rhiCreateDevice(config);
+    if (!renderState.device)
+    {
+        return false;
+    }
+    renderState.queue = rhiGetQueue(renderState.device, RHI_QUEUE_DIRECT);
+    return true;
+}
 
-    // descriptor sizes
-    D3DState.device.descriptorSizes.rtv = D3DState.device.logicalDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    D3DState.device.descriptorSizes.dsv = D3DState.device.logicalDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-    D3DState.device.descriptorSizes.srv_uav_cbv = D3DState.device.logicalDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+bool InitFrameContexts(void* userData)
+{
+    FrameContextsConfig config;
+    config.count = renderState.framesInFlight;
+    return frameContextsInitialize(&renderState.frames, renderState.device, config);
+}
 
+// Lazy: only required once 4x MSAA is switched on
+bool InitMsaaSupport(void* userData)
+{
     // Check 4x MSAA quality support
-    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msaaQualityLevels;
-    msaaQualityLevels.Format = D3DState.backBufferFormat;
-    msaaQualityLevels.SampleCount = 4;
-    msaaQualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
-    msaaQualityLevels.NumQualityLevels = 0;
-
-    DX_CHECK(D3DState.device.logicalDevice->CheckFeatureSupport(
-        D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS,
-        &msaaQualityLevels,
-        sizeof(msaaQualityLevels)));
-
-    D3DState.device.features.msaa4xQuality = msaaQualityLevels.NumQualityLevels;
-    assert(D3DState.device.features.msaa4xQuality > 0);
-
-    // create command objects
-    D3D12_COMMAND_QUEUE_DESC queueDescription = {};
-    queueDescription.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-    queueDescription.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-    DX_CHECK(D3DState.device.logicalDevice->CreateCommandQueue(&queueDescription, IID_PPV_ARGS(&D3DState.device.commandQueue)));
-
-    DX_CHECK(D3DState.device.logicalDevice->CreateCommandAllocator(
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-        IID_PPV_ARGS(D3DState.device.directCmdListAlloc.GetAddressOf())));
-
-    DX_CHECK(D3DState.device.logicalDevice->CreateCommandList(
-        0,
-        D3D12_COMMAND_LIST_TYPE_DIRECT,
-        D3DState.device.directCmdListAlloc.Get(),
-        nullptr,
-        IID_PPV_ARGS(D3DState.device.commandList.GetAddressOf())));
+    renderState.msaa4xQuality = rhiGetMsaaQualityLevels(renderState.device, renderState.backBufferFormat, 4);
+    SGSASSERT(renderState.msaa4xQuality > 0);
+    return true;
+}
+
+bool InitCommandObjects(void* userData)
+{
+    renderState.commandList = rhiCreateCommandList(renderState.device, RHI_QUEUE_DIRECT, "direct command list");
+    renderState.fixupList = rhiCreateCommandList(renderState.device, RHI_QUEUE_DIRECT, "fixup command list");
+    SGSRECORD(FLIGHT_EVENT_RESOURCE_CREATE, "command list", 0);
+    resourceStateRegistryInitialize(&renderState.resourceStates);
+    resourceStateTrackerInitialize(&renderState.barriers, &renderState.resourceStates);
+    frameGraphInitialize(&renderState.frameGraph, renderState.device, &renderState.frames.releases);
+    return renderState.commandList != nullptr && renderState.fixupList != nullptr;
+}
 
-    D3DState.device.commandList->Close();
+bool InitWindowTask(void* userData)
+{
+    return StartWindowThread();
+}
+
+// The depth and MSAA targets follow the client size through the frame graph
+void UpdateScreenViewport()
+{
+    // update the viewport transform to cover the client area
+    renderState.screenViewport = { 0.0f, 0.0f, (float32)renderState.clientWidth, (float32)renderState.clientHeight, 0.0f, 1.0f };
+    renderState.scissorRect = { 0, 0, (int32)renderState.clientWidth, (int32)renderState.clientHeight };
+}
+
+// Swapchain buffers start out, and are replaced by resizes, in the PRESENT state
+void RegisterSwapChainBuffers(bool registered)
+{
+    for (uint32 i = 0; i < renderState.bufferCount; i++)
+    {
+        RhiResource* buffer = rhiSwapChainBuffer(renderState.swapChain, i);
+        if (registered)
+        {
+            resourceStateRegister(&renderState.resourceStates, buffer, RHI_STATE_PRESENT);
+        }
+        else
+        {
+            resourceStateUnregister(&renderState.resourceStates, buffer);
+        }
+    }
+}
 
-    // create swapchain
-    D3DState.swapChain.handle.Reset();
+// Render thread, between frames. The frame graph sees the new size on the next frame and sends
+// the old depth and MSAA targets to the release queue; only the swapchain waits, because DXGI
+// resizes its buffers once no frame in flight uses them.
+bool ResizeRenderTargets(uint32 width, uint32 height)
+{
+    rhiFenceWait(renderState.frames.fence, frameContextsRetireValue(&renderState.frames));
+    RegisterSwapChainBuffers(false);
+    bool resized = rhiResizeSwapChain(renderState.swapChain, width, height);
+    RegisterSwapChainBuffers(true);
+    if (!resized)
+    {
+        return false;
+    }
+    renderState.clientWidth = width;
+    renderState.clientHeight = height;
+    UpdateScreenViewport();
+    return true;
+}
 
-    DXGI_SWAP_CHAIN_DESC swapChainDescription = {};
-    swapChainDescription.BufferDesc.Width = D3DState.clientWidth;
-    swapChainDescription.BufferDesc.Height = D3DState.clientHeight;
-    swapChainDescription.BufferDesc.RefreshRate.Numerator = 60;
-    swapChainDescription.BufferDesc.RefreshRate.Denominator = 1;
-    swapChainDescription.BufferDesc.Format = D3DState.backBufferFormat;
-    swapChainDescription.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-    swapChainDescription.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-    swapChainDescription.SampleDesc.Count = D3DState.device.features.msaa4xState ? 4 : 1;
-    swapChainDescription.SampleDesc.Quality = D3DState.device.features.msaa4xState ? (D3DState.device.features.msaa4xQuality - 1) : 0;
-    swapChainDescription.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDescription.BufferCount = D3DState.swapChain.bufferCount;
-    swapChainDescription.OutputWindow = d3dApp.windowHandle;
-    swapChainDescription.Windowed = true;
-    swapChainDescription.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapChainDescription.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
-
-    HRESULT result;
-    DX_CHECK(D3DState.device.dxgiFactory->CreateSwapChain(
-        D3DState.device.commandQueue.Get(),
-        &swapChainDescription,
-        D3DState.swapChain.handle.GetAddressOf()));
-
-    // create rtv and dsv descriptor heaps (image views)
-    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDescriptor = {};
-    rtvHeapDescriptor.NumDescriptors = D3DState.swapChain.bufferCount;
-    rtvHeapDescriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-    rtvHeapDescriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    rtvHeapDescriptor.NodeMask = 0;
-
-    DX_CHECK(D3DState.device.logicalDevice->CreateDescriptorHeap(
-        &rtvHeapDescriptor, 
-        IID_PPV_ARGS(D3DState.swapChain.rtvHeap.GetAddressOf())));
-
-    D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDescriptor = {};
-    dsvHeapDescriptor.NumDescriptors = 1;
-    dsvHeapDescriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-    dsvHeapDescriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    dsvHeapDescriptor.NodeMask = 0;
-
-    DX_CHECK(D3DState.device.logicalDevice->CreateDescriptorHeap(
-        &dsvHeapDescriptor,
-        IID_PPV_ARGS(D3DState.swapChain.dsvHeap.GetAddressOf())));
-
-    // resize code
-    assert(D3DState.device.logicalDevice);
-    assert(D3DState.swapChain.handle);
-    assert(D3DState.device.directCmdListAlloc);
-
-    // flush command queue
-    D3DState.fence.currentFence++;
-
-    D3DState.device.commandQueue->Signal(D3DState.fence.handle.Get(), D3DState.fence.currentFence);
-
-    if(D3DState.fence.handle->GetCompletedValue() < D3DState.fence.currentFence)
-    {
-        HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-
-        D3DState.fence.handle->SetEventOnCompletion(D3DState.fence.currentFence, eventHandle);
-
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
-    }
-
-    DX_CHECK(D3DState.device.commandList->Reset(D3DState.device.directCmdListAlloc.Get(), nullptr));
-
-    // release swapchain resources
-    for (int i = 0; i < D3DState.swapChain.bufferCount; i++)
-    {
-        D3DState.swapChain.imageBuffer[i].Reset();
-    }
-
-    D3DState.swapChain.depthStencilBuffer.Reset();
-
-    // resize the swapchain
-    DX_CHECK(D3DState.swapChain.handle->ResizeBuffers(
-        D3DState.swapChain.bufferCount,
-        D3DState.clientWidth, D3DState.clientHeight,
-        D3DState.backBufferFormat,
-        DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH));
-
-    D3DState.swapChain.currentBackBuffer = 0;
-
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHeapHandle(D3DState.swapChain.rtvHeap->GetCPUDescriptorHandleForHeapStart());
-    for (uint32 i = 0; i < D3DState.swapChain.bufferCount; i++)
-    {
-        DX_CHECK(D3DState.swapChain.handle->GetBuffer(i, IID_PPV_ARGS(&D3DState.swapChain.imageBuffer[i])));
-        D3DState.device.logicalDevice->CreateRenderTargetView(D3DState.swapChain.imageBuffer[i].Get(), nullptr, rtvHeapHandle);
-        rtvHeapHandle.Offset(1, D3DState.device.descriptorSizes.rtv);
-    }
-
-    // create the depth/stencil buffer and view
-    D3D12_RESOURCE_DESC depthStencilDescription = {};
-    depthStencilDescription.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    depthStencilDescription.Alignment = 0;
-    depthStencilDescription.Width = D3DState.clientWidth;
-    depthStencilDescription.Height = D3DState.clientHeight;
-    depthStencilDescription.DepthOrArraySize = 1;
-    depthStencilDescription.MipLevels = 1;
-    depthStencilDescription.Format = DXGI_FORMAT_R24G8_TYPELESS;
-    depthStencilDescription.SampleDesc.Count = D3DState.device.features.msaa4xState ? 4 : 1;
-    depthStencilDescription.SampleDesc.Quality = D3DState.device.features.msaa4xState ? (D3DState.device.features.msaa4xState - 1) : 0;
-    depthStencilDescription.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-    depthStencilDescription.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+// Needs the window, the command objects and the frame contexts
+bool InitSwapChain(void* userData)
+{
+    if (renderState.msaa4xState && !startupGraphRequire(&d3dApp.startup, d3dApp.msaaTask))
+    {
+        return false;
+    }
 
-    D3D12_CLEAR_VALUE optClear;
-    optClear.Format = D3DState.depthStencilFormat;
-    optClear.DepthStencil.Depth = 1.0f;
-    optClear.DepthStencil.Stencil = 0;
-    DX_CHECK(D3DState.device.logicalDevice->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-        D3D12_HEAP_FLAG_NONE,
-        &depthStencilDescription,
-        D3D12_RESOURCE_STATE_COMMON,
-        &optClear,
-        IID_PPV_ARGS(D3DState.swapChain.depthStencilBuffer.GetAddressOf())));
+    RhiSwapChainDesc swapChainDescription;
+    swapChainDescription.window = d3dApp.windowHandle;
+    swapChainDescription.width = renderState.clientWidth;
+    swapChainDescription.height = renderState.clientHeight;
+    swapChainDescription.bufferCount = renderState.bufferCount;
+    swapChainDescription.format = renderState.backBufferFormat;
+    renderState.swapChain = rhiCreateSwapChain(renderState.device, renderState.queue, swapChainDescription);
+    if (!renderState.swapChain)
+    {
+        return false;
+    }
+    RegisterSwapChainBuffers(true);
+    UpdateScreenViewport();
+    return true;
+}
 
-    D3D12_DEPTH_STENCIL_VIEW_DESC dsvViewDescription = {};
-    dsvViewDescription.Flags = D3D12_DSV_FLAG_NONE;
-    dsvViewDescription.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-    dsvViewDescription.Format = D3DState.depthStencilFormat;
-    dsvViewDescription.Texture2D.MipSlice = 0;
-    D3DState.device.logicalDevice->CreateDepthStencilView(D3DState.swapChain.depthStencilBuffer.Get(), &dsvViewDescription, DepthStencilView());
+// Everything the render thread created, once it stopped
+void ShutdownRenderer()
+{
+    if (!renderState.device)
+    {
+        return;
+    }
+    frameContextsShutdown(&renderState.frames);
+    frameGraphShutdown(&renderState.frameGraph);
+    if (renderState.swapChain)
+    {
+        rhiDestroySwapChain(renderState.swapChain);
+    }
+    if (renderState.commandList)
+    {
+        rhiDestroyCommandList(renderState.commandList);
+    }
+    if (renderState.fixupList)
+    {
+        rhiDestroyCommandList(renderState.fixupList);
+    }
+    resourceStateTrackerShutdown(&renderState.barriers);
+    resourceStateRegistryShutdown(&renderState.resourceStates);
+    rhiDestroyDevice(renderState.device);
+    renderState.device = nullptr;
+    renderState.swapChain = nullptr;
+    renderState.commandList = nullptr;
+    renderState.fixupList = nullptr;
+}
 
-    // transition the resource from its initial state to be used as a depth buffer
-    D3DState.device.commandList->ResourceBarrier(
-        1,
-        &CD3DX12_RESOURCE_BARRIER::Transition(
-            D3DState.swapChain.depthStencilBuffer.Get(),
-            D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+bool InitFramePacing(void* userData)
+{
+    FramePacerConfig pacerConfig;
+    pacerConfig.targetFps = cvarFloat(d3dApp.cvars.fps);
+    framePacerInitialize(&d3dApp.pacer, pacerConfig);
+
+    FrameTimingConfig timingConfig;
+    frameTimingInitialize(&d3dApp.timing, timingConfig);
+    // --frame-csv=path writes the last FRAME_TIMING_WINDOW frames on exit
+    const char* csvOption = strstr(d3dApp.commandLine, "--frame-csv=");
+    if (csvOption)
+    {
+        sscanf(csvOption + strlen("--frame-csv="), "%259s", d3dApp.frameCsvPath);
+    }
 
-    // execute resize commands
-    DX_CHECK(D3DState.device.commandList->Close());
-    ID3D12CommandList* cmdsLists[] = { D3DState.device.commandList.Get() };
-    D3DState.device.commandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+    // --pass-stats=path writes the last PASS_STATS_HISTORY frames' pass counters on exit, as JSON
+    // if path ends in .json and as CSV otherwise
+    passStatsInitialize(&d3dApp.passStats);
+    const char* passStatsOption = strstr(d3dApp.commandLine, "--pass-stats=");
+    if (passStatsOption)
+    {
+        sscanf(passStatsOption + strlen("--pass-stats="), "%259s", d3dApp.passStatsPath);
+    }
+    return true;
+}
 
-    // flush command queue
-    D3DState.fence.currentFence++;
+bool InitScene(void* userData)
+{
+    const uint32 sceneObjects = 1024;
+    sceneInitialize(&d3dApp.scene, sceneObjects, 1);
+    d3dApp.scene.aspectRatio = (float32)renderState.clientWidth / (float32)renderState.clientHeight;
+    snapshotExchangeInitialize(&d3dApp.snapshots, sceneObjects);
+    return true;
+}
 
-    DX_CHECK(D3DState.device.commandQueue->Signal(D3DState.fence.handle.Get(), D3DState.fence.currentFence));
+void OnFpsChanged(ConsoleVariable* cvar, void* userData)
+{
+    framePacerSetTargetFps(&d3dApp.pacer, cvarFloat(cvar));
+}
 
-    if(D3DState.fence.handle->GetCompletedValue() < D3DState.fence.currentFence)
+void OnLogLevelChanged(ConsoleVariable* cvar, void* userData)
+{
+    for (uint32 i = 0; i < LOG_CATEGORY_COUNT; i++)
     {
-        HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+        logSetCategoryLevel((e_logCategory)i, (e_logLevel)cvarInt(cvar));
+    }
+}
 
-        DX_CHECK(D3DState.fence.handle->SetEventOnCompletion(D3DState.fence.currentFence, eventHandle));
+// Defaults, then --config=path (sandbox.cfg if present), then +name=value on the command line.
+// Init only variables are copied into the startup state here; the rest are read where used.
+void RegisterConsoleVariables(const char* commandLine)
+{
+    d3dApp.cvars.windowWidth = cvarRegisterInt("window.width", 800, 320, 7680, "client area width", CVAR_FLAG_INIT_ONLY);
+    d3dApp.cvars.windowHeight = cvarRegisterInt("window.height", 600, 240, 4320, "client area height", CVAR_FLAG_INIT_ONLY);
+    d3dApp.cvars.framesInFlight = cvarRegisterInt("render.frames_in_flight", 2, 1, FRAME_CONTEXT_MAX, "frames the CPU may record ahead of the GPU", CVAR_FLAG_INIT_ONLY);
+    d3dApp.cvars.swapChainBuffers = cvarRegisterInt("swapchain.buffers", 2, 2, RHI_MAX_SWAPCHAIN_BUFFERS, "swapchain images", CVAR_FLAG_INIT_ONLY);
+    d3dApp.cvars.msaa = cvarRegisterBool("render.msaa", false, "4x MSAA back buffer", CVAR_FLAG_INIT_ONLY);
+    // The null backend runs the whole frame loop without presenting anything
+    d3dApp.cvars.backend = cvarRegisterInt("render.backend", RHI_BACKEND_D3D12, RHI_BACKEND_NULL, RHI_BACKEND_D3D12, "0 null, 1 d3d12", CVAR_FLAG_INIT_ONLY);
+    // --fps=N is still accepted as the default
+    d3dApp.cvars.fps = cvarRegisterFloat("pacer.fps", (float32)framePacerFpsFromCommandLine(commandLine, 144.0), 0.0f, 1000.0f, "frame rate cap, 0 uncapped");
+    d3dApp.cvars.logLevel = cvarRegisterInt("log.level", LOG_LEVEL_TRACE, LOG_LEVEL_FATAL, LOG_LEVEL_TRACE, "most verbose level logged, all categories");
+    cvarSetCallback(d3dApp.cvars.logLevel, OnLogLevelChanged, nullptr);
+    // Independent of the validation tier, compiled out with RHI_PASS_COUNTERS_ENABLED 0
+    d3dApp.cvars.passCounters = cvarRegisterBool("render.pass_counters", true, "count commands per pass for --pass-stats");
+
+    // cpu.<role>=N takes an e_threadPlacement: 0 any, 1 performance, 2 efficiency, 3 pin, 4 exclusive core
+    d3dApp.cvars.threadPlacement = cvarRegisterBool("cpu.placement", true, "apply thread placement policies", CVAR_FLAG_INIT_ONLY);
+    e_threadPlacement defaultPlacements[ENGINE_THREAD_COUNT];
+    cpuPlacementDefaultPolicies(defaultPlacements);
+    for (uint32 role = 0; role < ENGINE_THREAD_COUNT; role++)
+    {
+        char name[CVAR_NAME_SIZE];
+        snprintf(name, sizeof(name), "cpu.%s", cpuEngineThreadName((e_engineThread)role));
+        d3dApp.cvars.placements[role] = cvarRegisterInt(name, defaultPlacements[role], THREAD_PLACEMENT_ANY,
+            THREAD_PLACEMENT_EXCLUSIVE_CORE, "thread placement policy", CVAR_FLAG_INIT_ONLY);
+    }
 
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
+    char configPath[260] = "sandbox.cfg";
+    const char* configOption = strstr(commandLine, "--config=");
+    if (configOption)
+    {
+        sscanf(configOption + strlen("--config="), "%259s", configPath);
+    }
+    if (!cvarLoadFile(configPath) && configOption)
+    {
+        SGSWARN("Could not read config file %s", configPath);
     }
+    cvarParseCommandLine(commandLine);
+
+    cvarApplyPending();
+    // Only from here on: the pacer doesn't exist yet, InitFramePacing reads the value itself
+    cvarSetCallback(d3dApp.cvars.fps, OnFpsChanged, nullptr);
+
+    renderState.clientWidth = (uint32)cvarInt(d3dApp.cvars.windowWidth);
+    renderState.clientHeight = (uint32)cvarInt(d3dApp.cvars.windowHeight);
+    renderState.bufferCount = (uint32)cvarInt(d3dApp.cvars.swapChainBuffers);
+    renderState.framesInFlight = (uint32)cvarInt(d3dApp.cvars.framesInFlight);
+    renderState.msaa4xState = cvarBool(d3dApp.cvars.msaa);
+    renderState.backend = (e_rhiBackend)cvarInt(d3dApp.cvars.backend);
+}
 
-    // update the viewport transform to cover the client area
-    D3DState.screenViewport.TopLeftX = 0;
-    D3DState.screenViewport.TopLeftY = 0;
-    D3DState.screenViewport.Width = static_cast<float32>(D3DState.clientWidth);
-    D3DState.screenViewport.Height = static_cast<float32>(D3DState.clientHeight);
-    D3DState.screenViewport.MinDepth = 0.0f;
-    D3DState.screenViewport.MaxDepth = 1.0f;
+// Threads started before this (the logger) are placed now, later ones when they attach
+void PlaceThreads()
+{
+    CpuTopology* topology = new CpuTopology();
+    cpuTopologyDetect(topology);
+    cpuTopologyLog(topology);
 
-    D3DState.scissorRect = { 0, 0, static_cast<long>(D3DState.clientWidth), static_cast<long>(D3DState.clientHeight) };
+    if (cvarBool(d3dApp.cvars.threadPlacement))
+    {
+        e_threadPlacement policies[ENGINE_THREAD_COUNT];
+        for (uint32 role = 0; role < ENGINE_THREAD_COUNT; role++)
+        {
+            policies[role] = (e_threadPlacement)cvarInt(d3dApp.cvars.placements[role]);
+        }
+        CpuPlacementPlan plan;
+        cpuPlacementBuildPlan(topology, policies, &plan);
+        cpuPlacementInitialize(&plan);
+    }
+    cpuPlacementAttachThread(ENGINE_THREAD_MAIN, 0);
+    delete topology;
+}
 
+// Device creation, window creation and the CPU-side subsystems don't depend on each other, so
+// they overlap; the swapchain joins them. The window task blocks until the window thread
+// created the window, which keeps the window on its own thread.
+void BuildStartupGraph(StartupGraph* graph)
+{
+    startupGraphInitialize(graph);
+
+    uint32 device = startupGraphAddTask(graph, "render device", InitRenderDevice, nullptr);
+    uint32 frameContexts = startupGraphAddTask(graph, "frame contexts", InitFrameContexts, nullptr);
+    startupGraphAddDependency(graph, frameContexts, device);
+    d3dApp.msaaTask = startupGraphAddTask(graph, "msaa support", InitMsaaSupport, nullptr, STARTUP_TASK_LAZY);
+    startupGraphAddDependency(graph, d3dApp.msaaTask, device);
+    uint32 commandObjects = startupGraphAddTask(graph, "command objects", InitCommandObjects, nullptr);
+    startupGraphAddDependency(graph, commandObjects, device);
+
+    uint32 window = startupGraphAddTask(graph, "window", InitWindowTask, nullptr);
+    uint32 swapChain = startupGraphAddTask(graph, "swapchain", InitSwapChain, nullptr);
+    startupGraphAddDependency(graph, swapChain, window);
+    startupGraphAddDependency(graph, swapChain, frameContexts);
+    startupGraphAddDependency(graph, swapChain, commandObjects);
+
+    startupGraphAddTask(graph, "frame pacing", InitFramePacing, nullptr);
+    startupGraphAddTask(graph, "scene", InitScene, nullptr);
 }
 
-void DrawFrame()
+// Headless mode: renders the jobs named on the command line and exits
+int RunBatch(const char* commandLine)
 {
-    // Draw stuff
-    D3DState.device.directCmdListAlloc->Reset();
+    BatchJobList jobs = {};
+    if (batchJobsFromCommandLine(commandLine, &jobs) == 0)
+    {
+        SGSERROR("Batch mode requested but no jobs were found");
+        return 1;
+    }
 
-    D3DState.device.commandList->Reset(D3DState.device.directCmdListAlloc.Get(), nullptr);
+    // Offscreen targets only, no window or swapchain
+    if (!InitRenderDevice(nullptr))
+    {
+        batchJobListFree(&jobs);
+        return 1;
+    }
+
+    BatchConfig config;
+    const char* inFlightOption = strstr(commandLine, "--in-flight=");
+    if (inFlightOption)
+    {
+        config.framesInFlight = (uint32)atoi(inFlightOption + strlen("--in-flight="));
+    }
 
-    ID3D12Resource* resource = D3DState.swapChain.imageBuffer[D3DState.swapChain.currentBackBuffer].Get();
+    BatchDevice device = batchRhiDevice(renderState.device);
+    BatchStats stats;
+    batchRun(jobs.jobs, jobs.count, device, config, &stats);
+    device.destroy(device.userData);
+    ShutdownRenderer();
 
-    const D3D12_RESOURCE_BARRIER* barrier = &CD3DX12_RESOURCE_BARRIER::Transition(
-        resource,
-        D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    SGSINFO("Batch: %u jobs done, %u failed, %llu frames in %.3f s, %.3f s waiting on the GPU",
+        stats.jobsCompleted, stats.jobsFailed, (unsigned long long)stats.frames, stats.seconds, stats.waitSeconds);
+
+    batchJobListFree(&jobs);
+    return stats.jobsFailed ? 2 : 0;
+}
+
+// What DrawFrame's passes use, declared with the frame graph
+struct FramePassData
+{
+    const RenderSnapshot* snapshot;
+    FrameGraphHandle backBuffer;
+    FrameGraphHandle target;        // the back buffer, or the MSAA target resolving into it
+    FrameGraphHandle depthStencil;
+};
 
-    D3DState.device.commandList->ResourceBarrier(
-        1, 
-        barrier);
+void ClearPass(RhiCommandList* commandList, const FrameGraph* graph, void* userData)
+{
+    const FramePassData* data = (const FramePassData*)userData;
+    RhiResource* target = frameGraphGetResource(graph, data->target);
+    RhiResource* depthStencil = frameGraphGetResource(graph, data->depthStencil);
 
     // Set viewport and scissor
-    D3DState.device.commandList->RSSetViewports(1, &D3DState.screenViewport);
-    D3DState.device.commandList->RSSetScissorRects(1, &D3DState.scissorRect);
+    rhiCmdSetViewport(commandList, renderState.screenViewport);
+    rhiCmdSetScissor(commandList, renderState.scissorRect);
 
     // Clear render targets
-    D3DState.device.commandList->ClearRenderTargetView(CurrentBackBufferView(), DirectX::Colors::LightSteelBlue, 0, nullptr);
-    D3DState.device.commandList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+    rhiCmdClearRenderTarget(commandList, target, data->snapshot->clearColor);
+    rhiCmdClearDepthStencil(commandList, depthStencil, 1.0f, 0);
 
-    D3DState.device.commandList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
-        
-    D3DState.device.commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-        CurrentBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+    rhiCmdSetRenderTargets(commandList, &target, 1, depthStencil);
+}
 
-    DX_CHECK(D3DState.device.commandList->Close());
+void ResolvePass(RhiCommandList* commandList, const FrameGraph* graph, void* userData)
+{
+    const FramePassData* data = (const FramePassData*)userData;
+    rhiCmdResolve(commandList, frameGraphGetResource(graph, data->backBuffer), frameGraphGetResource(graph, data->target));
+}
 
-    // execute commands
-    ID3D12CommandList* commandLists[] = { D3DState.device.commandList.Get() };
-    D3DState.device.commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+// The depth buffer and the MSAA target are transient: the graph sizes them from their descs and
+// recompiles only when those change
+void DeclareFrame(FrameGraph* graph, FramePassData* data)
+{
+    uint32 sampleCount = renderState.msaa4xState ? 4 : 1;
+    frameGraphBegin(graph);
+    data->backBuffer = frameGraphImport(graph, "back buffer", CurrentBackBuffer(), RHI_STATE_PRESENT);
+    data->depthStencil = frameGraphCreateTexture(graph, "depth stencil buffer",
+        rhiTexture2DDesc(renderState.depthStencilFormat, renderState.clientWidth, renderState.clientHeight, RHI_RESOURCE_FLAG_DEPTH_STENCIL, sampleCount));
+    // Flip model swapchains can't be multisampled: 4x MSAA renders into its own target and
+    // resolves into the back buffer
+    data->target = data->backBuffer;
+    if (renderState.msaa4xState)
+    {
+        data->target = frameGraphCreateTexture(graph, "msaa target",
+            rhiTexture2DDesc(renderState.backBufferFormat, renderState.clientWidth, renderState.clientHeight, RHI_RESOURCE_FLAG_RENDER_TARGET, sampleCount));
+    }
+
+    frameGraphAddPass(graph, "clear", ClearPass, data);
+    frameGraphWrite(graph, data->target, RHI_STATE_RENDER_TARGET);
+    frameGraphWrite(graph, data->depthStencil, RHI_STATE_DEPTH_WRITE);
+    if (renderState.msaa4xState)
+    {
+        frameGraphAddPass(graph, "resolve", ResolvePass, data);
+        frameGraphRead(graph, data->target, RHI_STATE_RESOLVE_SOURCE);
+        frameGraphWrite(graph, data->backBuffer, RHI_STATE_RESOLVE_DEST);
+    }
+}
+
+// Render thread only. Everything it draws comes from the snapshot.
+void DrawFrame(const RenderSnapshot* snapshot)
+{
+    SGSRECORD(FLIGHT_EVENT_FRAME_BEGIN, "DrawFrame", snapshot->frame);
+
+    uint64 requestedSize = renderState.requestedSize.exchange(0);
+    if (requestedSize)
+    {
+        uint32 width = (uint32)(requestedSize >> 32);
+        uint32 height = (uint32)requestedSize;
+        if ((width != renderState.clientWidth || height != renderState.clientHeight) && !ResizeRenderTargets(width, height))
+        {
+            SGSERROR_CAT(LOG_CATEGORY_RENDER, "Resizing the render targets to %ux%u failed", width, height);
+        }
+    }
+
+    // Only waits when the GPU is still on the frame that last used this context
+    frameTimingBeginPhase(&d3dApp.timing, FRAME_TIMING_WAIT);
+    FrameContext* context = frameContextsBegin(&renderState.frames);
+    frameTimingEndPhase(&d3dApp.timing, FRAME_TIMING_WAIT);
+
+    frameTimingBeginPhase(&d3dApp.timing, FRAME_TIMING_RECORD);
+
+    // Draw stuff, counting per pass commands as the cvar stood when the frame began
+    rhiPassCountersEnabled = cvarBool(d3dApp.cvars.passCounters);
+    RhiCommandList* commandList = renderState.commandList;
+    ResourceStateTracker* barriers = &renderState.barriers;
+    rhiBeginCommandList(commandList, context->allocator);
+    resourceStateTrackerBegin(barriers, commandList);
+
+    // Replaced targets retire with this frame
+    FramePassData passData;
+    passData.snapshot = snapshot;
+    DeclareFrame(&renderState.frameGraph, &passData);
+    if (frameGraphCompile(&renderState.frameGraph, frameContextsRetireValue(&renderState.frames)))
+    {
+        frameGraphExecute(&renderState.frameGraph, barriers);
+    }
+    else
+    {
+        SGSERROR_CAT(LOG_CATEGORY_RENDER, "Compiling the frame graph failed, frame %llu is left out", (unsigned long long)snapshot->frame);
+    }
+
+    rhiEndCommandList(commandList);
+    frameTimingEndPhase(&d3dApp.timing, FRAME_TIMING_RECORD);
+
+    // execute commands, after the transitions into the states the list starts with
+    frameTimingBeginPhase(&d3dApp.timing, FRAME_TIMING_SUBMIT);
+    RhiCommandList* submission[2];
+    uint32 submissionCount = 0;
+    rhiBeginCommandList(renderState.fixupList, context->allocator);
+    bool fixup = resourceStateResolve(barriers, renderState.fixupList);
+    rhiEndCommandList(renderState.fixupList);
+    if (fixup)
+    {
+        passStatsAddList(&d3dApp.passStats, renderState.fixupList);
+        submission[submissionCount++] = renderState.fixupList;
+    }
+    passStatsAddList(&d3dApp.passStats, commandList);
+    submission[submissionCount++] = commandList;
+    rhiQueueSubmit(renderState.queue, submission, submissionCount);
 
     // swap buffers
-    D3DState.swapChain.handle->Present(0, 0);
-    D3DState.swapChain.currentBackBuffer = (D3DState.swapChain.currentBackBuffer + 1) % D3DState.swapChain.bufferCount;
+    rhiPresent(renderState.swapChain, 0);
+    frameContextsEnd(&renderState.frames);
+    frameTimingEndPhase(&d3dApp.timing, FRAME_TIMING_SUBMIT);
+    passStatsEndFrame(&d3dApp.passStats, snapshot->frame);
 
-    // Flush command queue
-    D3DState.fence.currentFence++;
+    SGSRECORD(FLIGHT_EVENT_FRAME_END, "DrawFrame", snapshot->frame);
+}
 
-    D3DState.device.commandQueue->Signal(D3DState.fence.handle.Get(), D3DState.fence.currentFence);
+void ProcessWindowEvents()
+{
+    WindowEventBatch batch;
+    do
+    {
+        windowEventDrain(&d3dApp.events, &batch);
+        for (uint32 i = 0; i < batch.count; i++)
+        {
+            const WindowEvent& event = batch.events[i];
+            switch (event.type)
+            {
+                case WINDOW_EVENT_CLOSE:
+                {
+                    d3dApp.running = false;
+                    SGSINFO_CAT(LOG_CATEGORY_WINDOW, "WM_CLOSE\n");
+                } break;
+
+                case WINDOW_EVENT_RESIZE:
+                {
+                    SGSINFO_CAT(LOG_CATEGORY_WINDOW, "WM_SIZE %dx%d\n", event.a, event.b);
+                    // WM_SIZE reports an empty client area when minimized
+                    framePacerSetMinimized(&d3dApp.pacer, event.a == 0 || event.b == 0);
+                    if (event.a > 0 && event.b > 0)
+                    {
+                        d3dApp.scene.aspectRatio = (float32)event.a / (float32)event.b;
+                        renderState.requestedSize.store(((uint64)event.a << 32) | (uint32)event.b);
+                    }
+                } break;
+
+                case WINDOW_EVENT_ACTIVATE:
+                {
+                    SGSINFO_CAT(LOG_CATEGORY_WINDOW, "WM_ACTIVATEAPP %d\n", event.a);
+                    framePacerSetActive(&d3dApp.pacer, event.a != 0);
+                } break;
+
+                default:
+                {
+                    // Input is not consumed yet
+                } break;
+            }
+        }
+    } while (batch.moreAvailable);
+}
 
-    if(D3DState.fence.handle->GetCompletedValue() < D3DState.fence.currentFence)
+void LogFrameStats()
+{
+    FramePacerStats stats;
+    framePacerGetStats(&d3dApp.pacer, &stats);
+    SGSINFO("%llu frames in %.1f s at %.0f fps target: %.3f ms avg, %.3f ms jitter, %.3f ms max, cpu %.1f%% of a core (sleep %.1f s, spin %.2f s)",
+        (unsigned long long)stats.frames, stats.wallSeconds, framePacerCurrentFps(&d3dApp.pacer),
+        stats.averageFrameMs, stats.jitterMs, stats.maxFrameMs, stats.cpuUtilization * 100.0,
+        stats.sleepSeconds, stats.spinSeconds);
+
+    FrameTimingStats timingStats;
+    frameTimingGetStats(&d3dApp.timing, &timingStats);
+    for (uint32 phase = 0; phase < FRAME_TIMING_PHASE_COUNT; phase++)
     {
-        HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+        const FrameTimingPhaseStats& phaseStats = timingStats.phases[phase];
+        SGSINFO("  %-6s p50 %.3f p95 %.3f p99 %.3f max %.3f ms", frameTimingPhaseName((e_frameTimingPhase)phase),
+            phaseStats.p50Ms, phaseStats.p95Ms, phaseStats.p99Ms, phaseStats.maxMs);
+    }
+    SGSINFO("  %llu hitches in %llu frames", (unsigned long long)timingStats.hitches, (unsigned long long)timingStats.frames);
+
+    DeferredReleaseStats releaseStats;
+    deferredReleaseGetStats(&renderState.frames.releases, &releaseStats);
+    SGSINFO("  release queue: %llu pending (%.2f MB), peak %llu (%.2f MB), %llu released",
+        (unsigned long long)releaseStats.pending, (float64)releaseStats.pendingBytes / (1024.0 * 1024.0),
+        (unsigned long long)releaseStats.peakPending, (float64)releaseStats.peakPendingBytes / (1024.0 * 1024.0),
+        (unsigned long long)releaseStats.released);
+}
 
-        D3DState.fence.handle->SetEventOnCompletion(D3DState.fence.currentFence, eventHandle);
+// Frame timing covers the render thread: wall time runs from one snapshot to the next
+void RenderThreadMain()
+{
+    cpuPlacementAttachThread(ENGINE_THREAD_RENDER, 0);
+    for (;;)
+    {
+        const RenderSnapshot* snapshot = snapshotAcquire(&d3dApp.snapshots);
+        if (!snapshot)
+        {
+            break;
+        }
 
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
+        frameTimingBeginFrame(&d3dApp.timing);
+        DrawFrame(snapshot);
+        snapshotRelease(&d3dApp.snapshots);
     }
+    frameTimingEndFrame(&d3dApp.timing);
+
+    // The counters belong to this thread, so they are reported here rather than with the others
+    FrameContextsStats frameStats;
+    frameContextsGetStats(&renderState.frames, &frameStats);
+    SGSINFO("%u frames in flight: %.0f%% of %llu frames overlapped the GPU, %.2f frames queued on average, %llu waits (%.3f s)",
+        renderState.frames.count, frameStats.overlapFraction * 100.0, (unsigned long long)frameStats.frames,
+        frameStats.averageFramesInFlight, (unsigned long long)frameStats.waits, frameStats.waitSeconds);
+    cpuPlacementDetachThread();
 }
 
 void Run()
 {
+    const float64 statsIntervalSeconds = 10.0;
+    // Longer steps, after a breakpoint or a stall, are clamped
+    const float32 maxStepSeconds = 0.1f;
+
+    d3dApp.renderThread = std::thread(RenderThreadMain);
+
+    int64 previousStep = frameTimingNow();
     while (d3dApp.running)
     {
-        MSG message = {};
-        if(PeekMessage(&message, 0, 0, 0, PM_REMOVE))
+        // Settings changed since the last frame take effect together, here
+        cvarApplyPending();
+
+        // All pending window events once per frame, in order, resize and mouse motion coalesced
+        ProcessWindowEvents();
+        if (!d3dApp.running)
         {
-            TranslateMessage(&message);
-            DispatchMessage(&message);
+            break;
         }
-        else
+
+        int64 now = frameTimingNow();
+        float32 step = (float32)((float64)(now - previousStep) * 1e-9);
+        previousStep = now;
+        sceneUpdate(&d3dApp.scene, step < maxStepSeconds ? step : maxStepSeconds);
+
+        // Nothing to present to while minimized, the pacer still wakes up to poll events
+        if (!d3dApp.pacer.minimized)
+        {
+            // Waits only if the render thread is still on the frame before the previous one
+            RenderSnapshot* snapshot = snapshotBeginWrite(&d3dApp.snapshots);
+            if (snapshot)
+            {
+                sceneWriteSnapshot(&d3dApp.scene, snapshot);
+                snapshotPublish(&d3dApp.snapshots);
+            }
+        }
+        framePacerEndFrame(&d3dApp.pacer);
+
+        if ((float64)(d3dApp.pacer.lastFrameEnd - d3dApp.pacer.statsStart) * 1e-9 >= statsIntervalSeconds)
+        {
+            LogFrameStats();
+            framePacerResetStats(&d3dApp.pacer);
+        }
+    }
+
+    snapshotExchangeStop(&d3dApp.snapshots);
+    d3dApp.renderThread.join();
+
+    LogFrameStats();
+    SGSINFO("simulation waited %.2f s for the render thread, render waited %.2f s for snapshots",
+        d3dApp.snapshots.simulationWaitSeconds, d3dApp.snapshots.renderWaitSeconds);
+
+    if (d3dApp.frameCsvPath[0] && !frameTimingWriteCsv(&d3dApp.timing, d3dApp.frameCsvPath))
+    {
+        SGSWARN("Could not write frame timings to %s", d3dApp.frameCsvPath);
+    }
+
+    if (d3dApp.passStatsPath[0])
+    {
+        uint32 length = (uint32)strlen(d3dApp.passStatsPath);
+        bool json = length >= 5 && strcmp(d3dApp.passStatsPath + length - 5, ".json") == 0;
+        bool written = json ? passStatsWriteJson(&d3dApp.passStats, d3dApp.passStatsPath) :
+            passStatsWriteCsv(&d3dApp.passStats, d3dApp.passStatsPath);
+        if (!written)
         {
-            DrawFrame();
+            SGSWARN("Could not write pass statistics to %s", d3dApp.passStatsPath);
         }
     }
 }
@@ -564,11 +971,51 @@ WinMain(HINSTANCE hInstance,
 		LPSTR lpCmdLine, 
         int showCmd)
 {
+    flightRecorderInstallCrashHandlers();
 
-    if(!InitWindow())
-        return false;
+    LogConfig logConfig;
+    logInitialize(logConfig);
+    // Window messages can arrive every frame during resizes
+    logSetCategoryRateLimit(LOG_CATEGORY_WINDOW, 10);
+
+    // Production runs pass --validation=off or --validation=light
+    validationInitialize(validationTierFromCommandLine(lpCmdLine, VALIDATION_TIER_FULL));
+
+    RegisterConsoleVariables(lpCmdLine);
+    PlaceThreads();
+
+    // --batch=manifest or --job=... render offscreen without a window
+    if (strstr(lpCmdLine, "--batch=") || strstr(lpCmdLine, "--job="))
+    {
+        int32 result = RunBatch(lpCmdLine);
+        logShutdown();
+        return result;
+    }
 
-    InitDirect3D();
+    d3dApp.hInstance = hInstance;
+    d3dApp.commandLine = lpCmdLine;
+
+    // --startup-threads=1 initializes serially, for comparison
+    uint32 startupThreads = 0;
+    const char* startupThreadsOption = strstr(lpCmdLine, "--startup-threads=");
+    if (startupThreadsOption)
+    {
+        startupThreads = (uint32)atoi(startupThreadsOption + strlen("--startup-threads="));
+    }
+
+    BuildStartupGraph(&d3dApp.startup);
+    bool started = startupGraphRun(&d3dApp.startup, startupThreads);
+    startupGraphReport(&d3dApp.startup);
+    cvarFinishStartup();
+    cvarLogAll();
+    if (!started)
+    {
+        // The window thread is the only thing that must be stopped; the rest is torn down by exit
+        StopWindowThread();
+        ShutdownRenderer();
+        logShutdown();
+        return false;
+    }
 
     // run the application
     // main loop
@@ -576,5 +1023,14 @@ WinMain(HINSTANCE hInstance,
 
     Run();
 
+    snapshotExchangeShutdown(&d3dApp.snapshots);
+    sceneShutdown(&d3dApp.scene);
+    framePacerShutdown(&d3dApp.pacer);
+    ShutdownRenderer();
+    StopWindowThread();
+    cpuPlacementDetachThread();
+    cpuPlacementShutdown();
+    logShutdown();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "batch_render.h"
+#include "logger.h"
+#include "rhi.h"
+
+// Runs batch render jobs on the null device, so job lists and the scheduler can be checked on
+// machines without a GPU. Images are deterministic splats of the test scene. --rhi renders
+// through the RHI null backend instead, the path the sandbox takes; its images are the clear color.
+// usage: batchnull [--in-flight=N] [--no-save] [--rhi] --batch=<manifest> | --job=name,output,width,height[,frames[,objects[,seed]]] ...
+
+int main(int argc, char** argv)
+{
+    std::string commandLine;
+    BatchConfig config;
+    bool useRhi = false;
+    for (int32 i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--in-flight=", 12) == 0)
+        {
+            config.framesInFlight = (uint32)atoi(argv[i] + 12);
+        }
+        else if (strcmp(argv[i], "--no-save") == 0)
+        {
+            config.saveOutputs = false;
+        }
+        else if (strcmp(argv[i], "--rhi") == 0)
+        {
+            useRhi = true;
+        }
+        commandLine += argv[i];
+        commandLine += " ";
+    }
+
+    LogConfig logConfig;
+    logInitialize(logConfig);
+
+    BatchJobList jobs = {};
+    if (batchJobsFromCommandLine(commandLine.c_str(), &jobs) == 0)
+    {
+        printf("usage: batchnull [--in-flight=N] [--no-save] [--rhi] --batch=<manifest> | --job=name,output,width,height[,frames[,objects[,seed]]] ...\n");
+        logShutdown();
+        return 1;
+    }
+
+    RhiDevice* rhiDevice = nullptr;
+    BatchDevice device;
+    if (useRhi)
+    {
+        RhiDeviceConfig rhiConfig;
+        rhiConfig.backend = RHI_BACKEND_NULL;
+        rhiDevice = rhiCreateDevice(rhiConfig);
+        device = batchRhiDevice(rhiDevice);
+    }
+    else
+    {
+        NullDeviceConfig deviceConfig;
+        device = batchNullDevice(deviceConfig);
+    }
+    BatchStats stats;
+    batchRun(jobs.jobs, jobs.count, device, config, &stats);
+    device.destroy(device.userData);
+    if (rhiDevice)
+    {
+        rhiDestroyDevice(rhiDevice);
+    }
+
+    printf("%u jobs done, %u failed, %llu frames in %.3f s (%.1f frames/s), %.3f s waiting on fences\n",
+        stats.jobsCompleted, stats.jobsFailed, (unsigned long long)stats.frames, stats.seconds,
+        stats.seconds > 0.0 ? (float64)stats.frames / stats.seconds : 0.0, stats.waitSeconds);
+
+    batchJobListFree(&jobs);
+    logShutdown();
+    return stats.jobsFailed ? 2 : 0;
+}
@@ -0,0 +1,9 @@
+@echo off
+
+echo "building tools"
+
+set include_paths= /I..\Engine\src
+
+pushd ..\bin
+for %%f in (..\Tools\*.cpp) do cl /EHsc /WX /Zi %include_paths% /DDEBUG %%f /link engine.lib D3D12.lib dxgi.lib
+popd
\ No newline at end of file
@@ -0,0 +1,11 @@
+#!/bin/bash
+
+echo "building tools"
+
+include_paths="-I../Engine/src"
+
+pushd ../bin > /dev/null
+for file in ../Tools/*.cpp; do
+    g++ -std=c++14 -Werror -g -O2 $include_paths -DDEBUG $file -o $(basename $file .cpp) -L. -lengine -lpthread
+done
+popd > /dev/null
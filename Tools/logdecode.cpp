@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "log_binary.h"
+
+// Turns a binary log written by logBinaryFileSink back into text.
+// usage: logdecode <file.sgsblog> [--sites]
+
+struct DecodedFormat
+{
+    bool known = false;
+    e_logLevel level = LOG_LEVEL_INFO;
+    uint32 line = 0;
+    std::vector<char> file;
+    std::vector<char> format;
+};
+
+static const char* levelStrings[6] = { "[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: " };
+
+static bool readBytes(const std::vector<uint8>& data, uint64& offset, void* out, uint64 size)
+{
+    if (offset + size > data.size())
+    {
+        return false;
+    }
+    memcpy(out, data.data() + offset, size);
+    offset += size;
+    return true;
+}
+
+static bool readString(const std::vector<uint8>& data, uint64& offset, std::vector<char>& out)
+{
+    uint16 length;
+    if (!readBytes(data, offset, &length, 2))
+    {
+        return false;
+    }
+    out.resize(length + 1);
+    out[length] = 0;
+    return readBytes(data, offset, out.data(), length);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: logdecode <file> [--sites]\n");
+        return 1;
+    }
+
+    bool printSites = argc > 2 && strcmp(argv[2], "--sites") == 0;
+
+    FILE* file = fopen(argv[1], "rb");
+    if (!file)
+    {
+        printf("could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<uint8> data;
+    uint8 chunk[64 * 1024];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + read);
+    }
+    fclose(file);
+
+    LogBinaryFileHeader header;
+    uint64 offset = 0;
+    if (!readBytes(data, offset, &header, sizeof(header)) || memcmp(header.magic, LOG_BINARY_MAGIC, 8) != 0)
+    {
+        printf("%s is not a binary log\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<DecodedFormat> formats;
+    uint64 records = 0;
+    uint64 overflowRecords = 0;
+    char text[LOG_RECORD_SIZE];
+
+    while (offset < data.size())
+    {
+        uint8 type = data[offset++];
+        if (type == LOG_CHUNK_FORMAT)
+        {
+            uint32 id;
+            uint8 level;
+            DecodedFormat format;
+            if (!readBytes(data, offset, &id, 4) || !readBytes(data, offset, &level, 1) ||
+                !readBytes(data, offset, &format.line, 4) || !readString(data, offset, format.file) ||
+                !readString(data, offset, format.format) || id >= LOG_BINARY_MAX_FORMATS)
+            {
+                break;
+            }
+
+            format.known = true;
+            format.level = (e_logLevel)level;
+            if (formats.size() <= id)
+            {
+                formats.resize(id + 1);
+            }
+            if (printSites)
+            {
+                printf("#%u %s:%u \"%s\"\n", id, format.file.data(), format.line, format.format.data());
+            }
+            formats[id] = format;
+        }
+        else if (type == LOG_CHUNK_RECORD)
+        {
+            uint16 length;
+            uint8 payload[LOG_RECORD_PAYLOAD_SIZE];
+            if (!readBytes(data, offset, &length, 2) || length < LOG_BINARY_HEADER_SIZE || length > sizeof(payload) ||
+                !readBytes(data, offset, payload, length))
+            {
+                break;
+            }
+
+            uint32 id;
+            uint64 timestamp;
+            memcpy(&id, payload, 4);
+            memcpy(&timestamp, payload + 4, 8);
+            float64 seconds = (float64)(int64)(timestamp - header.baseTimestamp) * 1e-9;
+
+            if (id == LOG_BINARY_FORMAT_OVERFLOW)
+            {
+                printf("%12.6f <no format, registry was full>\n", seconds);
+                overflowRecords++;
+                continue;
+            }
+            if (id >= formats.size() || !formats[id].known)
+            {
+                printf("%12.6f <unknown format %u>\n", seconds, id);
+                continue;
+            }
+
+            const DecodedFormat& format = formats[id];
+            logBinaryFormat(format.format.data(), payload + LOG_BINARY_HEADER_SIZE, length - LOG_BINARY_HEADER_SIZE, text, sizeof(text));
+            printf("%12.6f %s%s\n", seconds, levelStrings[format.level], text);
+            records++;
+        }
+        else if (type == LOG_CHUNK_TEXT)
+        {
+            uint8 level;
+            uint16 length;
+            if (!readBytes(data, offset, &level, 1) || !readBytes(data, offset, &length, 2) ||
+                offset + length > data.size())
+            {
+                break;
+            }
+            printf("%12s %.*s", "", (int32)length, (const char*)data.data() + offset);
+            offset += length;
+            records++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (offset < data.size())
+    {
+        fprintf(stderr, "stopped at corrupt or truncated chunk, offset %llu\n", (unsigned long long)offset);
+    }
+    fprintf(stderr, "%llu records, %u formats\n", (unsigned long long)records, (uint32)formats.size());
+    if (overflowRecords)
+    {
+        fprintf(stderr, "%llu records without a format: the format registry of %u was full when they were written\n",
+            (unsigned long long)overflowRecords, LOG_BINARY_MAX_FORMATS);
+    }
+    return 0;
+}
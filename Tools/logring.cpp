@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <vector>
+
+#include "log_ring_file.h"
+
+// Prints the records of a ring file written by logRingFileSink, oldest first. Works on the
+// file left behind by a crashed process.
+// usage: logring <file>
+
+static void printRecord(void* userData, uint64 sequence, e_logLevel level, const char* text, uint32 length)
+{
+    printf("%8llu %.*s", (unsigned long long)sequence, (int32)length, text);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: logring <file>\n");
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (!file)
+    {
+        printf("could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<uint8> image;
+    uint8 chunk[64 * 1024];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        image.insert(image.end(), chunk, chunk + read);
+    }
+    fclose(file);
+
+    uint64 tornRecords = 0;
+    uint64 records = logRingFileRead(image.data(), image.size(), printRecord, nullptr, &tornRecords);
+    if (records == 0 && image.size() < sizeof(LogRingFileHeader))
+    {
+        printf("%s is not a log ring file\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(stderr, "%llu records, %llu torn\n", (unsigned long long)records, (unsigned long long)tornRecords);
+    return 0;
+}
@@ -14,4 +14,12 @@ popd
 
 pushd Sandbox
 call build.bat
+popd
+
+pushd Tools
+call build.bat
+popd
+
+pushd Benchmark
+call build.bat
 popd
\ No newline at end of file
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+# Linux builds only cover the portable engine modules and the benchmark; the sandbox needs D3D12.
+echo "building all projects..."
+
+mkdir -p bin
+rm -f bin/*
+
+pushd Engine > /dev/null
+./build.sh
+popd > /dev/null
+
+pushd Tools > /dev/null
+./build.sh
+popd > /dev/null
+
+pushd Benchmark > /dev/null
+./build.sh
+popd > /dev/null